@@ -3,8 +3,15 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
+#include <stddef.h>
 #include <string.h>
+#include <time.h>
+
+#if !defined(_WIN32)
+#define _strdup strdup
+#endif
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -12,6 +19,7 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 //Types of error for this project.
+#define NO_ERROR           -1
 #define OUT_OF_MEMORY      0
 #define STACK_OVERFLOW     1
 #define STACK_UNDERFLOW    2
@@ -22,246 +30,298 @@
 #define LOG_OF_NEGATIVE    7
 #define UNEXPECTED_ALIAS   8
 #define DICT_OUT_OF_MEMORY 9
+#define INTEGER_OVERFLOW   10
+
+#define ERROR_TYPES_COUNT  11
+
+/**********************************************************************************************************
+NAME  : GET ERROR MESSAGE
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+const char* get_error_message(int error_code)
+{
+	switch (error_code)
+	{
+		case NO_ERROR           : return "No error";
+		case OUT_OF_MEMORY      : return "Out of memory";
+		case STACK_OVERFLOW     : return "Stack overflow";
+		case STACK_UNDERFLOW    : return "Stack underflow";
+		case UNEXPECTED_TOKEN   : return "Unexpected token";
+		case ZERO_DIVISION      : return "Zero division";
+		case ROOT_OF_NEGATIVE   : return "Root of negative";
+		case LOG_OF_ZERO        : return "Logarithm of zero";
+		case LOG_OF_NEGATIVE    : return "Logarithm of negative";
+		case UNEXPECTED_ALIAS   : return "Unexpected alias";
+		case DICT_OUT_OF_MEMORY : return "There is no room in the dictionary";
+		case INTEGER_OVERFLOW   : return "Integer overflow";
+		default                 : return "Unknown exeption";
+	}
+}
+
 
 /**********************************************************************************************************
 NAME  : THROW ERROR
 LIBS  : stdlib.h, stdio.h
 NOTES : this function was created for handling errors that are specific to this project. List of existing
-        error types located above.
+        error types located above. It terminates program, so it is used only for errors after which work
+        can not be continued (like out of memory). Errors of parsing and evaluation are returned to caller
+        as error codes.
 **********************************************************************************************************/
 void throw_error(int error_code)
 {
-	switch (error_code)
-	{
-		case OUT_OF_MEMORY :
-			fprintf(stderr, "Out of memory\n");
-			exit(EXIT_FAILURE);
-
-		case STACK_OVERFLOW :
-			fprintf(stderr, "Stack overflow\n");
-			exit(EXIT_FAILURE);
+	fprintf(stderr, "%s\n", get_error_message(error_code));
+	exit(EXIT_FAILURE);
+}
 
-		case STACK_UNDERFLOW :
-			fprintf(stderr, "Stack underflow\n");
-			exit(EXIT_FAILURE);
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////ERROR HANDLER SECTION END///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-		case UNEXPECTED_TOKEN:
-			fprintf(stderr, "Unexpected token\n");
-			exit(EXIT_FAILURE);
 
-		case ZERO_DIVISION:
-			fprintf(stderr, "Zero division\n");
-			exit(EXIT_FAILURE);
 
-		case ROOT_OF_NEGATIVE:
-			fprintf(stderr, "Root of negative\n");
-			exit(EXIT_FAILURE);
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////STATISTICS SECTION//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
 
-		case LOG_OF_ZERO:
-			fprintf(stderr, "Logarithm of zero\n");
-			exit(EXIT_FAILURE);
+/*
 
-		case LOG_OF_NEGATIVE:
-			fprintf(stderr, "Logarithm of negative\n");
-			exit(EXIT_FAILURE);
+Statistics are optional instrumentation of calculation, they are compiled only with PARSER_STATISTICS
+defined (for example "-DPARSER_STATISTICS"), otherwise every STATISTICS macro expands to nothing and costs
+nothing. Every phase (lexing, conversion to postfix notation, compilation, optimization, binding of "where"
+values, evaluation) keeps count of calls and sum of time stamp counter ticks (or nanoseconds where there is no
+time stamp counter). Count of evaluations, count of reported errors by error code and hits of formula cache and
+result cache are kept too.
 
-		case UNEXPECTED_ALIAS:
-			fprintf(stderr, "Unexpected alias\n");
-			exit(EXIT_FAILURE);
+Statistics are written as JSON to standard error when program exits and when process gets SIGUSR1. Signal
+handler only sets flag, statistics are written by the next calculation, so output is never interrupted in the
+middle. Counters of formula cache are incremented atomically, because threads which share cache lock only
+different shards of it. Other counters are not atomic, parallel evaluation is not instrumented.
 
-		case DICT_OUT_OF_MEMORY:
-			fprintf(stderr, "There is no room in the dictionary");
-			exit(EXIT_FAILURE);
+*/
 
-		default :
-			fprintf(stderr, "Unknown exeption\n");
-			exit(EXIT_FAILURE);
-	}
-}
+#if defined(PARSER_STATISTICS)
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////
-////ERROR HANDLER SECTION END///////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include <signal.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define STATISTICS_TIME_STAMP_COUNTER
+#endif
 
+//Phases of calculation.
+#define STATISTICS_LEX      0
+#define STATISTICS_POSTFIX  1
+#define STATISTICS_COMPILE  2
+#define STATISTICS_OPTIMIZE 3
+#define STATISTICS_BIND     4
+#define STATISTICS_EVALUATE 5
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-////DICTIONARY SECTION//////////////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////////////////////////////////
+#define STATISTICS_PHASES_COUNT 6
 
 /**********************************************************************************************************
-NAME  : DICTIONARY ENTRY
+NAME  : PARSER STATISTICS
 LIBS  : -
-NOTES : -
+NOTES : "start_ticks" and "start_seconds" are taken at initialization, they convert ticks to nanoseconds.
 **********************************************************************************************************/
-struct dictionary_entry
+struct parser_statistics
 {
-	char* key;
-	char* value;
+	unsigned long long phase_calls[STATISTICS_PHASES_COUNT];
+	unsigned long long phase_ticks[STATISTICS_PHASES_COUNT];
+
+	unsigned long long evaluations_count;
+	unsigned long long errors_count[ERROR_TYPES_COUNT];
+	unsigned long long cache_hits_count;
+	unsigned long long cache_misses_count;
+	unsigned long long cache_evictions_count;
+	unsigned long long result_cache_hits_count;
+	unsigned long long result_cache_misses_count;
+
+	unsigned long long start_ticks;
+	double start_seconds;
 };
 
+struct parser_statistics parser_statistics;
+volatile sig_atomic_t is_statistics_requested = 0;
 
 /**********************************************************************************************************
-NAME  : DICTIONARY
-LIBS  : -
+NAME  : GET STATISTICS SECONDS
+LIBS  : time.h
 NOTES : -
 **********************************************************************************************************/
-struct dictionary
+double get_statistics_seconds()
 {
-	struct dictionary_entry* current_entry;
-	struct dictionary_entry* origin_position;
-	int dictionary_capacity;
-	int current_entry_count;
-};
+	struct timespec time_spec;
+	timespec_get(&time_spec, TIME_UTC);
+
+	return (double)time_spec.tv_sec + (double)time_spec.tv_nsec / 1e9;
+}
 
 
 /**********************************************************************************************************
-NAME  : DICTIONARY INITIALIZE
-LIBS  : -
-NOTES : -
+NAME  : GET STATISTICS TICKS
+LIBS  : x86intrin.h or time.h
+NOTES : return time stamp counter, or nanoseconds where there is no time stamp counter.
 **********************************************************************************************************/
-struct dictionary* dictionary_initialize(int dictionary_capacity)
+unsigned long long get_statistics_ticks()
 {
-	struct dictionary* dictionary = calloc(1, sizeof(struct dictionary));
-	if (dictionary == NULL)
-	{
-		throw_error(OUT_OF_MEMORY);
-	}
+#if defined(STATISTICS_TIME_STAMP_COUNTER)
+	return __rdtsc();
+#else
+	return (unsigned long long)(get_statistics_seconds() * 1e9);
+#endif
+}
 
-	dictionary->current_entry = calloc(dictionary_capacity, sizeof(struct dictionary_entry));
-	if (dictionary->current_entry == NULL)
-	{
-		throw_error(OUT_OF_MEMORY);
-	}
-	
-	dictionary->origin_position = dictionary->current_entry;
-	dictionary->dictionary_capacity = dictionary_capacity;
-	dictionary->current_entry_count = 0;
 
-	return dictionary;
+/**********************************************************************************************************
+NAME  : ADD STATISTICS PHASE
+LIBS  : -
+NOTES : "start_ticks" is taken by "get_statistics_ticks()" at start of phase.
+**********************************************************************************************************/
+void add_statistics_phase(int phase, unsigned long long start_ticks)
+{
+	parser_statistics.phase_ticks[phase] += get_statistics_ticks() - start_ticks;
+	parser_statistics.phase_calls[phase]++;
 }
 
 
 /**********************************************************************************************************
-NAME  : DICTIONARY FREE
+NAME  : COUNT STATISTICS ERROR
 LIBS  : -
-NOTES : always use this function when finish work with dictionary.
+NOTES : NO_ERROR is not counted.
 **********************************************************************************************************/
-void dictionary_free(struct dictionary* dictionary)
+void count_statistics_error(int error_code)
 {
-	dictionary->current_entry = dictionary->origin_position;
-
-	for (size_t i = 0; i < dictionary->dictionary_capacity; i++)
+	if (error_code >= 0 && error_code < ERROR_TYPES_COUNT)
 	{
-		if (dictionary->current_entry->key != NULL && dictionary->current_entry->key != NULL)
-		{
-			free(dictionary->current_entry->key);
-			free(dictionary->current_entry->value);
-		}
-
-		dictionary->current_entry++;
+		parser_statistics.errors_count[error_code]++;
 	}
-
-	dictionary->current_entry = dictionary->origin_position;
-	free(dictionary->current_entry);
-	free(dictionary);
 }
 
 
 /**********************************************************************************************************
-NAME  : DICTIONARY ADD
-LIBS  : -
-NOTES : -
+NAME  : WRITE STATISTICS
+LIBS  : stdio.h
+NOTES : writes statistics as JSON to standard error.
 **********************************************************************************************************/
-void dictionary_add(struct dictionary* dictionary, char* key, char* value)
+void write_statistics()
 {
-	dictionary->current_entry = dictionary->origin_position;
-	for (size_t i = 0; i <= dictionary->dictionary_capacity; i++)
+	const char* PHASES_NAMES[STATISTICS_PHASES_COUNT] = { "lex", "postfix", "compile", "optimize", "bind",
+		"evaluate" };
+	const char* ERRORS_NAMES[ERROR_TYPES_COUNT] = { "out_of_memory", "stack_overflow", "stack_underflow",
+		"unexpected_token", "zero_division", "root_of_negative", "log_of_zero", "log_of_negative",
+		"unexpected_alias", "dict_out_of_memory", "integer_overflow" };
+
+	double elapsed_seconds = get_statistics_seconds() - parser_statistics.start_seconds;
+	unsigned long long elapsed_ticks = get_statistics_ticks() - parser_statistics.start_ticks;
+	double ns_per_tick = (elapsed_ticks != 0) ? elapsed_seconds * 1e9 / elapsed_ticks : 0;
+
+	fprintf(stderr, "{\n\"statistics\": {\n");
+#if defined(STATISTICS_TIME_STAMP_COUNTER)
+	fprintf(stderr, "\"ticks\": \"rdtsc\", \"ns_per_tick\": %.6f,\n", ns_per_tick);
+#else
+	fprintf(stderr, "\"ticks\": \"ns\", \"ns_per_tick\": %.6f,\n", ns_per_tick);
+#endif
+
+	fprintf(stderr, "\"phases\": {\n");
+	for (int i = 0; i < STATISTICS_PHASES_COUNT; i++)
 	{
-		if (dictionary->current_entry->key == NULL && dictionary->current_entry->value == NULL)
-		{
-			dictionary->current_entry->key = _strdup(key);
-			if (dictionary->current_entry->key == NULL)
-			{
-				throw_error(OUT_OF_MEMORY);
-			}
-
-			dictionary->current_entry->value = _strdup(value);
-			if (dictionary->current_entry->value == NULL)
-			{
-				throw_error(OUT_OF_MEMORY);
-			}
+		unsigned long long calls = parser_statistics.phase_calls[i];
+		unsigned long long ticks = parser_statistics.phase_ticks[i];
+		fprintf(stderr, "\"%s\": { \"calls\": %llu, \"ticks\": %llu, \"ns\": %.0f, \"ns_per_call\": %.1f }%s\n",
+			PHASES_NAMES[i], calls, ticks, ticks * ns_per_tick, (calls != 0) ? ticks * ns_per_tick / calls : 0,
+			(i + 1 < STATISTICS_PHASES_COUNT) ? "," : "");
+	}
+	fprintf(stderr, "},\n");
 
-			return;
-		}
-		dictionary->current_entry++;
+	fprintf(stderr, "\"evaluations\": %llu,\n\"errors\": {", parser_statistics.evaluations_count);
+	for (int i = 0; i < ERROR_TYPES_COUNT; i++)
+	{
+		fprintf(stderr, "%s \"%s\": %llu", (i == 0) ? "" : ",", ERRORS_NAMES[i], parser_statistics.errors_count[i]);
 	}
+	fprintf(stderr, " },\n\"formula_cache\": { \"hits\": %llu, \"misses\": %llu, \"evictions\": %llu },\n",
+		parser_statistics.cache_hits_count, parser_statistics.cache_misses_count,
+		parser_statistics.cache_evictions_count);
+	fprintf(stderr, "\"result_cache\": { \"hits\": %llu, \"misses\": %llu }\n}\n}\n",
+		parser_statistics.result_cache_hits_count, parser_statistics.result_cache_misses_count);
+	fflush(stderr);
+}
+
 
-	throw_error(DICT_OUT_OF_MEMORY);
+/**********************************************************************************************************
+NAME  : HANDLE STATISTICS SIGNAL
+LIBS  : signal.h
+NOTES : only sets flag, statistics are written by "poll_statistics()".
+**********************************************************************************************************/
+void handle_statistics_signal(int signal_number)
+{
+	is_statistics_requested = 1;
+	signal(signal_number, &handle_statistics_signal);
 }
 
 
 /**********************************************************************************************************
-NAME  : DICTIONARY DELETE
+NAME  : POLL STATISTICS
 LIBS  : -
-NOTES : if this function will not find an entry with given key, it will do nothing.
+NOTES : writes statistics if they were requested by signal.
 **********************************************************************************************************/
-void dictionary_delete(struct dictionary* dictionary, char* key)
+void poll_statistics()
 {
-	struct dictionary_entry* search_pointer = dictionary->origin_position;
-
-	for (size_t i = 0; i <= dictionary->dictionary_capacity; i++)
+	if (is_statistics_requested != 0)
 	{
-		if (search_pointer->key == key)
-		{
-			free(search_pointer->key);
-			free(search_pointer->value);
-			search_pointer->key = NULL;
-			search_pointer->value = NULL;
-
-			dictionary->current_entry_count--;
-			break;
-		}
-		else
-		{
-			search_pointer++;
-		}
+		is_statistics_requested = 0;
+		write_statistics();
 	}
 }
 
 
 /**********************************************************************************************************
-NAME  : DICTIONARY FIND
-LIBS  : -
-NOTES : if this function will not find an entry with given key, it will return NULL pointer.
+NAME  : INITIALIZE STATISTICS
+LIBS  : stdlib.h, signal.h
+NOTES : statistics are written at exit and by SIGUSR1 (where it exists).
 **********************************************************************************************************/
-char* dictionary_find(struct dictionary* dictionary, char* key)
+void initialize_statistics()
 {
-	char* found_value = NULL;
-
-	dictionary->current_entry = dictionary->origin_position;
-	for (size_t i = 0; i < dictionary->dictionary_capacity; i++)
-	{
-		if (dictionary->current_entry->key != NULL && strcmp(dictionary->current_entry->key, key) == 0)
-		{
-			found_value = dictionary->current_entry->value;
-			break;
-		}
-		else
-		{
-			dictionary->current_entry++;
-		}
-	}
+	parser_statistics.start_ticks = get_statistics_ticks();
+	parser_statistics.start_seconds = get_statistics_seconds();
 
-	return found_value;
+	atexit(&write_statistics);
+#if defined(SIGUSR1)
+	signal(SIGUSR1, &handle_statistics_signal);
+#endif
 }
 
+#define STATISTICS_INITIALIZE()               initialize_statistics()
+#define STATISTICS_START(start_ticks)         unsigned long long start_ticks = get_statistics_ticks()
+#define STATISTICS_END(phase, start_ticks)    add_statistics_phase(phase, start_ticks)
+#define STATISTICS_COUNT(counter)             (parser_statistics.counter++)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define STATISTICS_COUNT_SHARED(counter)      _InterlockedIncrement64((volatile long long*)&parser_statistics.counter)
+#else
+#define STATISTICS_COUNT_SHARED(counter)      __atomic_fetch_add(&parser_statistics.counter, 1, __ATOMIC_RELAXED)
+#endif
+#define STATISTICS_COUNT_ERROR(error_code)    count_statistics_error(error_code)
+#define STATISTICS_POLL()                     poll_statistics()
+#else
+#define STATISTICS_INITIALIZE()
+#define STATISTICS_START(start_ticks)
+#define STATISTICS_END(phase, start_ticks)
+#define STATISTICS_COUNT(counter)
+#define STATISTICS_COUNT_SHARED(counter)
+#define STATISTICS_COUNT_ERROR(error_code)
+#define STATISTICS_POLL()
+#endif
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
-////DICTIONARY SECTION END//////////////////////////////////////////////////////////////////////////////
+////STATISTICS SECTION END//////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////DOUBLE STACK SECTION////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -277,6 +337,7 @@ struct stack_double
 	double* origin_position;
 	size_t stack_capacity;
 	size_t current_elements_count;
+	int error_code;
 };
 
 
@@ -293,7 +354,8 @@ struct stack_double* stack_double_initialize(size_t stack_capacity)
 		throw_error(OUT_OF_MEMORY);
 	}
 
-	stack_double->head_element = calloc(stack_capacity, sizeof(double));
+	const size_t BUFFER_ELEMENT = 1;
+	stack_double->head_element = calloc(stack_capacity + BUFFER_ELEMENT, sizeof(double));
 	if (stack_double->head_element == NULL)
 	{
 		throw_error(OUT_OF_MEMORY);
@@ -301,15 +363,43 @@ struct stack_double* stack_double_initialize(size_t stack_capacity)
 	stack_double->origin_position = stack_double->head_element;
 	stack_double->stack_capacity = stack_capacity;
 	stack_double->current_elements_count = 0;
+	stack_double->error_code = NO_ERROR;
 
 	return stack_double;
 }
 
 
+/**********************************************************************************************************
+NAME  : SET STACK ERROR
+LIBS  : -
+NOTES : remembers the first error which happened during work with stack.
+**********************************************************************************************************/
+void set_stack_error(struct stack_double* stack_pointer, int error_code)
+{
+	if (stack_pointer->error_code == NO_ERROR)
+	{
+		stack_pointer->error_code = error_code;
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : CLEAR STACK DOUBLE
+LIBS  : -
+NOTES : removes all elements and error from stack.
+**********************************************************************************************************/
+void clear_stack_double(struct stack_double* stack_pointer)
+{
+	stack_pointer->head_element = stack_pointer->origin_position;
+	stack_pointer->current_elements_count = 0;
+	stack_pointer->error_code = NO_ERROR;
+}
+
+
 /**********************************************************************************************************
 NAME  : PUSH STACK DOUBLE
 LIBS  : -
-NOTES : -
+NOTES : on overflow value is not pushed and stack error is set.
 **********************************************************************************************************/
 void push_stack_double(struct stack_double* stack_pointer, double value_to_push)
 {
@@ -321,15 +411,15 @@ void push_stack_double(struct stack_double* stack_pointer, double value_to_push)
 	}
 	else
 	{
-		throw_error(STACK_OVERFLOW);
+		set_stack_error(stack_pointer, STACK_OVERFLOW);
 	}
 }
 
 
 /**********************************************************************************************************
 NAME  : POP STACK DOUBLE
-LIBS  : -
-NOTES : -
+LIBS  : math.h
+NOTES : on underflow NAN is returned and stack error is set.
 **********************************************************************************************************/
 double pop_stack_double(struct stack_double* stack_pointer)
 {
@@ -343,7 +433,8 @@ double pop_stack_double(struct stack_double* stack_pointer)
 	}
 	else
 	{
-		throw_error(STACK_UNDERFLOW);
+		set_stack_error(stack_pointer, STACK_UNDERFLOW);
+		return NAN;
 	}
 }
 
@@ -367,1498 +458,13981 @@ void stack_double_free(struct stack_double* stack_pointer)
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-////STACK STRING SECTION////////////////////////////////////////////////////////////////////////////////
+////BATCH MATHEMATICAL FUNCTIONS SECTION////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-/**********************************************************************************************************
-NAME  : STRING
-LIBS  : -
-NOTES : -
-**********************************************************************************************************/
-struct string
-{
-	char* char_pointer;
-};
+/*
+
+Batch functions are column versions of stack mathematical functions. Every batch function takes block of
+first operands and block of second operands (NULL for functions of one argument), calculates result for
+every row and writes it over block of first operands. Result for every row is identical to result of the
+corresponding stack function. Blocks of arguments are consecutive blocks of batch stack, so function of
+three arguments ("if") finds block of its third argument right after block of the second one.
+
+If calculation fails for some row (zero division, root of negative etc.), NAN is written as result of this
+row, error code is written to the same row of "row_errors" (only first error of row is kept) and
+calculation of other rows continues.
+
+Simple arithmetic, comparisons, logical operations, "if", "sqrt" and "abs" are calculated by AVX (4 rows) or
+SSE2 (2 rows) instructions if compiler targets them, rest of rows and all other functions are calculated by
+scalar loop.
+
+*/
 
+//Rows in block of batch evaluation, every element of batch stack is such block.
+#define BATCH_BLOCK_SIZE 256
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BATCH_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BATCH_SIMD_SSE2
+#endif
+
+//SIMD_SELECT takes lanes of "a" where mask is set and lanes of "b" elsewhere, SIMD_HIGH_WORDS converts the
+//high 32 bits of every lane (signed integer) to double.
+#if defined(BATCH_SIMD_AVX)
+#define SIMD_WIDTH                 4
+#define SIMD_ALL_LANES_MASK        0xF
+#define SIMD_DOUBLE                __m256d
+#define SIMD_LOAD(pointer)         _mm256_loadu_pd(pointer)
+#define SIMD_STORE(pointer, value) _mm256_storeu_pd(pointer, value)
+#define SIMD_SET(value)            _mm256_set1_pd(value)
+#define SIMD_ADD(a, b)             _mm256_add_pd(a, b)
+#define SIMD_SUBTRACT(a, b)        _mm256_sub_pd(a, b)
+#define SIMD_MULTIPLY(a, b)        _mm256_mul_pd(a, b)
+#define SIMD_DIVIDE(a, b)          _mm256_div_pd(a, b)
+#define SIMD_SQRT(a)               _mm256_sqrt_pd(a)
+#define SIMD_AND(a, b)             _mm256_and_pd(a, b)
+#define SIMD_OR(a, b)              _mm256_or_pd(a, b)
+#define SIMD_AND_NOT(a, b)         _mm256_andnot_pd(a, b)
+#define SIMD_MORE(a, b)            _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+#define SIMD_LESS(a, b)            _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define SIMD_EQUALS(a, b)          _mm256_cmp_pd(a, b, _CMP_EQ_OQ)
+#define SIMD_MORE_OR_EQUALS(a, b)  _mm256_cmp_pd(a, b, _CMP_GE_OQ)
+#define SIMD_MOVE_MASK(a)          _mm256_movemask_pd(a)
+#define SIMD_XOR(a, b)             _mm256_xor_pd(a, b)
+#define SIMD_NOT_EQUALS(a, b)      _mm256_cmp_pd(a, b, _CMP_NEQ_UQ)
+#define SIMD_SELECT(mask, a, b)    _mm256_blendv_pd(b, a, mask)
+#define SIMD_HIGH_WORDS(a)         _mm256_cvtepi32_pd(_mm_castps_si128(_mm_shuffle_ps( \
+	_mm256_castps256_ps128(_mm256_castpd_ps(a)), _mm256_extractf128_ps(_mm256_castpd_ps(a), 1), \
+	_MM_SHUFFLE(3, 1, 3, 1))))
+#elif defined(BATCH_SIMD_SSE2)
+#define SIMD_WIDTH                 2
+#define SIMD_ALL_LANES_MASK        0x3
+#define SIMD_DOUBLE                __m128d
+#define SIMD_LOAD(pointer)         _mm_loadu_pd(pointer)
+#define SIMD_STORE(pointer, value) _mm_storeu_pd(pointer, value)
+#define SIMD_SET(value)            _mm_set1_pd(value)
+#define SIMD_ADD(a, b)             _mm_add_pd(a, b)
+#define SIMD_SUBTRACT(a, b)        _mm_sub_pd(a, b)
+#define SIMD_MULTIPLY(a, b)        _mm_mul_pd(a, b)
+#define SIMD_DIVIDE(a, b)          _mm_div_pd(a, b)
+#define SIMD_SQRT(a)               _mm_sqrt_pd(a)
+#define SIMD_AND(a, b)             _mm_and_pd(a, b)
+#define SIMD_OR(a, b)              _mm_or_pd(a, b)
+#define SIMD_AND_NOT(a, b)         _mm_andnot_pd(a, b)
+#define SIMD_MORE(a, b)            _mm_cmpgt_pd(a, b)
+#define SIMD_LESS(a, b)            _mm_cmplt_pd(a, b)
+#define SIMD_EQUALS(a, b)          _mm_cmpeq_pd(a, b)
+#define SIMD_MORE_OR_EQUALS(a, b)  _mm_cmpge_pd(a, b)
+#define SIMD_MOVE_MASK(a)          _mm_movemask_pd(a)
+#define SIMD_XOR(a, b)             _mm_xor_pd(a, b)
+#define SIMD_NOT_EQUALS(a, b)      _mm_cmpneq_pd(a, b)
+#define SIMD_SELECT(mask, a, b)    _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b))
+#define SIMD_HIGH_WORDS(a)         _mm_cvtepi32_pd(_mm_shuffle_epi32(_mm_castpd_si128(a), _MM_SHUFFLE(3, 1, 3, 1)))
+#endif
 
 /**********************************************************************************************************
-NAME  : STACK STRING
+NAME  : SET ROW ERROR
 LIBS  : -
-NOTES : -
+NOTES : remembers the first error which happened in row of block.
 **********************************************************************************************************/
-struct stack_string
+void set_row_error(int* row_errors, size_t row_index, int error_code)
 {
-	struct string* head_element;
-	struct string* origin_position;
-	size_t stack_capacity;
-	size_t current_elements_count;
-};
+	if (row_errors[row_index] == NO_ERROR)
+	{
+		row_errors[row_index] = error_code;
+	}
+}
 
 
 /**********************************************************************************************************
-NAME  : STACK STRING INITIALIZE
-LIBS  : stdlib.h, stdio.h
-NOTES : -
+NAME  : BATCH ADD
+LIBS  : -
+NOTES : column version of "stack_add()".
 **********************************************************************************************************/
-struct stack_string* stack_string_initialize(size_t stack_capacity)
+void batch_add(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	struct stack_string* stack_string = calloc(1, sizeof(struct stack_string));
+	size_t i = 0;
 
-	if (stack_string == NULL)
+#if defined(SIMD_WIDTH)
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		throw_error(OUT_OF_MEMORY);
+		SIMD_STORE(first_operand + i, SIMD_ADD(SIMD_LOAD(first_operand + i), SIMD_LOAD(second_operand + i)));
 	}
+#endif
 
-	const size_t BUFFER_BYTE = 1;
-	stack_string->head_element = calloc(stack_capacity + BUFFER_BYTE, sizeof(struct string));
-
-	stack_string->origin_position = stack_string->head_element;
-
-	//fill buffer byte with zero character.
-	stack_string->head_element->char_pointer = _strdup("");
-	stack_string->head_element++;
-
-	stack_string->stack_capacity = stack_capacity;
-	stack_string->current_elements_count = 0;
-
-	
-
-	if (stack_string->head_element == NULL)
+	for (; i < rows_count; i++)
 	{
-		throw_error(OUT_OF_MEMORY);
+		first_operand[i] = first_operand[i] + second_operand[i];
 	}
-
-	return stack_string;
 }
 
 
 /**********************************************************************************************************
-NAME  : PUSH STACK STRING
-LIBS  : string.h
-NOTES : -
+NAME  : BATCH SUBTRACT
+LIBS  : -
+NOTES : column version of "stack_subtract()".
 **********************************************************************************************************/
-void push_stack_string(struct stack_string* stack_pointer, struct string* value_to_push)
+void batch_subtract(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	char* char_pointer = _strdup(value_to_push->char_pointer);
-	if (char_pointer == NULL)
-	{
-		throw_error(OUT_OF_MEMORY);
-	}
+	size_t i = 0;
 
-	if (stack_pointer->current_elements_count != stack_pointer->stack_capacity)
+#if defined(SIMD_WIDTH)
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		stack_pointer->head_element++;
-		stack_pointer->head_element->char_pointer = char_pointer;
-		stack_pointer->current_elements_count++;
+		SIMD_STORE(first_operand + i,
+			SIMD_SUBTRACT(SIMD_LOAD(first_operand + i), SIMD_LOAD(second_operand + i)));
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		throw_error(STACK_OVERFLOW);
+		first_operand[i] = first_operand[i] - second_operand[i];
 	}
 }
 
 
 /**********************************************************************************************************
-NAME  : POP STACK STRING
+NAME  : BATCH MULTIPLY
 LIBS  : -
-NOTES : -
+NOTES : column version of "stack_multiply()".
 **********************************************************************************************************/
-struct string* pop_stack_string(struct stack_string* stack_pointer)
+void batch_multiply(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	if (stack_pointer->current_elements_count != 0)
-	{
-		struct string* popped_element = stack_pointer->head_element;
-		stack_pointer->head_element--;
-		stack_pointer->current_elements_count--;
+	size_t i = 0;
 
-		return popped_element;
+#if defined(SIMD_WIDTH)
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
+	{
+		SIMD_STORE(first_operand + i,
+			SIMD_MULTIPLY(SIMD_LOAD(first_operand + i), SIMD_LOAD(second_operand + i)));
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		throw_error(STACK_UNDERFLOW);
+		first_operand[i] = first_operand[i] * second_operand[i];
 	}
 }
 
 
 /**********************************************************************************************************
-NAME  : PEEK STACK STRING
+NAME  : BATCH DIVIDE
 LIBS  : -
-NOTES : -
+NOTES : column version of "stack_divide()".
 **********************************************************************************************************/
-struct string* peek_stack_string(struct stack_string* stack_pointer)
+void batch_divide(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	struct string* peeked_element;
-	if (stack_pointer->head_element->char_pointer != NULL)
+	size_t i = 0;
+
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ZERO = SIMD_SET(0);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		peeked_element = stack_pointer->head_element;
+		SIMD_DOUBLE divisor = SIMD_LOAD(second_operand + i);
+		SIMD_STORE(first_operand + i, SIMD_DIVIDE(SIMD_LOAD(first_operand + i), divisor));
+
+		//rows with zero divisor are rare, so they are fixed after vector division.
+		int zero_lanes = SIMD_MOVE_MASK(SIMD_EQUALS(divisor, ZERO));
+		for (size_t lane = 0; zero_lanes != 0; lane++, zero_lanes >>= 1)
+		{
+			if (zero_lanes & 1)
+			{
+				first_operand[i + lane] = NAN;
+				set_row_error(row_errors, i + lane, ZERO_DIVISION);
+			}
+		}
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		stack_pointer->head_element--;
-		peeked_element = stack_pointer->head_element;
-		stack_pointer->head_element++;
+		if (second_operand[i] == 0)
+		{
+			first_operand[i] = NAN;
+			set_row_error(row_errors, i, ZERO_DIVISION);
+		}
+		else
+		{
+			first_operand[i] = first_operand[i] / second_operand[i];
+		}
 	}
-	return peeked_element;
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK STRING FREE
-LIBS  : -
-NOTES : always use this function when finish work with string stack.
+NAME  : BATCH SQRT
+LIBS  : math.h
+NOTES : column version of "stack_sqrt()".
 **********************************************************************************************************/
-void stack_string_free(struct stack_string* stack_pointer)
+void batch_sqrt(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	stack_pointer->head_element = stack_pointer->origin_position;
+	size_t i = 0;
 
-	for (size_t i = 0; i < stack_pointer->stack_capacity; i++)
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ZERO = SIMD_SET(0);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		free(stack_pointer->head_element->char_pointer);
-		stack_pointer->head_element++;
-	}
+		SIMD_DOUBLE operand = SIMD_LOAD(first_operand + i);
+		SIMD_STORE(first_operand + i, SIMD_SQRT(operand));
 
-	stack_pointer->head_element = stack_pointer->origin_position;
+		int negative_lanes = SIMD_MOVE_MASK(SIMD_MORE_OR_EQUALS(operand, ZERO)) ^ SIMD_ALL_LANES_MASK;
+		for (size_t lane = 0; negative_lanes != 0; lane++, negative_lanes >>= 1)
+		{
+			if (negative_lanes & 1)
+			{
+				first_operand[i + lane] = NAN;
+				set_row_error(row_errors, i + lane, ROOT_OF_NEGATIVE);
+			}
+		}
+	}
+#endif
 
-	free(stack_pointer->head_element);
-	free(stack_pointer);
+	for (; i < rows_count; i++)
+	{
+		if (!(first_operand[i] >= 0))
+		{
+			first_operand[i] = NAN;
+			set_row_error(row_errors, i, ROOT_OF_NEGATIVE);
+		}
+		else
+		{
+			first_operand[i] = sqrt(first_operand[i]);
+		}
+	}
 }
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////
-////STACK STRING SECTION END////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-
-
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-////STACK MATHEMATICAL FUNCTIONS SECTION////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////////////////////////////////
-
-/*
-
-If you want to add new math operation you need:
-1. Increase ARRAY_CAPACITY constant in function "get_math_operations_entries_array()" by one;
-
-2. Add new operation entry within OPERATIONS SECTION by template:
 
-operation_entry_array->function_entry_pointer->function_alias = "operation alias";
-operation_entry_array->operation_entry_pointer->operator_associativity = *operation associativity*;
-operation_entry_array->function_entry_pointer->pointer_on_function = *addres of function which handle this
-operation*;
-operation_entry_array->function_entry_pointer++;
-
-
-If you want to add new math function you need:
-1. Increase ARRAY_CAPACITY constant in function "get_math_function_entries_array()" by one;
-
-2. Add new operation entry within FUNCTIONS SECTION by template:
-
-func_entry_array->function_entry_pointer->function_alias = "function alias";
-func_entry_array->function_entry_pointer->pointer_on_function = *addres of function which handle this
-function*;
-func_entry_array->function_entry_pointer++;
+/**********************************************************************************************************
+NAME  : BATCH POWER
+LIBS  : math.h
+NOTES : column version of "stack_power()".
+**********************************************************************************************************/
+void batch_power(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
+{
+	for (size_t i = 0; i < rows_count; i++)
+	{
+		first_operand[i] = pow(first_operand[i], second_operand[i]);
+	}
+}
 
-*/
 
 /**********************************************************************************************************
-NAME  : STACK ADD
+NAME  : BATCH NEGATIVE
 LIBS  : -
-NOTES : this function implement stack add operation.
+NOTES : column version of "stack_negative()".
 **********************************************************************************************************/
-void stack_add(struct stack_double* stack_pointer)
+void batch_negative(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	double sum = first_operand + second_operand;
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE MINUS_ONE = SIMD_SET(-1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
+	{
+		SIMD_STORE(first_operand + i, SIMD_MULTIPLY(SIMD_LOAD(first_operand + i), MINUS_ONE));
+	}
+#endif
 
-	push_stack_double(stack_pointer, sum);
+	for (; i < rows_count; i++)
+	{
+		first_operand[i] = first_operand[i] * -1;
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK SUBTRACT
-LIBS  : -
-NOTES : this function implement stack subtract operation.
+NAME  : BATCH ABS
+LIBS  : math.h
+NOTES : column version of "stack_abs()".
 **********************************************************************************************************/
-void stack_subtract(struct stack_double* stack_pointer)
+void batch_abs(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	double difference = first_operand - second_operand;
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE SIGN_BIT = SIMD_SET(-0.0);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
+	{
+		SIMD_STORE(first_operand + i, SIMD_AND_NOT(SIGN_BIT, SIMD_LOAD(first_operand + i)));
+	}
+#endif
 
-	push_stack_double(stack_pointer, difference);
+	for (; i < rows_count; i++)
+	{
+		first_operand[i] = fabs(first_operand[i]);
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK MULTIPLY
-LIBS  : -
-NOTES : this function implement stack multiply operation.
+NAME  : BATCH SIN
+LIBS  : math.h
+NOTES : column version of "stack_sin()".
 **********************************************************************************************************/
-void stack_multiply(struct stack_double* stack_pointer)
+void batch_sin(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
-
-	double product = first_operand * second_operand;
-
-	push_stack_double(stack_pointer, product);
+	for (size_t i = 0; i < rows_count; i++)
+	{
+		first_operand[i] = sin(first_operand[i]);
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK DIVIDE
-LIBS  : -
-NOTES : this function implement stack divide operation.
+NAME  : BATCH COS
+LIBS  : math.h
+NOTES : column version of "stack_cos()".
 **********************************************************************************************************/
-void stack_divide(struct stack_double* stack_pointer)
+void batch_cos(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
-
-	if (second_operand != 0)
-	{
-		double quotient = first_operand / second_operand;
-
-		push_stack_double(stack_pointer, quotient);
-	}
-	else
+	for (size_t i = 0; i < rows_count; i++)
 	{
-		throw_error(ZERO_DIVISION);
+		first_operand[i] = cos(first_operand[i]);
 	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK SQRT
+NAME  : BATCH ARCCOS
 LIBS  : math.h
-NOTES : this function implement stack operation of taking square root.
+NOTES : column version of "stack_arccos()".
 **********************************************************************************************************/
-void stack_sqrt(struct stack_double* stack_pointer)
+void batch_arccos(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double operand = pop_stack_double(stack_pointer);
-
-	if (operand >= 0)
-	{
-		double taking_result = sqrt(operand);
-
-		push_stack_double(stack_pointer, taking_result);
-	}
-	else
+	for (size_t i = 0; i < rows_count; i++)
 	{
-		throw_error(ROOT_OF_NEGATIVE);
+		first_operand[i] = acos(first_operand[i]);
 	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK POWER
+NAME  : BATCH TAN
 LIBS  : math.h
-NOTES : this function implement stack operation of exponentiation.
+NOTES : column version of "stack_tan()".
 **********************************************************************************************************/
-void stack_power(struct stack_double* stack_pointer)
+void batch_tan(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
-
-	double power_result = pow(first_operand, second_operand);
-
-	push_stack_double(stack_pointer, power_result);
+	for (size_t i = 0; i < rows_count; i++)
+	{
+		first_operand[i] = tan(first_operand[i]);
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK NEGATIVE
+NAME  : BATCH COTAN
 LIBS  : math.h
-NOTES : this function implement stack operation of changing sign.
+NOTES : column version of "stack_cotan()".
 **********************************************************************************************************/
-void stack_negative(struct stack_double* stack_pointer)
+void batch_cotan(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double operand = pop_stack_double(stack_pointer);
-
-	double negative_result = operand * -1;
-
-	push_stack_double(stack_pointer, negative_result);
+	for (size_t i = 0; i < rows_count; i++)
+	{
+		first_operand[i] = 1 / tan(first_operand[i]);
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK ABS
+NAME  : BATCH LN
 LIBS  : math.h
-NOTES : this function implement stack operation of calculating absolute value of number.
+NOTES : column version of "stack_ln()".
 **********************************************************************************************************/
-void stack_abs(struct stack_double* stack_pointer)
+void batch_ln(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double operand = pop_stack_double(stack_pointer);
-
-	double abs_result = fabs(operand);
+	for (size_t i = 0; i < rows_count; i++)
+	{
+		if (first_operand[i] > 0)
+		{
+			first_operand[i] = log(first_operand[i]);
+		}
+		else
+		{
+			if (first_operand[i] == 0)
+				set_row_error(row_errors, i, LOG_OF_ZERO);
+			else
+				set_row_error(row_errors, i, LOG_OF_NEGATIVE);
 
-	push_stack_double(stack_pointer, abs_result);
+			first_operand[i] = NAN;
+		}
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK SIN
-LIBS  : math.h
-NOTES : this function implement stack operation of calculating sinus.
+NAME  : BATCH MORE
+LIBS  : -
+NOTES : column version of "stack_more()".
 **********************************************************************************************************/
-void stack_sin(struct stack_double* stack_pointer)
+void batch_more(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	double sin_result = sin(operand);
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
+	{
+		SIMD_DOUBLE mask = SIMD_MORE(SIMD_LOAD(first_operand + i), SIMD_LOAD(second_operand + i));
+		SIMD_STORE(first_operand + i, SIMD_AND(mask, ONE));
+	}
+#endif
 
-	push_stack_double(stack_pointer, sin_result);
+	for (; i < rows_count; i++)
+	{
+		first_operand[i] = (first_operand[i] > second_operand[i]) ? 1 : 0;
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK COS
-LIBS  : math.h
-NOTES : this function implement stack operation of calculating cosine.
+NAME  : BATCH LESS
+LIBS  : -
+NOTES : column version of "stack_less()".
 **********************************************************************************************************/
-void stack_cos(struct stack_double* stack_pointer)
+void batch_less(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	double cos_result = cos(operand);
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
+	{
+		SIMD_DOUBLE mask = SIMD_LESS(SIMD_LOAD(first_operand + i), SIMD_LOAD(second_operand + i));
+		SIMD_STORE(first_operand + i, SIMD_AND(mask, ONE));
+	}
+#endif
 
-	push_stack_double(stack_pointer, cos_result);
+	for (; i < rows_count; i++)
+	{
+		first_operand[i] = (first_operand[i] < second_operand[i]) ? 1 : 0;
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK ARCCOS
-LIBS  : math.h
-NOTES : this function implement stack operation of calculating arccosine.
+NAME  : BATCH EQUALS
+LIBS  : -
+NOTES : column version of "stack_equals()".
 **********************************************************************************************************/
-void stack_arccos(struct stack_double* stack_pointer)
+void batch_equals(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	double arccos_result = acos(operand);
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
+	{
+		SIMD_DOUBLE mask = SIMD_EQUALS(SIMD_LOAD(first_operand + i), SIMD_LOAD(second_operand + i));
+		SIMD_STORE(first_operand + i, SIMD_AND(mask, ONE));
+	}
+#endif
 
-	push_stack_double(stack_pointer, arccos_result);
+	for (; i < rows_count; i++)
+	{
+		first_operand[i] = (first_operand[i] == second_operand[i]) ? 1 : 0;
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK TAN
-LIBS  : math.h
-NOTES : this function implement stack operation of calculating tangent.
+NAME  : DIVIDE INTEGERS
+LIBS  : limits.h, math.h, stdlib.h
+NOTES : integer division of "DIV" and "MOD": operands are truncated to integers, so divisor from -1 to 1
+        fails with ZERO_DIVISION. NAN, infinity, operand out of int and INT_MIN DIV -1 fail with
+        INTEGER_OVERFLOW. Return NO_ERROR and write quotient and remainder to "result", or error code.
 **********************************************************************************************************/
-void stack_tan(struct stack_double* stack_pointer)
+int divide_integers(double first_operand, double second_operand, div_t* result)
 {
-	double operand = pop_stack_double(stack_pointer);
+	double dividend = trunc(first_operand);
+	double divisor = trunc(second_operand);
 
-	double tan_result = tan(operand);
-	
-	push_stack_double(stack_pointer, tan_result);
+	if (divisor == 0)
+	{
+		return ZERO_DIVISION;
+	}
+	if (!(dividend >= INT_MIN && dividend <= INT_MAX) || !(divisor >= INT_MIN && divisor <= INT_MAX) ||
+		(dividend == INT_MIN && divisor == -1))
+	{
+		return INTEGER_OVERFLOW;
+	}
+
+	*result = div((int)dividend, (int)divisor);
+
+	return NO_ERROR;
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK COTAN
-LIBS  : math.h
-NOTES : this function implement stack operation of calculating cotangent.
+NAME  : BATCH DIV
+LIBS  : stdlib.h
+NOTES : column version of "stack_div()". Rows which already failed are not divided, their values can be
+        anything.
 **********************************************************************************************************/
-void stack_cotan(struct stack_double* stack_pointer)
+void batch_div(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double operand = pop_stack_double(stack_pointer);
-
-	double cotan_result = 1 / tan(operand);
+	for (size_t i = 0; i < rows_count; i++)
+	{
+		div_t division_result;
+		int error_code = (row_errors[i] == NO_ERROR) ?
+			divide_integers(first_operand[i], second_operand[i], &division_result) : row_errors[i];
+		if (error_code != NO_ERROR)
+		{
+			first_operand[i] = NAN;
+			set_row_error(row_errors, i, error_code);
+			continue;
+		}
 
-	push_stack_double(stack_pointer, cotan_result);
+		first_operand[i] = (double)division_result.quot;
+	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK LN
-LIBS  : math.h
-NOTES : this function implement stack operation of calculating natural logarithm.
+NAME  : BATCH MOD
+LIBS  : stdlib.h
+NOTES : column version of "stack_mod()".
 **********************************************************************************************************/
-void stack_ln(struct stack_double* stack_pointer)
+void batch_mod(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double operand = pop_stack_double(stack_pointer);
-
-	if (operand > 0)
+	for (size_t i = 0; i < rows_count; i++)
 	{
-		double natlog_result = log(operand);
+		div_t division_result;
+		int error_code = (row_errors[i] == NO_ERROR) ?
+			divide_integers(first_operand[i], second_operand[i], &division_result) : row_errors[i];
+		if (error_code != NO_ERROR)
+		{
+			first_operand[i] = NAN;
+			set_row_error(row_errors, i, error_code);
+			continue;
+		}
 
-		push_stack_double(stack_pointer, natlog_result);
-	}
-	else
-	{
-		if (operand == 0)
-			throw_error(LOG_OF_ZERO);
-		else
-			throw_error(LOG_OF_NEGATIVE);
+		first_operand[i] = (double)division_result.rem;
 	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK MORE
-LIBS  : ?
-NOTES : ?
+NAME  : BATCH OR
+LIBS  : -
+NOTES : column version of "stack_or()".
 **********************************************************************************************************/
-void stack_more(struct stack_double* stack_pointer)
+void batch_or(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	int result = 0;
-	if (first_operand > second_operand)
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		result = 1;
+		SIMD_DOUBLE mask = SIMD_OR(SIMD_EQUALS(SIMD_LOAD(first_operand + i), ONE),
+			SIMD_EQUALS(SIMD_LOAD(second_operand + i), ONE));
+		SIMD_STORE(first_operand + i, SIMD_AND(mask, ONE));
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		result = 0;
+		first_operand[i] = (first_operand[i] == 1 || second_operand[i] == 1) ? 1 : 0;
 	}
-
-	push_stack_double(stack_pointer, result);
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK LESS
-LIBS  : ?
-NOTES : ?
+NAME  : BATCH MORE OR EQUALS
+LIBS  : -
+NOTES : column version of "stack_more_or_equals()".
 **********************************************************************************************************/
-void stack_less(struct stack_double* stack_pointer)
+void batch_more_or_equals(double* first_operand, const double* second_operand, size_t rows_count,
+	int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	int result = 0;
-	if (first_operand < second_operand)
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		result = 1;
+		SIMD_DOUBLE mask = SIMD_MORE_OR_EQUALS(SIMD_LOAD(first_operand + i), SIMD_LOAD(second_operand + i));
+		SIMD_STORE(first_operand + i, SIMD_AND(mask, ONE));
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		result = 0;
+		first_operand[i] = (first_operand[i] >= second_operand[i]) ? 1 : 0;
 	}
-
-	push_stack_double(stack_pointer, result);
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK EQUALS
-LIBS  : ?
-NOTES : ?
+NAME  : BATCH LESS OR EQUALS
+LIBS  : -
+NOTES : column version of "stack_less_or_equals()".
 **********************************************************************************************************/
-void stack_equals(struct stack_double* stack_pointer)
+void batch_less_or_equals(double* first_operand, const double* second_operand, size_t rows_count,
+	int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	int result = 0;
-	if (first_operand == second_operand)
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		result = 1;
+		SIMD_DOUBLE mask = SIMD_MORE_OR_EQUALS(SIMD_LOAD(second_operand + i), SIMD_LOAD(first_operand + i));
+		SIMD_STORE(first_operand + i, SIMD_AND(mask, ONE));
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		result = 0;
+		first_operand[i] = (first_operand[i] <= second_operand[i]) ? 1 : 0;
 	}
-
-	push_stack_double(stack_pointer, (double)result);
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK DIV
-LIBS  : ?
-NOTES : ?
+NAME  : BATCH NOT EQUALS
+LIBS  : -
+NOTES : column version of "stack_not_equals()". Ordered comparison of NAN is false, so NAN is not equal
+        to everything, as in C.
 **********************************************************************************************************/
-void stack_div(struct stack_double* stack_pointer)
+void batch_not_equals(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	if (second_operand != 0)
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		div_t division_result = div(first_operand, second_operand);
-
-		push_stack_double(stack_pointer, (double)division_result.quot);
+		SIMD_DOUBLE mask = SIMD_EQUALS(SIMD_LOAD(first_operand + i), SIMD_LOAD(second_operand + i));
+		SIMD_STORE(first_operand + i, SIMD_AND_NOT(mask, ONE));
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		throw_error(ZERO_DIVISION);
+		first_operand[i] = (first_operand[i] != second_operand[i]) ? 1 : 0;
 	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK MOD
-LIBS  : ?
-NOTES : ?
+NAME  : BATCH AND
+LIBS  : -
+NOTES : column version of "stack_and()".
 **********************************************************************************************************/
-void stack_mod(struct stack_double* stack_pointer)
+void batch_and(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	if (second_operand != 0)
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		div_t division_result = div(first_operand, second_operand);
-
-		push_stack_double(stack_pointer, (double)division_result.rem);
+		SIMD_DOUBLE mask = SIMD_AND(SIMD_EQUALS(SIMD_LOAD(first_operand + i), ONE),
+			SIMD_EQUALS(SIMD_LOAD(second_operand + i), ONE));
+		SIMD_STORE(first_operand + i, SIMD_AND(mask, ONE));
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		throw_error(ZERO_DIVISION);
+		first_operand[i] = (first_operand[i] == 1 && second_operand[i] == 1) ? 1 : 0;
 	}
 }
 
 
 /**********************************************************************************************************
-NAME  : STACK OR
-LIBS  : ?
-NOTES : ?
+NAME  : BATCH NOT
+LIBS  : -
+NOTES : column version of "stack_not()".
 **********************************************************************************************************/
-void stack_or(struct stack_double* stack_pointer)
+void batch_not(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	double second_operand = pop_stack_double(stack_pointer);
-	double first_operand = pop_stack_double(stack_pointer);
+	size_t i = 0;
 
-	int result = 0;
-	if (first_operand == 1 || second_operand == 1)
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		result = 1;
+		SIMD_DOUBLE mask = SIMD_EQUALS(SIMD_LOAD(first_operand + i), ONE);
+		SIMD_STORE(first_operand + i, SIMD_AND_NOT(mask, ONE));
 	}
-	else
+#endif
+
+	for (; i < rows_count; i++)
 	{
-		result = 0;
+		first_operand[i] = (first_operand[i] == 1) ? 0 : 1;
 	}
-	push_stack_double(stack_pointer, (double)result);
 }
 
 
 /**********************************************************************************************************
-NAME  : OPERATION ENTRY
+NAME  : BATCH IF
 LIBS  : -
-NOTES : -
+NOTES : column version of "stack_if()". Function has three arguments, block of the third one follows block
+        of the second one on batch stack, so it is "second_operand + BATCH_BLOCK_SIZE". Value is chosen
+        bitwise, so it is identical to the chosen argument.
 **********************************************************************************************************/
-struct operation_entry
+void batch_if(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors)
 {
-	char* operation_alias;
-	int operator_associativity;
-	void(*pointer_on_function)(struct stack_double*);
-};
+	const double* third_operand = second_operand + BATCH_BLOCK_SIZE;
 
+	size_t i = 0;
 
-/**********************************************************************************************************
-NAME  : FUNCTION ENTRY
-LIBS  : -
-NOTES : -
-**********************************************************************************************************/
-struct function_entry
-{
-	char* function_alias;
-	void(*pointer_on_function)(struct stack_double*);
-};
+#if defined(SIMD_WIDTH)
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	for (; i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
+	{
+		SIMD_DOUBLE mask = SIMD_EQUALS(SIMD_LOAD(first_operand + i), ONE);
+		SIMD_STORE(first_operand + i, SIMD_OR(SIMD_AND(mask, SIMD_LOAD(second_operand + i)),
+			SIMD_AND_NOT(mask, SIMD_LOAD(third_operand + i))));
+	}
+#endif
 
+	for (; i < rows_count; i++)
+	{
+		first_operand[i] = (first_operand[i] == 1) ? second_operand[i] : third_operand[i];
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////BATCH MATHEMATICAL FUNCTIONS SECTION END////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////VECTOR MATHEMATICAL FUNCTIONS SECTION///////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Vector functions are versions of batch "sin", "cos", "tan", "cotan", "arccos" and "ln" which calculate
+several rows at once (AVX: 4 rows, SSE2: 2 rows) by polynomials instead of calling library function for every
+row. Batch stack selects accuracy:
+
+	BATCH_ACCURACY_EXACT     library functions, results are identical to stack functions (default);
+	BATCH_ACCURACY_ONE_ULP   result differs from library function by at most 1 unit in the last place;
+	BATCH_ACCURACY_FOUR_ULP  at most 4 units in the last place, argument reduction and assembly of result
+	                         are simpler.
+
+Polynomials are ones of fdlibm, library which most "libm" implementations descend from. Argument of "sin",
+"cos", "tan" and "cotan" is reduced by pi/2 split into parts of 33 bits, so products of parts by quadrant are
+exact while |x| <= 1e6; for 1 ulp reduced argument is kept as sum of two doubles. Rows which vector function
+does not cover (|x| > 1e6, zero, NAN and infinity, "arccos" out of (-1, 1), "ln" of not positive or
+subnormal number) are calculated by batch function, so errors and special values are the same as in exact
+mode. "cotan" is 1 / tan(x) as in library version, so it may differ from library by one ulp more. "pow" is
+calculated by library in every mode: vector "pow" needs logarithm with precision beyond double, which costs
+more than library "pow()" without FMA instructions.
+
+With SSE2 (2 rows) polynomials of 1 ulp are about as fast as library, the gain comes with AVX.
+
+Results of approximate modes may differ in the last bits from results of stack evaluation and from blocks
+which zone map proves constant, so they are for data where the last bits do not matter.
+
+*/
+
+#include <float.h>
+
+//Accuracies of vector functions.
+#define BATCH_ACCURACY_EXACT    0
+#define BATCH_ACCURACY_ONE_ULP  1
+#define BATCH_ACCURACY_FOUR_ULP 2
+
+#define BATCH_ACCURACIES_COUNT 3
+
+//Trigonometric functions of "vector_trigonometric()".
+#define VECTOR_SIN   0
+#define VECTOR_COS   1
+#define VECTOR_TAN   2
+#define VECTOR_COTAN 3
 
 /**********************************************************************************************************
-NAME  : OPERATOR ENTRY ARRAY
-LIBS  : -
-NOTES : -
+NAME  : GET DOUBLE FROM BITS
+LIBS  : string.h
+NOTES : return double with given binary representation, it makes masks for bitwise SIMD operations.
 **********************************************************************************************************/
-struct operation_entry_array
+double get_double_from_bits(unsigned long long bits)
 {
-	struct operation_entry* operation_entry_pointer;
-	struct operation_entry* operation_entry_pointer_origin_position;
-	size_t array_capacity;
-};
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
 
 
 /**********************************************************************************************************
-NAME  : FUNCTION ENTRY ARRAY
+NAME  : GET ACCURACY NAME
 LIBS  : -
-NOTES : -
+NOTES : name of accuracy in command line and in output of benchmarks.
 **********************************************************************************************************/
-struct function_entry_array
+const char* get_accuracy_name(int accuracy)
 {
-	struct function_entry* function_entry_pointer;
-	struct function_entry* function_entry_pointer_origin_position;
-	size_t array_capacity;
-};
+	switch (accuracy)
+	{
+		case BATCH_ACCURACY_EXACT:    return "exact";
+		case BATCH_ACCURACY_ONE_ULP:  return "1ulp";
+		case BATCH_ACCURACY_FOUR_ULP: return "4ulp";
+		default:                      return "unknown";
+	}
+}
 
 
 /**********************************************************************************************************
-NAME  : FREE OPERATION ENTRY ARRAY
-LIBS  : -
-NOTES : always use this function when finish work with array of operation entry.
+NAME  : GET ACCURACY BY NAME
+LIBS  : string.h
+NOTES : return accuracy with name from "get_accuracy_name()", -1 if there is no such accuracy.
 **********************************************************************************************************/
-void free_operation_entry_array(struct operation_entry_array* operation_entry_array)
+int get_accuracy_by_name(const char* accuracy_name)
 {
-	operation_entry_array->operation_entry_pointer =
-		operation_entry_array->operation_entry_pointer_origin_position;
+	for (int accuracy = 0; accuracy < BATCH_ACCURACIES_COUNT; accuracy++)
+	{
+		if (strcmp(accuracy_name, get_accuracy_name(accuracy)) == 0)
+		{
+			return accuracy;
+		}
+	}
 
-	free(operation_entry_array->operation_entry_pointer);
-	free(operation_entry_array);
+	return -1;
 }
 
+#if defined(SIMD_WIDTH)
 
 /**********************************************************************************************************
-NAME  : FREE FUNCTION ENTRY ARRAY
+NAME  : VECTOR ANGLE
 LIBS  : -
-NOTES : always use this function when finish work with array of function entry.
+NOTES : argument of trigonometric function is quadrant * pi/2 + reduced_high + reduced_low, |reduced_high|
+        is at most about pi/4. "quadrant_bits" keeps quadrant in the lowest bits of mantissa (it is
+        quadrant + 1.5 * 2^52), "uncovered_lanes" is mask of lanes which polynomials do not cover.
 **********************************************************************************************************/
-void free_function_entry_array(struct function_entry_array* func_entry_array)
+struct vector_angle
 {
-	func_entry_array->function_entry_pointer = func_entry_array->function_entry_pointer_origin_position;
+	SIMD_DOUBLE reduced_high;
+	SIMD_DOUBLE reduced_low;
+	SIMD_DOUBLE quadrant_bits;
+	SIMD_DOUBLE uncovered_lanes;
+};
+
 
-	free(func_entry_array->function_entry_pointer);
-	free(func_entry_array);
+/**********************************************************************************************************
+NAME  : ADD VECTORS EXACTLY
+LIBS  : -
+NOTES : two sum: "sum" is rounded a + b, "error" is its rounding error, so sum + error = a + b exactly.
+**********************************************************************************************************/
+void add_vectors_exactly(SIMD_DOUBLE a, SIMD_DOUBLE b, SIMD_DOUBLE* sum, SIMD_DOUBLE* error)
+{
+	*sum = SIMD_ADD(a, b);
+	SIMD_DOUBLE b_part = SIMD_SUBTRACT(*sum, a);
+	*error = SIMD_ADD(SIMD_SUBTRACT(a, SIMD_SUBTRACT(*sum, b_part)), SIMD_SUBTRACT(b, b_part));
 }
 
 
 /**********************************************************************************************************
-NAME  : GET MATH OPERATIONS ENTRIES ARRAY
+NAME  : REDUCE VECTOR ANGLE
 LIBS  : -
-NOTES : this function contain operation section where all mathematical operations listed.
+NOTES : Cody-Waite reduction by pi/2. Quadrant is rounded by adding 1.5 * 2^52, which leaves integer in the
+        lowest bits. For 1 ulp rounding errors of subtractions are kept in "reduced_low". For 4 ulp reduced
+        angle is one double, it loses accuracy when argument is very close to multiple of pi/2, so such
+        lanes (|reduced| < 2^-40) are left to library.
 **********************************************************************************************************/
-struct operation_entry_array* get_math_operations_entries_array()
+void reduce_vector_angle(SIMD_DOUBLE argument, int accuracy, struct vector_angle* angle)
 {
-	size_t ARRAY_CAPACITY = 10;
-
-	struct operation_entry_array* operation_entry_array = calloc(1, sizeof(struct operation_entry_array));
-	if (operation_entry_array == NULL)
+	const double ROUNDING_CONSTANT = 6755399441055744.0;
+	const double TWO_OVER_PI = 6.36619772367581382433e-01;
+	const double PI_OVER_TWO_1 = 1.57079632673412561417e+00;
+	const double PI_OVER_TWO_2 = 6.07710050630396597660e-11;
+	const double PI_OVER_TWO_3 = 2.02226624871116645580e-21;
+	const double PI_OVER_TWO_3_TAIL = 8.47842766036889956997e-32;
+	const double MAX_ARGUMENT = 1e6;
+	const double MIN_FAST_REDUCED = 9.094947017729282e-13;
+	const SIMD_DOUBLE ZERO = SIMD_SET(0);
+	const SIMD_DOUBLE SIGN_BIT = SIMD_SET(-0.0);
+
+	angle->quadrant_bits = SIMD_ADD(SIMD_MULTIPLY(argument, SIMD_SET(TWO_OVER_PI)), SIMD_SET(ROUNDING_CONSTANT));
+	SIMD_DOUBLE quadrant = SIMD_SUBTRACT(angle->quadrant_bits, SIMD_SET(ROUNDING_CONSTANT));
+
+	//quadrant has at most 20 bits, so its products by 33-bit parts are exact and the first subtraction is
+	//exact too.
+	SIMD_DOUBLE reduced = SIMD_SUBTRACT(argument, SIMD_MULTIPLY(quadrant, SIMD_SET(PI_OVER_TWO_1)));
+	SIMD_DOUBLE second_part = SIMD_MULTIPLY(quadrant, SIMD_SET(PI_OVER_TWO_2));
+	SIMD_DOUBLE third_part = SIMD_MULTIPLY(quadrant, SIMD_SET(PI_OVER_TWO_3));
+	SIMD_DOUBLE tail_part = SIMD_MULTIPLY(quadrant, SIMD_SET(PI_OVER_TWO_3_TAIL));
+
+	SIMD_DOUBLE argument_magnitude = SIMD_AND_NOT(SIGN_BIT, argument);
+	angle->uncovered_lanes = SIMD_OR(SIMD_XOR(SIMD_MORE_OR_EQUALS(SIMD_SET(MAX_ARGUMENT), argument_magnitude),
+		SIMD_EQUALS(ZERO, ZERO)), SIMD_EQUALS(argument, ZERO));
+
+	if (accuracy == BATCH_ACCURACY_ONE_ULP)
 	{
-		throw_error(OUT_OF_MEMORY);
+		SIMD_DOUBLE first_error;
+		SIMD_DOUBLE second_error;
+		add_vectors_exactly(reduced, SIMD_XOR(second_part, SIGN_BIT), &reduced, &first_error);
+		add_vectors_exactly(reduced, SIMD_XOR(third_part, SIGN_BIT), &reduced, &second_error);
+
+		SIMD_DOUBLE tail = SIMD_SUBTRACT(SIMD_ADD(first_error, second_error), tail_part);
+		angle->reduced_high = SIMD_ADD(reduced, tail);
+		angle->reduced_low = SIMD_SUBTRACT(tail, SIMD_SUBTRACT(angle->reduced_high, reduced));
 	}
-
-	operation_entry_array->operation_entry_pointer = 
-		calloc(ARRAY_CAPACITY, sizeof(struct operation_entry));
-	if (operation_entry_array->operation_entry_pointer == NULL)
+	else
 	{
-		throw_error(OUT_OF_MEMORY);
+		angle->reduced_high = SIMD_SUBTRACT(SIMD_SUBTRACT(SIMD_SUBTRACT(reduced, second_part), third_part),
+			tail_part);
+		angle->reduced_low = ZERO;
+
+		SIMD_DOUBLE is_reduced_tiny = SIMD_LESS(SIMD_AND_NOT(SIGN_BIT, angle->reduced_high),
+			SIMD_SET(MIN_FAST_REDUCED));
+		angle->uncovered_lanes = SIMD_OR(angle->uncovered_lanes,
+			SIMD_AND(is_reduced_tiny, SIMD_NOT_EQUALS(quadrant, ZERO)));
 	}
-
-	operation_entry_array->array_capacity = ARRAY_CAPACITY;
-	operation_entry_array->operation_entry_pointer_origin_position = 
-		operation_entry_array->operation_entry_pointer;
-
-	////OPERATIONS SECTION BEGIN////
-
-	//adding addition operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "+";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 2;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_add;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding subtract operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "-";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 2;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_subtract;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding multiply operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "*";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 3;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_multiply;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding divide operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "/";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 3;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_divide;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding "more" operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = ">";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 1;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_more;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding "less" operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "<";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 1;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_less;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding "equals" operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "=";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 1;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_equals;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding "or" operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "OR";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 0;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_or;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding "div" operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "DIV";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 3;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_div;
-	operation_entry_array->operation_entry_pointer++;
-
-	//adding "mod" operation entry
-	operation_entry_array->operation_entry_pointer->operation_alias = "MOD";
-	operation_entry_array->operation_entry_pointer->operator_associativity = 3;
-	operation_entry_array->operation_entry_pointer->pointer_on_function = &stack_mod;
-	operation_entry_array->operation_entry_pointer++;
-
-	////OPERATIONS SECTION END////
-
-	operation_entry_array->operation_entry_pointer =
-		operation_entry_array->operation_entry_pointer_origin_position;
-
-	return operation_entry_array;
 }
 
 
 /**********************************************************************************************************
-NAME  : GET MATH FUNCTIONS ENTRIES ARRAY
+NAME  : CALCULATE VECTOR SIN POLYNOMIAL
 LIBS  : -
-NOTES : this function contain function section where all mathematical functions listed.
+NOTES : sin(x + y) for |x| <= pi/4, y is low part of argument (0 for 4 ulp).
 **********************************************************************************************************/
-struct function_entry_array* get_math_functions_entries_array()
+SIMD_DOUBLE calculate_vector_sin_polynomial(SIMD_DOUBLE x, SIMD_DOUBLE y, int accuracy)
 {
-	size_t ARRAY_CAPACITY = 10;
-
-	struct function_entry_array* func_entry_array = calloc(1, sizeof(struct function_entry_array));
-	if (func_entry_array == NULL)
-	{
-		throw_error(OUT_OF_MEMORY);
-	}
-
-	func_entry_array->function_entry_pointer = calloc(ARRAY_CAPACITY, sizeof(struct function_entry));
-	if (func_entry_array->function_entry_pointer == NULL)
+	const double S1 = -1.66666666666666324348e-01;
+	const double S2 = 8.33333333332248946124e-03;
+	const double S3 = -1.98412698298579493134e-04;
+	const double S4 = 2.75573137070700676789e-06;
+	const double S5 = -2.50507602534068634195e-08;
+	const double S6 = 1.58969099521155010221e-10;
+
+	SIMD_DOUBLE z = SIMD_MULTIPLY(x, x);
+	SIMD_DOUBLE v = SIMD_MULTIPLY(z, x);
+	SIMD_DOUBLE r = SIMD_ADD(SIMD_SET(S5), SIMD_MULTIPLY(z, SIMD_SET(S6)));
+	r = SIMD_ADD(SIMD_SET(S4), SIMD_MULTIPLY(z, r));
+	r = SIMD_ADD(SIMD_SET(S3), SIMD_MULTIPLY(z, r));
+	r = SIMD_ADD(SIMD_SET(S2), SIMD_MULTIPLY(z, r));
+
+	if (accuracy == BATCH_ACCURACY_ONE_ULP)
 	{
-		throw_error(OUT_OF_MEMORY);
+		//x - ((z * (y / 2 - v * r) - y) - v * S1)
+		SIMD_DOUBLE correction = SIMD_SUBTRACT(SIMD_MULTIPLY(SIMD_SET(0.5), y), SIMD_MULTIPLY(v, r));
+		correction = SIMD_SUBTRACT(SIMD_MULTIPLY(z, correction), y);
+		correction = SIMD_SUBTRACT(correction, SIMD_MULTIPLY(v, SIMD_SET(S1)));
+		return SIMD_SUBTRACT(x, correction);
 	}
 
-	func_entry_array->array_capacity = ARRAY_CAPACITY;
-	func_entry_array->function_entry_pointer_origin_position = func_entry_array->function_entry_pointer;
-
-	////FUNCTIONS SECTION BEGIN////
-
-	//adding sqrt function entry
-	func_entry_array->function_entry_pointer->function_alias = "sqrt";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_sqrt;
-	func_entry_array->function_entry_pointer++;
-
-	//adding power function entry
-	func_entry_array->function_entry_pointer->function_alias = "pow";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_power;
-	func_entry_array->function_entry_pointer++;
-
-	//adding negative function entry
-	func_entry_array->function_entry_pointer->function_alias = "neg";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_negative;
-	func_entry_array->function_entry_pointer++;
-
-	//adding abs function entry
-	func_entry_array->function_entry_pointer->function_alias = "abs";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_abs;
-	func_entry_array->function_entry_pointer++;
-
-	//adding sinus function entry
-	func_entry_array->function_entry_pointer->function_alias = "sin";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_sin;
-	func_entry_array->function_entry_pointer++;
-
-	//adding cosin function entry
-	func_entry_array->function_entry_pointer->function_alias = "cos";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_cos;
-	func_entry_array->function_entry_pointer++;
-
-	//adding arccosin function entry
-	func_entry_array->function_entry_pointer->function_alias = "arccos";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_arccos;
-	func_entry_array->function_entry_pointer++;
-
-	//adding tangent function entry
-	func_entry_array->function_entry_pointer->function_alias = "tan";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_tan;
-	func_entry_array->function_entry_pointer++;
-
-	//adding cotangent function entry
-	func_entry_array->function_entry_pointer->function_alias = "cotan";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_cotan;
-	func_entry_array->function_entry_pointer++;
-
-	//adding natual logarithm function entry
-	func_entry_array->function_entry_pointer->function_alias = "ln";
-	func_entry_array->function_entry_pointer->pointer_on_function = &stack_ln;
-	func_entry_array->function_entry_pointer++;
-
-	////FUNCTION SECTION END////
-
-	func_entry_array->function_entry_pointer = func_entry_array->function_entry_pointer_origin_position;
-
-	return func_entry_array;
+	return SIMD_ADD(x, SIMD_MULTIPLY(v, SIMD_ADD(SIMD_SET(S1), SIMD_MULTIPLY(z, r))));
 }
 
 
 /**********************************************************************************************************
-NAME  : IS OPERATION
-LIBS  : string.h
-NOTES : return 0 if there is no operation with such alias, 1 if there is operation with such alias.
+NAME  : CALCULATE VECTOR COS POLYNOMIAL
+LIBS  : -
+NOTES : cos(x + y) for |x| <= pi/4. For 1 ulp 1 - x^2 / 2 is split as (1 - qx) - (x^2 / 2 - qx), where qx
+        is exact number close to x / 4, so both differences are exact.
 **********************************************************************************************************/
-int is_operation(char* operation_alias)
+SIMD_DOUBLE calculate_vector_cos_polynomial(SIMD_DOUBLE x, SIMD_DOUBLE y, int accuracy)
 {
-	struct operation_entry_array* operation_entry_array = get_math_operations_entries_array();
-
-	for (size_t i = 0; i < operation_entry_array->array_capacity; i++)
+	const double C1 = 4.16666666666666019037e-02;
+	const double C2 = -1.38888888888741095749e-03;
+	const double C3 = 2.48015872894767294178e-05;
+	const double C4 = -2.75573143513906633035e-07;
+	const double C5 = 2.08757232129817482790e-09;
+	const double C6 = -1.13596475577881948265e-11;
+	const double SMALL_ARGUMENT = 0.3;
+	const double BIG_ARGUMENT = 0.78125;
+	const double BIG_ARGUMENT_QX = 0.28125;
+	const SIMD_DOUBLE HALF = SIMD_SET(0.5);
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+
+	SIMD_DOUBLE z = SIMD_MULTIPLY(x, x);
+	SIMD_DOUBLE r = SIMD_ADD(SIMD_SET(C5), SIMD_MULTIPLY(z, SIMD_SET(C6)));
+	r = SIMD_ADD(SIMD_SET(C4), SIMD_MULTIPLY(z, r));
+	r = SIMD_ADD(SIMD_SET(C3), SIMD_MULTIPLY(z, r));
+	r = SIMD_ADD(SIMD_SET(C2), SIMD_MULTIPLY(z, r));
+	r = SIMD_ADD(SIMD_SET(C1), SIMD_MULTIPLY(z, r));
+	r = SIMD_MULTIPLY(z, r);
+
+	if (accuracy == BATCH_ACCURACY_ONE_ULP)
 	{
-		if (strcmp(operation_alias, operation_entry_array->operation_entry_pointer->operation_alias) == 0)
-		{
-			free_operation_entry_array(operation_entry_array);
-			return 1;
-		}
-		else
-		{
-			operation_entry_array->operation_entry_pointer++;
-		}
+		SIMD_DOUBLE magnitude = SIMD_AND_NOT(SIMD_SET(-0.0), x);
+		SIMD_DOUBLE qx = SIMD_AND(SIMD_MULTIPLY(magnitude, SIMD_SET(0.25)),
+			SIMD_SET(get_double_from_bits(0xFFFFFFFF00000000ULL)));
+		qx = SIMD_SELECT(SIMD_MORE(magnitude, SIMD_SET(BIG_ARGUMENT)), SIMD_SET(BIG_ARGUMENT_QX), qx);
+		qx = SIMD_AND_NOT(SIMD_LESS(magnitude, SIMD_SET(SMALL_ARGUMENT)), qx);
+
+		SIMD_DOUBLE hz = SIMD_SUBTRACT(SIMD_MULTIPLY(HALF, z), qx);
+		SIMD_DOUBLE a = SIMD_SUBTRACT(ONE, qx);
+		return SIMD_SUBTRACT(a, SIMD_SUBTRACT(hz, SIMD_SUBTRACT(SIMD_MULTIPLY(z, r), SIMD_MULTIPLY(x, y))));
 	}
 
-	free_operation_entry_array(operation_entry_array);
-	return 0;
+	return SIMD_SUBTRACT(ONE, SIMD_SUBTRACT(SIMD_MULTIPLY(HALF, z), SIMD_MULTIPLY(z, r)));
 }
 
 
 /**********************************************************************************************************
-NAME  : IS FUNCTION
-LIBS  : string.h
-NOTES : return 0 if there is no function with such alias, 1 if there is function with such alias.
+NAME  : CALCULATE VECTOR TAN POLYNOMIAL
+LIBS  : -
+NOTES : tan(x + y) for |x| <= pi/4 in lanes where "is_odd" is not set, -1 / tan(x + y) where it is set.
+        Near pi/4 tan is calculated as tan(pi/4 - x), and -1 / tan is divided with correction of rounding.
 **********************************************************************************************************/
-int is_function(char* function_alias)
+SIMD_DOUBLE calculate_vector_tan_polynomial(SIMD_DOUBLE x, SIMD_DOUBLE y, SIMD_DOUBLE is_odd)
 {
-	struct function_entry_array* func_entry_array = get_math_functions_entries_array();
-
-	for (size_t i = 0; i < func_entry_array->array_capacity; i++)
+	const double T[] =
 	{
-		if (strcmp(function_alias, func_entry_array->function_entry_pointer->function_alias) == 0)
-		{
-			free_function_entry_array(func_entry_array);
-			return 1;
-		}
-		else
-		{
-			func_entry_array->function_entry_pointer++;
-		}
-	}
+		3.33333333333334091986e-01, 1.33333333333201242699e-01, 5.39682539762260521377e-02,
+		2.18694882948595424599e-02, 8.86323982359930005737e-03, 3.59207910759131235356e-03,
+		1.45620945432529025516e-03, 5.88041240820264096874e-04, 2.46463134818469906812e-04,
+		7.81794442939557092300e-05, 7.14072491382608190305e-05, -1.85586374855275456654e-05,
+		2.59073051863633712884e-05
+	};
+	const double PI_OVER_FOUR = 7.85398163397448278999e-01;
+	const double PI_OVER_FOUR_LOW = 3.06161699786838301793e-17;
+	const double BIG_ARGUMENT = 6.7434525489807128906e-01;
+	const SIMD_DOUBLE SIGN_BIT = SIMD_SET(-0.0);
+	const SIMD_DOUBLE HIGH_WORD_MASK = SIMD_SET(get_double_from_bits(0xFFFFFFFF00000000ULL));
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	const SIMD_DOUBLE TWO = SIMD_SET(2);
+
+	SIMD_DOUBLE sign = SIMD_AND(SIGN_BIT, x);
+	SIMD_DOUBLE is_big = SIMD_MORE_OR_EQUALS(SIMD_XOR(x, sign), SIMD_SET(BIG_ARGUMENT));
+	SIMD_DOUBLE reflected = SIMD_ADD(SIMD_SUBTRACT(SIMD_SET(PI_OVER_FOUR), SIMD_XOR(x, sign)),
+		SIMD_SUBTRACT(SIMD_SET(PI_OVER_FOUR_LOW), SIMD_XOR(y, sign)));
+	x = SIMD_SELECT(is_big, reflected, x);
+	y = SIMD_AND_NOT(is_big, y);
+
+	//odd and even coefficients are summed separately, so both chains are short.
+	SIMD_DOUBLE z = SIMD_MULTIPLY(x, x);
+	SIMD_DOUBLE w = SIMD_MULTIPLY(z, z);
+	SIMD_DOUBLE r = SIMD_ADD(SIMD_SET(T[9]), SIMD_MULTIPLY(w, SIMD_SET(T[11])));
+	r = SIMD_ADD(SIMD_SET(T[7]), SIMD_MULTIPLY(w, r));
+	r = SIMD_ADD(SIMD_SET(T[5]), SIMD_MULTIPLY(w, r));
+	r = SIMD_ADD(SIMD_SET(T[3]), SIMD_MULTIPLY(w, r));
+	r = SIMD_ADD(SIMD_SET(T[1]), SIMD_MULTIPLY(w, r));
+	SIMD_DOUBLE v = SIMD_ADD(SIMD_SET(T[10]), SIMD_MULTIPLY(w, SIMD_SET(T[12])));
+	v = SIMD_ADD(SIMD_SET(T[8]), SIMD_MULTIPLY(w, v));
+	v = SIMD_ADD(SIMD_SET(T[6]), SIMD_MULTIPLY(w, v));
+	v = SIMD_ADD(SIMD_SET(T[4]), SIMD_MULTIPLY(w, v));
+	v = SIMD_ADD(SIMD_SET(T[2]), SIMD_MULTIPLY(w, v));
+	v = SIMD_MULTIPLY(z, v);
+
+	SIMD_DOUBLE s = SIMD_MULTIPLY(z, x);
+	r = SIMD_ADD(y, SIMD_MULTIPLY(z, SIMD_ADD(SIMD_MULTIPLY(s, SIMD_ADD(r, v)), y)));
+	r = SIMD_ADD(r, SIMD_MULTIPLY(SIMD_SET(T[0]), s));
+	w = SIMD_ADD(x, r);
+
+	//near pi/4: (sign) * (iy - 2 * (x - (w^2 / (w + iy) - r))), iy is 1 for tan and -1 for -1 / tan.
+	SIMD_DOUBLE iy = SIMD_SELECT(is_odd, SIMD_SET(-1), ONE);
+	SIMD_DOUBLE big_result = SIMD_DIVIDE(SIMD_MULTIPLY(w, w), SIMD_ADD(w, iy));
+	big_result = SIMD_SUBTRACT(iy, SIMD_MULTIPLY(TWO, SIMD_SUBTRACT(x, SIMD_SUBTRACT(big_result, r))));
+	big_result = SIMD_XOR(big_result, sign);
+
+	//-1 / (x + r) with high parts of w and of quotient, whose products are exact.
+	SIMD_DOUBLE w_high = SIMD_AND(w, HIGH_WORD_MASK);
+	SIMD_DOUBLE w_low = SIMD_SUBTRACT(r, SIMD_SUBTRACT(w_high, x));
+	SIMD_DOUBLE quotient = SIMD_DIVIDE(SIMD_SET(-1), w);
+	SIMD_DOUBLE quotient_high = SIMD_AND(quotient, HIGH_WORD_MASK);
+	SIMD_DOUBLE residual = SIMD_ADD(ONE, SIMD_MULTIPLY(quotient_high, w_high));
+	SIMD_DOUBLE odd_result = SIMD_ADD(quotient_high,
+		SIMD_MULTIPLY(quotient, SIMD_ADD(residual, SIMD_MULTIPLY(quotient_high, w_low))));
+
+	return SIMD_SELECT(is_big, big_result, SIMD_SELECT(is_odd, odd_result, w));
+}
 
-	free_function_entry_array(func_entry_array);
-	return 0;
+
+/**********************************************************************************************************
+NAME  : GET QUADRANT MASK
+LIBS  : -
+NOTES : return mask of lanes where bit of quadrant ("bit" is 1 or 2) is set.
+**********************************************************************************************************/
+SIMD_DOUBLE get_quadrant_mask(SIMD_DOUBLE quadrant_bits, unsigned long long bit)
+{
+	return SIMD_NOT_EQUALS(SIMD_AND(quadrant_bits, SIMD_SET(get_double_from_bits(bit))), SIMD_SET(0));
 }
 
 
 /**********************************************************************************************************
-NAME  : CALCULATE STACK OPERATION
-LIBS  : string.h
-NOTES : -
+NAME  : CALCULATE VECTOR SIN COS
+LIBS  : -
+NOTES : sin of angle whose quadrant is "quadrant_bits" (cos is sin of quadrant + 1): quadrants 1 and 3 take
+        cos of reduced angle, quadrants 2 and 3 change sign.
 **********************************************************************************************************/
-void calculate_stack_operation(char* operation_alias, struct stack_double* stack_double)
+SIMD_DOUBLE calculate_vector_sin_cos(const struct vector_angle* angle, SIMD_DOUBLE quadrant_bits, int accuracy)
 {
-	struct operation_entry_array* operation_entry_array = get_math_operations_entries_array();
+	SIMD_DOUBLE sin_value = calculate_vector_sin_polynomial(angle->reduced_high, angle->reduced_low, accuracy);
+	SIMD_DOUBLE cos_value = calculate_vector_cos_polynomial(angle->reduced_high, angle->reduced_low, accuracy);
 
-	for (size_t i = 0; i < operation_entry_array->array_capacity; i++)
-	{
-		if (strcmp(operation_alias, operation_entry_array->operation_entry_pointer->operation_alias) == 0)
-		{
-			operation_entry_array->operation_entry_pointer->pointer_on_function(stack_double);
-			free_operation_entry_array(operation_entry_array);
-			return;
-		}
-		else
-		{
-			operation_entry_array->operation_entry_pointer++;
-		}
-	}
+	SIMD_DOUBLE result = SIMD_SELECT(get_quadrant_mask(quadrant_bits, 1), cos_value, sin_value);
 
-	throw_error(UNEXPECTED_ALIAS);
+	return SIMD_XOR(result, SIMD_AND(get_quadrant_mask(quadrant_bits, 2), SIMD_SET(-0.0)));
 }
 
 
 /**********************************************************************************************************
-NAME  : CALCULATE STACK FUNCTION
+NAME  : CALCULATE VECTOR TAN
 LIBS  : -
-NOTES : -
+NOTES : tan of angle, or cotan if "is_cotan" is 1: cotan is 1 / tan(x) as in "batch_cotan()". Near pole tan
+        is -1 / reduced angle, lanes where reduced angle is tiny (|x| < 2^-28) are left to library.
 **********************************************************************************************************/
-void calculate_stack_function(char* function_alias, struct stack_double* stack_double)
+SIMD_DOUBLE calculate_vector_tan(struct vector_angle* angle, int is_cotan)
 {
-	struct function_entry_array* func_entry_array = get_math_functions_entries_array();
+	const double MIN_POLE_DISTANCE = 3.7252902984619141e-09;
 
-	for (size_t i = 0; i < func_entry_array->array_capacity; i++)
-	{
-		if (strcmp(function_alias, func_entry_array->function_entry_pointer->function_alias) == 0)
-		{
-			func_entry_array->function_entry_pointer->pointer_on_function(stack_double);
-			free_function_entry_array(func_entry_array);
-			return;
-		}
-		else
-		{
-			func_entry_array->function_entry_pointer++;
-		}
-	}
+	SIMD_DOUBLE is_odd = get_quadrant_mask(angle->quadrant_bits, 1);
+	SIMD_DOUBLE is_near_pole = SIMD_LESS(SIMD_AND_NOT(SIMD_SET(-0.0), angle->reduced_high),
+		SIMD_SET(MIN_POLE_DISTANCE));
+	angle->uncovered_lanes = SIMD_OR(angle->uncovered_lanes, SIMD_AND(is_odd, is_near_pole));
+
+	SIMD_DOUBLE result = calculate_vector_tan_polynomial(angle->reduced_high, angle->reduced_low, is_odd);
 
-	throw_error(UNEXPECTED_ALIAS);
+	return (is_cotan == 1) ? SIMD_DIVIDE(SIMD_SET(1), result) : result;
 }
 
 
 /**********************************************************************************************************
-NAME  : GET OPERATOR ASSOCIATIVITY
+NAME  : CALCULATE VECTOR ARCCOS
 LIBS  : -
-NOTES : -
+NOTES : for |x| < 0.5 arccos(x) = pi/2 - arcsin(x), otherwise arccos(x) = 2 * arcsin(sqrt((1 - |x|) / 2))
+        (pi minus it for negative x), arcsin(s) = s + s * r(s^2), r is ratio of polynomials. For 1 ulp
+        sqrt is split into high part and correction. "uncovered_lanes" gets lanes where |x| is not less
+        than 1.
 **********************************************************************************************************/
-int get_operator_associativity(const char* operation_alias)
+SIMD_DOUBLE calculate_vector_arccos(SIMD_DOUBLE x, int accuracy, SIMD_DOUBLE* uncovered_lanes)
 {
-	struct operation_entry_array* operation_entry_array = get_math_operations_entries_array();
-
-	for (size_t i = 0; i < operation_entry_array->array_capacity; i++)
+	const double P0 = 1.66666666666666657415e-01;
+	const double P1 = -3.25565818622400915405e-01;
+	const double P2 = 2.01212532134862925881e-01;
+	const double P3 = -4.00555345006794114027e-02;
+	const double P4 = 7.91534994289814532176e-04;
+	const double P5 = 3.47933107596021167570e-05;
+	const double Q1 = -2.40339491173441421878e+00;
+	const double Q2 = 2.02094576023350569471e+00;
+	const double Q3 = -6.88283971605453293030e-01;
+	const double Q4 = 7.70381505559019352791e-02;
+	const double PI = 3.14159265358979311600e+00;
+	const double PI_OVER_TWO_HIGH = 1.57079632679489655800e+00;
+	const double PI_OVER_TWO_LOW = 6.12323399573676603587e-17;
+	const SIMD_DOUBLE ZERO = SIMD_SET(0);
+	const SIMD_DOUBLE HALF = SIMD_SET(0.5);
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+	const SIMD_DOUBLE TWO = SIMD_SET(2);
+
+	SIMD_DOUBLE magnitude = SIMD_AND_NOT(SIMD_SET(-0.0), x);
+	SIMD_DOUBLE is_covered = SIMD_LESS(magnitude, ONE);
+	*uncovered_lanes = SIMD_XOR(is_covered, SIMD_EQUALS(ZERO, ZERO));
+
+	SIMD_DOUBLE is_small = SIMD_LESS(magnitude, HALF);
+	SIMD_DOUBLE z = SIMD_SELECT(is_small, SIMD_MULTIPLY(x, x), SIMD_MULTIPLY(SIMD_SUBTRACT(ONE, magnitude), HALF));
+
+	SIMD_DOUBLE p = SIMD_ADD(SIMD_SET(P4), SIMD_MULTIPLY(z, SIMD_SET(P5)));
+	p = SIMD_ADD(SIMD_SET(P3), SIMD_MULTIPLY(z, p));
+	p = SIMD_ADD(SIMD_SET(P2), SIMD_MULTIPLY(z, p));
+	p = SIMD_ADD(SIMD_SET(P1), SIMD_MULTIPLY(z, p));
+	p = SIMD_ADD(SIMD_SET(P0), SIMD_MULTIPLY(z, p));
+	p = SIMD_MULTIPLY(z, p);
+	SIMD_DOUBLE q = SIMD_ADD(SIMD_SET(Q3), SIMD_MULTIPLY(z, SIMD_SET(Q4)));
+	q = SIMD_ADD(SIMD_SET(Q2), SIMD_MULTIPLY(z, q));
+	q = SIMD_ADD(SIMD_SET(Q1), SIMD_MULTIPLY(z, q));
+	q = SIMD_ADD(ONE, SIMD_MULTIPLY(z, q));
+	SIMD_DOUBLE r = SIMD_DIVIDE(p, q);
+
+	//uncovered lanes have negative z, their sqrt is NAN and is replaced later.
+	SIMD_DOUBLE s = SIMD_SQRT(z);
+	SIMD_DOUBLE small_result;
+	SIMD_DOUBLE negative_result;
+	SIMD_DOUBLE positive_result;
+	if (accuracy == BATCH_ACCURACY_ONE_ULP)
 	{
-		if (strcmp(operation_alias, operation_entry_array->operation_entry_pointer->operation_alias) == 0)
-		{
-			return operation_entry_array->operation_entry_pointer->operator_associativity;
-		}
-		else
-		{
-			operation_entry_array->operation_entry_pointer++;
-		}
+		small_result = SIMD_SUBTRACT(SIMD_SET(PI_OVER_TWO_HIGH),
+			SIMD_SUBTRACT(x, SIMD_SUBTRACT(SIMD_SET(PI_OVER_TWO_LOW), SIMD_MULTIPLY(x, r))));
+		negative_result = SIMD_SUBTRACT(SIMD_MULTIPLY(r, s), SIMD_SET(PI_OVER_TWO_LOW));
+		negative_result = SIMD_SUBTRACT(SIMD_SET(PI), SIMD_MULTIPLY(TWO, SIMD_ADD(s, negative_result)));
+
+		//sqrt(z) = s_high + correction, s_high has 21 bits, so s_high^2 is exact.
+		SIMD_DOUBLE s_high = SIMD_AND(s, SIMD_SET(get_double_from_bits(0xFFFFFFFF00000000ULL)));
+		SIMD_DOUBLE correction = SIMD_DIVIDE(SIMD_SUBTRACT(z, SIMD_MULTIPLY(s_high, s_high)), SIMD_ADD(s, s_high));
+		positive_result = SIMD_ADD(SIMD_MULTIPLY(r, s), correction);
+		positive_result = SIMD_MULTIPLY(TWO, SIMD_ADD(s_high, positive_result));
+	}
+	else
+	{
+		small_result = SIMD_SUBTRACT(SIMD_SET(PI_OVER_TWO_HIGH), SIMD_ADD(x, SIMD_MULTIPLY(x, r)));
+		positive_result = SIMD_MULTIPLY(TWO, SIMD_ADD(s, SIMD_MULTIPLY(s, r)));
+		negative_result = SIMD_SUBTRACT(SIMD_SET(PI), positive_result);
 	}
 
-	throw_error(UNEXPECTED_ALIAS);
+	return SIMD_SELECT(is_small, small_result, SIMD_SELECT(SIMD_LESS(x, ZERO), negative_result, positive_result));
 }
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////
-////STACK MATHEMATICAL FUNCTIONS SECTION END////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**********************************************************************************************************
+NAME  : CALCULATE VECTOR LN
+LIBS  : float.h
+NOTES : x = 2^k * (1 + f), 1 + f in [sqrt(2) / 2, sqrt(2)), ln(1 + f) = 2s + s * R(s^2), s = f / (2 + f).
+        For 1 ulp k * ln(2) is split into high part, whose product by k is exact, and low part. Exponent
+        and mantissa are taken from bits, so "uncovered_lanes" gets lanes which are not positive normal
+        numbers.
+**********************************************************************************************************/
+SIMD_DOUBLE calculate_vector_ln(SIMD_DOUBLE x, int accuracy, SIMD_DOUBLE* uncovered_lanes)
+{
+	const double LG1 = 6.666666666666735130e-01;
+	const double LG2 = 3.999999999940941908e-01;
+	const double LG3 = 2.857142874366239149e-01;
+	const double LG4 = 2.222219843214978396e-01;
+	const double LG5 = 1.818357216161805012e-01;
+	const double LG6 = 1.531383769920937332e-01;
+	const double LG7 = 1.479819860511658591e-01;
+	const double LN2 = 6.93147180559945286227e-01;
+	const double LN2_HIGH = 6.93147180369123816490e-01;
+	const double LN2_LOW = 1.90821492927058770002e-10;
+	const double EXPONENT_BIAS = 1023;
+	const double HIGH_WORD_EXPONENT_SCALE = 1.0 / (1 << 20);
+	const double SQRT2_MANTISSA = 1.41420745849609375;
+	const SIMD_DOUBLE HALF = SIMD_SET(0.5);
+	const SIMD_DOUBLE ONE = SIMD_SET(1);
+
+	SIMD_DOUBLE is_covered = SIMD_AND(SIMD_MORE_OR_EQUALS(x, SIMD_SET(DBL_MIN)),
+		SIMD_MORE_OR_EQUALS(SIMD_SET(DBL_MAX), x));
+	*uncovered_lanes = SIMD_XOR(is_covered, SIMD_EQUALS(ONE, ONE));
+
+	SIMD_DOUBLE exponent_bits = SIMD_AND(x, SIMD_SET(get_double_from_bits(0x7FF0000000000000ULL)));
+	SIMD_DOUBLE k = SIMD_SUBTRACT(SIMD_MULTIPLY(SIMD_HIGH_WORDS(exponent_bits), SIMD_SET(HIGH_WORD_EXPONENT_SCALE)),
+		SIMD_SET(EXPONENT_BIAS));
+	SIMD_DOUBLE mantissa = SIMD_OR(SIMD_AND(x, SIMD_SET(get_double_from_bits(0x000FFFFFFFFFFFFFULL))), ONE);
+
+	SIMD_DOUBLE is_big = SIMD_MORE_OR_EQUALS(mantissa, SIMD_SET(SQRT2_MANTISSA));
+	mantissa = SIMD_SELECT(is_big, SIMD_MULTIPLY(mantissa, HALF), mantissa);
+	k = SIMD_ADD(k, SIMD_AND(is_big, ONE));
+
+	SIMD_DOUBLE f = SIMD_SUBTRACT(mantissa, ONE);
+	SIMD_DOUBLE s = SIMD_DIVIDE(f, SIMD_ADD(SIMD_SET(2), f));
+	SIMD_DOUBLE z = SIMD_MULTIPLY(s, s);
+	SIMD_DOUBLE w = SIMD_MULTIPLY(z, z);
+	SIMD_DOUBLE t1 = SIMD_ADD(SIMD_SET(LG4), SIMD_MULTIPLY(w, SIMD_SET(LG6)));
+	t1 = SIMD_MULTIPLY(w, SIMD_ADD(SIMD_SET(LG2), SIMD_MULTIPLY(w, t1)));
+	SIMD_DOUBLE t2 = SIMD_ADD(SIMD_SET(LG5), SIMD_MULTIPLY(w, SIMD_SET(LG7)));
+	t2 = SIMD_ADD(SIMD_SET(LG3), SIMD_MULTIPLY(w, t2));
+	t2 = SIMD_MULTIPLY(z, SIMD_ADD(SIMD_SET(LG1), SIMD_MULTIPLY(w, t2)));
+	SIMD_DOUBLE r = SIMD_ADD(t2, t1);
+
+	if (accuracy == BATCH_ACCURACY_ONE_ULP)
+	{
+		//k * ln2_high - ((f^2 / 2 - (s * (f^2 / 2 + R) + k * ln2_low)) - f)
+		SIMD_DOUBLE half_f_square = SIMD_MULTIPLY(SIMD_MULTIPLY(HALF, f), f);
+		SIMD_DOUBLE result = SIMD_ADD(SIMD_MULTIPLY(s, SIMD_ADD(half_f_square, r)),
+			SIMD_MULTIPLY(k, SIMD_SET(LN2_LOW)));
+		result = SIMD_SUBTRACT(SIMD_SUBTRACT(half_f_square, result), f);
+		return SIMD_SUBTRACT(SIMD_MULTIPLY(k, SIMD_SET(LN2_HIGH)), result);
+	}
 
+	//k * ln2 + (f - s * (f - R))
+	return SIMD_ADD(SIMD_MULTIPLY(k, SIMD_SET(LN2)), SIMD_SUBTRACT(f, SIMD_MULTIPLY(s, SIMD_SUBTRACT(f, r))));
+}
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-////STACK MACHINE SECTION///////////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /**********************************************************************************************************
-NAME  : IS NUMBER
-LIBS  : string.h, ctype.h
-NOTES : return 1 if string is a number, 0 if not.
+NAME  : CALCULATE UNCOVERED LANES
+LIBS  : -
+NOTES : calculates lanes of "uncovered_lanes" mask by batch function, one row at a time. "results" already
+        keep vector results, "arguments" are arguments of these lanes.
 **********************************************************************************************************/
-int is_number(char* string_pointer)
+void calculate_uncovered_lanes(double* results, SIMD_DOUBLE arguments, int uncovered_lanes, int* row_errors,
+	void(*pointer_on_batch_function)(double*, const double*, size_t, int*))
 {
-	//check for first character (must be minus or digit).
-	char MINUS[] = { "-" };
-	if (*string_pointer != MINUS[0] && isdigit(*string_pointer) == 0)
+	if (uncovered_lanes == 0)
 	{
-		return 0;
+		return;
 	}
 
-	string_pointer++;
-
-	//check for dot (only one dot permitted, it must be digits to the left and right of dot).
-	const char DOT[] = { "." };
-	int is_there_dot = 0; //false
-	size_t string_length = strlen(string_pointer);
-	for (size_t i = 0; i < string_length; i++)
+	double lane_arguments[SIMD_WIDTH];
+	SIMD_STORE(lane_arguments, arguments);
+	for (size_t lane = 0; uncovered_lanes != 0; lane++, uncovered_lanes >>= 1)
 	{
-		if (*string_pointer == DOT[0])
-		{
-			if (is_there_dot == 0)
-			{
-				if (isdigit(*(string_pointer - 1)) != 0 && isdigit(*(string_pointer + 1)) != 0)
-				{
-					is_there_dot = 1;
-					string_pointer++;
-				}
-				else
-				{
-					return 0;
-				}
-			}
-			else
-			{
-				return 0;
-			}
-		}
-		//check for digit.
-		else if (isdigit(*string_pointer) != 0)
-		{
-			string_pointer++;
-		}
-		else
+		if (uncovered_lanes & 1)
 		{
-			return 0;
+			results[lane] = lane_arguments[lane];
+			pointer_on_batch_function(results + lane, NULL, 1, row_errors + lane);
 		}
 	}
-
-	if (strcmp(--string_pointer, "-") == 0 && strlen(string_pointer) == 1)
-	{
-		return 0;
-	}
-
-	return 1;
 }
 
+#endif
+
 
 /**********************************************************************************************************
-NAME  : CONVERT INFIX TO POSTFIX
-LIBS  : string.h
-NOTES : -
+NAME  : VECTOR TRIGONOMETRIC
+LIBS  : -
+NOTES : common loop of vector "sin", "cos", "tan" and "cotan", "batch_function" is exact version which
+        calculates uncovered lanes and rest of rows.
 **********************************************************************************************************/
-char* convert_infix_to_postfix(char* expression)
+void vector_trigonometric(double* first_operand, size_t rows_count, int* row_errors, int accuracy,
+	int trigonometric_function, void(*pointer_on_batch_function)(double*, const double*, size_t, int*))
 {
-	const char TOKEN_DELIMITER[2]     = " ";
-	const char ARGUMENTS_DELIMITER[2] = ",";
-	const char OPENING_BRACKET[2]     = "(";
-	const char CLOSING_BRACKET[2]     = ")";
+	size_t i = 0;
 
-	const size_t STACK_CAPACITY = 64;
-	struct stack_string* stack = stack_string_initialize(STACK_CAPACITY);
-
-	const size_t MAX_CHARACTERS = 256;
-	char* result_postfix_expression = calloc(MAX_CHARACTERS, sizeof(char));
-
-	char* token;
-
-	token = strtok(expression, TOKEN_DELIMITER);
-	struct string* token_as_string = calloc(1, sizeof(struct string));
-	token_as_string->char_pointer = token;
+#if defined(SIMD_WIDTH)
+	//cos(x) is sin of the next quadrant, so 1 is added to the lowest bit of quadrant.
+	const SIMD_DOUBLE NEXT_QUADRANT = SIMD_SET(1);
 
-	//Using shunting-yard algorithm
-	while (token != NULL)
+	for (; accuracy != BATCH_ACCURACY_EXACT && i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		token_as_string->char_pointer = token;
-		if (is_number(token) == 1)
-		{
-			strcat(result_postfix_expression, token);
-			strcat(result_postfix_expression, TOKEN_DELIMITER);
-		}
-		else if (is_function(token) == 1)
-		{
-			push_stack_string(stack, token_as_string);
-		}
-		else if (strcmp(token, ARGUMENTS_DELIMITER) == 0)
-		{
-			while (strcmp(peek_stack_string(stack)->char_pointer, OPENING_BRACKET) != 0)
-			{
-				struct string* operator = pop_stack_string(stack);
-				strcat(result_postfix_expression, operator->char_pointer);
-				strcat(result_postfix_expression, TOKEN_DELIMITER);
-			}
-		}
-		else if (is_operation(token) == 1)
-		{
-			while (is_operation(peek_stack_string(stack)->char_pointer) == 1)
-			{
-				if (get_operator_associativity(token) <=
-					get_operator_associativity(peek_stack_string(stack)->char_pointer))
-				{
-					strcat(result_postfix_expression, pop_stack_string(stack)->char_pointer);
-					strcat(result_postfix_expression, TOKEN_DELIMITER);
-				}
-				else
-				{
-					break;
-				}
-			}
+		SIMD_DOUBLE argument = SIMD_LOAD(first_operand + i);
+		struct vector_angle angle;
+		reduce_vector_angle(argument, accuracy, &angle);
 
-			push_stack_string(stack, token_as_string);
-		}
-		else if (strcmp(token, OPENING_BRACKET) == 0)
-		{
-			push_stack_string(stack, token_as_string);
-		}
-		else if (strcmp(token, CLOSING_BRACKET) == 0)
+		SIMD_DOUBLE result;
+		switch (trigonometric_function)
 		{
-			while (strcmp(peek_stack_string(stack)->char_pointer, OPENING_BRACKET) != 0)
-			{
-				strcat(result_postfix_expression, pop_stack_string(stack)->char_pointer);
-				strcat(result_postfix_expression, TOKEN_DELIMITER);
-			}
+			case VECTOR_SIN:
+				result = calculate_vector_sin_cos(&angle, angle.quadrant_bits, accuracy);
+				break;
 
-			pop_stack_string(stack);
+			case VECTOR_COS:
+				result = calculate_vector_sin_cos(&angle, SIMD_ADD(angle.quadrant_bits, NEXT_QUADRANT), accuracy);
+				break;
 
-			if (is_function(peek_stack_string(stack)->char_pointer) == 1)
-			{
-				strcat(result_postfix_expression, pop_stack_string(stack)->char_pointer);
-				strcat(result_postfix_expression, TOKEN_DELIMITER);
-			}
+			default:
+				result = calculate_vector_tan(&angle, (trigonometric_function == VECTOR_COTAN));
 		}
 
-		token = strtok(NULL, TOKEN_DELIMITER);
-	}
-
-	while (stack->current_elements_count != 0)
-	{
-		strcat(result_postfix_expression, pop_stack_string(stack)->char_pointer);
-		strcat(result_postfix_expression, TOKEN_DELIMITER);
+		SIMD_STORE(first_operand + i, result);
+		calculate_uncovered_lanes(first_operand + i, argument, SIMD_MOVE_MASK(angle.uncovered_lanes),
+			row_errors + i, pointer_on_batch_function);
 	}
+#endif
 
-	stack_string_free(stack);
-	return result_postfix_expression;
+	pointer_on_batch_function(first_operand + i, NULL, rows_count - i, row_errors + i);
 }
 
 
 /**********************************************************************************************************
-NAME  : IS THERE WHERE KEYWORD
-LIBS  : string.h
-NOTES : return 1 if string contains "where" keyword, 0 if not.
+NAME  : VECTOR SIN
+LIBS  : -
+NOTES : version of "batch_sin()" with selected accuracy, the same for other vector functions.
 **********************************************************************************************************/
-int is_there_where_keyword(const char* expression)
+void vector_sin(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors,
+	int accuracy)
 {
-	const char* TOKEN_DELIMITER = " ";
-	const char* WHERE_KEYWORD = "|";
-
-	const size_t MAX_CHARACTERS = 256;
-	char* this_expression = calloc(MAX_CHARACTERS, sizeof(char));
-	this_expression = strcpy(this_expression, expression);
-
-	int is_there_where = 0; //false
-	char* token = strtok(this_expression, TOKEN_DELIMITER);
-	while (token != NULL)
-	{
-		if (strcmp(token, WHERE_KEYWORD) == 0)
-		{
-			is_there_where = 1;
-			break;
-		}
-		else
-		{
-			token = strtok(NULL, TOKEN_DELIMITER);
-		}
-	}
+	vector_trigonometric(first_operand, rows_count, row_errors, accuracy, VECTOR_SIN, &batch_sin);
+}
 
-	free(this_expression);
 
-	return is_there_where;
+/**********************************************************************************************************
+NAME  : VECTOR COS
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void vector_cos(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors,
+	int accuracy)
+{
+	vector_trigonometric(first_operand, rows_count, row_errors, accuracy, VECTOR_COS, &batch_cos);
 }
 
 
 /**********************************************************************************************************
-NAME  : GET FORMULA FROM EXPRESSION
-LIBS  : string.h
-NOTES : returned pointer on formula must be passed to "free()" after use.
+NAME  : VECTOR TAN
+LIBS  : -
+NOTES : -
 **********************************************************************************************************/
-char* get_formula_from_expression(char* expression)
+void vector_tan(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors,
+	int accuracy)
 {
-	const char* SPLIT_KEYWORD = "|";
+	vector_trigonometric(first_operand, rows_count, row_errors, accuracy, VECTOR_TAN, &batch_tan);
+}
 
-	char* this_expression = _strdup(expression);
-	char* formula = strtok(this_expression, SPLIT_KEYWORD);
 
-	return formula;
+/**********************************************************************************************************
+NAME  : VECTOR COTAN
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void vector_cotan(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors,
+	int accuracy)
+{
+	vector_trigonometric(first_operand, rows_count, row_errors, accuracy, VECTOR_COTAN, &batch_cotan);
 }
 
 
 /**********************************************************************************************************
-NAME  : GET VALUES FROM EXPRESSION
-LIBS  : string.h
-NOTES : returned pointer on values must be passed to "free()" after use.
+NAME  : VECTOR ARCCOS
+LIBS  : -
+NOTES : -
 **********************************************************************************************************/
-char* get_values_from_expression(char* expression)
+void vector_arccos(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors,
+	int accuracy)
 {
-	const char* SPLIT_KEYWORD = "|";
-
-	char* this_expression = _strdup(expression);
+	size_t i = 0;
 
-	char* values;
-	values = strtok(this_expression, SPLIT_KEYWORD);
-	strcpy(values, strtok(NULL, SPLIT_KEYWORD));
+#if defined(SIMD_WIDTH)
+	for (; accuracy != BATCH_ACCURACY_EXACT && i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
+	{
+		SIMD_DOUBLE argument = SIMD_LOAD(first_operand + i);
+		SIMD_DOUBLE uncovered_lanes;
+		SIMD_STORE(first_operand + i, calculate_vector_arccos(argument, accuracy, &uncovered_lanes));
+		calculate_uncovered_lanes(first_operand + i, argument, SIMD_MOVE_MASK(uncovered_lanes), row_errors + i,
+			&batch_arccos);
+	}
+#endif
 
-	return values;
+	batch_arccos(first_operand + i, NULL, rows_count - i, row_errors + i);
 }
 
 
 /**********************************************************************************************************
-NAME  : GET VALUE DICTIONARY
-LIBS  : string.h
-NOTES : -
+NAME  : VECTOR LN
+LIBS  : -
+NOTES : not positive arguments go to "batch_ln()", which writes their errors.
 **********************************************************************************************************/
-struct dictionary* get_value_dictionary(char* values)
+void vector_ln(double* first_operand, const double* second_operand, size_t rows_count, int* row_errors,
+	int accuracy)
 {
-	const char* EQUALS_SIGN = '=';
-	const char* TOKEN_DELIMITER = " ";
+	size_t i = 0;
 
-	int dictionary_capacity = 0;
-	char* current_char = values;
-	const char* NULL_CHARACTER = "\0";
-	while (strcmp(current_char, NULL_CHARACTER) != 0)
+#if defined(SIMD_WIDTH)
+	for (; accuracy != BATCH_ACCURACY_EXACT && i + SIMD_WIDTH <= rows_count; i += SIMD_WIDTH)
 	{
-		if (current_char[0] == EQUALS_SIGN)
-		{
-			dictionary_capacity++;
+		SIMD_DOUBLE argument = SIMD_LOAD(first_operand + i);
+		SIMD_DOUBLE uncovered_lanes;
+		SIMD_STORE(first_operand + i, calculate_vector_ln(argument, accuracy, &uncovered_lanes));
+		calculate_uncovered_lanes(first_operand + i, argument, SIMD_MOVE_MASK(uncovered_lanes), row_errors + i,
+			&batch_ln);
+	}
+#endif
+
+	batch_ln(first_operand + i, NULL, rows_count - i, row_errors + i);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////VECTOR MATHEMATICAL FUNCTIONS SECTION END///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////INTERVAL MATHEMATICAL FUNCTIONS SECTION/////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Interval functions are versions of stack mathematical functions over sets of rows: every argument is interval
+which contains values of argument in all rows, function writes interval which contains results in all rows.
+Interval also tells if some row can give NAN without error (NAN is not inside of any interval) and if some row
+can fail. Intervals are used to prove that block of rows gives the same result in every row (see zone maps in
+batch evaluation), so they may be wider than needed but never narrower.
+
+Bounds of arithmetic are calculated with the same rounding as rows, rounding is monotonic, so rounded bounds
+still contain rounded results. Results of library functions (sin, acos, log, pow) are not guaranteed to be
+monotonic, so their bounds are moved outward by several units in the last place.
+
+Comparisons, logical operations and "if" look at intervals of lazy operands as "evaluate_compiled_formula()"
+looks at their values: operand which no row calculates does not pass its error.
+
+Every interval function takes array of intervals of arguments and writes result interval, result can be the
+same interval as the first argument (interval evaluation keeps its stack in place like stack functions do).
+
+*/
+
+/**********************************************************************************************************
+NAME  : INTERVAL
+LIBS  : -
+NOTES : "minimum" and "maximum" bound values of rows which give number, infinite bound means that value is not
+        bounded. Flags are 1 if some row can give NAN without error or fail.
+**********************************************************************************************************/
+struct interval
+{
+	double minimum;
+	double maximum;
+	int is_nan_possible;
+	int is_error_possible;
+};
+
+
+/**********************************************************************************************************
+NAME  : SET INTERVAL
+LIBS  : math.h
+NOTES : bound which is NAN (like "inf - inf") means that nothing is known, so interval becomes unbounded and
+        NAN becomes possible.
+**********************************************************************************************************/
+void set_interval(struct interval* result, double minimum, double maximum, int is_nan_possible,
+	int is_error_possible)
+{
+	if (isnan(minimum) || isnan(maximum))
+	{
+		minimum = -INFINITY;
+		maximum = INFINITY;
+		is_nan_possible = 1;
+	}
+
+	result->minimum = minimum;
+	result->maximum = maximum;
+	result->is_nan_possible = is_nan_possible;
+	result->is_error_possible = is_error_possible;
+}
+
+
+/**********************************************************************************************************
+NAME  : SET UNBOUNDED INTERVAL
+LIBS  : math.h
+NOTES : nothing is known about values of rows, they can be NAN too.
+**********************************************************************************************************/
+void set_unbounded_interval(struct interval* result, int is_error_possible)
+{
+	set_interval(result, -INFINITY, INFINITY, 1, is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : WIDEN INTERVAL
+LIBS  : math.h
+NOTES : moves bounds outward by several units in the last place, it covers error of library function.
+**********************************************************************************************************/
+void widen_interval(struct interval* result)
+{
+	const int LIBRARY_ERROR_UNITS = 4;
+
+	for (int i = 0; i < LIBRARY_ERROR_UNITS; i++)
+	{
+		result->minimum = nextafter(result->minimum, -INFINITY);
+		result->maximum = nextafter(result->maximum, INFINITY);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : SET INTERVAL TRUTH
+LIBS  : -
+NOTES : result of comparison or logical operation is exactly 1 or 0 in every row, flags tell which of them
+        are proved for all rows.
+**********************************************************************************************************/
+void set_interval_truth(struct interval* result, int is_always_true, int is_always_false, int is_error_possible)
+{
+	set_interval(result, (is_always_true == 1) ? 1 : 0, (is_always_false == 1) ? 0 : 1, 0, is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : IS INTERVAL TRUE
+LIBS  : -
+NOTES : return 1 if every row is true (equals 1).
+**********************************************************************************************************/
+int is_interval_true(const struct interval* argument)
+{
+	return argument->is_nan_possible == 0 && argument->minimum == 1 && argument->maximum == 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : IS INTERVAL FALSE
+LIBS  : -
+NOTES : return 1 if no row is true (NAN is not true too).
+**********************************************************************************************************/
+int is_interval_false(const struct interval* argument)
+{
+	return argument->minimum > 1 || argument->maximum < 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : IS INTERVAL INFINITE
+LIBS  : math.h
+NOTES : return 1 if some row can be infinity.
+**********************************************************************************************************/
+int is_interval_infinite(const struct interval* argument)
+{
+	return isinf(argument->minimum) || isinf(argument->maximum);
+}
+
+
+/**********************************************************************************************************
+NAME  : IS INTERVAL CONTAINS
+LIBS  : -
+NOTES : return 1 if some row can be equal to value.
+**********************************************************************************************************/
+int is_interval_contains(const struct interval* argument, double value)
+{
+	return argument->minimum <= value && argument->maximum >= value;
+}
+
+
+/**********************************************************************************************************
+NAME  : IS PERIODIC POINT POSSIBLE
+LIBS  : math.h
+NOTES : return 1 if "offset + k * period" can be inside of interval for some integer k. Argument is reduced by
+        period with rounding, so point near bound is counted as inside.
+**********************************************************************************************************/
+int is_periodic_point_possible(const struct interval* argument, double offset, double period)
+{
+	const double REDUCTION_MARGIN = 1e-9;
+
+	double first_point = ceil((argument->minimum - offset) / period - REDUCTION_MARGIN);
+	double last_point = floor((argument->maximum - offset) / period + REDUCTION_MARGIN);
+
+	return first_point <= last_point;
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL ERRORS
+LIBS  : -
+NOTES : return 1 if some of arguments can fail.
+**********************************************************************************************************/
+int interval_errors(const struct interval* arguments, size_t arguments_count)
+{
+	int is_error_possible = 0;
+
+	for (size_t i = 0; i < arguments_count; i++)
+	{
+		is_error_possible |= arguments[i].is_error_possible;
+	}
+
+	return is_error_possible;
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL NANS
+LIBS  : -
+NOTES : return 1 if some of arguments can be NAN.
+**********************************************************************************************************/
+int interval_nans(const struct interval* arguments, size_t arguments_count)
+{
+	int is_nan_possible = 0;
+
+	for (size_t i = 0; i < arguments_count; i++)
+	{
+		is_nan_possible |= arguments[i].is_nan_possible;
+	}
+
+	return is_nan_possible;
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL ADD
+LIBS  : math.h
+NOTES : interval version of "stack_add()", infinities of different signs give NAN.
+**********************************************************************************************************/
+void interval_add(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	int is_nan_possible = interval_nans(arguments, 2) ||
+		(first->maximum == INFINITY && second->minimum == -INFINITY) ||
+		(first->minimum == -INFINITY && second->maximum == INFINITY);
+
+	set_interval(result, first->minimum + second->minimum, first->maximum + second->maximum, is_nan_possible,
+		interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL SUBTRACT
+LIBS  : math.h
+NOTES : interval version of "stack_subtract()", infinities of the same sign give NAN.
+**********************************************************************************************************/
+void interval_subtract(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	int is_nan_possible = interval_nans(arguments, 2) ||
+		(first->maximum == INFINITY && second->maximum == INFINITY) ||
+		(first->minimum == -INFINITY && second->minimum == -INFINITY);
+
+	set_interval(result, first->minimum - second->maximum, first->maximum - second->minimum, is_nan_possible,
+		interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL CORNERS
+LIBS  : math.h
+NOTES : writes the least and the greatest of four values calculated at bounds of arguments.
+**********************************************************************************************************/
+void interval_corners(struct interval* result, double first, double second, double third, double fourth)
+{
+	result->minimum = fmin(fmin(first, second), fmin(third, fourth));
+	result->maximum = fmax(fmax(first, second), fmax(third, fourth));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL MULTIPLY
+LIBS  : -
+NOTES : interval version of "stack_multiply()", the least and the greatest products are at bounds. Zero
+        multiplied by infinity gives NAN.
+**********************************************************************************************************/
+void interval_multiply(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+	int is_error_possible = interval_errors(arguments, 2);
+
+	if ((is_interval_contains(first, 0) && is_interval_infinite(second)) ||
+		(is_interval_contains(second, 0) && is_interval_infinite(first)))
+	{
+		set_unbounded_interval(result, is_error_possible);
+		return;
+	}
+
+	interval_corners(result, first->minimum * second->minimum, first->minimum * second->maximum,
+		first->maximum * second->minimum, first->maximum * second->maximum);
+	set_interval(result, result->minimum, result->maximum, interval_nans(arguments, 2), is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL DIVIDE
+LIBS  : -
+NOTES : interval version of "stack_divide()". Divisor which can be zero makes error possible, quotients of
+        other rows are not bounded then. Infinity divided by infinity gives NAN.
+**********************************************************************************************************/
+void interval_divide(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	if (is_interval_contains(second, 0) || (is_interval_infinite(first) && is_interval_infinite(second)))
+	{
+		set_unbounded_interval(result, 1);
+		return;
+	}
+
+	interval_corners(result, first->minimum / second->minimum, first->minimum / second->maximum,
+		first->maximum / second->minimum, first->maximum / second->maximum);
+	set_interval(result, result->minimum, result->maximum, interval_nans(arguments, 2),
+		interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL INTEGER DIVISION
+LIBS  : -
+NOTES : interval version of "stack_div()" and "stack_mod()". Operands are truncated to integers, so divisor
+        from -1 to 1 can fail, and so can NAN and operands out of int (INT_MIN itself is out, it fails with
+        divisor -1). Results are not bounded.
+**********************************************************************************************************/
+void interval_integer_division(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	int is_error_possible = interval_errors(arguments, 2) || interval_nans(arguments, 2) ||
+		(second->minimum < 1 && second->maximum > -1) || first->minimum <= INT_MIN ||
+		first->maximum >= INT_MAX + 1.0 || second->minimum <= INT_MIN - 1.0 || second->maximum >= INT_MAX + 1.0;
+	set_unbounded_interval(result, is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL SQRT
+LIBS  : math.h
+NOTES : interval version of "stack_sqrt()", negative operand and NAN fail. Square root is correctly rounded,
+        so bounds are exact.
+**********************************************************************************************************/
+void interval_sqrt(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* operand = &arguments[0];
+
+	int is_error_possible = operand->is_error_possible || operand->minimum < 0 || operand->is_nan_possible;
+	set_interval(result, sqrt(fmax(operand->minimum, 0)), sqrt(fmax(operand->maximum, 0)), 0,
+		is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL POWER
+LIBS  : math.h
+NOTES : interval version of "stack_power()". For positive base power is monotonic by every argument, so the
+        least and the greatest powers are at bounds. Base which can be zero (negative zero gives negative
+        infinity) or negative is not bounded.
+**********************************************************************************************************/
+void interval_power(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* base = &arguments[0];
+	const struct interval* exponent = &arguments[1];
+	int is_error_possible = interval_errors(arguments, 2);
+
+	if ((base->minimum > 0) == 0)
+	{
+		set_unbounded_interval(result, is_error_possible);
+		return;
+	}
+
+	interval_corners(result, pow(base->minimum, exponent->minimum), pow(base->minimum, exponent->maximum),
+		pow(base->maximum, exponent->minimum), pow(base->maximum, exponent->maximum));
+	widen_interval(result);
+	set_interval(result, result->minimum, result->maximum, interval_nans(arguments, 2), is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL NEGATIVE
+LIBS  : -
+NOTES : interval version of "stack_negative()".
+**********************************************************************************************************/
+void interval_negative(struct interval* result, const struct interval* arguments)
+{
+	set_interval(result, -arguments[0].maximum, -arguments[0].minimum, arguments[0].is_nan_possible,
+		arguments[0].is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL ABS
+LIBS  : math.h
+NOTES : interval version of "stack_abs()".
+**********************************************************************************************************/
+void interval_abs(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* operand = &arguments[0];
+
+	double minimum = is_interval_contains(operand, 0) ? 0 : fmin(fabs(operand->minimum), fabs(operand->maximum));
+	double maximum = fmax(fabs(operand->minimum), fabs(operand->maximum));
+
+	set_interval(result, minimum, maximum, operand->is_nan_possible, operand->is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL WAVE
+LIBS  : math.h
+NOTES : common part of sinus and cosine: values at bounds, extended to 1 (-1) if interval can contain
+        maximum (minimum) of wave. Infinity gives NAN, huge arguments are not reduced precisely, so they give
+        the whole range.
+**********************************************************************************************************/
+void interval_wave(struct interval* result, const struct interval* operand, double(*wave)(double),
+	double maximum_offset)
+{
+	const double PI = 3.14159265358979323846;
+	const double MAX_REDUCED_ARGUMENT = 1e6;
+
+	if (is_interval_infinite(operand) || fabs(operand->minimum) > MAX_REDUCED_ARGUMENT ||
+		fabs(operand->maximum) > MAX_REDUCED_ARGUMENT)
+	{
+		set_interval(result, -1, 1, 1, operand->is_error_possible);
+		return;
+	}
+
+	struct interval bounds = *operand;
+	bounds.minimum = fmin(wave(operand->minimum), wave(operand->maximum));
+	bounds.maximum = fmax(wave(operand->minimum), wave(operand->maximum));
+	widen_interval(&bounds);
+
+	if (is_periodic_point_possible(operand, maximum_offset, 2 * PI))
+	{
+		bounds.maximum = 1;
+	}
+	if (is_periodic_point_possible(operand, maximum_offset + PI, 2 * PI))
+	{
+		bounds.minimum = -1;
+	}
+
+	set_interval(result, fmax(bounds.minimum, -1), fmin(bounds.maximum, 1), bounds.is_nan_possible,
+		bounds.is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL SIN
+LIBS  : -
+NOTES : interval version of "stack_sin()", maximums are at "pi / 2 + 2 * k * pi".
+**********************************************************************************************************/
+void interval_sin(struct interval* result, const struct interval* arguments)
+{
+	const double HALF_PI = 1.57079632679489661923;
+
+	interval_wave(result, &arguments[0], &sin, HALF_PI);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL COS
+LIBS  : -
+NOTES : interval version of "stack_cos()", maximums are at "2 * k * pi".
+**********************************************************************************************************/
+void interval_cos(struct interval* result, const struct interval* arguments)
+{
+	interval_wave(result, &arguments[0], &cos, 0);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL ARCCOS
+LIBS  : math.h
+NOTES : interval version of "stack_arccos()", operand outside of [-1, 1] gives NAN. Arccosine is
+        decreasing.
+**********************************************************************************************************/
+void interval_arccos(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* operand = &arguments[0];
+
+	if (operand->maximum < -1 || operand->minimum > 1)
+	{
+		set_unbounded_interval(result, operand->is_error_possible);
+		return;
+	}
+
+	struct interval bounds = *operand;
+	bounds.minimum = acos(fmin(operand->maximum, 1));
+	bounds.maximum = acos(fmax(operand->minimum, -1));
+	widen_interval(&bounds);
+
+	int is_nan_possible = operand->is_nan_possible || operand->minimum < -1 || operand->maximum > 1;
+	set_interval(result, bounds.minimum, bounds.maximum, is_nan_possible, bounds.is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL TAN
+LIBS  : math.h
+NOTES : interval version of "stack_tan()", tangent is increasing between its poles "pi / 2 + k * pi".
+**********************************************************************************************************/
+void interval_tan(struct interval* result, const struct interval* arguments)
+{
+	const double PI = 3.14159265358979323846;
+	const double HALF_PI = 1.57079632679489661923;
+	const double MAX_REDUCED_ARGUMENT = 1e6;
+	const struct interval* operand = &arguments[0];
+
+	if (is_interval_infinite(operand) || fabs(operand->minimum) > MAX_REDUCED_ARGUMENT ||
+		fabs(operand->maximum) > MAX_REDUCED_ARGUMENT || is_periodic_point_possible(operand, HALF_PI, PI))
+	{
+		set_unbounded_interval(result, operand->is_error_possible);
+		return;
+	}
+
+	struct interval bounds = *operand;
+	bounds.minimum = tan(operand->minimum);
+	bounds.maximum = tan(operand->maximum);
+	widen_interval(&bounds);
+	set_interval(result, bounds.minimum, bounds.maximum, bounds.is_nan_possible, bounds.is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL COTAN
+LIBS  : math.h
+NOTES : interval version of "stack_cotan()", cotangent is decreasing between its poles "k * pi".
+**********************************************************************************************************/
+void interval_cotan(struct interval* result, const struct interval* arguments)
+{
+	const double PI = 3.14159265358979323846;
+	const double MAX_REDUCED_ARGUMENT = 1e6;
+	const struct interval* operand = &arguments[0];
+
+	if (is_interval_infinite(operand) || fabs(operand->minimum) > MAX_REDUCED_ARGUMENT ||
+		fabs(operand->maximum) > MAX_REDUCED_ARGUMENT || is_periodic_point_possible(operand, 0, PI))
+	{
+		set_unbounded_interval(result, operand->is_error_possible);
+		return;
+	}
+
+	struct interval bounds = *operand;
+	bounds.minimum = 1 / tan(operand->maximum);
+	bounds.maximum = 1 / tan(operand->minimum);
+	widen_interval(&bounds);
+	set_interval(result, bounds.minimum, bounds.maximum, bounds.is_nan_possible, bounds.is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL LN
+LIBS  : math.h
+NOTES : interval version of "stack_ln()", not positive operand and NAN fail. Logarithms of other rows are not
+        bounded below then.
+**********************************************************************************************************/
+void interval_ln(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* operand = &arguments[0];
+
+	if (operand->maximum <= 0)
+	{
+		set_unbounded_interval(result, 1);
+		return;
+	}
+
+	struct interval bounds;
+	bounds.minimum = (operand->minimum <= 0) ? -INFINITY : log(operand->minimum);
+	bounds.maximum = log(operand->maximum);
+	widen_interval(&bounds);
+
+	int is_error_possible = operand->is_error_possible || operand->minimum <= 0 || operand->is_nan_possible;
+	set_interval(result, bounds.minimum, bounds.maximum, 0, is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL MORE
+LIBS  : -
+NOTES : interval version of "stack_more()", NAN is not more than anything.
+**********************************************************************************************************/
+void interval_more(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	set_interval_truth(result, interval_nans(arguments, 2) == 0 && first->minimum > second->maximum,
+		first->maximum <= second->minimum, interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL LESS
+LIBS  : -
+NOTES : interval version of "stack_less()", NAN is not less than anything.
+**********************************************************************************************************/
+void interval_less(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	set_interval_truth(result, interval_nans(arguments, 2) == 0 && first->maximum < second->minimum,
+		first->minimum >= second->maximum, interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL MORE OR EQUALS
+LIBS  : -
+NOTES : interval version of "stack_more_or_equals()".
+**********************************************************************************************************/
+void interval_more_or_equals(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	set_interval_truth(result, interval_nans(arguments, 2) == 0 && first->minimum >= second->maximum,
+		first->maximum < second->minimum, interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL LESS OR EQUALS
+LIBS  : -
+NOTES : interval version of "stack_less_or_equals()".
+**********************************************************************************************************/
+void interval_less_or_equals(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	set_interval_truth(result, interval_nans(arguments, 2) == 0 && first->maximum <= second->minimum,
+		first->minimum > second->maximum, interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : IS INTERVAL EQUAL
+LIBS  : -
+NOTES : return 1 if every row of both arguments is the same number, return -1 if no row of arguments is
+        equal, otherwise 0.
+**********************************************************************************************************/
+int is_interval_equal(const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	if (first->maximum < second->minimum || first->minimum > second->maximum)
+	{
+		return -1;
+	}
+	if (interval_nans(arguments, 2) == 0 && first->minimum == first->maximum &&
+		second->minimum == second->maximum && first->minimum == second->minimum)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL EQUALS
+LIBS  : -
+NOTES : interval version of "stack_equals()".
+**********************************************************************************************************/
+void interval_equals(struct interval* result, const struct interval* arguments)
+{
+	int is_equal = is_interval_equal(arguments);
+	set_interval_truth(result, is_equal == 1, is_equal == -1, interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL NOT EQUALS
+LIBS  : -
+NOTES : interval version of "stack_not_equals()".
+**********************************************************************************************************/
+void interval_not_equals(struct interval* result, const struct interval* arguments)
+{
+	int is_equal = is_interval_equal(arguments);
+	set_interval_truth(result, is_equal == -1, is_equal == 1, interval_errors(arguments, 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL OR
+LIBS  : -
+NOTES : interval version of "stack_or()", the second operand fails only in rows whose first operand is not
+        true.
+**********************************************************************************************************/
+void interval_or(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	int is_error_possible = first->is_error_possible ||
+		(is_interval_true(first) == 0 && second->is_error_possible);
+	set_interval_truth(result, is_interval_true(first) || is_interval_true(second),
+		is_interval_false(first) && is_interval_false(second), is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL AND
+LIBS  : -
+NOTES : interval version of "stack_and()", the second operand fails only in rows whose first operand is
+        true.
+**********************************************************************************************************/
+void interval_and(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* first = &arguments[0];
+	const struct interval* second = &arguments[1];
+
+	int is_error_possible = first->is_error_possible ||
+		(is_interval_false(first) == 0 && second->is_error_possible);
+	set_interval_truth(result, is_interval_true(first) && is_interval_true(second),
+		is_interval_false(first) || is_interval_false(second), is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL NOT
+LIBS  : -
+NOTES : interval version of "stack_not()".
+**********************************************************************************************************/
+void interval_not(struct interval* result, const struct interval* arguments)
+{
+	set_interval_truth(result, is_interval_false(&arguments[0]), is_interval_true(&arguments[0]),
+		arguments[0].is_error_possible);
+}
+
+
+/**********************************************************************************************************
+NAME  : INTERVAL IF
+LIBS  : math.h
+NOTES : interval version of "stack_if()", branch which no row chooses does not pass its values and errors.
+**********************************************************************************************************/
+void interval_if(struct interval* result, const struct interval* arguments)
+{
+	const struct interval* condition = &arguments[0];
+	const struct interval* then_branch = &arguments[1];
+	const struct interval* else_branch = &arguments[2];
+
+	int is_error_possible = condition->is_error_possible;
+	if (is_interval_true(condition) == 1)
+	{
+		*result = *then_branch;
+	}
+	else if (is_interval_false(condition) == 1)
+	{
+		*result = *else_branch;
+	}
+	else
+	{
+		set_interval(result, fmin(then_branch->minimum, else_branch->minimum),
+			fmax(then_branch->maximum, else_branch->maximum),
+			then_branch->is_nan_possible || else_branch->is_nan_possible,
+			then_branch->is_error_possible || else_branch->is_error_possible);
+	}
+	result->is_error_possible |= is_error_possible;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////INTERVAL MATHEMATICAL FUNCTIONS SECTION END/////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////STACK MATHEMATICAL FUNCTIONS SECTION////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+If you want to add new math operation you need:
+1. Add new operation index constant after the last one and increase MATH_OPERATIONS_COUNT by one;
+
+2. Add new operation entry to "MATH_OPERATIONS" array by template:
+
+[OPERATION_INDEX] = { "operation alias", *operation associativity*, *addres of function which handle this
+operation*, *addres of batch function which handle this operation*, *addres of interval function which
+handle this operation* },
+
+3. Add alias of new operation to switch in function "get_operation_index()". Alias is either a word of
+letters (like "MOD") or one or two symbols (like "+"), lexer recognizes both kinds without changes.
+
+
+If you want to add new math function you need:
+1. Add new function index constant after the last one and increase MATH_FUNCTIONS_COUNT by one;
+
+2. Add new function entry to "MATH_FUNCTIONS" array by template:
+
+[FUNCTION_INDEX] = { "function alias", *count of function arguments*, *addres of function which handle this
+function*, *addres of batch function which handle this function*, *addres of interval function which handle
+this function* },
+
+3. Add alias of new function to switch in function "get_function_index()".
+
+*/
+
+/**********************************************************************************************************
+NAME  : STACK ADD
+LIBS  : -
+NOTES : this function implement stack add operation.
+**********************************************************************************************************/
+void stack_add(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	double sum = first_operand + second_operand;
+
+	push_stack_double(stack_pointer, sum);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK SUBTRACT
+LIBS  : -
+NOTES : this function implement stack subtract operation.
+**********************************************************************************************************/
+void stack_subtract(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	double difference = first_operand - second_operand;
+
+	push_stack_double(stack_pointer, difference);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK MULTIPLY
+LIBS  : -
+NOTES : this function implement stack multiply operation.
+**********************************************************************************************************/
+void stack_multiply(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	double product = first_operand * second_operand;
+
+	push_stack_double(stack_pointer, product);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK DIVIDE
+LIBS  : -
+NOTES : this function implement stack divide operation.
+**********************************************************************************************************/
+void stack_divide(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	if (second_operand != 0)
+	{
+		double quotient = first_operand / second_operand;
+
+		push_stack_double(stack_pointer, quotient);
+	}
+	else
+	{
+		set_stack_error(stack_pointer, ZERO_DIVISION);
+		push_stack_double(stack_pointer, NAN);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK SQRT
+LIBS  : math.h
+NOTES : this function implement stack operation of taking square root.
+**********************************************************************************************************/
+void stack_sqrt(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	if (operand >= 0)
+	{
+		double taking_result = sqrt(operand);
+
+		push_stack_double(stack_pointer, taking_result);
+	}
+	else
+	{
+		set_stack_error(stack_pointer, ROOT_OF_NEGATIVE);
+		push_stack_double(stack_pointer, NAN);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK POWER
+LIBS  : math.h
+NOTES : this function implement stack operation of exponentiation.
+**********************************************************************************************************/
+void stack_power(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	double power_result = pow(first_operand, second_operand);
+
+	push_stack_double(stack_pointer, power_result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK NEGATIVE
+LIBS  : math.h
+NOTES : this function implement stack operation of changing sign.
+**********************************************************************************************************/
+void stack_negative(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	double negative_result = operand * -1;
+
+	push_stack_double(stack_pointer, negative_result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK ABS
+LIBS  : math.h
+NOTES : this function implement stack operation of calculating absolute value of number.
+**********************************************************************************************************/
+void stack_abs(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	double abs_result = fabs(operand);
+
+	push_stack_double(stack_pointer, abs_result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK SIN
+LIBS  : math.h
+NOTES : this function implement stack operation of calculating sinus.
+**********************************************************************************************************/
+void stack_sin(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	double sin_result = sin(operand);
+
+	push_stack_double(stack_pointer, sin_result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK COS
+LIBS  : math.h
+NOTES : this function implement stack operation of calculating cosine.
+**********************************************************************************************************/
+void stack_cos(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	double cos_result = cos(operand);
+
+	push_stack_double(stack_pointer, cos_result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK ARCCOS
+LIBS  : math.h
+NOTES : this function implement stack operation of calculating arccosine.
+**********************************************************************************************************/
+void stack_arccos(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	double arccos_result = acos(operand);
+
+	push_stack_double(stack_pointer, arccos_result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK TAN
+LIBS  : math.h
+NOTES : this function implement stack operation of calculating tangent.
+**********************************************************************************************************/
+void stack_tan(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	double tan_result = tan(operand);
+	
+	push_stack_double(stack_pointer, tan_result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK COTAN
+LIBS  : math.h
+NOTES : this function implement stack operation of calculating cotangent.
+**********************************************************************************************************/
+void stack_cotan(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	double cotan_result = 1 / tan(operand);
+
+	push_stack_double(stack_pointer, cotan_result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK LN
+LIBS  : math.h
+NOTES : this function implement stack operation of calculating natural logarithm.
+**********************************************************************************************************/
+void stack_ln(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	if (operand > 0)
+	{
+		double natlog_result = log(operand);
+
+		push_stack_double(stack_pointer, natlog_result);
+	}
+	else
+	{
+		if (operand == 0)
+			set_stack_error(stack_pointer, LOG_OF_ZERO);
+		else
+			set_stack_error(stack_pointer, LOG_OF_NEGATIVE);
+
+		push_stack_double(stack_pointer, NAN);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK MORE
+LIBS  : ?
+NOTES : ?
+**********************************************************************************************************/
+void stack_more(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	int result = 0;
+	if (first_operand > second_operand)
+	{
+		result = 1;
+	}
+	else
+	{
+		result = 0;
+	}
+
+	push_stack_double(stack_pointer, result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK LESS
+LIBS  : ?
+NOTES : ?
+**********************************************************************************************************/
+void stack_less(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	int result = 0;
+	if (first_operand < second_operand)
+	{
+		result = 1;
+	}
+	else
+	{
+		result = 0;
+	}
+
+	push_stack_double(stack_pointer, result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK EQUALS
+LIBS  : ?
+NOTES : ?
+**********************************************************************************************************/
+void stack_equals(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	int result = 0;
+	if (first_operand == second_operand)
+	{
+		result = 1;
+	}
+	else
+	{
+		result = 0;
+	}
+
+	push_stack_double(stack_pointer, (double)result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK DIV
+LIBS  : stdlib.h
+NOTES : operands are truncated to integers, errors are the same as in "divide_integers()".
+**********************************************************************************************************/
+void stack_div(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	div_t division_result;
+	int error_code = divide_integers(first_operand, second_operand, &division_result);
+	if (error_code == NO_ERROR)
+	{
+		push_stack_double(stack_pointer, (double)division_result.quot);
+	}
+	else
+	{
+		set_stack_error(stack_pointer, error_code);
+		push_stack_double(stack_pointer, NAN);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK MOD
+LIBS  : stdlib.h
+NOTES : operands are truncated to integers, errors are the same as in "divide_integers()".
+**********************************************************************************************************/
+void stack_mod(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	div_t division_result;
+	int error_code = divide_integers(first_operand, second_operand, &division_result);
+	if (error_code == NO_ERROR)
+	{
+		push_stack_double(stack_pointer, (double)division_result.rem);
+	}
+	else
+	{
+		set_stack_error(stack_pointer, error_code);
+		push_stack_double(stack_pointer, NAN);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK OR
+LIBS  : ?
+NOTES : ?
+**********************************************************************************************************/
+void stack_or(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	int result = 0;
+	if (first_operand == 1 || second_operand == 1)
+	{
+		result = 1;
+	}
+	else
+	{
+		result = 0;
+	}
+	push_stack_double(stack_pointer, (double)result);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK MORE OR EQUALS
+LIBS  : -
+NOTES : pushes 1 if first operand is not less than second one, otherwise 0 (NAN is not comparable).
+**********************************************************************************************************/
+void stack_more_or_equals(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	push_stack_double(stack_pointer, (first_operand >= second_operand) ? 1 : 0);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK LESS OR EQUALS
+LIBS  : -
+NOTES : pushes 1 if first operand is not greater than second one, otherwise 0 (NAN is not comparable).
+**********************************************************************************************************/
+void stack_less_or_equals(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	push_stack_double(stack_pointer, (first_operand <= second_operand) ? 1 : 0);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK NOT EQUALS
+LIBS  : -
+NOTES : pushes 1 if operands are not equal, otherwise 0. NAN is not equal to everything, itself too.
+**********************************************************************************************************/
+void stack_not_equals(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	push_stack_double(stack_pointer, (first_operand != second_operand) ? 1 : 0);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK AND
+LIBS  : -
+NOTES : as in "stack_or()", only 1 is true. Pushes 1 if both operands are true, otherwise 0.
+**********************************************************************************************************/
+void stack_and(struct stack_double* stack_pointer)
+{
+	double second_operand = pop_stack_double(stack_pointer);
+	double first_operand = pop_stack_double(stack_pointer);
+
+	push_stack_double(stack_pointer, (first_operand == 1 && second_operand == 1) ? 1 : 0);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK NOT
+LIBS  : -
+NOTES : pushes 0 if operand is true (equals 1), otherwise 1.
+**********************************************************************************************************/
+void stack_not(struct stack_double* stack_pointer)
+{
+	double operand = pop_stack_double(stack_pointer);
+
+	push_stack_double(stack_pointer, (operand == 1) ? 0 : 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : STACK IF
+LIBS  : -
+NOTES : "if ( condition , x , y )" pushes x if condition is true (equals 1), otherwise y.
+**********************************************************************************************************/
+void stack_if(struct stack_double* stack_pointer)
+{
+	double third_operand = pop_stack_double(stack_pointer);
+	double second_operand = pop_stack_double(stack_pointer);
+	double condition = pop_stack_double(stack_pointer);
+
+	push_stack_double(stack_pointer, (condition == 1) ? second_operand : third_operand);
+}
+
+
+/**********************************************************************************************************
+NAME  : OPERATION ENTRY
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+struct operation_entry
+{
+	char* operation_alias;
+	int operator_associativity;
+	void(*pointer_on_function)(struct stack_double*);
+	void(*pointer_on_batch_function)(double*, const double*, size_t, int*);
+	void(*pointer_on_interval_function)(struct interval*, const struct interval*);
+};
+
+
+/**********************************************************************************************************
+NAME  : FUNCTION ENTRY
+LIBS  : -
+NOTES : "pointer_on_vector_function" is batch function with selectable accuracy, NULL if function has only
+        exact batch version.
+**********************************************************************************************************/
+struct function_entry
+{
+	char* function_alias;
+	size_t arguments_count;
+	void(*pointer_on_function)(struct stack_double*);
+	void(*pointer_on_batch_function)(double*, const double*, size_t, int*);
+	void(*pointer_on_interval_function)(struct interval*, const struct interval*);
+	void(*pointer_on_vector_function)(double*, const double*, size_t, int*, int);
+};
+
+
+//Indexes of operations in "MATH_OPERATIONS" array.
+#define OPERATION_ADD      0
+#define OPERATION_SUBTRACT 1
+#define OPERATION_MULTIPLY 2
+#define OPERATION_DIVIDE   3
+#define OPERATION_MORE     4
+#define OPERATION_LESS     5
+#define OPERATION_EQUALS   6
+#define OPERATION_OR       7
+#define OPERATION_DIV      8
+#define OPERATION_MOD      9
+#define OPERATION_AND            10
+#define OPERATION_MORE_OR_EQUALS 11
+#define OPERATION_LESS_OR_EQUALS 12
+#define OPERATION_NOT_EQUALS     13
+
+#define MATH_OPERATIONS_COUNT 14
+
+//Indexes of functions in "MATH_FUNCTIONS" array.
+#define FUNCTION_SQRT     0
+#define FUNCTION_POWER    1
+#define FUNCTION_NEGATIVE 2
+#define FUNCTION_ABS      3
+#define FUNCTION_SIN      4
+#define FUNCTION_COS      5
+#define FUNCTION_ARCCOS   6
+#define FUNCTION_TAN      7
+#define FUNCTION_COTAN    8
+#define FUNCTION_LN       9
+#define FUNCTION_NOT      10
+#define FUNCTION_IF       11
+
+#define MATH_FUNCTIONS_COUNT 12
+
+/**********************************************************************************************************
+NAME  : MATH OPERATIONS
+LIBS  : -
+NOTES : operation section where all mathematical operations listed. It is read-only data, so it is built
+        once by compiler and never allocated at run time.
+**********************************************************************************************************/
+const struct operation_entry MATH_OPERATIONS[MATH_OPERATIONS_COUNT] =
+{
+	[OPERATION_ADD]            = { "+",   3, &stack_add,            &batch_add,            &interval_add },
+	[OPERATION_SUBTRACT]       = { "-",   3, &stack_subtract,       &batch_subtract,       &interval_subtract },
+	[OPERATION_MULTIPLY]       = { "*",   4, &stack_multiply,       &batch_multiply,       &interval_multiply },
+	[OPERATION_DIVIDE]         = { "/",   4, &stack_divide,         &batch_divide,         &interval_divide },
+	[OPERATION_MORE]           = { ">",   2, &stack_more,           &batch_more,           &interval_more },
+	[OPERATION_LESS]           = { "<",   2, &stack_less,           &batch_less,           &interval_less },
+	[OPERATION_EQUALS]         = { "=",   2, &stack_equals,         &batch_equals,         &interval_equals },
+	[OPERATION_OR]             = { "OR",  0, &stack_or,             &batch_or,             &interval_or },
+	[OPERATION_DIV]            = { "DIV", 4, &stack_div,            &batch_div,            &interval_integer_division },
+	[OPERATION_MOD]            = { "MOD", 4, &stack_mod,            &batch_mod,            &interval_integer_division },
+	[OPERATION_AND]            = { "AND", 1, &stack_and,            &batch_and,            &interval_and },
+	[OPERATION_MORE_OR_EQUALS] = { ">=",  2, &stack_more_or_equals, &batch_more_or_equals, &interval_more_or_equals },
+	[OPERATION_LESS_OR_EQUALS] = { "<=",  2, &stack_less_or_equals, &batch_less_or_equals, &interval_less_or_equals },
+	[OPERATION_NOT_EQUALS]     = { "!=",  2, &stack_not_equals,     &batch_not_equals,     &interval_not_equals }
+};
+
+
+/**********************************************************************************************************
+NAME  : MATH FUNCTIONS
+LIBS  : -
+NOTES : function section where all mathematical functions listed. It is read-only data, so it is built
+        once by compiler and never allocated at run time.
+**********************************************************************************************************/
+const struct function_entry MATH_FUNCTIONS[MATH_FUNCTIONS_COUNT] =
+{
+	[FUNCTION_SQRT]     = { "sqrt",   1, &stack_sqrt,     &batch_sqrt,     &interval_sqrt,     NULL },
+	[FUNCTION_POWER]    = { "pow",    2, &stack_power,    &batch_power,    &interval_power,    NULL },
+	[FUNCTION_NEGATIVE] = { "neg",    1, &stack_negative, &batch_negative, &interval_negative, NULL },
+	[FUNCTION_ABS]      = { "abs",    1, &stack_abs,      &batch_abs,      &interval_abs,      NULL },
+	[FUNCTION_SIN]      = { "sin",    1, &stack_sin,      &batch_sin,      &interval_sin,      &vector_sin },
+	[FUNCTION_COS]      = { "cos",    1, &stack_cos,      &batch_cos,      &interval_cos,      &vector_cos },
+	[FUNCTION_ARCCOS]   = { "arccos", 1, &stack_arccos,   &batch_arccos,   &interval_arccos,   &vector_arccos },
+	[FUNCTION_TAN]      = { "tan",    1, &stack_tan,      &batch_tan,      &interval_tan,      &vector_tan },
+	[FUNCTION_COTAN]    = { "cotan",  1, &stack_cotan,    &batch_cotan,    &interval_cotan,    &vector_cotan },
+	[FUNCTION_LN]       = { "ln",     1, &stack_ln,       &batch_ln,       &interval_ln,       &vector_ln },
+	[FUNCTION_NOT]      = { "NOT",    1, &stack_not,      &batch_not,      &interval_not,      NULL },
+	[FUNCTION_IF]       = { "if",     3, &stack_if,       &batch_if,       &interval_if,       NULL }
+};
+
+
+/**********************************************************************************************************
+NAME  : GET OPERATION INDEX
+LIBS  : string.h
+NOTES : return index of operation entry with such alias, -1 if there is no such operation. Alias is not
+        required to end with zero character. Candidate entry is chosen by switch on the first character of
+        alias, so only one "strncmp()" call is made.
+**********************************************************************************************************/
+int get_operation_index(const char* operation_alias, size_t alias_length)
+{
+	int operation_index = -1;
+
+	if (alias_length == 0)
+	{
+		return -1;
+	}
+
+	switch (operation_alias[0])
+	{
+		case '+': operation_index = OPERATION_ADD;        break;
+		case '-': operation_index = OPERATION_SUBTRACT;   break;
+		case '*': operation_index = OPERATION_MULTIPLY;   break;
+		case '/': operation_index = OPERATION_DIVIDE;     break;
+
+		case '>':
+			operation_index = (alias_length > 1 && operation_alias[1] == '=') ?
+				OPERATION_MORE_OR_EQUALS : OPERATION_MORE;
+			break;
+
+		case '<':
+			operation_index = (alias_length > 1 && operation_alias[1] == '=') ?
+				OPERATION_LESS_OR_EQUALS : OPERATION_LESS;
+			break;
+
+		case '=': operation_index = OPERATION_EQUALS;     break;
+		case '!': operation_index = OPERATION_NOT_EQUALS; break;
+		case 'O': operation_index = OPERATION_OR;         break;
+		case 'A': operation_index = OPERATION_AND;        break;
+		case 'D': operation_index = OPERATION_DIV;        break;
+		case 'M': operation_index = OPERATION_MOD;        break;
+		default : return -1;
+	}
+
+	const char* entry_alias = MATH_OPERATIONS[operation_index].operation_alias;
+	if (strncmp(operation_alias, entry_alias, alias_length) != 0 || entry_alias[alias_length] != '\0')
+	{
+		return -1;
+	}
+
+	return operation_index;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET FUNCTION INDEX
+LIBS  : string.h
+NOTES : return index of function entry with such alias, -1 if there is no such function. Alias is not
+        required to end with zero character. Candidate entry is chosen by switch on the first characters of
+        alias, so only one "strncmp()" call is made.
+**********************************************************************************************************/
+int get_function_index(const char* function_alias, size_t alias_length)
+{
+	int function_index = -1;
+
+	if (alias_length == 0)
+	{
+		return -1;
+	}
+
+	switch (function_alias[0])
+	{
+		case 's':
+			function_index = (alias_length > 1 && function_alias[1] == 'q') ? FUNCTION_SQRT : FUNCTION_SIN;
+			break;
+
+		case 'p': function_index = FUNCTION_POWER;    break;
+		case 'n': function_index = FUNCTION_NEGATIVE; break;
+
+		case 'a':
+			function_index = (alias_length > 1 && function_alias[1] == 'b') ? FUNCTION_ABS : FUNCTION_ARCCOS;
+			break;
+
+		case 'c':
+			function_index = (alias_length > 2 && function_alias[1] == 'o' && function_alias[2] == 's') ?
+				FUNCTION_COS : FUNCTION_COTAN;
+			break;
+
+		case 't': function_index = FUNCTION_TAN; break;
+		case 'l': function_index = FUNCTION_LN;  break;
+		case 'N': function_index = FUNCTION_NOT; break;
+		case 'i': function_index = FUNCTION_IF;  break;
+		default : return -1;
+	}
+
+	const char* entry_alias = MATH_FUNCTIONS[function_index].function_alias;
+	if (strncmp(function_alias, entry_alias, alias_length) != 0 || entry_alias[alias_length] != '\0')
+	{
+		return -1;
+	}
+
+	return function_index;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////STACK MATHEMATICAL FUNCTIONS SECTION END////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////ARENA SECTION///////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Arena is a bump allocator for scratch memory of one expression: compiled formula of
+"calculate_expression()", its variable names, optimizer buffers, bindings. Allocation only moves offset in
+current block, nothing is freed one by one, "arena_reset()" releases everything at once.
+
+If block is full, new block twice bigger is taken from "malloc()". On reset several blocks are replaced by
+one block of their total size, so after the first expressions arena has one block which is big enough, and
+further expressions make no system allocations at all.
+
+Functions which can work both with arena and with heap take pointer on arena which is NULL for heap, see
+"allocate_memory()" and "release_memory()".
+
+*/
+
+//Every allocation is aligned by this count of bytes, as "malloc()" aligns memory for any type.
+#define ARENA_ALIGNMENT 16
+
+/**********************************************************************************************************
+NAME  : ARENA BLOCK
+LIBS  : -
+NOTES : memory of block follows this header after ARENA_HEADER_SIZE bytes.
+**********************************************************************************************************/
+struct arena_block
+{
+	struct arena_block* previous_block;
+	size_t block_capacity;
+	size_t used_size;
+};
+
+#define ARENA_HEADER_SIZE ((sizeof(struct arena_block) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+
+/**********************************************************************************************************
+NAME  : ARENA
+LIBS  : -
+NOTES : "system_allocations_count" counts blocks taken from "malloc()" since arena was created.
+**********************************************************************************************************/
+struct arena
+{
+	struct arena_block* current_block;
+	size_t total_capacity;
+	size_t system_allocations_count;
+};
+
+
+/**********************************************************************************************************
+NAME  : ARENA ADD BLOCK
+LIBS  : stdlib.h
+NOTES : new block becomes current one, previous blocks are kept until reset.
+**********************************************************************************************************/
+void arena_add_block(struct arena* arena, size_t block_capacity)
+{
+	struct arena_block* block = malloc(ARENA_HEADER_SIZE + block_capacity);
+	if (block == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	block->previous_block = arena->current_block;
+	block->block_capacity = block_capacity;
+	block->used_size = 0;
+
+	arena->current_block = block;
+	arena->total_capacity += block_capacity;
+	arena->system_allocations_count++;
+}
+
+
+/**********************************************************************************************************
+NAME  : ARENA INITIALIZE
+LIBS  : stdlib.h
+NOTES : -
+**********************************************************************************************************/
+struct arena* arena_initialize(size_t initial_capacity)
+{
+	struct arena* arena = calloc(1, sizeof(struct arena));
+	if (arena == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	arena_add_block(arena, initial_capacity);
+
+	return arena;
+}
+
+
+/**********************************************************************************************************
+NAME  : ARENA ALLOCATE
+LIBS  : string.h
+NOTES : return zeroed memory for "count" elements of "size" bytes (like "calloc()").
+**********************************************************************************************************/
+void* arena_allocate(struct arena* arena, size_t count, size_t size)
+{
+	size_t allocation_size = (count * size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+	struct arena_block* block = arena->current_block;
+	if (block->block_capacity - block->used_size < allocation_size)
+	{
+		size_t block_capacity = block->block_capacity * 2;
+		while (block_capacity < allocation_size)
+		{
+			block_capacity *= 2;
+		}
+		arena_add_block(arena, block_capacity);
+		block = arena->current_block;
+	}
+
+	unsigned char* memory = (unsigned char*)block + ARENA_HEADER_SIZE + block->used_size;
+	block->used_size += allocation_size;
+
+	memset(memory, 0, count * size);
+
+	return memory;
+}
+
+
+/**********************************************************************************************************
+NAME  : ARENA RESET
+LIBS  : stdlib.h
+NOTES : releases all allocations. Usually it only sets offset to zero, several blocks are merged into one.
+**********************************************************************************************************/
+void arena_reset(struct arena* arena)
+{
+	if (arena->current_block->previous_block != NULL)
+	{
+		size_t total_capacity = arena->total_capacity;
+
+		while (arena->current_block != NULL)
+		{
+			struct arena_block* previous_block = arena->current_block->previous_block;
+			free(arena->current_block);
+			arena->current_block = previous_block;
+		}
+
+		arena->total_capacity = 0;
+		arena_add_block(arena, total_capacity);
+	}
+
+	arena->current_block->used_size = 0;
+}
+
+
+/**********************************************************************************************************
+NAME  : ARENA FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with arena.
+**********************************************************************************************************/
+void arena_free(struct arena* arena)
+{
+	while (arena->current_block != NULL)
+	{
+		struct arena_block* previous_block = arena->current_block->previous_block;
+		free(arena->current_block);
+		arena->current_block = previous_block;
+	}
+
+	free(arena);
+}
+
+
+/**********************************************************************************************************
+NAME  : ALLOCATE MEMORY
+LIBS  : stdlib.h
+NOTES : allocates zeroed memory from arena, or by "calloc()" if arena is NULL.
+**********************************************************************************************************/
+void* allocate_memory(struct arena* arena, size_t count, size_t size)
+{
+	if (arena != NULL)
+	{
+		return arena_allocate(arena, count, size);
+	}
+
+	void* memory = calloc(count, size);
+	if (memory == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	return memory;
+}
+
+
+/**********************************************************************************************************
+NAME  : RELEASE MEMORY
+LIBS  : stdlib.h
+NOTES : frees memory from "allocate_memory()", memory of arena is released only by "arena_reset()".
+**********************************************************************************************************/
+void release_memory(struct arena* arena, void* memory)
+{
+	if (arena == NULL)
+	{
+		free(memory);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////ARENA SECTION END///////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////PARSER CONTEXT SECTION//////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Parser context keeps all state of lexer, shunting-yard algorithm and stack machine. Functions of parser
+and evaluator do not use global or static variables, so every thread can parse and evaluate expressions
+without locks as long as it uses its own context.
+
+Arrays of context grow when expression does not fit them and are reused by next expressions, so in steady
+state parsing does not allocate memory.
+
+*/
+
+//Kinds of token.
+#define TOKEN_NUMBER              0
+#define TOKEN_VARIABLE            1
+#define TOKEN_OPERATION           2
+#define TOKEN_FUNCTION            3
+#define TOKEN_OPENING_BRACKET     4
+#define TOKEN_CLOSING_BRACKET     5
+#define TOKEN_ARGUMENTS_DELIMITER 6
+#define TOKEN_WHERE_KEYWORD       7
+
+/**********************************************************************************************************
+NAME  : TOKEN
+LIBS  : -
+NOTES : token does not own text, it is a view (offset, length) into source expression. "index" is index of
+        entry in "MATH_OPERATIONS" ("MATH_FUNCTIONS") array for operations (functions), "value" is value
+        of number.
+**********************************************************************************************************/
+struct token
+{
+	int kind;
+	int index;
+	size_t offset;
+	size_t length;
+	double value;
+};
+
+
+/**********************************************************************************************************
+NAME  : PARSER CONTEXT
+LIBS  : -
+NOTES : "tokens" are tokens of the last tokenized expression. "postfix_tokens" and "operator_stack" are
+        indexes of tokens, they have the same capacity as "tokens". "error_code" and "error_position"
+        describe the first error of the last parsed expression. Arena keeps scratch memory of the last
+        expression calculated by "calculate_expression()".
+**********************************************************************************************************/
+struct parser_context
+{
+	struct token* tokens;
+	size_t tokens_count;
+	size_t tokens_capacity;
+
+	size_t* postfix_tokens;
+	size_t postfix_tokens_count;
+	size_t* operator_stack;
+
+	struct stack_double* evaluation_stack;
+	struct arena* arena;
+
+	int error_code;
+	size_t error_position;
+};
+
+
+/**********************************************************************************************************
+NAME  : PARSER CONTEXT RESERVE TOKENS
+LIBS  : stdlib.h
+NOTES : makes room for at least "tokens_capacity" tokens, old tokens are kept.
+**********************************************************************************************************/
+void parser_context_reserve_tokens(struct parser_context* context, size_t tokens_capacity)
+{
+	if (tokens_capacity <= context->tokens_capacity)
+	{
+		return;
+	}
+
+	if (tokens_capacity < context->tokens_capacity * 2)
+	{
+		tokens_capacity = context->tokens_capacity * 2;
+	}
+
+	struct token* tokens = realloc(context->tokens, tokens_capacity * sizeof(struct token));
+	size_t* postfix_tokens = realloc(context->postfix_tokens, tokens_capacity * sizeof(size_t));
+	size_t* operator_stack = realloc(context->operator_stack, tokens_capacity * sizeof(size_t));
+	if (tokens == NULL || postfix_tokens == NULL || operator_stack == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	context->tokens = tokens;
+	context->postfix_tokens = postfix_tokens;
+	context->operator_stack = operator_stack;
+	context->tokens_capacity = tokens_capacity;
+}
+
+
+/**********************************************************************************************************
+NAME  : PARSER CONTEXT INITIALIZE
+LIBS  : stdlib.h
+NOTES : -
+**********************************************************************************************************/
+struct parser_context* parser_context_initialize()
+{
+	const size_t TOKENS_CAPACITY = 64;
+	const size_t STACK_CAPACITY = 64;
+	const size_t ARENA_CAPACITY = 16384;
+
+	struct parser_context* context = calloc(1, sizeof(struct parser_context));
+	if (context == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	parser_context_reserve_tokens(context, TOKENS_CAPACITY);
+	context->evaluation_stack = stack_double_initialize(STACK_CAPACITY);
+	context->arena = arena_initialize(ARENA_CAPACITY);
+	context->error_code = NO_ERROR;
+	context->error_position = 0;
+
+	return context;
+}
+
+
+/**********************************************************************************************************
+NAME  : SET PARSER ERROR
+LIBS  : -
+NOTES : remembers the first error of expression and offset of token which caused it.
+**********************************************************************************************************/
+void set_parser_error(struct parser_context* context, int error_code, size_t error_position)
+{
+	if (context->error_code == NO_ERROR)
+	{
+		context->error_code = error_code;
+		context->error_position = error_position;
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : PARSER CONTEXT FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with parser context.
+**********************************************************************************************************/
+void parser_context_free(struct parser_context* context)
+{
+	free(context->tokens);
+	free(context->postfix_tokens);
+	free(context->operator_stack);
+	stack_double_free(context->evaluation_stack);
+	arena_free(context->arena);
+	free(context);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////PARSER CONTEXT SECTION END//////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////NUMBER PARSER SECTION///////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Number parser checks and converts decimal literal in one pass over its characters. Result is correctly
+rounded (to nearest, ties to even) and does not depend on locale, "strtod()" is not used. Literal is optional
+minus, digits, optionally dot and digits, optionally exponent: "e" or "E", optional sign and digits
+("-2.5e-9").
+
+Digits are converted by eight at once by arithmetic on one 64-bit word (SWAR), the rest one by one. If
+there are not more than 19 significant digits and mantissa fits 2^53, mantissa and power of ten (up to
+10^22) are exact doubles, so one multiplication or division by power of ten is correctly rounded. Almost
+all literals take this way.
+
+Other literals are calculated exactly: value is ratio of two big integers (digits multiplied by power of
+ten, divided by power of ten), quotient is calculated with 56-57 bits and rounded by the rest bits and
+remainder. Only the first 768 significant digits are used, the rest are replaced by one nonzero digit
+if they are not all zeros: number which is exactly halfway between two doubles never has more than 767
+significant digits, so such replacement does not change rounding.
+
+*/
+
+//Count of 32-bit parts of big integer: 5120 bits are enough for 768 digits divided by 10^1125.
+#define BIG_NUMBER_LIMBS_COUNT 160
+
+/**********************************************************************************************************
+NAME  : BIG NUMBER
+LIBS  : -
+NOTES : unsigned big integer, "limbs" are 32-bit parts from the lowest one. "limbs_count" does not include
+        the highest zero parts, zero has no parts.
+**********************************************************************************************************/
+struct big_number
+{
+	unsigned int limbs[BIG_NUMBER_LIMBS_COUNT];
+	size_t limbs_count;
+};
+
+
+/**********************************************************************************************************
+NAME  : BIG NUMBER MULTIPLY SMALL
+LIBS  : -
+NOTES : number = number * multiplier + addend. Big numbers of number parser never overflow.
+**********************************************************************************************************/
+void big_number_multiply_small(struct big_number* number, unsigned int multiplier, unsigned int addend)
+{
+	unsigned long long carry = addend;
+	for (size_t i = 0; i < number->limbs_count; i++)
+	{
+		carry += (unsigned long long)number->limbs[i] * multiplier;
+		number->limbs[i] = (unsigned int)carry;
+		carry >>= 32;
+	}
+
+	if (carry != 0)
+	{
+		number->limbs[number->limbs_count] = (unsigned int)carry;
+		number->limbs_count++;
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : BIG NUMBER MULTIPLY POWER OF TEN
+LIBS  : -
+NOTES : number = number * 10^exponent.
+**********************************************************************************************************/
+void big_number_multiply_power_of_ten(struct big_number* number, size_t exponent)
+{
+	const unsigned int MAX_SMALL_POWER_OF_TEN = 1000000000;
+	const size_t MAX_SMALL_EXPONENT = 9;
+
+	for (; exponent >= MAX_SMALL_EXPONENT; exponent -= MAX_SMALL_EXPONENT)
+	{
+		big_number_multiply_small(number, MAX_SMALL_POWER_OF_TEN, 0);
+	}
+
+	unsigned int power_of_ten = 1;
+	for (; exponent != 0; exponent--)
+	{
+		power_of_ten *= 10;
+	}
+	big_number_multiply_small(number, power_of_ten, 0);
+}
+
+
+/**********************************************************************************************************
+NAME  : BIG NUMBER SHIFT LEFT
+LIBS  : string.h
+NOTES : number = number * 2^bits_count.
+**********************************************************************************************************/
+void big_number_shift_left(struct big_number* number, size_t bits_count)
+{
+	if (number->limbs_count == 0)
+	{
+		return;
+	}
+
+	size_t limbs_shift = bits_count / 32;
+	unsigned int bits_shift = (unsigned int)(bits_count % 32);
+
+	if (bits_shift != 0)
+	{
+		unsigned int carry = 0;
+		for (size_t i = 0; i < number->limbs_count; i++)
+		{
+			unsigned int limb = number->limbs[i];
+			number->limbs[i] = (limb << bits_shift) | carry;
+			carry = limb >> (32 - bits_shift);
+		}
+
+		if (carry != 0)
+		{
+			number->limbs[number->limbs_count] = carry;
+			number->limbs_count++;
+		}
+	}
+
+	memmove(number->limbs + limbs_shift, number->limbs, number->limbs_count * sizeof(unsigned int));
+	memset(number->limbs, 0, limbs_shift * sizeof(unsigned int));
+	number->limbs_count += limbs_shift;
+}
+
+
+/**********************************************************************************************************
+NAME  : BIG NUMBER DIVIDE
+LIBS  : -
+NOTES : numerator = numerator % denominator, return numerator / denominator. Denominator must be normalized
+        (the highest bit of its highest part is 1) and quotient must be less than 2^64. Quotient is found
+        by 32-bit digits, every digit is estimated by the highest parts and corrected (Knuth, algorithm D).
+**********************************************************************************************************/
+unsigned long long big_number_divide(struct big_number* numerator, const struct big_number* denominator)
+{
+	const unsigned long long BASE = 1ULL << 32;
+	const unsigned long long LOW_HALF_MASK = BASE - 1;
+
+	unsigned int* dividend = numerator->limbs;
+	const unsigned int* divisor = denominator->limbs;
+	size_t divisor_count = denominator->limbs_count;
+	if (numerator->limbs_count < divisor_count)
+	{
+		return 0;
+	}
+
+	unsigned long long quotient = 0;
+	dividend[numerator->limbs_count] = 0;
+	for (size_t j = numerator->limbs_count - divisor_count + 1; j-- != 0;)
+	{
+		unsigned long long highest_parts = ((unsigned long long)dividend[j + divisor_count] << 32) |
+			dividend[j + divisor_count - 1];
+		unsigned long long digit = highest_parts / divisor[divisor_count - 1];
+		unsigned long long rest = highest_parts - digit * divisor[divisor_count - 1];
+		while (digit >= BASE || (divisor_count > 1 &&
+			digit * divisor[divisor_count - 2] > ((rest << 32) | dividend[j + divisor_count - 2])))
+		{
+			digit--;
+			rest += divisor[divisor_count - 1];
+			if (rest >= BASE)
+			{
+				break;
+			}
+		}
+
+		//dividend = dividend - digit * divisor, shifted by j parts.
+		long long borrow = 0;
+		long long difference;
+		for (size_t i = 0; i < divisor_count; i++)
+		{
+			unsigned long long product = digit * divisor[i];
+			difference = (long long)dividend[i + j] - borrow - (long long)(product & LOW_HALF_MASK);
+			dividend[i + j] = (unsigned int)difference;
+			borrow = (long long)(product >> 32) - (difference >> 32);
+		}
+		difference = (long long)dividend[j + divisor_count] - borrow;
+		dividend[j + divisor_count] = (unsigned int)difference;
+
+		//estimate was greater by one, divisor is added back.
+		if (difference < 0)
+		{
+			digit--;
+			unsigned long long carry = 0;
+			for (size_t i = 0; i < divisor_count; i++)
+			{
+				carry += (unsigned long long)dividend[i + j] + divisor[i];
+				dividend[i + j] = (unsigned int)carry;
+				carry >>= 32;
+			}
+			dividend[j + divisor_count] += (unsigned int)carry;
+		}
+
+		quotient = (quotient << 32) | digit;
+	}
+
+	numerator->limbs_count = divisor_count;
+	while (numerator->limbs_count != 0 && dividend[numerator->limbs_count - 1] == 0)
+	{
+		numerator->limbs_count--;
+	}
+
+	return quotient;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET BITS COUNT
+LIBS  : -
+NOTES : return count of significant bits of value, 0 for zero. Bits are counted by halves of value.
+**********************************************************************************************************/
+int get_bits_count(unsigned long long value)
+{
+	int bits_count = 0;
+	for (int half_width = 32; half_width != 0; half_width /= 2)
+	{
+		if ((value >> half_width) != 0)
+		{
+			value >>= half_width;
+			bits_count += half_width;
+		}
+	}
+
+	return bits_count + (int)value;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET BIG NUMBER BITS COUNT
+LIBS  : -
+NOTES : return count of significant bits, 0 for zero.
+**********************************************************************************************************/
+size_t get_big_number_bits_count(const struct big_number* number)
+{
+	if (number->limbs_count == 0)
+	{
+		return 0;
+	}
+
+	return (number->limbs_count - 1) * 32 + (size_t)get_bits_count(number->limbs[number->limbs_count - 1]);
+}
+
+
+/**********************************************************************************************************
+NAME  : IS EIGHT DIGITS
+LIBS  : -
+NOTES : return 1 if all eight characters of word are decimal digits. Every byte is checked by the same
+        arithmetic: high half of digit is 3 and adding 6 to digit does not change high half.
+**********************************************************************************************************/
+int is_eight_digits(unsigned long long chunk)
+{
+	return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+		== 0x3333333333333333ULL);
+}
+
+
+/**********************************************************************************************************
+NAME  : PARSE EIGHT DIGITS
+LIBS  : -
+NOTES : converts word of eight decimal digits (the first digit in the lowest byte) to number. Pairs of digits,
+        then pairs of pairs are joined by multiplication, so there are three multiplications instead of eight.
+**********************************************************************************************************/
+unsigned long long parse_eight_digits(unsigned long long chunk)
+{
+	const unsigned long long MASK = 0x000000FF000000FFULL;
+	const unsigned long long FIRST_MULTIPLIER = 100 + (1000000ULL << 32);
+	const unsigned long long SECOND_MULTIPLIER = 1 + (10000ULL << 32);
+
+	chunk -= 0x3030303030303030ULL;
+	chunk = chunk * 10 + (chunk >> 8);
+
+	return (((chunk & MASK) * FIRST_MULTIPLIER + ((chunk >> 16) & MASK) * SECOND_MULTIPLIER) >> 32);
+}
+
+
+/**********************************************************************************************************
+NAME  : PARSE DECIMAL DIGITS
+LIBS  : string.h
+NOTES : appends decimal digits which start at cursor to mantissa, mantissa overflows if there are more than
+        19 digits. Return pointer after the last digit.
+**********************************************************************************************************/
+const char* parse_decimal_digits(const char* cursor, const char* text_end, unsigned long long* mantissa)
+{
+	const unsigned long long EIGHT_DIGITS_SCALE = 100000000;
+	const size_t CHUNK_SIZE = sizeof(unsigned long long);
+
+	unsigned long long chunk;
+	while ((size_t)(text_end - cursor) >= CHUNK_SIZE)
+	{
+		memcpy(&chunk, cursor, CHUNK_SIZE);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		chunk = __builtin_bswap64(chunk);
+#endif
+		if (is_eight_digits(chunk) == 0)
+		{
+			break;
+		}
+		*mantissa = *mantissa * EIGHT_DIGITS_SCALE + parse_eight_digits(chunk);
+		cursor += CHUNK_SIZE;
+	}
+
+	while (cursor < text_end && *cursor >= '0' && *cursor <= '9')
+	{
+		*mantissa = *mantissa * 10 + (unsigned long long)(*cursor - '0');
+		cursor++;
+	}
+
+	return cursor;
+}
+
+
+/**********************************************************************************************************
+NAME  : ROUND BIG RATIO
+LIBS  : math.h
+NOTES : return numerator / denominator correctly rounded to double, both numbers are changed. "is_inexact"
+        is 1 if numerator is less than exact value (digits were dropped), but greater than the previous
+        representable numerator.
+**********************************************************************************************************/
+double round_big_ratio(struct big_number* numerator, struct big_number* denominator, int is_inexact)
+{
+	//quotient has 56 or 57 bits, at least 2 bits more than mantissa of double.
+	const int QUOTIENT_BITS_COUNT = 56;
+	const int MANTISSA_BITS_COUNT = 53;
+	const int MIN_SUBNORMAL_EXPONENT = -1074;
+
+	//quotient = numerator * 2^shift / denominator, denominator is normalized by whole parts.
+	int denominator_bits_count = (int)get_big_number_bits_count(denominator);
+	int denominator_shift = (32 - denominator_bits_count % 32) % 32;
+	int shift = denominator_bits_count + denominator_shift - (int)get_big_number_bits_count(numerator) +
+		QUOTIENT_BITS_COUNT;
+	if (shift < 0)
+	{
+		denominator_shift += (-shift + 31) / 32 * 32;
+		shift += (-shift + 31) / 32 * 32;
+	}
+	big_number_shift_left(denominator, (size_t)denominator_shift);
+	big_number_shift_left(numerator, (size_t)shift);
+	shift -= denominator_shift;
+
+	unsigned long long quotient = big_number_divide(numerator, denominator);
+	int is_sticky = (numerator->limbs_count != 0 || is_inexact == 1);
+
+	int quotient_bits_count = get_bits_count(quotient);
+
+	//subnormal numbers have less bits of mantissa.
+	int exponent = quotient_bits_count - 1 - shift;
+	int precision = MANTISSA_BITS_COUNT;
+	if (exponent - (MANTISSA_BITS_COUNT - 1) < MIN_SUBNORMAL_EXPONENT)
+	{
+		precision = exponent - MIN_SUBNORMAL_EXPONENT + 1;
+	}
+	if (precision < 0)
+	{
+		return 0;
+	}
+
+	int dropped_bits_count = quotient_bits_count - precision;
+	unsigned long long rounded = quotient >> dropped_bits_count;
+	unsigned long long dropped_bits = quotient & ((1ULL << dropped_bits_count) - 1);
+	unsigned long long half = 1ULL << (dropped_bits_count - 1);
+	if (dropped_bits > half || (dropped_bits == half && (is_sticky == 1 || (rounded & 1) != 0)))
+	{
+		rounded++;
+	}
+
+	//rounded mantissa is representable, so "ldexp()" is exact (or overflows to infinity).
+	return ldexp((double)rounded, dropped_bits_count - shift);
+}
+
+
+/**********************************************************************************************************
+NAME  : SCALE BIG NUMBER
+LIBS  : math.h
+NOTES : return correctly rounded value of integer numerator of "digits_count" digits multiplied by
+        10^exponent, numerator is changed. "is_inexact" is the same as in "round_big_ratio()".
+**********************************************************************************************************/
+double scale_big_number(struct big_number* numerator, size_t digits_count, long long exponent, int is_inexact)
+{
+	//value less than 10^-325 is rounded to zero, value not less than 10^310 to infinity.
+	const long long MIN_DECIMAL_EXPONENT = -325;
+	const long long MAX_DECIMAL_EXPONENT = 310;
+
+	if (exponent + (long long)digits_count > MAX_DECIMAL_EXPONENT)
+	{
+		return INFINITY;
+	}
+	if (exponent + (long long)digits_count < MIN_DECIMAL_EXPONENT)
+	{
+		return 0;
+	}
+
+	//big numbers are not cleared, only their used parts are written.
+	struct big_number denominator;
+	denominator.limbs[0] = 1;
+	denominator.limbs_count = 1;
+
+	if (exponent >= 0)
+	{
+		big_number_multiply_power_of_ten(numerator, (size_t)exponent);
+	}
+	else
+	{
+		big_number_multiply_power_of_ten(&denominator, (size_t)-exponent);
+	}
+
+	return round_big_ratio(numerator, &denominator, is_inexact);
+}
+
+
+/**********************************************************************************************************
+NAME  : CALCULATE BIG NUMBER
+LIBS  : -
+NOTES : return correctly rounded value of digits (dot is skipped) multiplied by 10^exponent. The first digit
+        is significant (not zero).
+**********************************************************************************************************/
+double calculate_big_number(const char* digits_start, const char* digits_end, long long exponent)
+{
+	const size_t MAX_SIGNIFICANT_DIGITS_COUNT = 768;
+	const size_t CHUNK_DIGITS_COUNT = 9;
+
+	struct big_number numerator;
+	numerator.limbs_count = 0;
+
+	size_t digits_count = 0;
+	size_t chunk_digits_count = 0;
+	unsigned int chunk = 0;
+	int is_inexact = 0; //false
+	for (const char* digit = digits_start; digit < digits_end; digit++)
+	{
+		if (*digit == '.')
+		{
+			continue;
+		}
+
+		if (digits_count == MAX_SIGNIFICANT_DIGITS_COUNT)
+		{
+			//dropped digits only shift exponent, nonzero of them make value inexact.
+			exponent++;
+			is_inexact |= (*digit != '0');
+			continue;
+		}
+
+		chunk = chunk * 10 + (unsigned int)(*digit - '0');
+		chunk_digits_count++;
+		digits_count++;
+		if (chunk_digits_count == CHUNK_DIGITS_COUNT)
+		{
+			big_number_multiply_small(&numerator, 1000000000, chunk);
+			chunk = 0;
+			chunk_digits_count = 0;
+		}
+	}
+
+	unsigned int chunk_scale = 1;
+	for (size_t i = 0; i < chunk_digits_count; i++)
+	{
+		chunk_scale *= 10;
+	}
+	big_number_multiply_small(&numerator, chunk_scale, chunk);
+
+	return scale_big_number(&numerator, digits_count, exponent, is_inexact);
+}
+
+
+/**********************************************************************************************************
+NAME  : PARSE NUMBER
+LIBS  : -
+NOTES : parses literal which starts at text and writes its value. Text is read not further than "text_end",
+        it does not have to end with zero character. Return length of literal, 0 if there is no literal.
+        Characters after literal are not checked: "2x" gives 2 of length 1.
+**********************************************************************************************************/
+size_t parse_number(const char* text, const char* text_end, double* value)
+{
+	const unsigned long long MAX_EXACT_MANTISSA = 1ULL << 53;
+	const size_t MAX_FAST_DIGITS_COUNT = 19;
+	const long long MAX_EXPONENT = 100000;
+	static const double POWERS_OF_TEN[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	const long long MAX_EXACT_POWER = (long long)(sizeof(POWERS_OF_TEN) / sizeof(POWERS_OF_TEN[0])) - 1;
+
+	const char* cursor = text;
+	int is_negative = (cursor < text_end && *cursor == '-');
+	cursor += is_negative;
+
+	//leading zeros are not significant digits.
+	const char* integer_start = cursor;
+	while (cursor < text_end && *cursor == '0')
+	{
+		cursor++;
+	}
+	const char* significant_start = cursor;
+	unsigned long long mantissa = 0;
+	cursor = parse_decimal_digits(cursor, text_end, &mantissa);
+	if (cursor == integer_start)
+	{
+		return 0;
+	}
+	size_t significant_digits_count = (size_t)(cursor - significant_start);
+
+	long long exponent = 0;
+	if (cursor + 1 < text_end && *cursor == '.' && cursor[1] >= '0' && cursor[1] <= '9')
+	{
+		cursor++;
+		const char* fraction_start = cursor;
+		if (significant_digits_count == 0)
+		{
+			while (cursor < text_end && *cursor == '0')
+			{
+				cursor++;
+			}
+			significant_start = cursor;
+		}
+		const char* fraction_digits_start = cursor;
+		cursor = parse_decimal_digits(cursor, text_end, &mantissa);
+		significant_digits_count += (size_t)(cursor - fraction_digits_start);
+		exponent -= (long long)(cursor - fraction_start);
+	}
+	const char* significant_end = cursor;
+
+	if (cursor < text_end && (*cursor == 'e' || *cursor == 'E'))
+	{
+		const char* exponent_start = cursor + 1;
+		int is_exponent_negative = (exponent_start < text_end && *exponent_start == '-');
+		exponent_start += (exponent_start < text_end && (*exponent_start == '-' || *exponent_start == '+'));
+
+		long long explicit_exponent = 0;
+		const char* exponent_end = exponent_start;
+		while (exponent_end < text_end && *exponent_end >= '0' && *exponent_end <= '9')
+		{
+			//huge exponent gives zero or infinity anyway.
+			if (explicit_exponent < MAX_EXPONENT)
+			{
+				explicit_exponent = explicit_exponent * 10 + (*exponent_end - '0');
+			}
+			exponent_end++;
+		}
+
+		if (exponent_end != exponent_start)
+		{
+			exponent += (is_exponent_negative == 1) ? -explicit_exponent : explicit_exponent;
+			cursor = exponent_end;
+		}
+	}
+
+	if (significant_digits_count == 0)
+	{
+		*value = 0;
+	}
+	else if (significant_digits_count <= MAX_FAST_DIGITS_COUNT && mantissa <= MAX_EXACT_MANTISSA &&
+		exponent >= -MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER)
+	{
+		*value = (exponent < 0) ? (double)mantissa / POWERS_OF_TEN[-exponent] :
+			(double)mantissa * POWERS_OF_TEN[exponent];
+	}
+	else if (significant_digits_count <= MAX_FAST_DIGITS_COUNT)
+	{
+		//mantissa is exact, so digits are not read again.
+		struct big_number numerator;
+		numerator.limbs[0] = (unsigned int)mantissa;
+		numerator.limbs[1] = (unsigned int)(mantissa >> 32);
+		numerator.limbs_count = (numerator.limbs[1] != 0) ? 2 : 1;
+		*value = scale_big_number(&numerator, significant_digits_count, exponent, 0);
+	}
+	else
+	{
+		*value = calculate_big_number(significant_start, significant_end, exponent);
+	}
+	*value = (is_negative == 1) ? -*value : *value;
+
+	return (size_t)(cursor - text);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////NUMBER PARSER SECTION END///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////LEXER SECTION///////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Lexer reads expression once from left to right and writes tokens to parser context. Spaces between tokens
+are optional: "a+b>c" and "a + b > c" give the same tokens. Spaces are required only between two words
+("a OR b") and between word and number.
+
+Minus is a part of number if it stands before digit where operand is expected (at the beginning of
+expression, after operation, opening bracket, comma or where keyword), so "-4" and "2 * -4" contain
+negative numbers, but "2-4" is subtraction. Numbers are checked and converted in one pass by
+"parse_number()", exponent is allowed ("1e-9", "2.5E+3").
+
+*/
+
+/**********************************************************************************************************
+NAME  : IS WORD CHARACTER
+LIBS  : ctype.h
+NOTES : return 1 if character can be a part of word (alias of variable, function or word operation).
+**********************************************************************************************************/
+int is_word_character(char character)
+{
+	return isalnum((unsigned char)character) != 0 || character == '_';
+}
+
+
+/**********************************************************************************************************
+NAME  : IS OPERAND EXPECTED
+LIBS  : -
+NOTES : return 1 if next token must start new operand, it means that minus before digit is a sign of number.
+**********************************************************************************************************/
+int is_operand_expected(const struct parser_context* context)
+{
+	if (context->tokens_count == 0)
+	{
+		return 1;
+	}
+
+	int previous_kind = context->tokens[context->tokens_count - 1].kind;
+
+	return previous_kind == TOKEN_OPERATION || previous_kind == TOKEN_OPENING_BRACKET ||
+		previous_kind == TOKEN_ARGUMENTS_DELIMITER || previous_kind == TOKEN_WHERE_KEYWORD;
+}
+
+
+/**********************************************************************************************************
+NAME  : TOKENIZE EXPRESSION PART
+LIBS  : stdlib.h, ctype.h
+NOTES : writes tokens of the first "expression_length" characters of expression to parser context, characters
+        after them are not read, so token is never longer than this part. Return error code, offset of wrong
+        character is written to parser context.
+**********************************************************************************************************/
+int tokenize_expression_part(struct parser_context* context, const char* expression, size_t expression_length)
+{
+	const char OPENING_BRACKET     = '(';
+	const char CLOSING_BRACKET     = ')';
+	const char ARGUMENTS_DELIMITER = ',';
+	const char WHERE_KEYWORD       = '|';
+	const size_t MAX_SYMBOL_OPERATION_LENGTH = 2;
+
+	context->tokens_count = 0;
+	context->error_code = NO_ERROR;
+	context->error_position = 0;
+
+	const char* expression_end = expression + expression_length;
+	const char* current_char = expression;
+	while (current_char < expression_end)
+	{
+		if (isspace((unsigned char)*current_char) != 0)
+		{
+			current_char++;
+			continue;
+		}
+
+		parser_context_reserve_tokens(context, context->tokens_count + 1);
+		struct token* token = &context->tokens[context->tokens_count];
+		token->offset = (size_t)(current_char - expression);
+		token->index = -1;
+		token->value = 0;
+
+		size_t number_length = 0;
+		if (isdigit((unsigned char)*current_char) != 0 ||
+			(*current_char == '-' && is_operand_expected(context) == 1))
+		{
+			//number followed by dot or word character ("1.", "2x", "3e") is wrong.
+			number_length = parse_number(current_char, expression_end, &token->value);
+			if (current_char + number_length < expression_end &&
+				(current_char[number_length] == '.' || is_word_character(current_char[number_length]) == 1))
+			{
+				number_length = 0;
+			}
+		}
+
+		if (number_length != 0)
+		{
+			token->kind = TOKEN_NUMBER;
+			token->length = number_length;
+		}
+		else if (isdigit((unsigned char)*current_char) != 0)
+		{
+			set_parser_error(context, UNEXPECTED_TOKEN, token->offset);
+			return context->error_code;
+		}
+		else if (is_word_character(*current_char) == 1)
+		{
+			token->length = 0;
+			while (current_char + token->length < expression_end &&
+				is_word_character(current_char[token->length]) == 1)
+			{
+				token->length++;
+			}
+
+			if ((token->index = get_function_index(current_char, token->length)) != -1)
+			{
+				token->kind = TOKEN_FUNCTION;
+			}
+			else if ((token->index = get_operation_index(current_char, token->length)) != -1)
+			{
+				token->kind = TOKEN_OPERATION;
+			}
+			else
+			{
+				token->kind = TOKEN_VARIABLE;
+			}
+		}
+		else
+		{
+			token->length = 1;
+			if (*current_char == OPENING_BRACKET)
+			{
+				token->kind = TOKEN_OPENING_BRACKET;
+			}
+			else if (*current_char == CLOSING_BRACKET)
+			{
+				token->kind = TOKEN_CLOSING_BRACKET;
+			}
+			else if (*current_char == ARGUMENTS_DELIMITER)
+			{
+				token->kind = TOKEN_ARGUMENTS_DELIMITER;
+			}
+			else if (*current_char == WHERE_KEYWORD)
+			{
+				token->kind = TOKEN_WHERE_KEYWORD;
+			}
+			else
+			{
+				//the longest symbol operation wins.
+				token->kind = TOKEN_OPERATION;
+				token->length = (size_t)(expression_end - current_char);
+				if (token->length > MAX_SYMBOL_OPERATION_LENGTH)
+				{
+					token->length = MAX_SYMBOL_OPERATION_LENGTH;
+				}
+				for (; token->length != 0; token->length--)
+				{
+					if ((token->index = get_operation_index(current_char, token->length)) != -1)
+					{
+						break;
+					}
+				}
+
+				if (token->length == 0)
+				{
+					set_parser_error(context, UNEXPECTED_TOKEN, token->offset);
+					return context->error_code;
+				}
+			}
+		}
+
+		current_char += token->length;
+		context->tokens_count++;
+	}
+
+	return NO_ERROR;
+}
+
+
+/**********************************************************************************************************
+NAME  : TOKENIZE EXPRESSION
+LIBS  : string.h
+NOTES : writes tokens of the whole expression (with where keyword and values, if there are any) to parser
+        context. Return error code, offset of wrong character is written to parser context.
+**********************************************************************************************************/
+int tokenize_expression(struct parser_context* context, const char* expression)
+{
+	return tokenize_expression_part(context, expression, strlen(expression));
+}
+
+
+/**********************************************************************************************************
+NAME  : CONVERT TOKENS TO POSTFIX
+LIBS  : -
+NOTES : shunting-yard algorithm over the first "tokens_count" tokens of parser context, indexes of tokens
+        in postfix order are written to "postfix_tokens". Return error code, offset of wrong token is written
+        to parser context.
+**********************************************************************************************************/
+int convert_tokens_to_postfix(struct parser_context* context, size_t tokens_count)
+{
+	const struct token* tokens = context->tokens;
+	size_t* output = context->postfix_tokens;
+	size_t* stack = context->operator_stack;
+
+	size_t output_count = 0;
+	size_t stack_count = 0;
+
+	for (size_t i = 0; i < tokens_count; i++)
+	{
+		const struct token* token = &tokens[i];
+
+		switch (token->kind)
+		{
+			case TOKEN_NUMBER:
+			case TOKEN_VARIABLE:
+				output[output_count++] = i;
+				break;
+
+			case TOKEN_FUNCTION:
+			case TOKEN_OPENING_BRACKET:
+				stack[stack_count++] = i;
+				break;
+
+			case TOKEN_OPERATION:
+			{
+				int associativity = MATH_OPERATIONS[token->index].operator_associativity;
+				while (stack_count != 0 && tokens[stack[stack_count - 1]].kind == TOKEN_OPERATION &&
+					associativity <= MATH_OPERATIONS[tokens[stack[stack_count - 1]].index].operator_associativity)
+				{
+					output[output_count++] = stack[--stack_count];
+				}
+
+				stack[stack_count++] = i;
+				break;
+			}
+
+			case TOKEN_ARGUMENTS_DELIMITER:
+			case TOKEN_CLOSING_BRACKET:
+				while (stack_count != 0 && tokens[stack[stack_count - 1]].kind != TOKEN_OPENING_BRACKET)
+				{
+					output[output_count++] = stack[--stack_count];
+				}
+
+				//there is no opening bracket for this comma or closing bracket.
+				if (stack_count == 0)
+				{
+					set_parser_error(context, UNEXPECTED_TOKEN, token->offset);
+					return context->error_code;
+				}
+
+				if (token->kind == TOKEN_CLOSING_BRACKET)
+				{
+					stack_count--;
+
+					if (stack_count != 0 && tokens[stack[stack_count - 1]].kind == TOKEN_FUNCTION)
+					{
+						output[output_count++] = stack[--stack_count];
+					}
+				}
+				break;
+
+			default:
+				set_parser_error(context, UNEXPECTED_TOKEN, token->offset);
+				return context->error_code;
+		}
+	}
+
+	while (stack_count != 0)
+	{
+		size_t token_index = stack[--stack_count];
+
+		//there is no closing bracket for this opening bracket.
+		if (tokens[token_index].kind == TOKEN_OPENING_BRACKET)
+		{
+			set_parser_error(context, UNEXPECTED_TOKEN, tokens[token_index].offset);
+			return context->error_code;
+		}
+
+		output[output_count++] = token_index;
+	}
+
+	context->postfix_tokens_count = output_count;
+
+	return NO_ERROR;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////LEXER SECTION END///////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////COMPILED FORMULA SECTION////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Compiled formula is a program for the double stack machine. Formula is parsed only once by
+"compile_formula()", after that it can be evaluated many times by "evaluate_compiled_formula()" with
+new values of variables. Evaluation does not parse strings and does not allocate memory.
+
+Errors of compilation and evaluation do not terminate program. "compile_formula()" returns NULL and writes
+error code and offset of wrong token to parser context, "evaluate_compiled_formula()" returns error code and
+offset of token which failed together with result.
+
+Typical usage:
+
+struct parser_context* context = parser_context_initialize();
+struct compiled_formula* formula = compile_formula(context, "a + b > c");
+struct stack_double* stack = stack_double_initialize(formula->max_stack_depth);
+
+double bindings[3];
+bindings[get_variable_slot(formula, "a")] = 2;
+bindings[get_variable_slot(formula, "b")] = 2;
+bindings[get_variable_slot(formula, "c")] = 2;
+
+struct evaluation_result result = evaluate_compiled_formula(formula, bindings, stack);
+if (result.error_code != NO_ERROR)
+{
+	printf("%s at position %zu\n", get_error_message(result.error_code), result.error_position);
+}
+
+stack_double_free(stack);
+compiled_formula_free(formula);
+parser_context_free(context);
+
+*/
+
+//Types of instruction for compiled formula.
+#define PUSH_CONSTANT  0
+#define PUSH_VARIABLE  1
+#define CALL_OPERATION 2
+#define CALL_FUNCTION  3
+#define DUPLICATE      4
+
+//Skip instructions of lazy operands, see "add_short_circuit_jumps()".
+#define SKIP_IF_TRUE       5
+#define SKIP_IF_FALSE      6
+#define SKIP_IF_BELOW_TRUE 7
+
+/**********************************************************************************************************
+NAME  : INSTRUCTION
+LIBS  : -
+NOTES : operand is index in constant pool, index of variable slot or index of entry in "MATH_OPERATIONS"
+        ("MATH_FUNCTIONS") array. Which one of them depends on opcode. DUPLICATE pushes copy of the top of
+        stack and has no operand, it is produced only by optimizer. Operand of skip instruction is index of
+        instruction where evaluation continues if operand is skipped.
+**********************************************************************************************************/
+struct instruction
+{
+	int opcode;
+	int operand;
+};
+
+
+/**********************************************************************************************************
+NAME  : COMPILED FORMULA
+LIBS  : -
+NOTES : "instruction_positions" keeps offset of source token of every instruction for error reporting.
+        Variable table is hash table with open addressing from name of variable to its slot, it keeps
+        slot + 1 (0 is empty place) and its capacity is power of two. Constant table is the same table for
+        constant pool. "arena" owns memory of formula, it is NULL if formula is allocated in heap.
+**********************************************************************************************************/
+struct compiled_formula
+{
+	struct instruction* instructions;
+	size_t* instruction_positions;
+	size_t instructions_count;
+
+	double* constants;
+	size_t constants_count;
+	int* constant_table;
+	size_t constant_table_capacity;
+
+	char** variable_names;
+	size_t variables_count;
+	int* variable_table;
+	size_t variable_table_capacity;
+
+	size_t max_stack_depth;
+
+	struct arena* arena;
+};
+
+
+/**********************************************************************************************************
+NAME  : EVALUATION RESULT
+LIBS  : -
+NOTES : "error_code" is NO_ERROR if evaluation succeeded, otherwise value is NAN and "error_position" is
+        offset of token which failed.
+**********************************************************************************************************/
+struct evaluation_result
+{
+	double value;
+	int error_code;
+	size_t error_position;
+};
+
+
+/**********************************************************************************************************
+NAME  : GET STRING HASH
+LIBS  : -
+NOTES : FNV-1a hash of "length" characters of string.
+**********************************************************************************************************/
+size_t get_string_hash(const char* string_pointer, size_t length)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char)string_pointer[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return (size_t)hash;
+}
+
+
+/**********************************************************************************************************
+NAME  : FIND VARIABLE PLACE
+LIBS  : string.h
+NOTES : name of variable is not required to end with zero character. Return place of variable in variable
+        table, or empty place where such variable must be added.
+**********************************************************************************************************/
+size_t find_variable_place(const struct compiled_formula* formula, const char* variable_name, size_t name_length)
+{
+	size_t position = get_string_hash(variable_name, name_length) & (formula->variable_table_capacity - 1);
+	while (formula->variable_table[position] != 0)
+	{
+		const char* name = formula->variable_names[formula->variable_table[position] - 1];
+		if (strncmp(name, variable_name, name_length) == 0 && name[name_length] == '\0')
+		{
+			break;
+		}
+		position = (position + 1) & (formula->variable_table_capacity - 1);
+	}
+
+	return position;
+}
+
+
+/**********************************************************************************************************
+NAME  : FIND VARIABLE SLOT
+LIBS  : -
+NOTES : the same as "get_variable_slot()", but name is a view (for example, token of expression) which is
+        not required to end with zero character.
+**********************************************************************************************************/
+int find_variable_slot(const struct compiled_formula* formula, const char* variable_name, size_t name_length)
+{
+	return formula->variable_table[find_variable_place(formula, variable_name, name_length)] - 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET VARIABLE SLOT
+LIBS  : string.h
+NOTES : return index of variable in bindings array, -1 if formula does not use such variable. Slot is found
+        by hash of name, so values can be bound by name without scan of all variables.
+**********************************************************************************************************/
+int get_variable_slot(const struct compiled_formula* formula, const char* variable_name)
+{
+	return find_variable_slot(formula, variable_name, strlen(variable_name));
+}
+
+
+/**********************************************************************************************************
+NAME  : ADD CONSTANT
+LIBS  : string.h
+NOTES : bitwise equal constants share one entry of constant pool, so 0 and -0 are different constants.
+        Return index of constant in constant pool.
+**********************************************************************************************************/
+int add_constant(struct compiled_formula* formula, double value)
+{
+	size_t position = get_string_hash((const char*)&value, sizeof(double)) &
+		(formula->constant_table_capacity - 1);
+	while (formula->constant_table[position] != 0)
+	{
+		int index = formula->constant_table[position] - 1;
+		if (memcmp(&formula->constants[index], &value, sizeof(double)) == 0)
+		{
+			return index;
+		}
+		position = (position + 1) & (formula->constant_table_capacity - 1);
+	}
+
+	formula->constants[formula->constants_count] = value;
+	formula->constants_count++;
+	formula->constant_table[position] = (int)formula->constants_count;
+
+	return (int)(formula->constants_count - 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : ADD VARIABLE
+LIBS  : string.h
+NOTES : name of variable is a view into source expression, it is copied only for the first use of variable.
+        Return index of variable slot.
+**********************************************************************************************************/
+int add_variable(struct compiled_formula* formula, const char* variable_name, size_t name_length)
+{
+	size_t position = find_variable_place(formula, variable_name, name_length);
+	if (formula->variable_table[position] != 0)
+	{
+		return formula->variable_table[position] - 1;
+	}
+
+	char* name = allocate_memory(formula->arena, name_length + 1, sizeof(char));
+	memcpy(name, variable_name, name_length);
+
+	formula->variable_names[formula->variables_count] = name;
+	formula->variables_count++;
+	formula->variable_table[position] = (int)formula->variables_count;
+
+	return (int)(formula->variables_count - 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : COMPILED FORMULA FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with compiled formula. Formula from arena is released
+        together with arena, so nothing is done for it.
+**********************************************************************************************************/
+void compiled_formula_free(struct compiled_formula* formula)
+{
+	if (formula->arena != NULL)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < formula->variables_count; i++)
+	{
+		free(formula->variable_names[i]);
+	}
+
+	free(formula->variable_names);
+	free(formula->variable_table);
+	free(formula->constant_table);
+	free(formula->constants);
+	free(formula->instruction_positions);
+	free(formula->instructions);
+	free(formula);
+}
+
+
+/*
+
+Operands of OR, AND and "if" are lazy: "a OR b" does not calculate b if a is true, "a AND b" does not
+calculate b if a is not true, "if ( c , x , y )" calculates only one of x and y. Skipped operand can not
+fail, so "x = 0 OR 1 / x > 2 | x = 0" is 1 without ZERO_DIVISION.
+
+Program of compiled formula is built without jumps, the last step of compilation adds skip instruction
+before every lazy operand longer than one instruction (operand of one instruction is a push, it is cheaper
+than jump and never fails). Skip instruction checks truth value on the stack and if operand is not needed,
+pushes NAN instead of it and jumps to the instruction which uses it. NAN does not change result: "1 OR NAN"
+is 1, "0 AND NAN" is 0 and "if" returns the other operand. So skip instructions can be removed without
+change of values, optimizer ignores them and adds them again for optimized program:
+
+a > 1 OR b / c > 2   ->   a 1 > SKIP_IF_TRUE(9) b c / 2 > OR
+if ( c , ln ( x ) , ln ( y ) )   ->   c SKIP_IF_FALSE(4) x ln SKIP_IF_BELOW_TRUE(7) y ln if
+
+SKIP_IF_TRUE and SKIP_IF_FALSE check the top of stack, SKIP_IF_BELOW_TRUE checks the element under the top
+(condition of "if" under its second operand).
+
+*/
+
+/**********************************************************************************************************
+NAME  : IS SKIP INSTRUCTION
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+int is_skip_instruction(const struct instruction* instruction)
+{
+	return instruction->opcode == SKIP_IF_TRUE || instruction->opcode == SKIP_IF_FALSE ||
+		instruction->opcode == SKIP_IF_BELOW_TRUE;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET INSTRUCTION ARGUMENTS COUNT
+LIBS  : -
+NOTES : return count of values which instruction pops from the stack (0 for pushes and skips).
+**********************************************************************************************************/
+size_t get_instruction_arguments_count(const struct instruction* instruction)
+{
+	const size_t OPERATION_ARGUMENTS_COUNT = 2;
+
+	if (instruction->opcode == CALL_OPERATION)
+	{
+		return OPERATION_ARGUMENTS_COUNT;
+	}
+	if (instruction->opcode == CALL_FUNCTION)
+	{
+		return MATH_FUNCTIONS[instruction->operand].arguments_count;
+	}
+
+	return 0;
+}
+
+
+/**********************************************************************************************************
+NAME  : IS SKIP TAKEN
+LIBS  : -
+NOTES : return 1 if skip instruction jumps, "tested_value" is the top of stack (the element under the top
+        for SKIP_IF_BELOW_TRUE).
+**********************************************************************************************************/
+int is_skip_taken(int opcode, double tested_value)
+{
+	if (opcode == SKIP_IF_FALSE)
+	{
+		return tested_value != 1;
+	}
+
+	return tested_value == 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : IS LAZY ARGUMENT USED
+LIBS  : -
+NOTES : return 0 if argument of operation (function) is lazy operand which is not calculated for such value
+        of the first argument: the second operand of OR if the first is true, of AND if the first is not true,
+        and one of branches of "if".
+**********************************************************************************************************/
+int is_lazy_argument_used(int opcode, int operand, double first_argument, size_t argument_index)
+{
+	if (argument_index == 0)
+	{
+		return 1;
+	}
+
+	int is_condition_true = (first_argument == 1);
+	if (opcode == CALL_OPERATION && operand == OPERATION_OR)
+	{
+		return is_condition_true == 0;
+	}
+	if (opcode == CALL_OPERATION && operand == OPERATION_AND)
+	{
+		return is_condition_true == 1;
+	}
+	if (opcode == CALL_FUNCTION && operand == FUNCTION_IF)
+	{
+		return (argument_index == 1) == (is_condition_true == 1);
+	}
+
+	return 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : ADD SHORT CIRCUIT JUMPS
+LIBS  : -
+NOTES : adds skip instructions to program without them, arrays of formula are allocated again only if
+        there is something to skip. Jump to lazy operand of "if" lands on skip instruction of the next
+        operand, so skips of one block are always resolved in reverse order. Return count of added
+        instructions.
+**********************************************************************************************************/
+size_t add_short_circuit_jumps(struct compiled_formula* formula)
+{
+	const size_t BUFFER_ELEMENT = 1;
+	const size_t IF_FIRST_VALUE = 1;
+	const size_t IF_SECOND_VALUE = 2;
+
+	struct arena* arena = formula->arena;
+	size_t instructions_count = formula->instructions_count;
+
+	//first instruction of every value on the stack; opcode (0 is none) and target of skip before instruction.
+	size_t* operand_starts = allocate_memory(arena, instructions_count + BUFFER_ELEMENT, sizeof(size_t));
+	int* skip_opcodes = allocate_memory(arena, instructions_count + BUFFER_ELEMENT, sizeof(int));
+	size_t* skip_targets = allocate_memory(arena, instructions_count + BUFFER_ELEMENT, sizeof(size_t));
+
+	size_t skips_count = 0;
+	size_t stack_depth = 0;
+	for (size_t i = 0; i < instructions_count; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+		size_t arguments_count = get_instruction_arguments_count(instruction);
+		if (arguments_count == 0)
+		{
+			operand_starts[stack_depth++] = i;
+			continue;
+		}
+
+		stack_depth -= arguments_count;
+		const size_t* arguments = &operand_starts[stack_depth];
+
+		//first instruction of lazy operand, the first instruction after it and skip instruction for it.
+		size_t lazy_starts[2];
+		size_t lazy_ends[2];
+		int lazy_opcodes[2];
+		size_t lazy_count = 0;
+		if (instruction->opcode == CALL_OPERATION &&
+			(instruction->operand == OPERATION_OR || instruction->operand == OPERATION_AND))
+		{
+			lazy_starts[0] = arguments[1];
+			lazy_ends[0] = i;
+			lazy_opcodes[0] = (instruction->operand == OPERATION_OR) ? SKIP_IF_TRUE : SKIP_IF_FALSE;
+			lazy_count = 1;
+		}
+		else if (instruction->opcode == CALL_FUNCTION && instruction->operand == FUNCTION_IF)
+		{
+			lazy_starts[0] = arguments[IF_FIRST_VALUE];
+			lazy_ends[0] = arguments[IF_SECOND_VALUE];
+			lazy_opcodes[0] = SKIP_IF_FALSE;
+			lazy_starts[1] = arguments[IF_SECOND_VALUE];
+			lazy_ends[1] = i;
+			lazy_opcodes[1] = SKIP_IF_BELOW_TRUE;
+			lazy_count = 2;
+		}
+
+		for (size_t j = 0; j < lazy_count; j++)
+		{
+			if (lazy_ends[j] - lazy_starts[j] > 1)
+			{
+				skip_opcodes[lazy_starts[j]] = lazy_opcodes[j];
+				skip_targets[lazy_starts[j]] = lazy_ends[j];
+				skips_count++;
+			}
+		}
+
+		//result of instruction starts where its first argument starts.
+		operand_starts[stack_depth++] = arguments[0];
+	}
+
+	if (skips_count != 0)
+	{
+		size_t count = instructions_count + skips_count;
+		struct instruction* instructions = allocate_memory(arena, count + BUFFER_ELEMENT,
+			sizeof(struct instruction));
+		size_t* instruction_positions = allocate_memory(arena, count + BUFFER_ELEMENT, sizeof(size_t));
+
+		//new index of every instruction (of its skip instruction, if there is one), so jumps land on skips.
+		size_t* new_indexes = operand_starts;
+		size_t new_index = 0;
+		for (size_t i = 0; i < instructions_count; i++)
+		{
+			new_indexes[i] = new_index;
+			new_index += (skip_opcodes[i] != 0) ? 2 : 1;
+		}
+
+		new_index = 0;
+		for (size_t i = 0; i < instructions_count; i++)
+		{
+			if (skip_opcodes[i] != 0)
+			{
+				instructions[new_index].opcode = skip_opcodes[i];
+				instructions[new_index].operand = (int)new_indexes[skip_targets[i]];
+				instruction_positions[new_index] = formula->instruction_positions[i];
+				new_index++;
+			}
+			instructions[new_index] = formula->instructions[i];
+			instruction_positions[new_index] = formula->instruction_positions[i];
+			new_index++;
+		}
+
+		release_memory(arena, formula->instructions);
+		release_memory(arena, formula->instruction_positions);
+		formula->instructions = instructions;
+		formula->instruction_positions = instruction_positions;
+		formula->instructions_count = count;
+	}
+
+	release_memory(arena, skip_targets);
+	release_memory(arena, skip_opcodes);
+	release_memory(arena, operand_starts);
+
+	return skips_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : COMPILE POSTFIX TOKENS
+LIBS  : stdlib.h
+NOTES : compiles postfix tokens of parser context (result of "convert_tokens_to_postfix()"), "expression" is
+        source of tokens. Formula is allocated from arena, or in heap if arena is NULL. Return NULL if formula
+        is wrong, error code and offset of wrong token are written to parser context.
+**********************************************************************************************************/
+struct compiled_formula* compile_postfix_tokens(struct parser_context* context, const char* expression,
+	struct arena* arena)
+{
+	size_t postfix_tokens_count = context->postfix_tokens_count;
+
+	struct compiled_formula* formula = allocate_memory(arena, 1, sizeof(struct compiled_formula));
+	formula->arena = arena;
+
+	const size_t BUFFER_ELEMENT = 1;
+	size_t capacity = postfix_tokens_count + BUFFER_ELEMENT;
+	formula->instructions = allocate_memory(arena, capacity, sizeof(struct instruction));
+	formula->instruction_positions = allocate_memory(arena, capacity, sizeof(size_t));
+	formula->constants = allocate_memory(arena, capacity, sizeof(double));
+	formula->variable_names = allocate_memory(arena, capacity, sizeof(char*));
+
+	//every token can be a new variable or constant, tables are kept at most half full.
+	size_t table_capacity = 1;
+	while (table_capacity < 2 * capacity)
+	{
+		table_capacity *= 2;
+	}
+	formula->variable_table_capacity = table_capacity;
+	formula->variable_table = allocate_memory(arena, table_capacity, sizeof(int));
+	formula->constant_table_capacity = table_capacity;
+	formula->constant_table = allocate_memory(arena, table_capacity, sizeof(int));
+
+	size_t stack_depth = 0;
+
+	for (size_t i = 0; i < postfix_tokens_count; i++)
+	{
+		const struct token* token = &context->tokens[context->postfix_tokens[i]];
+		struct instruction* instruction = &formula->instructions[formula->instructions_count];
+		formula->instruction_positions[formula->instructions_count] = token->offset;
+
+		if (token->kind == TOKEN_NUMBER)
+		{
+			instruction->opcode = PUSH_CONSTANT;
+			instruction->operand = add_constant(formula, token->value);
+			stack_depth++;
+		}
+		else if (token->kind == TOKEN_VARIABLE)
+		{
+			instruction->opcode = PUSH_VARIABLE;
+			instruction->operand = add_variable(formula, expression + token->offset, token->length);
+			stack_depth++;
+		}
+		else if (token->kind == TOKEN_OPERATION)
+		{
+			const size_t OPERATION_ARGUMENTS_COUNT = 2;
+			if (stack_depth < OPERATION_ARGUMENTS_COUNT)
+			{
+				set_parser_error(context, STACK_UNDERFLOW, token->offset);
+				break;
+			}
+
+			instruction->opcode = CALL_OPERATION;
+			instruction->operand = token->index;
+			stack_depth -= OPERATION_ARGUMENTS_COUNT - 1;
+		}
+		else
+		{
+			size_t arguments_count = MATH_FUNCTIONS[token->index].arguments_count;
+			if (stack_depth < arguments_count)
+			{
+				set_parser_error(context, STACK_UNDERFLOW, token->offset);
+				break;
+			}
+
+			instruction->opcode = CALL_FUNCTION;
+			instruction->operand = token->index;
+			stack_depth -= arguments_count - 1;
+		}
+
+		if (stack_depth > formula->max_stack_depth)
+		{
+			formula->max_stack_depth = stack_depth;
+		}
+
+		formula->instructions_count++;
+	}
+
+	//formula must leave exactly one value on the stack.
+	if (context->error_code == NO_ERROR && stack_depth != 1)
+	{
+		size_t last_position = (formula->instructions_count != 0) ?
+			formula->instruction_positions[formula->instructions_count - 1] : 0;
+		set_parser_error(context, UNEXPECTED_TOKEN, last_position);
+	}
+
+	if (context->error_code != NO_ERROR)
+	{
+		compiled_formula_free(formula);
+		return NULL;
+	}
+
+	add_short_circuit_jumps(formula);
+
+	return formula;
+}
+
+
+/**********************************************************************************************************
+NAME  : COMPILE TOKENS
+LIBS  : -
+NOTES : compiles the first "tokens_count" tokens of parser context, "expression" is source of tokens.
+        Formula is allocated from arena, or in heap if arena is NULL. Return NULL if formula is wrong, error
+        code and offset of wrong token are written to parser context.
+**********************************************************************************************************/
+struct compiled_formula* compile_tokens(struct parser_context* context, const char* expression,
+	size_t tokens_count, struct arena* arena)
+{
+	STATISTICS_START(postfix_start_ticks);
+	int error_code = convert_tokens_to_postfix(context, tokens_count);
+	STATISTICS_END(STATISTICS_POSTFIX, postfix_start_ticks);
+	if (error_code != NO_ERROR)
+	{
+		return NULL;
+	}
+
+	STATISTICS_START(compile_start_ticks);
+	struct compiled_formula* formula = compile_postfix_tokens(context, expression, arena);
+	STATISTICS_END(STATISTICS_COMPILE, compile_start_ticks);
+
+	return formula;
+}
+
+
+/*
+
+Optimizer rewrites instructions of compiled formula between compilation and evaluation:
+1. Operation or function whose arguments are all constants is calculated once and replaced by constant
+   (unless calculation fails, then error is left for evaluation, so it is reported with its position);
+2. "pow ( x , 2 )" and "pow ( x , 3 )" become multiplications of duplicated x. Square is rounded once, cube
+   twice, and "pow()" is not required to be correctly rounded, so both can differ from "pow()" in the last
+   bits. "pow ( x , 0.5 )" is not replaced by "sqrt ( x )": they differ for negative x (NAN without error
+   against ROOT_OF_NEGATIVE), -0 and -infinity;
+3. Division by constant whose reciprocal is exact (power of two) becomes multiplication by reciprocal, result
+   is bit-exact;
+4. "neg ( neg ( x ) )" becomes x;
+5. OR, AND and "if" whose first operand is constant are replaced by their result ("1 OR x" is 1, "0 AND x"
+   is 0) or by the chosen operand of "if", lazy operand which is not needed is removed even if it fails.
+
+Skip instructions are removed before optimization and added again after it.
+
+*/
+
+/**********************************************************************************************************
+NAME  : OPTIMIZER OPERAND
+LIBS  : -
+NOTES : value on symbolic stack of optimizer. Optimized instructions from "first_instruction" to the end
+        calculate this value, "value" is known only if value is constant.
+**********************************************************************************************************/
+struct optimizer_operand
+{
+	size_t first_instruction;
+	int is_constant;
+	double value;
+};
+
+
+/**********************************************************************************************************
+NAME  : IS EXACT RECIPROCAL
+LIBS  : math.h
+NOTES : return 1 if "1 / value" is exactly representable, so "x / value" and "x * (1 / value)" are equal for
+        every x.
+**********************************************************************************************************/
+int is_exact_reciprocal(double value)
+{
+	const double POWER_OF_TWO_MANTISSA = 0.5;
+
+	if (value == 0 || isfinite(value) == 0)
+	{
+		return 0;
+	}
+
+	int exponent;
+	double reciprocal = 1 / value;
+
+	return fabs(frexp(value, &exponent)) == POWER_OF_TWO_MANTISSA && isfinite(reciprocal) != 0 &&
+		reciprocal * value == 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : FOLD CONSTANTS
+LIBS  : -
+NOTES : calculates operation (function) over constant arguments on scratch stack. Return 1 and writes result
+        if calculation succeeded, 0 if it failed.
+**********************************************************************************************************/
+int fold_constants(const struct instruction* instruction, const struct optimizer_operand* arguments,
+	size_t arguments_count, struct stack_double* stack, double* result)
+{
+	clear_stack_double(stack);
+	for (size_t i = 0; i < arguments_count; i++)
+	{
+		push_stack_double(stack, arguments[i].value);
+	}
+
+	if (instruction->opcode == CALL_OPERATION)
+	{
+		MATH_OPERATIONS[instruction->operand].pointer_on_function(stack);
+	}
+	else
+	{
+		MATH_FUNCTIONS[instruction->operand].pointer_on_function(stack);
+	}
+
+	if (stack->error_code != NO_ERROR || stack->current_elements_count != 1)
+	{
+		return 0;
+	}
+
+	*result = pop_stack_double(stack);
+
+	return 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : EMIT INSTRUCTION
+LIBS  : -
+NOTES : appends instruction to optimized instructions, value is used only by PUSH_CONSTANT.
+**********************************************************************************************************/
+void emit_instruction(struct instruction* instructions, size_t* instruction_positions, double* constant_values,
+	size_t* instructions_count, int opcode, int operand, double value, size_t position)
+{
+	instructions[*instructions_count].opcode = opcode;
+	instructions[*instructions_count].operand = operand;
+	instruction_positions[*instructions_count] = position;
+	constant_values[*instructions_count] = value;
+	(*instructions_count)++;
+}
+
+
+/**********************************************************************************************************
+NAME  : OPTIMIZE COMPILED FORMULA
+LIBS  : stdlib.h
+NOTES : rewrites formula in place, rebuilds constant pool and maximal stack depth. Return count of removed
+        instructions (negative if strength reduction added cheap instructions instead of expensive ones).
+**********************************************************************************************************/
+int optimize_compiled_formula(struct compiled_formula* formula)
+{
+	//"pow ( x , 3 )" becomes "x DUPLICATE DUPLICATE * *", it is the longest rewrite.
+	const size_t MAX_INSTRUCTIONS_PER_INSTRUCTION = 2;
+	const size_t MAX_ARGUMENTS_COUNT = 3;
+
+	struct arena* arena = formula->arena;
+	size_t capacity = formula->instructions_count * MAX_INSTRUCTIONS_PER_INSTRUCTION + 1;
+	struct instruction* instructions = allocate_memory(arena, capacity, sizeof(struct instruction));
+	size_t* instruction_positions = allocate_memory(arena, capacity, sizeof(size_t));
+	double* constant_values = allocate_memory(arena, capacity, sizeof(double));
+	struct optimizer_operand* operands = allocate_memory(arena, formula->instructions_count + 1,
+		sizeof(struct optimizer_operand));
+
+	//scratch stack of folding lives in local array: three arguments and buffer element of double stack.
+	double fold_elements[4];
+	struct stack_double fold_stack = { fold_elements, fold_elements, MAX_ARGUMENTS_COUNT, 0, NO_ERROR };
+
+	size_t count = 0;
+	size_t operands_count = 0;
+
+	for (size_t i = 0; i < formula->instructions_count; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+		size_t position = formula->instruction_positions[i];
+
+		if (is_skip_instruction(instruction) == 1)
+		{
+			continue;
+		}
+
+		if (instruction->opcode == PUSH_CONSTANT || instruction->opcode == PUSH_VARIABLE ||
+			instruction->opcode == DUPLICATE)
+		{
+			struct optimizer_operand* operand = &operands[operands_count];
+			if (instruction->opcode == DUPLICATE)
+			{
+				*operand = operands[operands_count - 1];
+			}
+			else
+			{
+				operand->is_constant = (instruction->opcode == PUSH_CONSTANT);
+				operand->value = operand->is_constant ? formula->constants[instruction->operand] : 0;
+			}
+			operand->first_instruction = count;
+			operands_count++;
+
+			emit_instruction(instructions, instruction_positions, constant_values, &count, instruction->opcode,
+				instruction->operand, operand->value, position);
+			continue;
+		}
+
+		size_t arguments_count = (instruction->opcode == CALL_OPERATION) ? 2 :
+			MATH_FUNCTIONS[instruction->operand].arguments_count;
+		struct optimizer_operand* arguments = &operands[operands_count - arguments_count];
+
+		int are_arguments_constant = 1; //true
+		for (size_t j = 0; j < arguments_count; j++)
+		{
+			are_arguments_constant &= arguments[j].is_constant;
+		}
+
+		double folded_value;
+		if (are_arguments_constant == 1 &&
+			fold_constants(instruction, arguments, arguments_count, &fold_stack, &folded_value) == 1)
+		{
+			count = arguments[0].first_instruction;
+			emit_instruction(instructions, instruction_positions, constant_values, &count, PUSH_CONSTANT, 0,
+				folded_value, position);
+
+			operands_count -= arguments_count - 1;
+			arguments[0].is_constant = 1;
+			arguments[0].value = folded_value;
+			continue;
+		}
+
+		int is_or = (instruction->opcode == CALL_OPERATION && instruction->operand == OPERATION_OR);
+		int is_and = (instruction->opcode == CALL_OPERATION && instruction->operand == OPERATION_AND);
+		int is_if = (instruction->opcode == CALL_FUNCTION && instruction->operand == FUNCTION_IF);
+
+		if (arguments[0].is_constant == 1 &&
+			((is_or == 1 && arguments[0].value == 1) || (is_and == 1 && arguments[0].value != 1)))
+		{
+			//result is known from the first operand, the second one is never calculated.
+			double result = (is_or == 1) ? 1 : 0;
+			count = arguments[0].first_instruction;
+			emit_instruction(instructions, instruction_positions, constant_values, &count, PUSH_CONSTANT, 0,
+				result, position);
+
+			operands_count -= arguments_count - 1;
+			arguments[0].value = result;
+			continue;
+		}
+
+		if (is_if == 1 && arguments[0].is_constant == 1)
+		{
+			//instructions of the chosen operand are moved over instructions of condition.
+			size_t chosen = (arguments[0].value == 1) ? 1 : 2;
+			size_t chosen_start = arguments[chosen].first_instruction;
+			size_t chosen_end = (chosen == 1) ? arguments[2].first_instruction : count;
+			size_t start = arguments[0].first_instruction;
+
+			memmove(instructions + start, instructions + chosen_start,
+				(chosen_end - chosen_start) * sizeof(struct instruction));
+			memmove(instruction_positions + start, instruction_positions + chosen_start,
+				(chosen_end - chosen_start) * sizeof(size_t));
+			memmove(constant_values + start, constant_values + chosen_start,
+				(chosen_end - chosen_start) * sizeof(double));
+			count = start + (chosen_end - chosen_start);
+
+			operands_count -= arguments_count - 1;
+			arguments[0].is_constant = arguments[chosen].is_constant;
+			arguments[0].value = arguments[chosen].value;
+			continue;
+		}
+
+		int is_power = (instruction->opcode == CALL_FUNCTION && instruction->operand == FUNCTION_POWER);
+		int is_divide = (instruction->opcode == CALL_OPERATION && instruction->operand == OPERATION_DIVIDE);
+		int is_negative = (instruction->opcode == CALL_FUNCTION && instruction->operand == FUNCTION_NEGATIVE);
+
+		if (is_power == 1 && arguments[1].is_constant == 1 && (arguments[1].value == 2 || arguments[1].value == 3))
+		{
+			//constant exponent is the last instruction, it is replaced by cheaper instructions.
+			count = arguments[1].first_instruction;
+			size_t multiplications_count = (arguments[1].value == 2) ? 1 : 2;
+			for (size_t j = 0; j < multiplications_count; j++)
+			{
+				emit_instruction(instructions, instruction_positions, constant_values, &count, DUPLICATE, 0, 0,
+					position);
+			}
+			for (size_t j = 0; j < multiplications_count; j++)
+			{
+				emit_instruction(instructions, instruction_positions, constant_values, &count, CALL_OPERATION,
+					OPERATION_MULTIPLY, 0, position);
+			}
+		}
+		else if (is_divide == 1 && arguments[1].is_constant == 1 && is_exact_reciprocal(arguments[1].value) == 1)
+		{
+			constant_values[arguments[1].first_instruction] = 1 / arguments[1].value;
+			emit_instruction(instructions, instruction_positions, constant_values, &count, CALL_OPERATION,
+				OPERATION_MULTIPLY, 0, position);
+		}
+		else if (is_negative == 1 && count != 0 && instructions[count - 1].opcode == CALL_FUNCTION &&
+			instructions[count - 1].operand == FUNCTION_NEGATIVE && count - 1 > arguments[0].first_instruction)
+		{
+			//the last instruction of argument is negation, so two negations cancel each other.
+			count--;
+		}
+		else
+		{
+			emit_instruction(instructions, instruction_positions, constant_values, &count, instruction->opcode,
+				instruction->operand, 0, position);
+		}
+
+		operands_count -= arguments_count - 1;
+		arguments[0].is_constant = 0;
+	}
+
+	release_memory(arena, operands);
+
+	//constant pool and stack depth are built again for optimized instructions.
+	formula->constants_count = 0;
+	memset(formula->constant_table, 0, formula->constant_table_capacity * sizeof(int));
+	formula->max_stack_depth = 0;
+	size_t stack_depth = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		struct instruction* instruction = &instructions[i];
+		switch (instruction->opcode)
+		{
+			case PUSH_CONSTANT:
+				instruction->operand = add_constant(formula, constant_values[i]);
+				stack_depth++;
+				break;
+
+			case PUSH_VARIABLE:
+			case DUPLICATE:
+				stack_depth++;
+				break;
+
+			case CALL_OPERATION:
+				stack_depth--;
+				break;
+
+			case CALL_FUNCTION:
+				stack_depth -= MATH_FUNCTIONS[instruction->operand].arguments_count - 1;
+				break;
+		}
+
+		if (stack_depth > formula->max_stack_depth)
+		{
+			formula->max_stack_depth = stack_depth;
+		}
+	}
+	release_memory(arena, constant_values);
+
+	size_t old_instructions_count = formula->instructions_count;
+
+	release_memory(arena, formula->instructions);
+	release_memory(arena, formula->instruction_positions);
+	formula->instructions = instructions;
+	formula->instruction_positions = instruction_positions;
+	formula->instructions_count = count;
+
+	add_short_circuit_jumps(formula);
+
+	return (int)old_instructions_count - (int)formula->instructions_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : COMPILE FORMULA
+LIBS  : -
+NOTES : every word which is not a function or operation is a variable. Compiled formula is optimized.
+        Returned pointer on compiled formula must be passed to "compiled_formula_free()" after use. Parser
+        context is used only during compilation, compiled formula does not depend on it. Return NULL if
+        formula is wrong, error code and offset of wrong token are written to parser context.
+**********************************************************************************************************/
+struct compiled_formula* compile_formula(struct parser_context* context, const char* formula_text)
+{
+	STATISTICS_START(lex_start_ticks);
+	int error_code = tokenize_expression(context, formula_text);
+	STATISTICS_END(STATISTICS_LEX, lex_start_ticks);
+	if (error_code != NO_ERROR)
+	{
+		return NULL;
+	}
+
+	struct compiled_formula* formula = compile_tokens(context, formula_text, context->tokens_count, NULL);
+	if (formula != NULL)
+	{
+		STATISTICS_START(optimize_start_ticks);
+		optimize_compiled_formula(formula);
+		STATISTICS_END(STATISTICS_OPTIMIZE, optimize_start_ticks);
+	}
+
+	return formula;
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE COMPILED FORMULA
+LIBS  : math.h
+NOTES : bindings array contains values of variables in order of their slots. Stack must be created with
+        capacity not less than "max_stack_depth" of formula. Evaluation stops on the first failed
+        instruction.
+**********************************************************************************************************/
+struct evaluation_result evaluate_compiled_formula(const struct compiled_formula* formula,
+	const double* bindings, struct stack_double* stack)
+{
+	struct evaluation_result result = { NAN, NO_ERROR, 0 };
+
+	if (stack->stack_capacity < formula->max_stack_depth)
+	{
+		result.error_code = STACK_OVERFLOW;
+		return result;
+	}
+
+	clear_stack_double(stack);
+
+	for (size_t i = 0; i < formula->instructions_count; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+
+		switch (instruction->opcode)
+		{
+			case PUSH_CONSTANT:
+				push_stack_double(stack, formula->constants[instruction->operand]);
+				break;
+
+			case PUSH_VARIABLE:
+				push_stack_double(stack, bindings[instruction->operand]);
+				break;
+
+			case DUPLICATE:
+				push_stack_double(stack, *(stack->head_element));
+				break;
+
+			case CALL_OPERATION:
+				MATH_OPERATIONS[instruction->operand].pointer_on_function(stack);
+				break;
+
+			case CALL_FUNCTION:
+				MATH_FUNCTIONS[instruction->operand].pointer_on_function(stack);
+				break;
+
+			case SKIP_IF_TRUE:
+			case SKIP_IF_FALSE:
+			case SKIP_IF_BELOW_TRUE:
+			{
+				double tested_value = (instruction->opcode == SKIP_IF_BELOW_TRUE) ? stack->head_element[-1] :
+					stack->head_element[0];
+				if (is_skip_taken(instruction->opcode, tested_value) == 1)
+				{
+					push_stack_double(stack, NAN);
+					//loop increments index, so it is set to the instruction before target.
+					i = (size_t)instruction->operand - 1;
+				}
+				break;
+			}
+
+			default:
+				set_stack_error(stack, UNEXPECTED_TOKEN);
+		}
+
+		if (stack->error_code != NO_ERROR)
+		{
+			result.error_code = stack->error_code;
+			result.error_position = formula->instruction_positions[i];
+			return result;
+		}
+	}
+
+	result.value = pop_stack_double(stack);
+
+	return result;
+}
+
+
+/**********************************************************************************************************
+NAME  : BIND VALUE TOKENS
+LIBS  : string.h
+NOTES : the same as "bind_where_values()", but variables without value are not checked, bound variables are
+        marked in "bound_flags". Offset of wrong token is always offset in values part plus "values_position".
+**********************************************************************************************************/
+int bind_value_tokens(struct parser_context* context, size_t first_token, const char* values,
+	size_t values_position, const struct compiled_formula* formula, double* bindings, char* bound_flags,
+	size_t* error_position)
+{
+	//every value is "variable = number", values are separated by commas.
+	const size_t VALUE_TOKENS_COUNT = 3;
+
+	memset(bound_flags, 0, formula->variables_count);
+
+	size_t i = first_token;
+	while (i < context->tokens_count)
+	{
+		const struct token* name = &context->tokens[i];
+		if (name->kind == TOKEN_ARGUMENTS_DELIMITER)
+		{
+			i++;
+			continue;
+		}
+
+		if (name->kind != TOKEN_VARIABLE || i + VALUE_TOKENS_COUNT > context->tokens_count ||
+			context->tokens[i + 1].kind != TOKEN_OPERATION || context->tokens[i + 1].index != OPERATION_EQUALS)
+		{
+			*error_position = values_position + name->offset;
+			return UNEXPECTED_TOKEN;
+		}
+
+		const struct token* value = &context->tokens[i + 2];
+		if (value->kind != TOKEN_NUMBER)
+		{
+			*error_position = values_position + value->offset;
+			return UNEXPECTED_TOKEN;
+		}
+
+		int slot = find_variable_slot(formula, values + name->offset, name->length);
+		if (slot != -1)
+		{
+			bindings[slot] = value->value;
+			bound_flags[slot] = 1;
+		}
+
+		i += VALUE_TOKENS_COUNT;
+		if (i < context->tokens_count && context->tokens[i].kind != TOKEN_ARGUMENTS_DELIMITER)
+		{
+			*error_position = values_position + context->tokens[i].offset;
+			return UNEXPECTED_TOKEN;
+		}
+	}
+
+	return NO_ERROR;
+}
+
+
+/**********************************************************************************************************
+NAME  : CHECK BOUND VARIABLES
+LIBS  : -
+NOTES : return UNEXPECTED_TOKEN if some variable of formula is not marked in "bound_flags", offset of its first
+        use in formula text is written to "error_position".
+**********************************************************************************************************/
+int check_bound_variables(const struct compiled_formula* formula, const char* bound_flags, size_t* error_position)
+{
+	for (size_t j = 0; j < formula->instructions_count; j++)
+	{
+		const struct instruction* instruction = &formula->instructions[j];
+		if (instruction->opcode == PUSH_VARIABLE && bound_flags[instruction->operand] == 0)
+		{
+			*error_position = formula->instruction_positions[j];
+			return UNEXPECTED_TOKEN;
+		}
+	}
+
+	return NO_ERROR;
+}
+
+
+/**********************************************************************************************************
+NAME  : BIND WHERE VALUES
+LIBS  : -
+NOTES : binds values part of expression ("a = 2 , b = 2"), which is tokenized from token "first_token" of
+        parser context, directly to bindings of formula. Values of variables which formula does not use are
+        ignored, every variable of formula must get value. "bound_flags" is scratch array of formula
+        variables count. "values" is source of tokens, "values_position" is its offset in expression.
+        Return error code, offset of wrong token in expression is written to "error_position", variable
+        without value is reported at its first use in formula.
+**********************************************************************************************************/
+int bind_where_values(struct parser_context* context, size_t first_token, const char* values,
+	size_t values_position, const struct compiled_formula* formula, double* bindings, char* bound_flags,
+	size_t* error_position)
+{
+	int error_code = bind_value_tokens(context, first_token, values, values_position, formula, bindings,
+		bound_flags, error_position);
+
+	return (error_code != NO_ERROR) ? error_code : check_bound_variables(formula, bound_flags, error_position);
+}
+
+
+/**********************************************************************************************************
+NAME  : CALCULATE EXPRESSION
+LIBS  : stdlib.h
+NOTES : calculates expression with optional values of variables ("a + b | a = 1 , b = 2"). Expression is
+        tokenized once, formula and values are taken from the same tokens. Evaluation stack of parser
+        context is used, formula and bindings are allocated from arena of parser context, which is reset
+        for every expression, so steady-state expression makes no system allocations.
+**********************************************************************************************************/
+struct evaluation_result calculate_expression(struct parser_context* context, const char* expression)
+{
+	struct evaluation_result result = { NAN, NO_ERROR, 0 };
+
+	STATISTICS_POLL();
+	arena_reset(context->arena);
+
+	STATISTICS_START(lex_start_ticks);
+	int error_code = tokenize_expression(context, expression);
+	STATISTICS_END(STATISTICS_LEX, lex_start_ticks);
+	if (error_code != NO_ERROR)
+	{
+		result.error_code = context->error_code;
+		result.error_position = context->error_position;
+		STATISTICS_COUNT_ERROR(result.error_code);
+		return result;
+	}
+
+	size_t formula_tokens_count = 0;
+	while (formula_tokens_count < context->tokens_count &&
+		context->tokens[formula_tokens_count].kind != TOKEN_WHERE_KEYWORD)
+	{
+		formula_tokens_count++;
+	}
+
+	struct compiled_formula* formula = compile_tokens(context, expression, formula_tokens_count, context->arena);
+	if (formula == NULL)
+	{
+		result.error_code = context->error_code;
+		result.error_position = context->error_position;
+		STATISTICS_COUNT_ERROR(result.error_code);
+		return result;
+	}
+	STATISTICS_START(optimize_start_ticks);
+	optimize_compiled_formula(formula);
+	STATISTICS_END(STATISTICS_OPTIMIZE, optimize_start_ticks);
+
+	double* bindings = arena_allocate(context->arena, formula->variables_count + 1, sizeof(double));
+	char* bound_flags = arena_allocate(context->arena, formula->variables_count + 1, sizeof(char));
+
+	const size_t WHERE_KEYWORD_TOKENS_COUNT = 1;
+	STATISTICS_START(bind_start_ticks);
+	result.error_code = bind_where_values(context, formula_tokens_count + WHERE_KEYWORD_TOKENS_COUNT,
+		expression, 0, formula, bindings, bound_flags, &result.error_position);
+	STATISTICS_END(STATISTICS_BIND, bind_start_ticks);
+	if (result.error_code == NO_ERROR)
+	{
+		if (context->evaluation_stack->stack_capacity < formula->max_stack_depth)
+		{
+			stack_double_free(context->evaluation_stack);
+			context->evaluation_stack = stack_double_initialize(formula->max_stack_depth);
+		}
+
+		STATISTICS_START(evaluate_start_ticks);
+		result = evaluate_compiled_formula(formula, bindings, context->evaluation_stack);
+		STATISTICS_END(STATISTICS_EVALUATE, evaluate_start_ticks);
+		STATISTICS_COUNT(evaluations_count);
+	}
+	STATISTICS_COUNT_ERROR(result.error_code);
+
+	return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////COMPILED FORMULA SECTION END////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////FORMULA GROUP SECTION///////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Formula group is a set of formulas which are always evaluated together with the same values of variables,
+for example three triangle predicates from examples. Compiled formulas of group are merged into one
+directed acyclic graph: equal subexpressions ("pow ( a , 2 )" of every predicate) become one node, so every
+distinct subexpression is calculated only once per bindings. Nodes are hash-consed, node is added only if
+there is no node with the same instruction and the same arguments yet. Arguments of node are always created
+before node, so nodes are evaluated in order of their indexes.
+
+Variables with the same name are one variable of group. Error of node is passed to nodes which use it, so
+every formula gets the same error and offset of failed token as if it was evaluated alone. Lazy operands of
+OR, AND and "if" are shared nodes too, so group calculates them always, but passes their errors only when
+formula evaluated alone would calculate them.
+
+Work of group per node is a bit more than work of stack per instruction, so group pays off only when shared
+subexpressions are expensive. Three triangle predicates share only squares and products and are evaluated
+at 0.85-0.9 of speed of evaluation one by one, six distance rules share square root of sum of squares and
+are evaluated 1.4-1.7 times faster (--bench).
+
+Typical usage:
+
+const char* formulas_texts[] = { "a + b > c", "a + c > b", "b + c > a" };
+size_t error_formula_index;
+struct formula_group* group = compile_formula_group(context, formulas_texts, 3, &error_formula_index);
+
+double bindings[3];
+bindings[get_group_variable_slot(group, "a")] = 2;
+bindings[get_group_variable_slot(group, "b")] = 2;
+bindings[get_group_variable_slot(group, "c")] = 2;
+
+struct evaluation_result results[3];
+evaluate_formula_group(group, bindings, results);
+
+formula_group_free(group);
+
+*/
+
+/**********************************************************************************************************
+NAME  : GROUP NODE
+LIBS  : -
+NOTES : node of formula group. Opcode and operand are the same as in instruction, but operand of
+        PUSH_VARIABLE is slot of group variable and PUSH_CONSTANT keeps its value in node. Arguments are
+        indexes of nodes, DUPLICATE and skip instructions never become nodes.
+**********************************************************************************************************/
+struct group_node
+{
+	int opcode;
+	int operand;
+	size_t arguments[3];
+	size_t arguments_count;
+	double value;
+};
+
+
+/**********************************************************************************************************
+NAME  : FORMULA GROUP
+LIBS  : -
+NOTES : "instruction_nodes" keeps node of every instruction of every formula, it is used to find offset of
+        failed token. Node table is hash table with open addressing which keeps node index + 1 (0 is empty
+        place), its capacity is power of two. Node values and errors are scratch arrays of evaluation, so
+        one group must not be evaluated by several threads at once.
+**********************************************************************************************************/
+struct formula_group
+{
+	struct compiled_formula** formulas;
+	size_t** instruction_nodes;
+	size_t* root_nodes;
+	size_t formulas_count;
+
+	struct group_node* nodes;
+	size_t nodes_count;
+	size_t* node_table;
+	size_t node_table_capacity;
+
+	char** variable_names;
+	size_t variables_count;
+
+	double* node_values;
+	int* node_errors;
+	size_t* node_error_sources;
+	struct stack_double* stack;
+};
+
+
+/**********************************************************************************************************
+NAME  : GET GROUP NODE HASH
+LIBS  : string.h
+NOTES : FNV-1a hash of fields of node.
+**********************************************************************************************************/
+size_t get_group_node_hash(const struct group_node* node)
+{
+	unsigned long long value_bits;
+	memcpy(&value_bits, &node->value, sizeof(double));
+
+	unsigned long long fields[6];
+	fields[0] = (unsigned long long)node->opcode;
+	fields[1] = (unsigned long long)node->operand;
+	fields[2] = node->arguments_count > 0 ? node->arguments[0] : 0;
+	fields[3] = node->arguments_count > 1 ? node->arguments[1] : 0;
+	fields[4] = node->arguments_count > 2 ? node->arguments[2] : 0;
+	fields[5] = value_bits;
+
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < 6; i++)
+	{
+		hash ^= fields[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return (size_t)(hash ^ (hash >> 32));
+}
+
+
+/**********************************************************************************************************
+NAME  : ARE GROUP NODES EQUAL
+LIBS  : string.h
+NOTES : constants are compared bitwise, so 0 and -0 are different nodes.
+**********************************************************************************************************/
+int are_group_nodes_equal(const struct group_node* first_node, const struct group_node* second_node)
+{
+	if (first_node->opcode != second_node->opcode || first_node->operand != second_node->operand ||
+		first_node->arguments_count != second_node->arguments_count ||
+		memcmp(&first_node->value, &second_node->value, sizeof(double)) != 0)
+	{
+		return 0;
+	}
+
+	for (size_t i = 0; i < first_node->arguments_count; i++)
+	{
+		if (first_node->arguments[i] != second_node->arguments[i])
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : ADD GROUP NODE
+LIBS  : -
+NOTES : return index of node equal to given one, node is added to group only if there is no such node yet.
+        Node table must have free places, its capacity is chosen by "compile_formula_group()".
+**********************************************************************************************************/
+size_t add_group_node(struct formula_group* group, const struct group_node* node)
+{
+	size_t position = get_group_node_hash(node) & (group->node_table_capacity - 1);
+	while (group->node_table[position] != 0)
+	{
+		size_t node_index = group->node_table[position] - 1;
+		if (are_group_nodes_equal(&group->nodes[node_index], node) == 1)
+		{
+			return node_index;
+		}
+		position = (position + 1) & (group->node_table_capacity - 1);
+	}
+
+	group->nodes[group->nodes_count] = *node;
+	group->nodes_count++;
+	group->node_table[position] = group->nodes_count;
+
+	return group->nodes_count - 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET GROUP VARIABLE SLOT
+LIBS  : string.h
+NOTES : return index of variable in bindings array of group, -1 if no formula of group uses such variable.
+**********************************************************************************************************/
+int get_group_variable_slot(const struct formula_group* group, const char* variable_name)
+{
+	for (size_t i = 0; i < group->variables_count; i++)
+	{
+		if (strcmp(group->variable_names[i], variable_name) == 0)
+		{
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
+
+/**********************************************************************************************************
+NAME  : ADD GROUP VARIABLE
+LIBS  : string.h
+NOTES : name is not copied, it belongs to compiled formula of group. Return index of variable slot.
+**********************************************************************************************************/
+int add_group_variable(struct formula_group* group, char* variable_name)
+{
+	int slot = get_group_variable_slot(group, variable_name);
+	if (slot != -1)
+	{
+		return slot;
+	}
+
+	group->variable_names[group->variables_count] = variable_name;
+	group->variables_count++;
+
+	return (int)(group->variables_count - 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA GROUP FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with formula group, it frees compiled formulas too.
+**********************************************************************************************************/
+void formula_group_free(struct formula_group* group)
+{
+	for (size_t i = 0; i < group->formulas_count; i++)
+	{
+		if (group->formulas[i] != NULL)
+		{
+			compiled_formula_free(group->formulas[i]);
+		}
+		free(group->instruction_nodes[i]);
+	}
+
+	if (group->stack != NULL)
+	{
+		stack_double_free(group->stack);
+	}
+	free(group->formulas);
+	free(group->instruction_nodes);
+	free(group->root_nodes);
+	free(group->nodes);
+	free(group->node_table);
+	free(group->variable_names);
+	free(group->node_values);
+	free(group->node_errors);
+	free(group->node_error_sources);
+	free(group);
+}
+
+
+/**********************************************************************************************************
+NAME  : ADD FORMULA TO GROUP
+LIBS  : stdlib.h
+NOTES : walks instructions of compiled formula with stack of nodes instead of values and turns every
+        instruction into node of group.
+**********************************************************************************************************/
+void add_formula_to_group(struct formula_group* group, size_t formula_index)
+{
+	const struct compiled_formula* formula = group->formulas[formula_index];
+
+	const size_t BUFFER_ELEMENT = 1;
+	size_t* nodes_stack = calloc(formula->max_stack_depth + BUFFER_ELEMENT, sizeof(size_t));
+	size_t* instruction_nodes = calloc(formula->instructions_count + BUFFER_ELEMENT, sizeof(size_t));
+	if (nodes_stack == NULL || instruction_nodes == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	size_t stack_depth = 0;
+	for (size_t i = 0; i < formula->instructions_count; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+		struct group_node node = { instruction->opcode, 0, { 0, 0, 0 }, 0, 0 };
+
+		//lazy operands are calculated too, they only do not pass errors (see "is_group_argument_used()").
+		if (is_skip_instruction(instruction) == 1)
+		{
+			instruction_nodes[i] = (size_t)-1;
+			continue;
+		}
+
+		switch (instruction->opcode)
+		{
+			case PUSH_CONSTANT:
+				node.value = formula->constants[instruction->operand];
+				break;
+
+			case PUSH_VARIABLE:
+				node.operand = add_group_variable(group, formula->variable_names[instruction->operand]);
+				break;
+
+			case DUPLICATE:
+				instruction_nodes[i] = nodes_stack[stack_depth - 1];
+				nodes_stack[stack_depth] = instruction_nodes[i];
+				stack_depth++;
+				continue;
+
+			default:
+				node.operand = instruction->operand;
+				node.arguments_count = (instruction->opcode == CALL_OPERATION) ? 2 :
+					MATH_FUNCTIONS[instruction->operand].arguments_count;
+				stack_depth -= node.arguments_count;
+				for (size_t j = 0; j < node.arguments_count; j++)
+				{
+					node.arguments[j] = nodes_stack[stack_depth + j];
+				}
+		}
+
+		instruction_nodes[i] = add_group_node(group, &node);
+		nodes_stack[stack_depth] = instruction_nodes[i];
+		stack_depth++;
+	}
+
+	group->instruction_nodes[formula_index] = instruction_nodes;
+	group->root_nodes[formula_index] = nodes_stack[0];
+	free(nodes_stack);
+}
+
+
+/**********************************************************************************************************
+NAME  : COMPILE FORMULA GROUP
+LIBS  : stdlib.h
+NOTES : compiles and optimizes every formula and merges them into one group. Returned pointer must be
+        passed to "formula_group_free()" after use. Return NULL if one of formulas is wrong, its index is
+        written to "error_formula_index", error code and offset of wrong token are written to parser context.
+**********************************************************************************************************/
+struct formula_group* compile_formula_group(struct parser_context* context, const char* const* formulas_texts,
+	size_t formulas_count, size_t* error_formula_index)
+{
+	const size_t BUFFER_ELEMENT = 1;
+
+	struct formula_group* group = calloc(1, sizeof(struct formula_group));
+	if (group == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	group->formulas = calloc(formulas_count + BUFFER_ELEMENT, sizeof(struct compiled_formula*));
+	group->instruction_nodes = calloc(formulas_count + BUFFER_ELEMENT, sizeof(size_t*));
+	group->root_nodes = calloc(formulas_count + BUFFER_ELEMENT, sizeof(size_t));
+	if (group->formulas == NULL || group->instruction_nodes == NULL || group->root_nodes == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	group->formulas_count = formulas_count;
+
+	size_t instructions_count = 0;
+	size_t variables_count = 0;
+	for (size_t i = 0; i < formulas_count; i++)
+	{
+		group->formulas[i] = compile_formula(context, formulas_texts[i]);
+		if (group->formulas[i] == NULL)
+		{
+			*error_formula_index = i;
+			formula_group_free(group);
+			return NULL;
+		}
+		instructions_count += group->formulas[i]->instructions_count;
+		variables_count += group->formulas[i]->variables_count;
+	}
+
+	//every instruction gives at most one node, node table is kept at most half full.
+	group->node_table_capacity = 1;
+	while (group->node_table_capacity < 2 * (instructions_count + BUFFER_ELEMENT))
+	{
+		group->node_table_capacity *= 2;
+	}
+
+	group->nodes = calloc(instructions_count + BUFFER_ELEMENT, sizeof(struct group_node));
+	group->node_table = calloc(group->node_table_capacity, sizeof(size_t));
+	group->variable_names = calloc(variables_count + BUFFER_ELEMENT, sizeof(char*));
+	if (group->nodes == NULL || group->node_table == NULL || group->variable_names == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	for (size_t i = 0; i < formulas_count; i++)
+	{
+		add_formula_to_group(group, i);
+	}
+
+	group->node_values = calloc(group->nodes_count + BUFFER_ELEMENT, sizeof(double));
+	group->node_errors = calloc(group->nodes_count + BUFFER_ELEMENT, sizeof(int));
+	group->node_error_sources = calloc(group->nodes_count + BUFFER_ELEMENT, sizeof(size_t));
+	if (group->node_values == NULL || group->node_errors == NULL || group->node_error_sources == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	const size_t MAX_ARGUMENTS_COUNT = 3;
+	group->stack = stack_double_initialize(MAX_ARGUMENTS_COUNT);
+
+	return group;
+}
+
+
+/**********************************************************************************************************
+NAME  : IS GROUP ARGUMENT USED
+LIBS  : -
+NOTES : return 0 if argument of node is lazy operand which formula evaluated alone would skip, so its error
+        is not error of node. Values of previous arguments of node must be calculated without errors.
+**********************************************************************************************************/
+int is_group_argument_used(const struct formula_group* group, const struct group_node* node,
+	size_t argument_index)
+{
+	return is_lazy_argument_used(node->opcode, node->operand, group->node_values[node->arguments[0]],
+		argument_index);
+}
+
+
+/**********************************************************************************************************
+NAME  : GET NEXT GROUP INSTRUCTION
+LIBS  : -
+NOTES : return index of instruction of formula of group which is evaluated after "instruction_index" for
+        calculated values of nodes, so skip instruction goes to its target if it is taken. Value tested by
+        skip is node of the previous instruction, or condition of "if" (target of SKIP_IF_BELOW_TRUE).
+**********************************************************************************************************/
+size_t get_next_group_instruction(const struct formula_group* group, size_t formula_index,
+	size_t instruction_index)
+{
+	const struct instruction* instruction = &group->formulas[formula_index]->instructions[instruction_index];
+	const size_t* instruction_nodes = group->instruction_nodes[formula_index];
+
+	if (is_skip_instruction(instruction) == 0)
+	{
+		return instruction_index + 1;
+	}
+
+	size_t target = (size_t)instruction->operand;
+	size_t tested_node = (instruction->opcode == SKIP_IF_BELOW_TRUE) ?
+		group->nodes[instruction_nodes[target]].arguments[0] : instruction_nodes[instruction_index - 1];
+
+	return (is_skip_taken(instruction->opcode, group->node_values[tested_node]) == 1) ? target :
+		instruction_index + 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE FORMULA GROUP
+LIBS  : math.h
+NOTES : bindings array contains values of group variables in order of their slots, results array gets
+        result of every formula in order of formulas of group. Every node is calculated once.
+**********************************************************************************************************/
+void evaluate_formula_group(struct formula_group* group, const double* bindings,
+	struct evaluation_result* results)
+{
+	//arguments of nodes are checked for errors only after the first failed node.
+	int has_errors = 0; //false
+	clear_stack_double(group->stack);
+
+	for (size_t i = 0; i < group->nodes_count; i++)
+	{
+		const struct group_node* node = &group->nodes[i];
+		group->node_errors[i] = NO_ERROR;
+
+		switch (node->opcode)
+		{
+			case PUSH_CONSTANT:
+				group->node_values[i] = node->value;
+				continue;
+
+			case PUSH_VARIABLE:
+				group->node_values[i] = bindings[node->operand];
+				continue;
+		}
+
+		//the first failed argument is the one which fails first in formula evaluated alone.
+		for (size_t j = 0; has_errors == 1 && j < node->arguments_count; j++)
+		{
+			if (group->node_errors[node->arguments[j]] != NO_ERROR &&
+				is_group_argument_used(group, node, j) == 1)
+			{
+				group->node_errors[i] = group->node_errors[node->arguments[j]];
+				group->node_error_sources[i] = group->node_error_sources[node->arguments[j]];
+				break;
+			}
+		}
+		if (group->node_errors[i] != NO_ERROR)
+		{
+			group->node_values[i] = NAN;
+			continue;
+		}
+
+		for (size_t j = 0; j < node->arguments_count; j++)
+		{
+			push_stack_double(group->stack, group->node_values[node->arguments[j]]);
+		}
+
+		if (node->opcode == CALL_OPERATION)
+		{
+			MATH_OPERATIONS[node->operand].pointer_on_function(group->stack);
+		}
+		else
+		{
+			MATH_FUNCTIONS[node->operand].pointer_on_function(group->stack);
+		}
+
+		if (group->stack->error_code != NO_ERROR)
+		{
+			group->node_values[i] = NAN;
+			group->node_errors[i] = group->stack->error_code;
+			group->node_error_sources[i] = i;
+			has_errors = 1;
+			clear_stack_double(group->stack);
+		}
+		else
+		{
+			group->node_values[i] = pop_stack_double(group->stack);
+		}
+	}
+
+	for (size_t i = 0; i < group->formulas_count; i++)
+	{
+		size_t root_node = group->root_nodes[i];
+		results[i].value = group->node_values[root_node];
+		results[i].error_code = group->node_errors[root_node];
+		results[i].error_position = 0;
+
+		if (results[i].error_code != NO_ERROR)
+		{
+			//failed node is reported at its first instruction in this formula which is not skipped.
+			const struct compiled_formula* formula = group->formulas[i];
+			size_t j = 0;
+			while (group->instruction_nodes[i][j] != group->node_error_sources[root_node])
+			{
+				j = get_next_group_instruction(group, i, j);
+			}
+			results[i].error_position = formula->instruction_positions[j];
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////FORMULA GROUP SECTION END///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////INCREMENTAL EVALUATION SECTION//////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Incremental evaluator keeps value of every subexpression of one compiled formula between evaluations, so
+when only some variables change (simulation loop changes one of "a", "b", "c" per step), only subexpressions
+which depend on changed variables are calculated again. Formula is turned into tree of nodes (DUPLICATE
+shares node of its argument), and for every variable evaluator keeps list of nodes which depend on it.
+Changed variable marks its dependent nodes as dirty, evaluation calculates only dirty nodes in order of their
+indexes, clean ones keep their values.
+
+Error of node is passed to nodes which use it, so result, error and offset of failed token are the same as
+from "evaluate_compiled_formula()". Lazy operands of OR, AND and "if" are calculated when they are dirty, like
+in formula group, but their errors are passed only when formula evaluated alone would calculate them.
+
+Typical usage:
+
+struct compiled_formula* formula = compile_formula(context, "a + b > c");
+struct incremental_evaluator* evaluator = incremental_evaluator_initialize(formula);
+
+set_incremental_variable(evaluator, get_variable_slot(formula, "a"), 2);
+set_incremental_variable(evaluator, get_variable_slot(formula, "b"), 2);
+set_incremental_variable(evaluator, get_variable_slot(formula, "c"), 2);
+struct evaluation_result result = evaluate_incremental(evaluator);
+
+set_incremental_variable(evaluator, get_variable_slot(formula, "c"), 5);
+result = evaluate_incremental(evaluator); //"a + b" is not calculated again.
+printf("%zu\n", evaluator->recomputed_nodes_count);
+
+incremental_evaluator_free(evaluator);
+compiled_formula_free(formula);
+
+*/
+
+/**********************************************************************************************************
+NAME  : INCREMENTAL NODE
+LIBS  : -
+NOTES : node of incremental evaluator. Opcode and operand are the same as in instruction, arguments are
+        indexes of nodes, position is offset of token of instruction which reports error of node.
+**********************************************************************************************************/
+struct incremental_node
+{
+	int opcode;
+	int operand;
+	size_t arguments[3];
+	size_t arguments_count;
+	size_t position;
+};
+
+
+/**********************************************************************************************************
+NAME  : INCREMENTAL EVALUATOR
+LIBS  : -
+NOTES : formula is not copied, it must live while evaluator is used. Arguments of node are always created
+        before node. "dependent_nodes[slot]" lists nodes which depend on variable with such slot, in order of
+        their indexes. There are no dirty nodes before "first_dirty_node". "recomputed_nodes_count" is count
+        of nodes calculated by the last evaluation.
+**********************************************************************************************************/
+struct incremental_evaluator
+{
+	const struct compiled_formula* formula;
+
+	struct incremental_node* nodes;
+	size_t nodes_count;
+	size_t root_node;
+
+	double* node_values;
+	int* node_errors;
+	size_t* node_error_positions;
+	unsigned char* dirty_nodes;
+
+	double* bindings;
+	size_t** dependent_nodes;
+	size_t* dependent_nodes_counts;
+
+	size_t first_dirty_node;
+	struct stack_double* stack;
+
+	size_t recomputed_nodes_count;
+};
+
+
+/**********************************************************************************************************
+NAME  : ADD INCREMENTAL NODE
+LIBS  : -
+NOTES : return index of added node, node is dirty until the first evaluation.
+**********************************************************************************************************/
+size_t add_incremental_node(struct incremental_evaluator* evaluator, const struct incremental_node* node)
+{
+	size_t node_index = evaluator->nodes_count;
+
+	evaluator->nodes[node_index] = *node;
+	evaluator->node_errors[node_index] = NO_ERROR;
+	evaluator->dirty_nodes[node_index] = 1;
+	evaluator->nodes_count++;
+
+	return node_index;
+}
+
+
+/**********************************************************************************************************
+NAME  : ADD INCREMENTAL DEPENDENCIES
+LIBS  : stdlib.h
+NOTES : collects nodes which depend on variable node, "is_dependent" is scratch array of flags of nodes.
+        Arguments are created before node, so one pass in order of indexes is enough.
+**********************************************************************************************************/
+void add_incremental_dependencies(struct incremental_evaluator* evaluator, int slot, size_t variable_node,
+	unsigned char* is_dependent)
+{
+	const size_t BUFFER_ELEMENT = 1;
+
+	memset(is_dependent, 0, evaluator->nodes_count);
+	is_dependent[variable_node] = 1;
+
+	size_t dependent_nodes_count = 1;
+	for (size_t i = variable_node + 1; i < evaluator->nodes_count; i++)
+	{
+		const struct incremental_node* node = &evaluator->nodes[i];
+		for (size_t j = 0; j < node->arguments_count; j++)
+		{
+			is_dependent[i] |= is_dependent[node->arguments[j]];
+		}
+		dependent_nodes_count += is_dependent[i];
+	}
+
+	size_t* dependent_nodes = calloc(dependent_nodes_count + BUFFER_ELEMENT, sizeof(size_t));
+	if (dependent_nodes == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	size_t count = 0;
+	for (size_t i = variable_node; i < evaluator->nodes_count; i++)
+	{
+		if (is_dependent[i] == 1)
+		{
+			dependent_nodes[count] = i;
+			count++;
+		}
+	}
+
+	evaluator->dependent_nodes[slot] = dependent_nodes;
+	evaluator->dependent_nodes_counts[slot] = dependent_nodes_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : INCREMENTAL EVALUATOR INITIALIZE
+LIBS  : stdlib.h
+NOTES : walks instructions of compiled formula with stack of nodes instead of values, like
+        "add_formula_to_group()". Variables are 0 until they are set. Returned pointer must be passed to
+        "incremental_evaluator_free()" after use.
+**********************************************************************************************************/
+struct incremental_evaluator* incremental_evaluator_initialize(const struct compiled_formula* formula)
+{
+	const size_t BUFFER_ELEMENT = 1;
+	const size_t MAX_ARGUMENTS_COUNT = 3;
+
+	struct incremental_evaluator* evaluator = calloc(1, sizeof(struct incremental_evaluator));
+	if (evaluator == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	evaluator->formula = formula;
+
+	size_t capacity = formula->instructions_count + BUFFER_ELEMENT;
+	evaluator->nodes = calloc(capacity, sizeof(struct incremental_node));
+	evaluator->node_values = calloc(capacity, sizeof(double));
+	evaluator->node_errors = calloc(capacity, sizeof(int));
+	evaluator->node_error_positions = calloc(capacity, sizeof(size_t));
+	evaluator->dirty_nodes = calloc(capacity, sizeof(unsigned char));
+	evaluator->bindings = calloc(formula->variables_count + BUFFER_ELEMENT, sizeof(double));
+	evaluator->dependent_nodes = calloc(formula->variables_count + BUFFER_ELEMENT, sizeof(size_t*));
+	evaluator->dependent_nodes_counts = calloc(formula->variables_count + BUFFER_ELEMENT, sizeof(size_t));
+	size_t* nodes_stack = calloc(formula->max_stack_depth + BUFFER_ELEMENT, sizeof(size_t));
+	size_t* variable_nodes = calloc(formula->variables_count + BUFFER_ELEMENT, sizeof(size_t));
+	if (evaluator->nodes == NULL || evaluator->node_values == NULL || evaluator->node_errors == NULL ||
+		evaluator->node_error_positions == NULL || evaluator->dirty_nodes == NULL || evaluator->bindings == NULL ||
+		evaluator->dependent_nodes == NULL || evaluator->dependent_nodes_counts == NULL || nodes_stack == NULL ||
+		variable_nodes == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	//every occurrence of variable is one node, variable removed by optimizer has no node.
+	for (size_t slot = 0; slot < formula->variables_count; slot++)
+	{
+		variable_nodes[slot] = (size_t)-1;
+	}
+
+	size_t stack_depth = 0;
+	for (size_t i = 0; i < formula->instructions_count; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+		struct incremental_node node = { instruction->opcode, instruction->operand, { 0, 0, 0 }, 0,
+			formula->instruction_positions[i] };
+
+		//laziness is decided by node of operation, so skip instructions are not needed.
+		if (is_skip_instruction(instruction) == 1)
+		{
+			continue;
+		}
+
+		size_t node_index;
+		switch (instruction->opcode)
+		{
+			case PUSH_CONSTANT:
+				node_index = add_incremental_node(evaluator, &node);
+				evaluator->node_values[node_index] = formula->constants[instruction->operand];
+				evaluator->dirty_nodes[node_index] = 0;
+				break;
+
+			case PUSH_VARIABLE:
+				if (variable_nodes[instruction->operand] == (size_t)-1)
+				{
+					variable_nodes[instruction->operand] = add_incremental_node(evaluator, &node);
+				}
+				node_index = variable_nodes[instruction->operand];
+				break;
+
+			case DUPLICATE:
+				node_index = nodes_stack[stack_depth - 1];
+				break;
+
+			default:
+				node.arguments_count = get_instruction_arguments_count(instruction);
+				stack_depth -= node.arguments_count;
+				for (size_t j = 0; j < node.arguments_count; j++)
+				{
+					node.arguments[j] = nodes_stack[stack_depth + j];
+				}
+				node_index = add_incremental_node(evaluator, &node);
+		}
+
+		nodes_stack[stack_depth] = node_index;
+		stack_depth++;
+	}
+	evaluator->root_node = nodes_stack[0];
+
+	unsigned char* is_dependent = calloc(evaluator->nodes_count + BUFFER_ELEMENT, sizeof(unsigned char));
+	if (is_dependent == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	for (size_t slot = 0; slot < formula->variables_count; slot++)
+	{
+		if (variable_nodes[slot] != (size_t)-1)
+		{
+			add_incremental_dependencies(evaluator, (int)slot, variable_nodes[slot], is_dependent);
+		}
+	}
+
+	free(is_dependent);
+	free(variable_nodes);
+	free(nodes_stack);
+
+	evaluator->stack = stack_double_initialize(MAX_ARGUMENTS_COUNT);
+
+	return evaluator;
+}
+
+
+/**********************************************************************************************************
+NAME  : INCREMENTAL EVALUATOR FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with incremental evaluator, formula is not freed.
+**********************************************************************************************************/
+void incremental_evaluator_free(struct incremental_evaluator* evaluator)
+{
+	for (size_t slot = 0; slot < evaluator->formula->variables_count; slot++)
+	{
+		free(evaluator->dependent_nodes[slot]);
+	}
+
+	if (evaluator->stack != NULL)
+	{
+		stack_double_free(evaluator->stack);
+	}
+	free(evaluator->nodes);
+	free(evaluator->node_values);
+	free(evaluator->node_errors);
+	free(evaluator->node_error_positions);
+	free(evaluator->dirty_nodes);
+	free(evaluator->bindings);
+	free(evaluator->dependent_nodes);
+	free(evaluator->dependent_nodes_counts);
+	free(evaluator);
+}
+
+
+/**********************************************************************************************************
+NAME  : SET INCREMENTAL VARIABLE
+LIBS  : string.h
+NOTES : slot is slot of variable in compiled formula. Nodes which depend on variable become dirty only if
+        value really changed.
+**********************************************************************************************************/
+void set_incremental_variable(struct incremental_evaluator* evaluator, int slot, double value)
+{
+	if (memcmp(&evaluator->bindings[slot], &value, sizeof(double)) == 0)
+	{
+		return;
+	}
+
+	evaluator->bindings[slot] = value;
+	if (evaluator->dependent_nodes_counts[slot] == 0)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < evaluator->dependent_nodes_counts[slot]; i++)
+	{
+		evaluator->dirty_nodes[evaluator->dependent_nodes[slot][i]] = 1;
+	}
+	if (evaluator->dependent_nodes[slot][0] < evaluator->first_dirty_node)
+	{
+		evaluator->first_dirty_node = evaluator->dependent_nodes[slot][0];
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : CALCULATE INCREMENTAL NODE
+LIBS  : math.h
+NOTES : calculates node whose arguments are calculated already, like "evaluate_formula_group()" does.
+**********************************************************************************************************/
+void calculate_incremental_node(struct incremental_evaluator* evaluator, size_t node_index)
+{
+	const struct incremental_node* node = &evaluator->nodes[node_index];
+	evaluator->node_errors[node_index] = NO_ERROR;
+
+	if (node->opcode == PUSH_VARIABLE)
+	{
+		evaluator->node_values[node_index] = evaluator->bindings[node->operand];
+		return;
+	}
+
+	//the first failed argument is the one which fails first in formula evaluated alone.
+	for (size_t i = 0; i < node->arguments_count; i++)
+	{
+		size_t argument = node->arguments[i];
+		if (evaluator->node_errors[argument] != NO_ERROR && is_lazy_argument_used(node->opcode, node->operand,
+			evaluator->node_values[node->arguments[0]], i) == 1)
+		{
+			evaluator->node_values[node_index] = NAN;
+			evaluator->node_errors[node_index] = evaluator->node_errors[argument];
+			evaluator->node_error_positions[node_index] = evaluator->node_error_positions[argument];
+			return;
+		}
+	}
+
+	clear_stack_double(evaluator->stack);
+	for (size_t i = 0; i < node->arguments_count; i++)
+	{
+		push_stack_double(evaluator->stack, evaluator->node_values[node->arguments[i]]);
+	}
+
+	if (node->opcode == CALL_OPERATION)
+	{
+		MATH_OPERATIONS[node->operand].pointer_on_function(evaluator->stack);
+	}
+	else
+	{
+		MATH_FUNCTIONS[node->operand].pointer_on_function(evaluator->stack);
+	}
+
+	if (evaluator->stack->error_code != NO_ERROR)
+	{
+		evaluator->node_values[node_index] = NAN;
+		evaluator->node_errors[node_index] = evaluator->stack->error_code;
+		evaluator->node_error_positions[node_index] = node->position;
+	}
+	else
+	{
+		evaluator->node_values[node_index] = pop_stack_double(evaluator->stack);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE INCREMENTAL
+LIBS  : -
+NOTES : calculates dirty nodes, count of calculated nodes is written to "recomputed_nodes_count".
+**********************************************************************************************************/
+struct evaluation_result evaluate_incremental(struct incremental_evaluator* evaluator)
+{
+	evaluator->recomputed_nodes_count = 0;
+
+	for (size_t i = evaluator->first_dirty_node; i < evaluator->nodes_count; i++)
+	{
+		if (evaluator->dirty_nodes[i] == 1)
+		{
+			calculate_incremental_node(evaluator, i);
+			evaluator->dirty_nodes[i] = 0;
+			evaluator->recomputed_nodes_count++;
+		}
+	}
+	evaluator->first_dirty_node = evaluator->nodes_count;
+
+	struct evaluation_result result;
+	result.value = evaluator->node_values[evaluator->root_node];
+	result.error_code = evaluator->node_errors[evaluator->root_node];
+	result.error_position = (result.error_code != NO_ERROR) ?
+		evaluator->node_error_positions[evaluator->root_node] : 0;
+
+	return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////INCREMENTAL EVALUATION SECTION END//////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////BATCH EVALUATION SECTION////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Batch evaluation calculates one compiled formula for many rows of variable values. Values are passed as
+columns (structure of arrays): "columns[slot]" points on array of values of variable with such slot.
+Rows are processed by blocks of BATCH_BLOCK_SIZE rows, every instruction of formula is applied to the whole
+block by batch function, so stack of batch evaluation contains blocks instead of single values.
+
+Failed rows do not stop evaluation: result of such row is NAN and its error code is written to side array of
+errors, all other rows are calculated as usual.
+
+Skip instruction jumps over lazy operand only if all rows of block skip it (or already failed). Otherwise
+operand is calculated for all rows, rows which skip it are remembered and their errors from this operand
+are forgotten at target of skip, so every row gets the same result and error as in
+"evaluate_compiled_formula()".
+
+Zone map keeps interval (the least and the greatest value, NAN flag) of every column in every block of rows.
+Before block is calculated, formula is evaluated once over intervals of its columns by interval functions. If
+result interval proves that every row of block gives the same number without errors (predicate is true in
+all rows or false in all rows), block is not calculated, the number is written to all its rows. Blocks which
+are not proved go in runs, so after failed proof the next blocks are tried more rarely.
+
+Zone map pays off only for data whose values are clustered (sorted by time, by key etc.), random data almost
+never gives such blocks and gains nothing. Building of zone map reads all columns once, it costs about as much
+as batch evaluation of cheap formula, so map should be built once per data and used by many formulas
+(--bench prints both speedups, with ready map and with building of map).
+
+*/
+
+/**********************************************************************************************************
+NAME  : BATCH STACK
+LIBS  : -
+NOTES : stack of blocks for batch evaluation, every element of stack is BATCH_BLOCK_SIZE doubles.
+        "row_errors" keeps error codes of rows of current block. "skip_rows" and "skip_targets" are stack of
+        skips which only part of rows takes: flags of skipping rows and target instruction of every skip.
+        Every such skip waits for operation over value on the stack, so there are at most "stack_capacity"
+        of them. "intervals" is stack of interval evaluation of block. "accuracy" selects vector functions
+        (BATCH_ACCURACY_EXACT after initialization).
+**********************************************************************************************************/
+struct batch_stack
+{
+	double* blocks;
+	int* row_errors;
+	size_t stack_capacity;
+
+	unsigned char* skip_rows;
+	size_t* skip_targets;
+
+	struct interval* intervals;
+
+	int accuracy;
+};
+
+
+/**********************************************************************************************************
+NAME  : BATCH STACK INITIALIZE
+LIBS  : stdlib.h
+NOTES : -
+**********************************************************************************************************/
+struct batch_stack* batch_stack_initialize(size_t stack_capacity)
+{
+	struct batch_stack* batch_stack = calloc(1, sizeof(struct batch_stack));
+	if (batch_stack == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	const size_t BUFFER_ELEMENT = 1;
+	batch_stack->blocks = calloc(stack_capacity * BATCH_BLOCK_SIZE, sizeof(double));
+	batch_stack->row_errors = calloc(BATCH_BLOCK_SIZE, sizeof(int));
+	batch_stack->skip_rows = calloc((stack_capacity + BUFFER_ELEMENT) * BATCH_BLOCK_SIZE,
+		sizeof(unsigned char));
+	batch_stack->skip_targets = calloc(stack_capacity + BUFFER_ELEMENT, sizeof(size_t));
+	batch_stack->intervals = calloc(stack_capacity + BUFFER_ELEMENT, sizeof(struct interval));
+	if (batch_stack->blocks == NULL || batch_stack->row_errors == NULL || batch_stack->skip_rows == NULL ||
+		batch_stack->skip_targets == NULL || batch_stack->intervals == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	batch_stack->stack_capacity = stack_capacity;
+
+	return batch_stack;
+}
+
+
+/**********************************************************************************************************
+NAME  : BATCH STACK FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with batch stack.
+**********************************************************************************************************/
+void batch_stack_free(struct batch_stack* batch_stack)
+{
+	free(batch_stack->blocks);
+	free(batch_stack->row_errors);
+	free(batch_stack->skip_rows);
+	free(batch_stack->skip_targets);
+	free(batch_stack->intervals);
+	free(batch_stack);
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE BATCH BLOCK
+LIBS  : string.h
+NOTES : calculates rows of one block which starts at "block_start" row of columns, results of rows are left
+        in the first block of stack and their errors in "row_errors" of stack.
+**********************************************************************************************************/
+int evaluate_batch_block(const struct compiled_formula* formula, const double* const* columns,
+	size_t block_start, size_t block_rows_count, struct batch_stack* stack)
+{
+	int* row_errors = stack->row_errors;
+
+	for (size_t row = 0; row < block_rows_count; row++)
+	{
+		row_errors[row] = NO_ERROR;
+	}
+
+	//pointer on block above the top of stack.
+	double* head_block = stack->blocks;
+	size_t skips_count = 0;
+
+	for (size_t i = 0; i < formula->instructions_count; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+
+		//lazy operand is finished, rows which skip it forget its errors.
+		while (skips_count != 0 && stack->skip_targets[skips_count - 1] == i)
+		{
+			skips_count--;
+			const unsigned char* skip_rows = stack->skip_rows + skips_count * BATCH_BLOCK_SIZE;
+			for (size_t row = 0; row < block_rows_count; row++)
+			{
+				if (skip_rows[row] == 1)
+				{
+					row_errors[row] = NO_ERROR;
+				}
+			}
+		}
+
+		switch (instruction->opcode)
+		{
+			case PUSH_CONSTANT:
+			{
+				double constant = formula->constants[instruction->operand];
+				for (size_t row = 0; row < block_rows_count; row++)
+				{
+					head_block[row] = constant;
+				}
+				head_block += BATCH_BLOCK_SIZE;
+				break;
+			}
+
+			case PUSH_VARIABLE:
+				memcpy(head_block, columns[instruction->operand] + block_start,
+					block_rows_count * sizeof(double));
+				head_block += BATCH_BLOCK_SIZE;
+				break;
+
+			case DUPLICATE:
+				memcpy(head_block, head_block - BATCH_BLOCK_SIZE, block_rows_count * sizeof(double));
+				head_block += BATCH_BLOCK_SIZE;
+				break;
+
+			case CALL_OPERATION:
+				head_block -= BATCH_BLOCK_SIZE;
+				MATH_OPERATIONS[instruction->operand].pointer_on_batch_function(
+					head_block - BATCH_BLOCK_SIZE, head_block, block_rows_count, row_errors);
+				break;
+
+			case CALL_FUNCTION:
+			{
+				const struct function_entry* function = &MATH_FUNCTIONS[instruction->operand];
+				head_block -= (function->arguments_count - 1) * BATCH_BLOCK_SIZE;
+				if (stack->accuracy != BATCH_ACCURACY_EXACT && function->pointer_on_vector_function != NULL)
+				{
+					function->pointer_on_vector_function(head_block - BATCH_BLOCK_SIZE,
+						(function->arguments_count > 1) ? head_block : NULL, block_rows_count, row_errors,
+						stack->accuracy);
+					break;
+				}
+				function->pointer_on_batch_function(head_block - BATCH_BLOCK_SIZE,
+					(function->arguments_count > 1) ? head_block : NULL, block_rows_count, row_errors);
+				break;
+			}
+
+			case SKIP_IF_TRUE:
+			case SKIP_IF_FALSE:
+			case SKIP_IF_BELOW_TRUE:
+			{
+				const double* tested_block = head_block -
+					((instruction->opcode == SKIP_IF_BELOW_TRUE) ? 2 : 1) * BATCH_BLOCK_SIZE;
+				unsigned char* skip_rows = stack->skip_rows + skips_count * BATCH_BLOCK_SIZE;
+
+				size_t skip_rows_count = 0;
+				size_t failed_rows_count = 0;
+				for (size_t row = 0; row < block_rows_count; row++)
+				{
+					skip_rows[row] = (row_errors[row] == NO_ERROR &&
+						is_skip_taken(instruction->opcode, tested_block[row]) == 1);
+					skip_rows_count += skip_rows[row];
+					failed_rows_count += (row_errors[row] != NO_ERROR);
+				}
+
+				if (skip_rows_count + failed_rows_count == block_rows_count)
+				{
+					for (size_t row = 0; row < block_rows_count; row++)
+					{
+						head_block[row] = NAN;
+					}
+					head_block += BATCH_BLOCK_SIZE;
+					i = (size_t)instruction->operand - 1;
+				}
+				else if (skip_rows_count != 0)
+				{
+					stack->skip_targets[skips_count] = (size_t)instruction->operand;
+					skips_count++;
+				}
+				break;
+			}
+
+			default:
+				return UNEXPECTED_TOKEN;
+		}
+	}
+
+	return NO_ERROR;
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE COMPILED FORMULA BATCH
+LIBS  : string.h
+NOTES : writes result of every row to results array and error code of every row (NO_ERROR for rows
+        without errors) to errors array, errors can be NULL if they are not needed. Stack must be created
+        with capacity not less than "max_stack_depth" of formula, otherwise STACK_OVERFLOW is returned
+        and nothing is calculated. Function does not allocate memory.
+**********************************************************************************************************/
+int evaluate_compiled_formula_batch(const struct compiled_formula* formula, const double* const* columns,
+	size_t rows_count, double* results, int* errors, struct batch_stack* stack)
+{
+	if (stack->stack_capacity < formula->max_stack_depth)
+	{
+		return STACK_OVERFLOW;
+	}
+
+	for (size_t block_start = 0; block_start < rows_count; block_start += BATCH_BLOCK_SIZE)
+	{
+		size_t block_rows_count = rows_count - block_start;
+		if (block_rows_count > BATCH_BLOCK_SIZE)
+		{
+			block_rows_count = BATCH_BLOCK_SIZE;
+		}
+
+		int error_code = evaluate_batch_block(formula, columns, block_start, block_rows_count, stack);
+		if (error_code != NO_ERROR)
+		{
+			return error_code;
+		}
+
+		memcpy(results + block_start, stack->blocks, block_rows_count * sizeof(double));
+		if (errors != NULL)
+		{
+			memcpy(errors + block_start, stack->row_errors, block_rows_count * sizeof(int));
+		}
+	}
+
+	return NO_ERROR;
+}
+
+/**********************************************************************************************************
+NAME  : ZONE MAP
+LIBS  : -
+NOTES : intervals of columns of every block of rows, intervals of one block are consecutive and go in order
+        of columns: interval of column "slot" in block "block" is "block_intervals[block * columns_count +
+        slot]". Intervals of columns never have errors.
+**********************************************************************************************************/
+struct zone_map
+{
+	struct interval* block_intervals;
+	size_t columns_count;
+	size_t blocks_count;
+	size_t rows_count;
+};
+
+
+/**********************************************************************************************************
+NAME  : ZONE MAP INITIALIZE
+LIBS  : stdlib.h
+NOTES : scans columns once and keeps the least and the greatest number of every block of BATCH_BLOCK_SIZE rows.
+        Block whose rows are all NAN gets unbounded interval. Returned pointer must be passed to
+        "zone_map_free()" after use.
+**********************************************************************************************************/
+struct zone_map* zone_map_initialize(const double* const* columns, size_t columns_count, size_t rows_count)
+{
+	const size_t BUFFER_ELEMENT = 1;
+
+	struct zone_map* zones = calloc(1, sizeof(struct zone_map));
+	if (zones == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	zones->columns_count = columns_count;
+	zones->rows_count = rows_count;
+	zones->blocks_count = (rows_count + BATCH_BLOCK_SIZE - 1) / BATCH_BLOCK_SIZE;
+	zones->block_intervals = calloc(zones->blocks_count * columns_count + BUFFER_ELEMENT, sizeof(struct interval));
+	if (zones->block_intervals == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	for (size_t block = 0; block < zones->blocks_count; block++)
+	{
+		size_t block_start = block * BATCH_BLOCK_SIZE;
+		size_t block_end = (block_start + BATCH_BLOCK_SIZE < rows_count) ? block_start + BATCH_BLOCK_SIZE :
+			rows_count;
+
+		for (size_t slot = 0; slot < columns_count; slot++)
+		{
+			const double* column = columns[slot];
+			double minimum = INFINITY;
+			double maximum = -INFINITY;
+			int is_nan_possible = 0;
+
+			//NAN is not less and not greater than anything, so it never becomes bound.
+			for (size_t row = block_start; row < block_end; row++)
+			{
+				double value = column[row];
+				minimum = (value < minimum) ? value : minimum;
+				maximum = (value > maximum) ? value : maximum;
+				is_nan_possible |= (value != value);
+			}
+
+			struct interval* block_interval = &zones->block_intervals[block * columns_count + slot];
+			if (minimum > maximum)
+			{
+				set_unbounded_interval(block_interval, 0);
+			}
+			else
+			{
+				set_interval(block_interval, minimum, maximum, is_nan_possible, 0);
+			}
+		}
+	}
+
+	return zones;
+}
+
+
+/**********************************************************************************************************
+NAME  : ZONE MAP FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with zone map.
+**********************************************************************************************************/
+void zone_map_free(struct zone_map* zones)
+{
+	free(zones->block_intervals);
+	free(zones);
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE COMPILED FORMULA INTERVAL
+LIBS  : -
+NOTES : evaluates formula over intervals of variables in order of their slots, result contains results of all
+        rows whose variables are inside of these intervals. Skip instructions are not taken: lazy operand is
+        evaluated too and interval function of operation decides if its errors are passed. Stack must contain
+        not less than "max_stack_depth" of formula elements.
+**********************************************************************************************************/
+struct interval evaluate_compiled_formula_interval(const struct compiled_formula* formula,
+	const struct interval* variable_intervals, struct interval* stack)
+{
+	//count of intervals on the stack.
+	size_t stack_depth = 0;
+
+	for (size_t i = 0; i < formula->instructions_count; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+
+		switch (instruction->opcode)
+		{
+			case PUSH_CONSTANT:
+			{
+				double constant = formula->constants[instruction->operand];
+				set_interval(&stack[stack_depth], constant, constant, isnan(constant), 0);
+				stack_depth++;
+				break;
+			}
+
+			case PUSH_VARIABLE:
+				stack[stack_depth] = variable_intervals[instruction->operand];
+				stack_depth++;
+				break;
+
+			case DUPLICATE:
+				stack[stack_depth] = stack[stack_depth - 1];
+				stack_depth++;
+				break;
+
+			case CALL_OPERATION:
+				stack_depth--;
+				MATH_OPERATIONS[instruction->operand].pointer_on_interval_function(&stack[stack_depth - 1],
+					&stack[stack_depth - 1]);
+				break;
+
+			case CALL_FUNCTION:
+			{
+				size_t arguments_count = MATH_FUNCTIONS[instruction->operand].arguments_count;
+				stack_depth -= arguments_count - 1;
+				MATH_FUNCTIONS[instruction->operand].pointer_on_interval_function(&stack[stack_depth - 1],
+					&stack[stack_depth - 1]);
+				break;
+			}
+		}
+	}
+
+	return stack[0];
+}
+
+
+/**********************************************************************************************************
+NAME  : IS INTERVAL BLOCK CONSTANT
+LIBS  : -
+NOTES : return 1 if every row of block gives "result->minimum" without error. Zero of arithmetic can be
+        negative zero in some rows, so zero is constant only if formula ends by comparison or logical
+        operation, which gives exactly 0.
+**********************************************************************************************************/
+int is_interval_block_constant(const struct compiled_formula* formula, const struct interval* result)
+{
+	if (result->is_error_possible == 1 || result->is_nan_possible == 1 || result->minimum != result->maximum)
+	{
+		return 0;
+	}
+	if (result->minimum != 0)
+	{
+		return 1;
+	}
+
+	const struct instruction* last_instruction = &formula->instructions[formula->instructions_count - 1];
+	if (last_instruction->opcode == CALL_FUNCTION)
+	{
+		return last_instruction->operand == FUNCTION_NOT;
+	}
+
+	return last_instruction->opcode == CALL_OPERATION && last_instruction->operand != OPERATION_ADD &&
+		last_instruction->operand != OPERATION_SUBTRACT && last_instruction->operand != OPERATION_MULTIPLY &&
+		last_instruction->operand != OPERATION_DIVIDE && last_instruction->operand != OPERATION_DIV &&
+		last_instruction->operand != OPERATION_MOD;
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE COMPILED FORMULA ZONES
+LIBS  : string.h
+NOTES : the same as "evaluate_compiled_formula_batch()", but columns are described by zone map, and blocks
+        whose result is proved by interval evaluation are not calculated. Count of such blocks is written to
+        "skipped_blocks_count". Blocks which can not be proved go in runs (and in unsorted data every block
+        is such), so after every failed proof the next proof is made twice further, but not further than
+        MAX_PROOF_DISTANCE blocks, and the first proved block makes every block tried again.
+**********************************************************************************************************/
+int evaluate_compiled_formula_zones(const struct compiled_formula* formula, const double* const* columns,
+	const struct zone_map* zones, double* results, int* errors, struct batch_stack* stack,
+	size_t* skipped_blocks_count)
+{
+	const size_t MAX_PROOF_DISTANCE = 64;
+
+	*skipped_blocks_count = 0;
+	size_t proof_distance = 1;
+	size_t next_proof_block = 0;
+
+	if (stack->stack_capacity < formula->max_stack_depth)
+	{
+		return STACK_OVERFLOW;
+	}
+
+	for (size_t block = 0; block < zones->blocks_count; block++)
+	{
+		size_t block_start = block * BATCH_BLOCK_SIZE;
+		size_t block_rows_count = zones->rows_count - block_start;
+		if (block_rows_count > BATCH_BLOCK_SIZE)
+		{
+			block_rows_count = BATCH_BLOCK_SIZE;
+		}
+
+		if (block == next_proof_block)
+		{
+			struct interval result = evaluate_compiled_formula_interval(formula,
+				&zones->block_intervals[block * zones->columns_count], stack->intervals);
+			if (is_interval_block_constant(formula, &result) == 1)
+			{
+				for (size_t row = 0; row < block_rows_count; row++)
+				{
+					results[block_start + row] = result.minimum;
+				}
+				for (size_t row = 0; errors != NULL && row < block_rows_count; row++)
+				{
+					errors[block_start + row] = NO_ERROR;
+				}
+				(*skipped_blocks_count)++;
+				proof_distance = 1;
+				next_proof_block = block + 1;
+				continue;
+			}
+
+			proof_distance = (proof_distance * 2 < MAX_PROOF_DISTANCE) ? proof_distance * 2 : MAX_PROOF_DISTANCE;
+			next_proof_block = block + proof_distance;
+		}
+
+		int error_code = evaluate_batch_block(formula, columns, block_start, block_rows_count, stack);
+		if (error_code != NO_ERROR)
+		{
+			return error_code;
+		}
+
+		memcpy(results + block_start, stack->blocks, block_rows_count * sizeof(double));
+		if (errors != NULL)
+		{
+			memcpy(errors + block_start, stack->row_errors, block_rows_count * sizeof(int));
+		}
+	}
+
+	return NO_ERROR;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////BATCH EVALUATION SECTION END////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////JIT SECTION/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+JIT translates compiled formula to x86-64 machine code, so hot formula is evaluated without dispatch of
+instructions and without memory stack. Element of double stack with depth d lives in register xmm<d>,
+register xmm15 is scratch, so formula with "max_stack_depth" greater than JIT_REGISTERS_COUNT is not
+translated. Simple operations are made by SSE2 instructions, "sin", "arccos", "ln" and other functions
+are direct calls of C library. All registers xmm are not saved by called function, so live registers are
+spilled to stack frame before call and loaded back after it.
+
+Errors are checked by the same conditions as stack functions use. Failed code writes error code and index
+of failed instruction and returns NAN, so result and error are identical to "evaluate_compiled_formula()"
+(only sign of NAN result can differ, C compiler may swap operands of commutative operations).
+
+Machine code is written to buffer, then it is copied to pages from "mmap()" which are made executable (and
+not writable) by "mprotect()". Every translated formula is appended to "/tmp/perf-<pid>.map", so "perf"
+attributes samples to formula text. JIT works only on x86-64 systems other than Windows and can be
+disabled by NO_JIT macro, otherwise "jit_compile_formula()" returns NULL and compiled formula is evaluated
+as usual.
+
+Generated function has signature:
+double function(const double* bindings, const double* constants, struct jit_error* error);
+
+*/
+
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(NO_JIT)
+#define JIT_AVAILABLE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define JIT_REGISTERS_COUNT 14
+#define JIT_SCRATCH_REGISTER 15
+
+//Numbers of general purpose registers.
+#define JIT_RAX 0
+#define JIT_RBX 3
+#define JIT_RSP 4
+#define JIT_R12 12
+
+//Mandatory prefixes and opcodes (after 0x0F) of SSE2 instructions.
+#define JIT_PREFIX_SD 0xF2
+#define JIT_PREFIX_PD 0x66
+#define JIT_MOVSD_LOAD  0x10
+#define JIT_MOVSD_STORE 0x11
+#define JIT_CVTSI2SD    0x2A
+#define JIT_UCOMISD     0x2E
+#define JIT_MOVAPD      0x28
+#define JIT_SQRTSD      0x51
+#define JIT_ANDPD       0x54
+#define JIT_XORPD       0x57
+#define JIT_ADDSD       0x58
+#define JIT_MULSD       0x59
+#define JIT_SUBSD       0x5C
+#define JIT_DIVSD       0x5E
+#define JIT_MOVQ        0x6E
+#define JIT_MOVQ_STORE  0x7E
+
+//Opcodes (after 0x0F) of conditional jumps.
+#define JIT_JAE 0x83
+#define JIT_JE  0x84
+#define JIT_JNE 0x85
+#define JIT_JA  0x87
+#define JIT_JP  0x8A
+#define JIT_JNP 0x8B
+
+//Opcodes (after 0x0F) of "set<condition> al".
+#define JIT_SETAE 0x93
+#define JIT_SETE  0x94
+#define JIT_SETNE 0x95
+#define JIT_SETA  0x97
+
+/**********************************************************************************************************
+NAME  : JIT ERROR
+LIBS  : -
+NOTES : written by generated code, "instruction_index" is index of failed instruction of compiled formula.
+**********************************************************************************************************/
+struct jit_error
+{
+	int error_code;
+	size_t instruction_index;
+};
+
+
+/**********************************************************************************************************
+NAME  : JIT FORMULA
+LIBS  : -
+NOTES : generated code uses constant pool of compiled formula, so compiled formula must not be freed
+        before JIT formula.
+**********************************************************************************************************/
+struct jit_formula
+{
+	double(*function)(const double*, const double*, struct jit_error*);
+	void* code;
+	size_t code_size;
+	const struct compiled_formula* formula;
+};
+
+
+/**********************************************************************************************************
+NAME  : JIT BUFFER
+LIBS  : -
+NOTES : growable buffer of machine code.
+**********************************************************************************************************/
+struct jit_buffer
+{
+	unsigned char* data;
+	size_t buffer_capacity;
+	size_t current_length;
+};
+
+
+/**********************************************************************************************************
+NAME  : JIT COTAN
+LIBS  : math.h
+NOTES : called by generated code, the same as "stack_cotan()".
+**********************************************************************************************************/
+double jit_cotan(double operand)
+{
+	return 1 / tan(operand);
+}
+
+
+/**********************************************************************************************************
+NAME  : GET JIT ERROR VALUE
+LIBS  : -
+NOTES : NAN whose low bits of mantissa keep error code. Integer division never gives NAN without error, so
+        generated code takes error code from NAN result of "jit_div()" and "jit_mod()".
+**********************************************************************************************************/
+double get_jit_error_value(int error_code)
+{
+	const unsigned long long QUIET_NAN_BITS = 0x7FF8000000000000ULL;
+
+	return get_double_from_bits(QUIET_NAN_BITS | (unsigned int)error_code);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT DIV
+LIBS  : stdlib.h
+NOTES : called by generated code, the same as "stack_div()". Error is returned as NAN from
+        "get_jit_error_value()".
+**********************************************************************************************************/
+double jit_div(double first_operand, double second_operand)
+{
+	div_t division_result;
+	int error_code = divide_integers(first_operand, second_operand, &division_result);
+
+	return (error_code == NO_ERROR) ? (double)division_result.quot : get_jit_error_value(error_code);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT MOD
+LIBS  : stdlib.h
+NOTES : called by generated code, the same as "stack_mod()". Error is returned as NAN from
+        "get_jit_error_value()".
+**********************************************************************************************************/
+double jit_mod(double first_operand, double second_operand)
+{
+	div_t division_result;
+	int error_code = divide_integers(first_operand, second_operand, &division_result);
+
+	return (error_code == NO_ERROR) ? (double)division_result.rem : get_jit_error_value(error_code);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT BYTES
+LIBS  : stdlib.h, string.h
+NOTES : appends bytes to buffer, buffer grows twice when it is full.
+**********************************************************************************************************/
+void jit_emit_bytes(struct jit_buffer* buffer, const unsigned char* bytes, size_t bytes_count)
+{
+	if (buffer->current_length + bytes_count > buffer->buffer_capacity)
+	{
+		while (buffer->current_length + bytes_count > buffer->buffer_capacity)
+		{
+			buffer->buffer_capacity *= 2;
+		}
+		buffer->data = realloc(buffer->data, buffer->buffer_capacity);
+		if (buffer->data == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+	}
+
+	memcpy(buffer->data + buffer->current_length, bytes, bytes_count);
+	buffer->current_length += bytes_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT BYTE
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void jit_emit_byte(struct jit_buffer* buffer, unsigned char byte)
+{
+	jit_emit_bytes(buffer, &byte, 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT INTEGER
+LIBS  : -
+NOTES : appends "bytes_count" low bytes of value in little-endian order.
+**********************************************************************************************************/
+void jit_emit_integer(struct jit_buffer* buffer, unsigned long long value, size_t bytes_count)
+{
+	for (size_t i = 0; i < bytes_count; i++)
+	{
+		jit_emit_byte(buffer, (unsigned char)(value >> (8 * i)));
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT SSE
+LIBS  : -
+NOTES : appends SSE2 instruction with two registers xmm (or xmm and general purpose register for
+        "cvtsi2sd" and "movq"). "is_wide" sets REX.W bit.
+**********************************************************************************************************/
+void jit_emit_sse(struct jit_buffer* buffer, unsigned char prefix, unsigned char opcode, int register_index,
+	int rm_register_index, int is_wide)
+{
+	unsigned char rex = 0x40 | (is_wide << 3) | ((register_index >> 3) << 2) | (rm_register_index >> 3);
+
+	jit_emit_byte(buffer, prefix);
+	if (rex != 0x40)
+	{
+		jit_emit_byte(buffer, rex);
+	}
+	jit_emit_byte(buffer, 0x0F);
+	jit_emit_byte(buffer, opcode);
+	jit_emit_byte(buffer, 0xC0 | ((register_index & 7) << 3) | (rm_register_index & 7));
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT SSE MEMORY
+LIBS  : -
+NOTES : appends SSE2 instruction with register xmm and memory operand [base + displacement].
+**********************************************************************************************************/
+void jit_emit_sse_memory(struct jit_buffer* buffer, unsigned char prefix, unsigned char opcode,
+	int register_index, int base_register_index, size_t displacement)
+{
+	//base rsp or r12 needs SIB byte without index.
+	const unsigned char SIB_WITHOUT_INDEX = 0x24;
+
+	unsigned char rex = 0x40 | ((register_index >> 3) << 2) | (base_register_index >> 3);
+
+	jit_emit_byte(buffer, prefix);
+	if (rex != 0x40)
+	{
+		jit_emit_byte(buffer, rex);
+	}
+	jit_emit_byte(buffer, 0x0F);
+	jit_emit_byte(buffer, opcode);
+	jit_emit_byte(buffer, 0x80 | ((register_index & 7) << 3) | (base_register_index & 7));
+	if ((base_register_index & 7) == JIT_RSP)
+	{
+		jit_emit_byte(buffer, SIB_WITHOUT_INDEX);
+	}
+	jit_emit_integer(buffer, displacement, 4);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT LOAD DOUBLE
+LIBS  : string.h
+NOTES : loads constant to register xmm through rax.
+**********************************************************************************************************/
+void jit_emit_load_double(struct jit_buffer* buffer, int register_index, double value)
+{
+	const unsigned char MOV_RAX_IMMEDIATE[] = { 0x48, 0xB8 };
+
+	unsigned long long value_bits;
+	memcpy(&value_bits, &value, sizeof(double));
+
+	jit_emit_bytes(buffer, MOV_RAX_IMMEDIATE, sizeof(MOV_RAX_IMMEDIATE));
+	jit_emit_integer(buffer, value_bits, 8);
+	jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_MOVQ, register_index, JIT_RAX, 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT JUMP
+LIBS  : -
+NOTES : appends conditional jump with empty offset, return position of offset for "jit_patch_jump()".
+**********************************************************************************************************/
+size_t jit_emit_jump(struct jit_buffer* buffer, unsigned char condition_opcode)
+{
+	jit_emit_byte(buffer, 0x0F);
+	jit_emit_byte(buffer, condition_opcode);
+	jit_emit_integer(buffer, 0, 4);
+
+	return buffer->current_length - 4;
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT PATCH JUMP TO
+LIBS  : -
+NOTES : makes jump go to position "target_position" of code.
+**********************************************************************************************************/
+void jit_patch_jump_to(struct jit_buffer* buffer, size_t offset_position, size_t target_position)
+{
+	unsigned long long offset = target_position - (offset_position + 4);
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		buffer->data[offset_position + i] = (unsigned char)(offset >> (8 * i));
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT PATCH JUMP
+LIBS  : -
+NOTES : makes jump go to the current end of code.
+**********************************************************************************************************/
+void jit_patch_jump(struct jit_buffer* buffer, size_t offset_position)
+{
+	jit_patch_jump_to(buffer, offset_position, buffer->current_length);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT EPILOGUE
+LIBS  : -
+NOTES : frees stack frame, restores rbx, r12, r13 and returns.
+**********************************************************************************************************/
+void jit_emit_epilogue(struct jit_buffer* buffer, size_t frame_size)
+{
+	const unsigned char ADD_RSP[] = { 0x48, 0x81, 0xC4 };
+	const unsigned char POP_REGISTERS[] = { 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 };
+
+	jit_emit_bytes(buffer, ADD_RSP, sizeof(ADD_RSP));
+	jit_emit_integer(buffer, frame_size, 4);
+	jit_emit_bytes(buffer, POP_REGISTERS, sizeof(POP_REGISTERS));
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT ERROR EXIT
+LIBS  : math.h
+NOTES : error code must be in eax. Writes error code and instruction index to error structure (its address
+        is kept in r13) and returns NAN.
+**********************************************************************************************************/
+void jit_emit_error_exit(struct jit_buffer* buffer, size_t instruction_index, size_t frame_size)
+{
+	const unsigned char MOV_ERROR_CODE[] = { 0x41, 0x89, 0x45 };
+	const unsigned char MOV_INSTRUCTION_INDEX[] = { 0x49, 0xC7, 0x45 };
+
+	jit_emit_bytes(buffer, MOV_ERROR_CODE, sizeof(MOV_ERROR_CODE));
+	jit_emit_byte(buffer, (unsigned char)offsetof(struct jit_error, error_code));
+	jit_emit_bytes(buffer, MOV_INSTRUCTION_INDEX, sizeof(MOV_INSTRUCTION_INDEX));
+	jit_emit_byte(buffer, (unsigned char)offsetof(struct jit_error, instruction_index));
+	jit_emit_integer(buffer, instruction_index, 4);
+
+	jit_emit_load_double(buffer, 0, NAN);
+	jit_emit_epilogue(buffer, frame_size);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT ZERO CHECK
+LIBS  : -
+NOTES : fails with ZERO_DIVISION if register is zero (not NAN), as "second_operand != 0" of stack functions.
+**********************************************************************************************************/
+void jit_emit_zero_check(struct jit_buffer* buffer, int register_index, size_t instruction_index,
+	size_t frame_size)
+{
+	const unsigned char MOV_EAX = 0xB8;
+
+	jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_XORPD, JIT_SCRATCH_REGISTER, JIT_SCRATCH_REGISTER, 0);
+	jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, register_index, JIT_SCRATCH_REGISTER, 0);
+	size_t unordered_jump = jit_emit_jump(buffer, JIT_JP);
+	size_t not_equal_jump = jit_emit_jump(buffer, JIT_JNE);
+
+	jit_emit_byte(buffer, MOV_EAX);
+	jit_emit_integer(buffer, (unsigned int)ZERO_DIVISION, 4);
+	jit_emit_error_exit(buffer, instruction_index, frame_size);
+
+	jit_patch_jump(buffer, unordered_jump);
+	jit_patch_jump(buffer, not_equal_jump);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT RESULT ERROR CHECK
+LIBS  : -
+NOTES : fails if register is NAN from "get_jit_error_value()", error code is low 32 bits of it.
+**********************************************************************************************************/
+void jit_emit_result_error_check(struct jit_buffer* buffer, int register_index, size_t instruction_index,
+	size_t frame_size)
+{
+	jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, register_index, register_index, 0);
+	size_t ordered_jump = jit_emit_jump(buffer, JIT_JNP);
+
+	jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_MOVQ_STORE, register_index, JIT_RAX, 1);
+	jit_emit_error_exit(buffer, instruction_index, frame_size);
+
+	jit_patch_jump(buffer, ordered_jump);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT CALL
+LIBS  : -
+NOTES : calls C function with arguments in registers from "first_register" and puts its result to
+        "first_register". Registers below "first_register" are alive, they are kept in stack frame.
+**********************************************************************************************************/
+void jit_emit_call(struct jit_buffer* buffer, const void* function_address, int first_register,
+	size_t arguments_count)
+{
+	const unsigned char MOV_RAX_IMMEDIATE[] = { 0x48, 0xB8 };
+	const unsigned char CALL_RAX[] = { 0xFF, 0xD0 };
+
+	for (int i = 0; i < first_register; i++)
+	{
+		jit_emit_sse_memory(buffer, JIT_PREFIX_SD, JIT_MOVSD_STORE, i, JIT_RSP, i * sizeof(double));
+	}
+	for (int i = 0; i < (int)arguments_count; i++)
+	{
+		if (first_register != 0)
+		{
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_MOVAPD, i, first_register + i, 0);
+		}
+	}
+
+	jit_emit_bytes(buffer, MOV_RAX_IMMEDIATE, sizeof(MOV_RAX_IMMEDIATE));
+	jit_emit_integer(buffer, (unsigned long long)(size_t)function_address, 8);
+	jit_emit_bytes(buffer, CALL_RAX, sizeof(CALL_RAX));
+
+	if (first_register != 0)
+	{
+		jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_MOVAPD, first_register, 0, 0);
+	}
+	for (int i = 0; i < first_register; i++)
+	{
+		jit_emit_sse_memory(buffer, JIT_PREFIX_SD, JIT_MOVSD_LOAD, i, JIT_RSP, i * sizeof(double));
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT COMPARISON
+LIBS  : -
+NOTES : turns flags of "ucomisd" to 1 or 0 in register xmm. Condition is "seta" for MORE and LESS, "setae"
+        for MORE OR EQUALS and LESS OR EQUALS (both are false for NAN, unordered sets CF). For EQUALS ZF must
+        be set and PF (unordered, NAN) must be clear, NOT EQUALS is its negation.
+**********************************************************************************************************/
+void jit_emit_comparison(struct jit_buffer* buffer, int result_register, unsigned char condition_opcode)
+{
+	const unsigned char SETE_AL_AND_NOT_PARITY[] = { 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8 };
+	const unsigned char SETNE_AL_OR_PARITY[] = { 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8 };
+	const unsigned char MOVZX_EAX_AL[] = { 0x0F, 0xB6, 0xC0 };
+
+	if (condition_opcode == JIT_SETE)
+	{
+		jit_emit_bytes(buffer, SETE_AL_AND_NOT_PARITY, sizeof(SETE_AL_AND_NOT_PARITY));
+	}
+	else if (condition_opcode == JIT_SETNE)
+	{
+		jit_emit_bytes(buffer, SETNE_AL_OR_PARITY, sizeof(SETNE_AL_OR_PARITY));
+	}
+	else
+	{
+		jit_emit_byte(buffer, 0x0F);
+		jit_emit_byte(buffer, condition_opcode);
+		jit_emit_byte(buffer, 0xC0);
+	}
+	jit_emit_bytes(buffer, MOVZX_EAX_AL, sizeof(MOVZX_EAX_AL));
+	jit_emit_sse(buffer, JIT_PREFIX_SD, JIT_CVTSI2SD, result_register, JIT_RAX, 0);
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT OPERATION
+LIBS  : -
+NOTES : first operand is in register "first_register", second one is in the next register, result is
+        written to "first_register". Return 0 if operation can not be translated.
+**********************************************************************************************************/
+int jit_emit_operation(struct jit_buffer* buffer, int operation_index, int first_register,
+	size_t instruction_index, size_t frame_size)
+{
+	//"first OR second" compares both operands with 1, dl keeps result of the first comparison.
+	const unsigned char SETE_DL_AND_NOT_PARITY[] = { 0x0F, 0x94, 0xC2, 0x0F, 0x9B, 0xC1, 0x20, 0xCA };
+	const unsigned char SETE_AL_AND_NOT_PARITY_OR_DL[] = { 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8,
+		0x08, 0xD0, 0x0F, 0xB6, 0xC0 };
+	const unsigned char SETE_AL_AND_NOT_PARITY_AND_DL[] = { 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8,
+		0x20, 0xD0, 0x0F, 0xB6, 0xC0 };
+
+	int second_register = first_register + 1;
+
+	switch (operation_index)
+	{
+		case OPERATION_ADD:
+			jit_emit_sse(buffer, JIT_PREFIX_SD, JIT_ADDSD, first_register, second_register, 0);
+			break;
+
+		case OPERATION_SUBTRACT:
+			jit_emit_sse(buffer, JIT_PREFIX_SD, JIT_SUBSD, first_register, second_register, 0);
+			break;
+
+		case OPERATION_MULTIPLY:
+			jit_emit_sse(buffer, JIT_PREFIX_SD, JIT_MULSD, first_register, second_register, 0);
+			break;
+
+		case OPERATION_DIVIDE:
+			jit_emit_zero_check(buffer, second_register, instruction_index, frame_size);
+			jit_emit_sse(buffer, JIT_PREFIX_SD, JIT_DIVSD, first_register, second_register, 0);
+			break;
+
+		case OPERATION_MORE:
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, second_register, 0);
+			jit_emit_comparison(buffer, first_register, JIT_SETA);
+			break;
+
+		case OPERATION_LESS:
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, second_register, first_register, 0);
+			jit_emit_comparison(buffer, first_register, JIT_SETA);
+			break;
+
+		case OPERATION_EQUALS:
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, second_register, 0);
+			jit_emit_comparison(buffer, first_register, JIT_SETE);
+			break;
+
+		case OPERATION_MORE_OR_EQUALS:
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, second_register, 0);
+			jit_emit_comparison(buffer, first_register, JIT_SETAE);
+			break;
+
+		case OPERATION_LESS_OR_EQUALS:
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, second_register, first_register, 0);
+			jit_emit_comparison(buffer, first_register, JIT_SETAE);
+			break;
+
+		case OPERATION_NOT_EQUALS:
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, second_register, 0);
+			jit_emit_comparison(buffer, first_register, JIT_SETNE);
+			break;
+
+		case OPERATION_OR:
+			jit_emit_load_double(buffer, JIT_SCRATCH_REGISTER, 1);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, JIT_SCRATCH_REGISTER, 0);
+			jit_emit_bytes(buffer, SETE_DL_AND_NOT_PARITY, sizeof(SETE_DL_AND_NOT_PARITY));
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, second_register, JIT_SCRATCH_REGISTER, 0);
+			jit_emit_bytes(buffer, SETE_AL_AND_NOT_PARITY_OR_DL, sizeof(SETE_AL_AND_NOT_PARITY_OR_DL));
+			jit_emit_sse(buffer, JIT_PREFIX_SD, JIT_CVTSI2SD, first_register, JIT_RAX, 0);
+			break;
+
+		case OPERATION_AND:
+			jit_emit_load_double(buffer, JIT_SCRATCH_REGISTER, 1);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, JIT_SCRATCH_REGISTER, 0);
+			jit_emit_bytes(buffer, SETE_DL_AND_NOT_PARITY, sizeof(SETE_DL_AND_NOT_PARITY));
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, second_register, JIT_SCRATCH_REGISTER, 0);
+			jit_emit_bytes(buffer, SETE_AL_AND_NOT_PARITY_AND_DL, sizeof(SETE_AL_AND_NOT_PARITY_AND_DL));
+			jit_emit_sse(buffer, JIT_PREFIX_SD, JIT_CVTSI2SD, first_register, JIT_RAX, 0);
+			break;
+
+		case OPERATION_DIV:
+			jit_emit_call(buffer, (const void*)&jit_div, first_register, 2);
+			jit_emit_result_error_check(buffer, first_register, instruction_index, frame_size);
+			break;
+
+		case OPERATION_MOD:
+			jit_emit_call(buffer, (const void*)&jit_mod, first_register, 2);
+			jit_emit_result_error_check(buffer, first_register, instruction_index, frame_size);
+			break;
+
+		default:
+			return 0;
+	}
+
+	return 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT FUNCTION
+LIBS  : math.h
+NOTES : arguments are in registers from "first_register", result is written to "first_register". Return 0
+        if function can not be translated.
+**********************************************************************************************************/
+int jit_emit_function(struct jit_buffer* buffer, int function_index, int first_register,
+	size_t instruction_index, size_t frame_size)
+{
+	const unsigned char MOV_EAX = 0xB8;
+	//eax = LOG_OF_NEGATIVE, ecx = LOG_OF_ZERO, r8d = LOG_OF_NEGATIVE, then "cmove eax, ecx", "cmovp eax, r8d".
+	const unsigned char MOV_ECX = 0xB9;
+	const unsigned char MOV_R8D[] = { 0x41, 0xB8 };
+	const unsigned char CHOOSE_LOG_ERROR[] = { 0x0F, 0x44, 0xC1, 0x41, 0x0F, 0x4A, 0xC0 };
+	const unsigned long long ABSOLUTE_MASK_BITS = 0x7FFFFFFFFFFFFFFFULL;
+
+	double absolute_mask;
+	size_t jump;
+	size_t unordered_jump;
+
+	switch (function_index)
+	{
+		case FUNCTION_SQRT:
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_XORPD, JIT_SCRATCH_REGISTER, JIT_SCRATCH_REGISTER, 0);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, JIT_SCRATCH_REGISTER, 0);
+			jump = jit_emit_jump(buffer, JIT_JAE);
+			jit_emit_byte(buffer, MOV_EAX);
+			jit_emit_integer(buffer, (unsigned int)ROOT_OF_NEGATIVE, 4);
+			jit_emit_error_exit(buffer, instruction_index, frame_size);
+			jit_patch_jump(buffer, jump);
+			jit_emit_sse(buffer, JIT_PREFIX_SD, JIT_SQRTSD, first_register, first_register, 0);
+			break;
+
+		case FUNCTION_POWER:
+			jit_emit_call(buffer, (const void*)&pow, first_register, 2);
+			break;
+
+		case FUNCTION_NEGATIVE:
+			//compiler turns "operand * -1" into change of sign bit too, so sign of NAN is the same.
+			jit_emit_load_double(buffer, JIT_SCRATCH_REGISTER, -0.0);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_XORPD, first_register, JIT_SCRATCH_REGISTER, 0);
+			break;
+
+		case FUNCTION_ABS:
+			memcpy(&absolute_mask, &ABSOLUTE_MASK_BITS, sizeof(double));
+			jit_emit_load_double(buffer, JIT_SCRATCH_REGISTER, absolute_mask);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_ANDPD, first_register, JIT_SCRATCH_REGISTER, 0);
+			break;
+
+		case FUNCTION_SIN:
+			jit_emit_call(buffer, (const void*)&sin, first_register, 1);
+			break;
+
+		case FUNCTION_COS:
+			jit_emit_call(buffer, (const void*)&cos, first_register, 1);
+			break;
+
+		case FUNCTION_ARCCOS:
+			jit_emit_call(buffer, (const void*)&acos, first_register, 1);
+			break;
+
+		case FUNCTION_TAN:
+			jit_emit_call(buffer, (const void*)&tan, first_register, 1);
+			break;
+
+		case FUNCTION_COTAN:
+			jit_emit_call(buffer, (const void*)&jit_cotan, first_register, 1);
+			break;
+
+		case FUNCTION_LN:
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_XORPD, JIT_SCRATCH_REGISTER, JIT_SCRATCH_REGISTER, 0);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, JIT_SCRATCH_REGISTER, 0);
+			jump = jit_emit_jump(buffer, JIT_JA);
+			jit_emit_byte(buffer, MOV_EAX);
+			jit_emit_integer(buffer, (unsigned int)LOG_OF_NEGATIVE, 4);
+			jit_emit_byte(buffer, MOV_ECX);
+			jit_emit_integer(buffer, (unsigned int)LOG_OF_ZERO, 4);
+			jit_emit_bytes(buffer, MOV_R8D, sizeof(MOV_R8D));
+			jit_emit_integer(buffer, (unsigned int)LOG_OF_NEGATIVE, 4);
+			jit_emit_bytes(buffer, CHOOSE_LOG_ERROR, sizeof(CHOOSE_LOG_ERROR));
+			jit_emit_error_exit(buffer, instruction_index, frame_size);
+			jit_patch_jump(buffer, jump);
+			jit_emit_call(buffer, (const void*)&log, first_register, 1);
+			break;
+
+		case FUNCTION_NOT:
+			jit_emit_load_double(buffer, JIT_SCRATCH_REGISTER, 1);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, JIT_SCRATCH_REGISTER, 0);
+			jit_emit_comparison(buffer, first_register, JIT_SETNE);
+			break;
+
+		case FUNCTION_IF:
+			//"movapd" does not change flags, so the third argument is taken unless condition equals 1.
+			jit_emit_load_double(buffer, JIT_SCRATCH_REGISTER, 1);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, first_register, JIT_SCRATCH_REGISTER, 0);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_MOVAPD, first_register, first_register + 2, 0);
+			unordered_jump = jit_emit_jump(buffer, JIT_JP);
+			jump = jit_emit_jump(buffer, JIT_JNE);
+			jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_MOVAPD, first_register, first_register + 1, 0);
+			jit_patch_jump(buffer, unordered_jump);
+			jit_patch_jump(buffer, jump);
+			break;
+
+		default:
+			return 0;
+	}
+
+	return 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT EMIT SKIP
+LIBS  : math.h
+NOTES : skip instruction with "stack_depth" values on the stack. NAN is loaded to the next free register
+        before check, so it is ready if operand is skipped (otherwise operand overwrites it). Positions of
+        jumps to target are written to "jump_positions", return count of them.
+**********************************************************************************************************/
+size_t jit_emit_skip(struct jit_buffer* buffer, int opcode, int stack_depth, size_t* jump_positions)
+{
+	int tested_register = (opcode == SKIP_IF_BELOW_TRUE) ? stack_depth - 2 : stack_depth - 1;
+
+	jit_emit_load_double(buffer, stack_depth, NAN);
+	jit_emit_load_double(buffer, JIT_SCRATCH_REGISTER, 1);
+	jit_emit_sse(buffer, JIT_PREFIX_PD, JIT_UCOMISD, tested_register, JIT_SCRATCH_REGISTER, 0);
+
+	//not equal or unordered (NAN) is not true.
+	if (opcode == SKIP_IF_FALSE)
+	{
+		jump_positions[0] = jit_emit_jump(buffer, JIT_JP);
+		jump_positions[1] = jit_emit_jump(buffer, JIT_JNE);
+		return 2;
+	}
+
+	size_t unordered_jump = jit_emit_jump(buffer, JIT_JP);
+	jump_positions[0] = jit_emit_jump(buffer, JIT_JE);
+	jit_patch_jump(buffer, unordered_jump);
+	return 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT WRITE PERF MAP
+LIBS  : stdio.h, unistd.h
+NOTES : appends "<address> <size> <name>" line to "/tmp/perf-<pid>.map", failure is ignored.
+**********************************************************************************************************/
+void jit_write_perf_map(const void* code, size_t code_size, const char* formula_name)
+{
+#if defined(JIT_AVAILABLE)
+	const size_t MAX_PATH_LENGTH = 64;
+
+	char path[64];
+	snprintf(path, MAX_PATH_LENGTH, "/tmp/perf-%ld.map", (long)getpid());
+
+	FILE* map_file = fopen(path, "a");
+	if (map_file == NULL)
+	{
+		return;
+	}
+
+	fprintf(map_file, "%llx %zx mathpars_jit:%s\n", (unsigned long long)(size_t)code, code_size, formula_name);
+	fclose(map_file);
+#endif
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT COMPILE FORMULA
+LIBS  : stdlib.h, string.h, sys/mman.h, unistd.h
+NOTES : translates compiled formula to machine code, "formula_name" is written to perf map. Returned pointer
+        must be passed to "jit_formula_free()" after use. Return NULL if JIT is not available, formula is
+        too deep for registers or contains instruction which can not be translated.
+**********************************************************************************************************/
+struct jit_formula* jit_compile_formula(const struct compiled_formula* formula, const char* formula_name)
+{
+#if defined(JIT_AVAILABLE)
+	const size_t INITIAL_CAPACITY = 256;
+	const size_t FRAME_SIZE = JIT_REGISTERS_COUNT * sizeof(double);
+	//push rbx, push r12, push r13, mov rbx, rdi, mov r12, rsi, mov r13, rdx, sub rsp.
+	const unsigned char PROLOGUE[] = { 0x53, 0x41, 0x54, 0x41, 0x55, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4,
+		0x49, 0x89, 0xD5, 0x48, 0x81, 0xEC };
+
+	if (formula->max_stack_depth > JIT_REGISTERS_COUNT || formula->instructions_count == 0)
+	{
+		return NULL;
+	}
+
+	struct jit_buffer buffer;
+	buffer.buffer_capacity = INITIAL_CAPACITY;
+	buffer.current_length = 0;
+	buffer.data = calloc(buffer.buffer_capacity, sizeof(unsigned char));
+	if (buffer.data == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	//code position of every instruction, jumps of skip instructions are patched after translation.
+	const size_t MAX_JUMPS_PER_SKIP = 2;
+	size_t* code_positions = calloc(formula->instructions_count, sizeof(size_t));
+	size_t* jump_positions = calloc(formula->instructions_count * MAX_JUMPS_PER_SKIP, sizeof(size_t));
+	size_t* jump_targets = calloc(formula->instructions_count * MAX_JUMPS_PER_SKIP, sizeof(size_t));
+	if (code_positions == NULL || jump_positions == NULL || jump_targets == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	size_t jumps_count = 0;
+
+	jit_emit_bytes(&buffer, PROLOGUE, sizeof(PROLOGUE));
+	jit_emit_integer(&buffer, FRAME_SIZE, 4);
+
+	int stack_depth = 0;
+	int is_translated = 1; //true
+	for (size_t i = 0; i < formula->instructions_count && is_translated == 1; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+		int arguments_count;
+		size_t skip_jumps_count;
+
+		code_positions[i] = buffer.current_length;
+
+		switch (instruction->opcode)
+		{
+			case PUSH_CONSTANT:
+				jit_emit_sse_memory(&buffer, JIT_PREFIX_SD, JIT_MOVSD_LOAD, stack_depth, JIT_R12,
+					instruction->operand * sizeof(double));
+				stack_depth++;
+				break;
+
+			case PUSH_VARIABLE:
+				jit_emit_sse_memory(&buffer, JIT_PREFIX_SD, JIT_MOVSD_LOAD, stack_depth, JIT_RBX,
+					instruction->operand * sizeof(double));
+				stack_depth++;
+				break;
+
+			case DUPLICATE:
+				jit_emit_sse(&buffer, JIT_PREFIX_PD, JIT_MOVAPD, stack_depth, stack_depth - 1, 0);
+				stack_depth++;
+				break;
+
+			case CALL_OPERATION:
+				stack_depth -= 2;
+				is_translated = jit_emit_operation(&buffer, instruction->operand, stack_depth, i, FRAME_SIZE);
+				stack_depth++;
+				break;
+
+			case CALL_FUNCTION:
+				arguments_count = (int)MATH_FUNCTIONS[instruction->operand].arguments_count;
+				stack_depth -= arguments_count;
+				is_translated = jit_emit_function(&buffer, instruction->operand, stack_depth, i, FRAME_SIZE);
+				stack_depth++;
+				break;
+
+			//value on the stack at target is the same as after skipped operand, so depth is not changed.
+			case SKIP_IF_TRUE:
+			case SKIP_IF_FALSE:
+			case SKIP_IF_BELOW_TRUE:
+				skip_jumps_count = jit_emit_skip(&buffer, instruction->opcode, stack_depth,
+					jump_positions + jumps_count);
+				for (size_t j = 0; j < skip_jumps_count; j++)
+				{
+					jump_targets[jumps_count++] = (size_t)instruction->operand;
+				}
+				break;
+
+			default:
+				is_translated = 0;
+		}
+	}
+
+	//result is already in xmm0.
+	jit_emit_epilogue(&buffer, FRAME_SIZE);
+
+	for (size_t i = 0; i < jumps_count && is_translated == 1; i++)
+	{
+		jit_patch_jump_to(&buffer, jump_positions[i], code_positions[jump_targets[i]]);
+	}
+	free(jump_targets);
+	free(jump_positions);
+	free(code_positions);
+
+	if (is_translated == 0)
+	{
+		free(buffer.data);
+		return NULL;
+	}
+
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	size_t code_size = (buffer.current_length + page_size - 1) / page_size * page_size;
+	void* code = mmap(NULL, code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (code == MAP_FAILED)
+	{
+		free(buffer.data);
+		return NULL;
+	}
+	memcpy(code, buffer.data, buffer.current_length);
+	if (mprotect(code, code_size, PROT_READ | PROT_EXEC) != 0)
+	{
+		munmap(code, code_size);
+		free(buffer.data);
+		return NULL;
+	}
+
+	struct jit_formula* jit = calloc(1, sizeof(struct jit_formula));
+	if (jit == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	jit->function = (double(*)(const double*, const double*, struct jit_error*))code;
+	jit->code = code;
+	jit->code_size = code_size;
+	jit->formula = formula;
+
+	jit_write_perf_map(code, buffer.current_length, formula_name);
+	free(buffer.data);
+
+	return jit;
+#else
+	return NULL;
+#endif
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE JIT FORMULA
+LIBS  : math.h
+NOTES : the same as "evaluate_compiled_formula()", but runs machine code and needs no stack.
+**********************************************************************************************************/
+struct evaluation_result evaluate_jit_formula(const struct jit_formula* jit, const double* bindings)
+{
+	struct evaluation_result result = { NAN, NO_ERROR, 0 };
+	struct jit_error error = { NO_ERROR, 0 };
+
+	result.value = jit->function(bindings, jit->formula->constants, &error);
+	if (error.error_code != NO_ERROR)
+	{
+		result.value = NAN;
+		result.error_code = error.error_code;
+		result.error_position = jit->formula->instruction_positions[error.instruction_index];
+	}
+
+	return result;
+}
+
+
+/**********************************************************************************************************
+NAME  : JIT FORMULA FREE
+LIBS  : stdlib.h, sys/mman.h
+NOTES : always use this function when finish work with JIT formula.
+**********************************************************************************************************/
+void jit_formula_free(struct jit_formula* jit)
+{
+#if defined(JIT_AVAILABLE)
+	munmap(jit->code, jit->code_size);
+#endif
+	free(jit);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////JIT SECTION END/////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////THREAD SECTION//////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/**********************************************************************************************************
+NAME  : THREAD
+LIBS  : windows.h or pthread.h
+NOTES : -
+**********************************************************************************************************/
+struct thread
+{
+	void(*thread_function)(void*);
+	void* argument;
+
+#if defined(_WIN32)
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+};
+
+
+/**********************************************************************************************************
+NAME  : MUTEX
+LIBS  : windows.h or pthread.h
+NOTES : -
+**********************************************************************************************************/
+struct mutex
+{
+#if defined(_WIN32)
+	CRITICAL_SECTION critical_section;
+#else
+	pthread_mutex_t handle;
+#endif
+};
+
+
+/**********************************************************************************************************
+NAME  : THREAD START ROUTINE
+LIBS  : windows.h or pthread.h
+NOTES : adapts thread function of this project to signature required by operating system.
+**********************************************************************************************************/
+#if defined(_WIN32)
+unsigned __stdcall thread_start_routine(void* thread_pointer)
+{
+	struct thread* thread = thread_pointer;
+	thread->thread_function(thread->argument);
+
+	return 0;
+}
+#else
+void* thread_start_routine(void* thread_pointer)
+{
+	struct thread* thread = thread_pointer;
+	thread->thread_function(thread->argument);
+
+	return NULL;
+}
+#endif
+
+
+/**********************************************************************************************************
+NAME  : THREAD START
+LIBS  : windows.h, process.h or pthread.h
+NOTES : thread structure must stay alive until "thread_join()" call.
+**********************************************************************************************************/
+void thread_start(struct thread* thread, void(*thread_function)(void*), void* argument)
+{
+	thread->thread_function = thread_function;
+	thread->argument = argument;
+
+#if defined(_WIN32)
+	thread->handle = (HANDLE)_beginthreadex(NULL, 0, &thread_start_routine, thread, 0, NULL);
+	if (thread->handle == 0)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+#else
+	if (pthread_create(&thread->handle, NULL, &thread_start_routine, thread) != 0)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+#endif
+}
+
+
+/**********************************************************************************************************
+NAME  : THREAD JOIN
+LIBS  : windows.h or pthread.h
+NOTES : -
+**********************************************************************************************************/
+void thread_join(struct thread* thread)
+{
+#if defined(_WIN32)
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif
+}
+
+
+/**********************************************************************************************************
+NAME  : MUTEX INITIALIZE
+LIBS  : windows.h or pthread.h
+NOTES : -
+**********************************************************************************************************/
+void mutex_initialize(struct mutex* mutex)
+{
+#if defined(_WIN32)
+	InitializeCriticalSection(&mutex->critical_section);
+#else
+	pthread_mutex_init(&mutex->handle, NULL);
+#endif
+}
+
+
+/**********************************************************************************************************
+NAME  : MUTEX LOCK
+LIBS  : windows.h or pthread.h
+NOTES : -
+**********************************************************************************************************/
+void mutex_lock(struct mutex* mutex)
+{
+#if defined(_WIN32)
+	EnterCriticalSection(&mutex->critical_section);
+#else
+	pthread_mutex_lock(&mutex->handle);
+#endif
+}
+
+
+/**********************************************************************************************************
+NAME  : MUTEX UNLOCK
+LIBS  : windows.h or pthread.h
+NOTES : -
+**********************************************************************************************************/
+void mutex_unlock(struct mutex* mutex)
+{
+#if defined(_WIN32)
+	LeaveCriticalSection(&mutex->critical_section);
+#else
+	pthread_mutex_unlock(&mutex->handle);
+#endif
+}
+
+
+/**********************************************************************************************************
+NAME  : MUTEX FREE
+LIBS  : windows.h or pthread.h
+NOTES : always use this function when finish work with mutex.
+**********************************************************************************************************/
+void mutex_free(struct mutex* mutex)
+{
+#if defined(_WIN32)
+	DeleteCriticalSection(&mutex->critical_section);
+#else
+	pthread_mutex_destroy(&mutex->handle);
+#endif
+}
+
+
+/**********************************************************************************************************
+NAME  : GET PROCESSORS COUNT
+LIBS  : windows.h or unistd.h
+NOTES : -
+**********************************************************************************************************/
+size_t get_processors_count()
+{
+#if defined(_WIN32)
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	long processors_count = (long)system_info.dwNumberOfProcessors;
+#else
+	long processors_count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+	if (processors_count < 1)
+	{
+		processors_count = 1;
+	}
+
+	return (size_t)processors_count;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////THREAD SECTION END//////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////PARALLEL EVALUATION SECTION/////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Parallel evaluation calculates many compiled formulas over the same rows on several threads. Work is split
+into tasks, every task is one formula over PARALLEL_TASK_ROWS rows. Tasks are numbered formula by formula,
+every worker initially owns an equal contiguous range of task numbers. Worker takes tasks from the
+beginning of its own range; when its range is empty, it steals upper half of the range of another worker.
+Every worker has its own batch stack, and every task writes results to its own place of results array,
+so results keep input order regardless of which worker calculated them.
+
+*/
+
+#define PARALLEL_TASK_ROWS (16 * BATCH_BLOCK_SIZE)
+
+/**********************************************************************************************************
+NAME  : PARALLEL JOB
+LIBS  : -
+NOTES : description of work shared by all workers. "columns[formula][slot]" is column of variable with such
+        slot of such formula, "results[formula]" ("errors[formula]") is array of results (error codes of
+        rows) of such formula.
+**********************************************************************************************************/
+struct parallel_job
+{
+	const struct compiled_formula* const* formulas;
+	size_t formulas_count;
+
+	const double* const* const* columns;
+	size_t rows_count;
+	double** results;
+	int** errors;
+
+	size_t blocks_count;
+	size_t max_stack_depth;
+	size_t max_variables_count;
+
+	struct parallel_worker* workers;
+	size_t workers_count;
+};
+
+
+/**********************************************************************************************************
+NAME  : PARALLEL WORKER
+LIBS  : -
+NOTES : range of not yet taken tasks [first_task, last_task) is protected by mutex. Padding keeps ranges of
+        different workers in different cache lines.
+**********************************************************************************************************/
+struct parallel_worker
+{
+	struct mutex mutex;
+	size_t first_task;
+	size_t last_task;
+
+	struct parallel_job* job;
+	size_t worker_index;
+	struct thread thread;
+
+	char padding[64];
+};
+
+
+/**********************************************************************************************************
+NAME  : TAKE OWN TASK
+LIBS  : -
+NOTES : return 1 and writes number of task if worker has tasks, 0 if its range is empty.
+**********************************************************************************************************/
+int take_own_task(struct parallel_worker* worker, size_t* task)
+{
+	int is_task_taken = 0; //false
+
+	mutex_lock(&worker->mutex);
+	if (worker->first_task < worker->last_task)
+	{
+		*task = worker->first_task;
+		worker->first_task++;
+		is_task_taken = 1;
+	}
+	mutex_unlock(&worker->mutex);
+
+	return is_task_taken;
+}
+
+
+/**********************************************************************************************************
+NAME  : STEAL TASKS
+LIBS  : -
+NOTES : moves upper half of range of the first non-empty victim to worker. Return 0 if all workers are empty,
+        it means that there is no work left, because new tasks never appear.
+**********************************************************************************************************/
+int steal_tasks(struct parallel_worker* worker)
+{
+	struct parallel_job* job = worker->job;
+
+	for (size_t i = 1; i < job->workers_count; i++)
+	{
+		struct parallel_worker* victim = &job->workers[(worker->worker_index + i) % job->workers_count];
+
+		mutex_lock(&victim->mutex);
+		size_t remaining_tasks_count = victim->last_task - victim->first_task;
+		if (victim->first_task >= victim->last_task)
+		{
+			mutex_unlock(&victim->mutex);
+			continue;
+		}
+
+		size_t stolen_tasks_count = (remaining_tasks_count + 1) / 2;
+		size_t stolen_last_task = victim->last_task;
+		victim->last_task -= stolen_tasks_count;
+		mutex_unlock(&victim->mutex);
+
+		mutex_lock(&worker->mutex);
+		worker->first_task = stolen_last_task - stolen_tasks_count;
+		worker->last_task = stolen_last_task;
+		mutex_unlock(&worker->mutex);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/**********************************************************************************************************
+NAME  : PARALLEL WORKER ROUTINE
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void parallel_worker_routine(void* worker_pointer)
+{
+	struct parallel_worker* worker = worker_pointer;
+	struct parallel_job* job = worker->job;
+
+	struct batch_stack* stack = batch_stack_initialize(job->max_stack_depth);
+
+	const double** task_columns = calloc(job->max_variables_count + 1, sizeof(double*));
+	if (task_columns == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	for (;;)
+	{
+		size_t task;
+		if (take_own_task(worker, &task) == 0)
+		{
+			if (steal_tasks(worker) == 0)
+			{
+				break;
+			}
+			continue;
+		}
+
+		size_t formula_index = task / job->blocks_count;
+		size_t block_start = (task % job->blocks_count) * PARALLEL_TASK_ROWS;
+
+		size_t block_rows_count = job->rows_count - block_start;
+		if (block_rows_count > PARALLEL_TASK_ROWS)
+		{
+			block_rows_count = PARALLEL_TASK_ROWS;
+		}
+
+		//columns of task are the same columns shifted to the first row of task.
+		const struct compiled_formula* formula = job->formulas[formula_index];
+		for (size_t slot = 0; slot < formula->variables_count; slot++)
+		{
+			task_columns[slot] = job->columns[formula_index][slot] + block_start;
+		}
+
+		int* task_errors = (job->errors != NULL) ? job->errors[formula_index] + block_start : NULL;
+		evaluate_compiled_formula_batch(formula, task_columns, block_rows_count,
+			job->results[formula_index] + block_start, task_errors, stack);
+	}
+
+	free(task_columns);
+	batch_stack_free(stack);
+}
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE FORMULAS PARALLEL
+LIBS  : stdlib.h
+NOTES : "columns[formula][slot]" is column of variable with such slot of such formula, results of formula
+        are written to "results[formula]", error codes of its rows to "errors[formula]" (errors can be NULL).
+        If threads count is 0, all processors are used. Calling thread works as one of workers.
+**********************************************************************************************************/
+void evaluate_formulas_parallel(const struct compiled_formula* const* formulas, size_t formulas_count,
+	const double* const* const* columns, size_t rows_count, double** results, int** errors,
+	size_t threads_count)
+{
+	if (threads_count == 0)
+	{
+		threads_count = get_processors_count();
+	}
+
+	struct parallel_job job;
+	job.formulas = formulas;
+	job.formulas_count = formulas_count;
+	job.columns = columns;
+	job.rows_count = rows_count;
+	job.results = results;
+	job.errors = errors;
+	job.blocks_count = (rows_count + PARALLEL_TASK_ROWS - 1) / PARALLEL_TASK_ROWS;
+	job.max_stack_depth = 0;
+	job.max_variables_count = 0;
+
+	for (size_t i = 0; i < formulas_count; i++)
+	{
+		if (formulas[i]->variables_count > job.max_variables_count)
+		{
+			job.max_variables_count = formulas[i]->variables_count;
+		}
+		if (formulas[i]->max_stack_depth > job.max_stack_depth)
+		{
+			job.max_stack_depth = formulas[i]->max_stack_depth;
+		}
+	}
+
+	job.workers_count = threads_count;
+	job.workers = calloc(threads_count, sizeof(struct parallel_worker));
+	if (job.workers == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	size_t tasks_count = formulas_count * job.blocks_count;
+	for (size_t i = 0; i < threads_count; i++)
+	{
+		struct parallel_worker* worker = &job.workers[i];
+		mutex_initialize(&worker->mutex);
+		worker->first_task = tasks_count * i / threads_count;
+		worker->last_task = tasks_count * (i + 1) / threads_count;
+		worker->job = &job;
+		worker->worker_index = i;
+	}
+
+	for (size_t i = 1; i < threads_count; i++)
+	{
+		thread_start(&job.workers[i].thread, &parallel_worker_routine, &job.workers[i]);
+	}
+
+	parallel_worker_routine(&job.workers[0]);
+
+	for (size_t i = 1; i < threads_count; i++)
+	{
+		thread_join(&job.workers[i].thread);
+	}
+
+	for (size_t i = 0; i < threads_count; i++)
+	{
+		mutex_free(&job.workers[i].mutex);
+	}
+	free(job.workers);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////PARALLEL EVALUATION SECTION END/////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////MAPPED FILE SECTION/////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**********************************************************************************************************
+NAME  : MAPPED FILE
+LIBS  : windows.h or sys/mman.h
+NOTES : read-only view of the whole file.
+**********************************************************************************************************/
+struct mapped_file
+{
+	const char* data;
+	size_t size;
+
+#if defined(_WIN32)
+	HANDLE file_handle;
+	HANDLE mapping_handle;
+#else
+	int file_descriptor;
+#endif
+};
+
+
+/**********************************************************************************************************
+NAME  : MAP FILE
+LIBS  : windows.h or fcntl.h, sys/mman.h, sys/stat.h
+NOTES : return NULL if file can not be opened or mapped. Returned pointer must be passed to "unmap_file()"
+        after use.
+**********************************************************************************************************/
+struct mapped_file* map_file(const char* file_path)
+{
+	struct mapped_file* mapped_file = calloc(1, sizeof(struct mapped_file));
+	if (mapped_file == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+#if defined(_WIN32)
+	mapped_file->file_handle = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mapped_file->file_handle == INVALID_HANDLE_VALUE)
+	{
+		free(mapped_file);
+		return NULL;
+	}
+
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(mapped_file->file_handle, &file_size);
+	mapped_file->size = (size_t)file_size.QuadPart;
+
+	if (mapped_file->size != 0)
+	{
+		mapped_file->mapping_handle = CreateFileMappingA(mapped_file->file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapped_file->mapping_handle == NULL)
+		{
+			CloseHandle(mapped_file->file_handle);
+			free(mapped_file);
+			return NULL;
+		}
+
+		mapped_file->data = MapViewOfFile(mapped_file->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+		if (mapped_file->data == NULL)
+		{
+			CloseHandle(mapped_file->mapping_handle);
+			CloseHandle(mapped_file->file_handle);
+			free(mapped_file);
+			return NULL;
+		}
+	}
+#else
+	mapped_file->file_descriptor = open(file_path, O_RDONLY);
+	if (mapped_file->file_descriptor == -1)
+	{
+		free(mapped_file);
+		return NULL;
+	}
+
+	struct stat file_status;
+	fstat(mapped_file->file_descriptor, &file_status);
+	mapped_file->size = (size_t)file_status.st_size;
+
+	if (mapped_file->size != 0)
+	{
+		void* data = mmap(NULL, mapped_file->size, PROT_READ, MAP_PRIVATE, mapped_file->file_descriptor, 0);
+		if (data == MAP_FAILED)
+		{
+			close(mapped_file->file_descriptor);
+			free(mapped_file);
+			return NULL;
+		}
+
+		madvise(data, mapped_file->size, MADV_SEQUENTIAL);
+		mapped_file->data = data;
+	}
+#endif
+
+	return mapped_file;
+}
+
+
+/**********************************************************************************************************
+NAME  : UNMAP FILE
+LIBS  : windows.h or sys/mman.h
+NOTES : -
+**********************************************************************************************************/
+void unmap_file(struct mapped_file* mapped_file)
+{
+#if defined(_WIN32)
+	if (mapped_file->data != NULL)
+	{
+		UnmapViewOfFile(mapped_file->data);
+		CloseHandle(mapped_file->mapping_handle);
+	}
+	CloseHandle(mapped_file->file_handle);
+#else
+	if (mapped_file->data != NULL)
+	{
+		munmap((void*)mapped_file->data, mapped_file->size);
+	}
+	close(mapped_file->file_descriptor);
+#endif
+
+	free(mapped_file);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////MAPPED FILE SECTION END/////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////RESULT CACHE SECTION////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Result cache keeps results of the last evaluations, key is id of compiled formula and values of its variables.
+Evaluation is deterministic, so repeated formula with the same values gets the same result (or the same error
+with the same position) without evaluation. Values are compared bitwise, so "-0" and "0" (and different NaNs)
+are different keys. Cache has fixed count of entries, the least recently used entry is replaced by new one.
+
+*/
+
+//Index which means "no entry" in chains of result cache.
+#define RESULT_CACHE_NONE ((size_t)-1)
+
+/**********************************************************************************************************
+NAME  : RESULT CACHE ENTRY
+LIBS  : -
+NOTES : "next_in_bucket" links entries of the same bucket, "previous_used" and "next_used" link entries from
+        the most recently used to the least recently used. Bindings array is kept when entry is replaced, so
+        steady-state cache makes no system allocations.
+**********************************************************************************************************/
+struct result_cache_entry
+{
+	size_t formula_id;
+	size_t key_hash;
+	double* bindings;
+	size_t bindings_count;
+	size_t bindings_capacity;
+	struct evaluation_result result;
+
+	size_t next_in_bucket;
+	size_t previous_used;
+	size_t next_used;
+};
+
+
+/**********************************************************************************************************
+NAME  : RESULT CACHE
+LIBS  : -
+NOTES : hash table with chains, count of buckets is power of two not less than twice capacity.
+**********************************************************************************************************/
+struct result_cache
+{
+	struct result_cache_entry* entries;
+	size_t entries_count;
+	size_t cache_capacity;
+
+	size_t* buckets;
+	size_t buckets_count;
+
+	size_t most_recent;
+	size_t least_recent;
+
+	size_t hits_count;
+	size_t misses_count;
+};
+
+
+/**********************************************************************************************************
+NAME  : RESULT CACHE INITIALIZE
+LIBS  : stdlib.h
+NOTES : "cache_capacity" is maximal count of kept results, it must be greater than 0. Returned pointer must be
+        passed to "result_cache_free()" after use.
+**********************************************************************************************************/
+struct result_cache* result_cache_initialize(size_t cache_capacity)
+{
+	struct result_cache* cache = calloc(1, sizeof(struct result_cache));
+	if (cache == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	cache->buckets_count = 1;
+	while (cache->buckets_count < cache_capacity * 2)
+	{
+		cache->buckets_count *= 2;
+	}
+
+	cache->entries = calloc(cache_capacity, sizeof(struct result_cache_entry));
+	cache->buckets = calloc(cache->buckets_count, sizeof(size_t));
+	if (cache->entries == NULL || cache->buckets == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	for (size_t i = 0; i < cache->buckets_count; i++)
+	{
+		cache->buckets[i] = RESULT_CACHE_NONE;
+	}
+	cache->cache_capacity = cache_capacity;
+	cache->most_recent = RESULT_CACHE_NONE;
+	cache->least_recent = RESULT_CACHE_NONE;
+
+	return cache;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET RESULT KEY HASH
+LIBS  : -
+NOTES : hash of formula id and bytes of values of variables.
+**********************************************************************************************************/
+size_t get_result_key_hash(size_t formula_id, const double* bindings, size_t bindings_count)
+{
+	const size_t GOLDEN_RATIO = 0x9E3779B9;
+
+	size_t hash = get_string_hash((const char*)bindings, bindings_count * sizeof(double));
+
+	return hash ^ (formula_id + GOLDEN_RATIO + (hash << 6) + (hash >> 2));
+}
+
+
+/**********************************************************************************************************
+NAME  : RESULT CACHE UNLINK USED
+LIBS  : -
+NOTES : removes entry from list of used entries.
+**********************************************************************************************************/
+void result_cache_unlink_used(struct result_cache* cache, size_t index)
+{
+	struct result_cache_entry* entry = &cache->entries[index];
+
+	if (entry->previous_used != RESULT_CACHE_NONE)
+	{
+		cache->entries[entry->previous_used].next_used = entry->next_used;
+	}
+	else
+	{
+		cache->most_recent = entry->next_used;
+	}
+
+	if (entry->next_used != RESULT_CACHE_NONE)
+	{
+		cache->entries[entry->next_used].previous_used = entry->previous_used;
+	}
+	else
+	{
+		cache->least_recent = entry->previous_used;
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : RESULT CACHE LINK MOST RECENT
+LIBS  : -
+NOTES : puts entry to the beginning of list of used entries.
+**********************************************************************************************************/
+void result_cache_link_most_recent(struct result_cache* cache, size_t index)
+{
+	struct result_cache_entry* entry = &cache->entries[index];
+
+	entry->previous_used = RESULT_CACHE_NONE;
+	entry->next_used = cache->most_recent;
+	if (cache->most_recent != RESULT_CACHE_NONE)
+	{
+		cache->entries[cache->most_recent].previous_used = index;
+	}
+	else
+	{
+		cache->least_recent = index;
+	}
+	cache->most_recent = index;
+}
+
+
+/**********************************************************************************************************
+NAME  : RESULT CACHE FIND
+LIBS  : string.h
+NOTES : return 1 and writes kept result if result of formula with these values is in cache, 0 otherwise.
+        Found entry becomes the most recently used.
+**********************************************************************************************************/
+int result_cache_find(struct result_cache* cache, size_t formula_id, const double* bindings, size_t bindings_count,
+	struct evaluation_result* result)
+{
+	size_t key_hash = get_result_key_hash(formula_id, bindings, bindings_count);
+
+	size_t index = cache->buckets[key_hash & (cache->buckets_count - 1)];
+	while (index != RESULT_CACHE_NONE)
+	{
+		struct result_cache_entry* entry = &cache->entries[index];
+		if (entry->key_hash == key_hash && entry->formula_id == formula_id &&
+			entry->bindings_count == bindings_count &&
+			(bindings_count == 0 || memcmp(entry->bindings, bindings, bindings_count * sizeof(double)) == 0))
+		{
+			if (cache->most_recent != index)
+			{
+				result_cache_unlink_used(cache, index);
+				result_cache_link_most_recent(cache, index);
+			}
+
+			*result = entry->result;
+			cache->hits_count++;
+			STATISTICS_COUNT(result_cache_hits_count);
+			return 1;
+		}
+		index = entry->next_in_bucket;
+	}
+
+	cache->misses_count++;
+	STATISTICS_COUNT(result_cache_misses_count);
+
+	return 0;
+}
+
+
+/**********************************************************************************************************
+NAME  : RESULT CACHE ADD
+LIBS  : stdlib.h, string.h
+NOTES : keeps result of formula with these values, result must not be in cache yet (it is added after failed
+        "result_cache_find()"). If cache is full, the least recently used entry is replaced.
+**********************************************************************************************************/
+void result_cache_add(struct result_cache* cache, size_t formula_id, const double* bindings, size_t bindings_count,
+	struct evaluation_result result)
+{
+	size_t index;
+	if (cache->entries_count < cache->cache_capacity)
+	{
+		index = cache->entries_count++;
+	}
+	else
+	{
+		index = cache->least_recent;
+		result_cache_unlink_used(cache, index);
+
+		size_t* link = &cache->buckets[cache->entries[index].key_hash & (cache->buckets_count - 1)];
+		while (*link != index)
+		{
+			link = &cache->entries[*link].next_in_bucket;
+		}
+		*link = cache->entries[index].next_in_bucket;
+	}
+
+	struct result_cache_entry* entry = &cache->entries[index];
+	if (entry->bindings_capacity < bindings_count)
+	{
+		free(entry->bindings);
+		entry->bindings_capacity = bindings_count;
+		entry->bindings = calloc(bindings_count, sizeof(double));
+		if (entry->bindings == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+	}
+	if (bindings_count != 0)
+	{
+		memcpy(entry->bindings, bindings, bindings_count * sizeof(double));
+	}
+
+	entry->formula_id = formula_id;
+	entry->key_hash = get_result_key_hash(formula_id, bindings, bindings_count);
+	entry->bindings_count = bindings_count;
+	entry->result = result;
+
+	size_t* bucket = &cache->buckets[entry->key_hash & (cache->buckets_count - 1)];
+	entry->next_in_bucket = *bucket;
+	*bucket = index;
+	result_cache_link_most_recent(cache, index);
+}
+
+
+/**********************************************************************************************************
+NAME  : RESULT CACHE FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with result cache.
+**********************************************************************************************************/
+void result_cache_free(struct result_cache* cache)
+{
+	for (size_t i = 0; i < cache->entries_count; i++)
+	{
+		free(cache->entries[i].bindings);
+	}
+	free(cache->entries);
+	free(cache->buckets);
+	free(cache);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////RESULT CACHE SECTION END////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////FORMULA CACHE SECTION///////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Formula cache maps formula text to compiled formula, so repeated formula costs only lexing and hash lookup.
+Key is text of formula tokens separated by one space, so "a+b", "a + b" and "a  +  b" are compiled once. To
+build key every formula is lexed once, and formula which is not in cache is lexed once more by compilation
+(tokens of key have offsets in original text, compilation needs offsets in key). One cache can be shared by
+all threads of process: it is split into shards with their own mutex, hash table and list of used entries,
+threads with different formulas rarely wait for each other.
+
+Capacity is divided between shards exactly, so the whole cache keeps not more than capacity formulas. Every
+shard keeps not more than its part of capacity, the least recently used formula is evicted. Entry is
+given to caller with reference, evicted entry is freed when the last reference is released, so formula
+is never freed while it is evaluated.
+
+Positions of errors of cached formula are offsets in normalized text, "normalize_formula_text()" gives offsets
+in original text for them.
+
+*/
+
+//Count of independently locked parts of formula cache, power of two.
+#define FORMULA_CACHE_SHARDS_COUNT 16
+
+//Formula is translated by JIT (if it is enabled) when it is taken from cache this count of times.
+#define JIT_HOT_EVALUATIONS_COUNT 1000
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE ENTRY
+LIBS  : -
+NOTES : if formula can not be compiled, formula is NULL and error of compilation is kept, so wrong formula is
+        not parsed again. "jit" is not NULL when formula became hot and was translated to machine code.
+        "formula_id" is unique number of formula in cache (evicted formula never gets it again), it is key of
+        result cache. "next_in_bucket" links entries of the same bucket, "previous_used" and "next_used" link
+        entries of shard from the most recently used to the least recently used.
+**********************************************************************************************************/
+struct formula_cache_entry
+{
+	char* formula_text;
+	size_t formula_length;
+	size_t formula_hash;
+	size_t formula_id;
+	struct compiled_formula* formula;
+	int error_code;
+	size_t error_position;
+
+	struct jit_formula* jit;
+	size_t uses_count;
+	size_t references_count;
+	int is_evicted;
+
+	struct formula_cache_entry* next_in_bucket;
+	struct formula_cache_entry* previous_used;
+	struct formula_cache_entry* next_used;
+};
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE SHARD
+LIBS  : -
+NOTES : hash table with chains, count of buckets is power of two not less than twice capacity of shard.
+**********************************************************************************************************/
+struct formula_cache_shard
+{
+	struct mutex mutex;
+	struct formula_cache_entry** buckets;
+	size_t buckets_count;
+	size_t entries_count;
+	size_t shard_capacity;
+	size_t next_formula_id;
+	size_t evictions_count;
+
+	struct formula_cache_entry* most_recent;
+	struct formula_cache_entry* least_recent;
+};
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+struct formula_cache
+{
+	struct formula_cache_shard shards[FORMULA_CACHE_SHARDS_COUNT];
+};
+
+
+/**********************************************************************************************************
+NAME  : NORMALIZE FORMULA WHITESPACE
+LIBS  : ctype.h
+NOTES : the same as "normalize_formula_text()", but only runs of whitespace are replaced by one space.
+**********************************************************************************************************/
+size_t normalize_formula_whitespace(const char* text, size_t text_length, char* normalized_text, size_t* positions)
+{
+	size_t normalized_length = 0;
+	int is_space_pending = 0; //false
+
+	for (size_t i = 0; i < text_length; i++)
+	{
+		if (isspace((unsigned char)text[i]) != 0)
+		{
+			is_space_pending = (normalized_length != 0) ? 1 : 0;
+			continue;
+		}
+
+		if (is_space_pending == 1)
+		{
+			positions[normalized_length] = i - 1;
+			normalized_text[normalized_length++] = ' ';
+			is_space_pending = 0;
+		}
+		positions[normalized_length] = i;
+		normalized_text[normalized_length++] = text[i];
+	}
+	positions[normalized_length] = (normalized_length != 0) ? positions[normalized_length - 1] + 1 : 0;
+
+	return normalized_length;
+}
+
+
+/**********************************************************************************************************
+NAME  : NORMALIZE FORMULA TEXT
+LIBS  : -
+NOTES : writes texts of formula tokens separated by one space to "normalized_text" (it is not terminated by
+        zero character) and offset in original text of every normalized character to "positions", both arrays
+        must have place for "2 * text_length + 1" elements. Formula is tokenized by parser context, formula
+        which can not be tokenized keeps its tokens and only gets normalized whitespace, its compilation
+        fails anyway. Offset of the end of normalized text is offset after its last character in original text
+        (0 for empty text). Return length of normalized text.
+**********************************************************************************************************/
+size_t normalize_formula_text(struct parser_context* context, const char* text, size_t text_length,
+	char* normalized_text, size_t* positions)
+{
+	if (tokenize_expression_part(context, text, text_length) != NO_ERROR)
+	{
+		return normalize_formula_whitespace(text, text_length, normalized_text, positions);
+	}
+
+	size_t normalized_length = 0;
+	for (size_t i = 0; i < context->tokens_count; i++)
+	{
+		const struct token* token = &context->tokens[i];
+		if (i != 0)
+		{
+			positions[normalized_length] = positions[normalized_length - 1] + 1;
+			normalized_text[normalized_length++] = ' ';
+		}
+
+		for (size_t j = 0; j < token->length; j++)
+		{
+			positions[normalized_length] = token->offset + j;
+			normalized_text[normalized_length++] = text[token->offset + j];
+		}
+	}
+	positions[normalized_length] = (normalized_length != 0) ? positions[normalized_length - 1] + 1 : 0;
+
+	return normalized_length;
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE INITIALIZE
+LIBS  : stdlib.h
+NOTES : "cache_capacity" is maximal count of kept formulas, it is divided between shards exactly: the first
+        "cache_capacity % FORMULA_CACHE_SHARDS_COUNT" shards keep one formula more than others. Shard can
+        have zero capacity, then its formulas are compiled for every use. Returned pointer must be passed to
+        "formula_cache_free()" after use.
+**********************************************************************************************************/
+struct formula_cache* formula_cache_initialize(size_t cache_capacity)
+{
+	struct formula_cache* cache = calloc(1, sizeof(struct formula_cache));
+	if (cache == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	for (size_t i = 0; i < FORMULA_CACHE_SHARDS_COUNT; i++)
+	{
+		struct formula_cache_shard* shard = &cache->shards[i];
+		mutex_initialize(&shard->mutex);
+
+		size_t shard_capacity = cache_capacity / FORMULA_CACHE_SHARDS_COUNT +
+			((i < cache_capacity % FORMULA_CACHE_SHARDS_COUNT) ? 1 : 0);
+
+		shard->buckets_count = 1;
+		while (shard->buckets_count < shard_capacity * 2)
+		{
+			shard->buckets_count *= 2;
+		}
+		shard->buckets = calloc(shard->buckets_count, sizeof(struct formula_cache_entry*));
+		if (shard->buckets == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+		shard->shard_capacity = shard_capacity;
+	}
+
+	return cache;
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE ENTRY FREE
+LIBS  : stdlib.h
+NOTES : -
+**********************************************************************************************************/
+void formula_cache_entry_free(struct formula_cache_entry* entry)
+{
+	if (entry->jit != NULL)
+	{
+		jit_formula_free(entry->jit);
+	}
+	if (entry->formula != NULL)
+	{
+		compiled_formula_free(entry->formula);
+	}
+	free(entry->formula_text);
+	free(entry);
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE UNLINK
+LIBS  : -
+NOTES : removes entry from hash table and list of used entries of shard, mutex of shard must be locked.
+**********************************************************************************************************/
+void formula_cache_unlink(struct formula_cache_shard* shard, struct formula_cache_entry* entry)
+{
+	struct formula_cache_entry** link = &shard->buckets[(entry->formula_hash / FORMULA_CACHE_SHARDS_COUNT) &
+		(shard->buckets_count - 1)];
+	while (*link != entry)
+	{
+		link = &(*link)->next_in_bucket;
+	}
+	*link = entry->next_in_bucket;
+
+	if (entry->previous_used != NULL)
+	{
+		entry->previous_used->next_used = entry->next_used;
+	}
+	else
+	{
+		shard->most_recent = entry->next_used;
+	}
+
+	if (entry->next_used != NULL)
+	{
+		entry->next_used->previous_used = entry->previous_used;
+	}
+	else
+	{
+		shard->least_recent = entry->previous_used;
+	}
+
+	shard->entries_count--;
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE LINK
+LIBS  : -
+NOTES : puts entry to hash table and to the beginning of list of used entries, mutex of shard must be locked.
+**********************************************************************************************************/
+void formula_cache_link(struct formula_cache_shard* shard, struct formula_cache_entry* entry)
+{
+	struct formula_cache_entry** bucket = &shard->buckets[(entry->formula_hash / FORMULA_CACHE_SHARDS_COUNT) &
+		(shard->buckets_count - 1)];
+	entry->next_in_bucket = *bucket;
+	*bucket = entry;
+
+	entry->previous_used = NULL;
+	entry->next_used = shard->most_recent;
+	if (shard->most_recent != NULL)
+	{
+		shard->most_recent->previous_used = entry;
+	}
+	else
+	{
+		shard->least_recent = entry;
+	}
+	shard->most_recent = entry;
+
+	shard->entries_count++;
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE EVICT
+LIBS  : -
+NOTES : evicts the least recently used entry of full shard, mutex of shard must be locked. Entry which is used
+        by other thread is freed by the last "formula_cache_release()".
+**********************************************************************************************************/
+void formula_cache_evict(struct formula_cache_shard* shard)
+{
+	struct formula_cache_entry* entry = shard->least_recent;
+
+	formula_cache_unlink(shard, entry);
+	shard->evictions_count++;
+	STATISTICS_COUNT_SHARED(cache_evictions_count);
+
+	entry->is_evicted = 1;
+	if (entry->references_count == 0)
+	{
+		formula_cache_entry_free(entry);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE ACQUIRE
+LIBS  : stdlib.h, string.h
+NOTES : return cache entry of normalized formula text (see "normalize_formula_text()"), formula is compiled by
+        parser context of caller if it is not in cache yet. Entry must be passed to "formula_cache_release()"
+        after use. If "is_jit_enabled" is 1, formula is translated by JIT when it becomes hot. "jit" of entry
+        is set by other thread under mutex of shard, so its value read under the same mutex is written to
+        "jit" (NULL if formula is not translated yet) and caller must use it instead of field of entry.
+**********************************************************************************************************/
+struct formula_cache_entry* formula_cache_acquire(struct formula_cache* cache, struct parser_context* context,
+	const char* formula_text, size_t formula_length, int is_jit_enabled, struct jit_formula** jit)
+{
+	size_t formula_hash = get_string_hash(formula_text, formula_length);
+	struct formula_cache_shard* shard = &cache->shards[formula_hash & (FORMULA_CACHE_SHARDS_COUNT - 1)];
+
+	mutex_lock(&shard->mutex);
+
+	struct formula_cache_entry* entry = shard->buckets[(formula_hash / FORMULA_CACHE_SHARDS_COUNT) &
+		(shard->buckets_count - 1)];
+	while (entry != NULL)
+	{
+		if (entry->formula_hash == formula_hash && entry->formula_length == formula_length &&
+			memcmp(entry->formula_text, formula_text, formula_length) == 0)
+		{
+			break;
+		}
+		entry = entry->next_in_bucket;
+	}
+
+	if (entry != NULL)
+	{
+		STATISTICS_COUNT_SHARED(cache_hits_count);
+		if (shard->most_recent != entry)
+		{
+			formula_cache_unlink(shard, entry);
+			formula_cache_link(shard, entry);
+		}
+	}
+	else
+	{
+		STATISTICS_COUNT_SHARED(cache_misses_count);
+		if (shard->entries_count == shard->shard_capacity && shard->entries_count != 0)
+		{
+			formula_cache_evict(shard);
+		}
+
+		entry = calloc(1, sizeof(struct formula_cache_entry));
+		char* entry_text = calloc(formula_length + 1, sizeof(char));
+		if (entry == NULL || entry_text == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+		memcpy(entry_text, formula_text, formula_length);
+
+		entry->formula_text = entry_text;
+		entry->formula_length = formula_length;
+		entry->formula_hash = formula_hash;
+		entry->formula_id = shard->next_formula_id++ * FORMULA_CACHE_SHARDS_COUNT +
+			(formula_hash & (FORMULA_CACHE_SHARDS_COUNT - 1));
+		entry->formula = compile_formula(context, entry->formula_text);
+		entry->error_code = context->error_code;
+		entry->error_position = context->error_position;
+
+		//entry of shard without capacity is only given to caller, it is freed by release.
+		if (shard->shard_capacity != 0)
+		{
+			formula_cache_link(shard, entry);
+		}
+		else
+		{
+			entry->is_evicted = 1;
+		}
+	}
+
+	entry->references_count++;
+	entry->uses_count++;
+	if (is_jit_enabled == 1 && entry->formula != NULL && entry->uses_count == JIT_HOT_EVALUATIONS_COUNT)
+	{
+		entry->jit = jit_compile_formula(entry->formula, entry->formula_text);
+	}
+	*jit = entry->jit;
+
+	mutex_unlock(&shard->mutex);
+
+	return entry;
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE RELEASE
+LIBS  : -
+NOTES : entry must not be used after release.
+**********************************************************************************************************/
+void formula_cache_release(struct formula_cache* cache, struct formula_cache_entry* entry)
+{
+	struct formula_cache_shard* shard = &cache->shards[entry->formula_hash & (FORMULA_CACHE_SHARDS_COUNT - 1)];
+
+	mutex_lock(&shard->mutex);
+	entry->references_count--;
+	int is_unused = (entry->is_evicted == 1 && entry->references_count == 0);
+	mutex_unlock(&shard->mutex);
+
+	if (is_unused == 1)
+	{
+		formula_cache_entry_free(entry);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with formula cache, entries must be released before.
+**********************************************************************************************************/
+void formula_cache_free(struct formula_cache* cache)
+{
+	for (size_t i = 0; i < FORMULA_CACHE_SHARDS_COUNT; i++)
+	{
+		struct formula_cache_shard* shard = &cache->shards[i];
+		while (shard->most_recent != NULL)
+		{
+			struct formula_cache_entry* entry = shard->most_recent;
+			formula_cache_unlink(shard, entry);
+			formula_cache_entry_free(entry);
+		}
+
+		free(shard->buckets);
+		mutex_free(&shard->mutex);
+	}
+
+	free(cache);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////FORMULA CACHE SECTION END///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////STREAM SECTION//////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Stream mode reads newline-delimited expressions (with or without "where" part) and writes one result per
+line. Input is either memory-mapped file or standard input read by large chunks, output goes through large
+buffer. Every distinct formula is compiled once and kept in formula cache, so repeated formula costs only
+hash lookup and parsing of its values.
+
+*/
+
+/**********************************************************************************************************
+NAME  : OUTPUT BUFFER
+LIBS  : stdio.h
+NOTES : -
+**********************************************************************************************************/
+struct output_buffer
+{
+	char* data;
+	size_t buffer_capacity;
+	size_t current_length;
+	FILE* output_stream;
+};
+
+
+/**********************************************************************************************************
+NAME  : OUTPUT BUFFER FLUSH
+LIBS  : stdio.h
+NOTES : output is discarded if "output_stream" is NULL (benchmarks).
+**********************************************************************************************************/
+void output_buffer_flush(struct output_buffer* buffer)
+{
+	if (buffer->output_stream != NULL)
+	{
+		fwrite(buffer->data, sizeof(char), buffer->current_length, buffer->output_stream);
+	}
+	buffer->current_length = 0;
+}
+
+
+/**********************************************************************************************************
+NAME  : OUTPUT BUFFER WRITE RESULT
+LIBS  : stdio.h
+NOTES : writes result in the same format as interactive mode does, one result per line.
+**********************************************************************************************************/
+void output_buffer_write_result(struct output_buffer* buffer, double result)
+{
+	const size_t MAX_RESULT_LENGTH = 512;
+
+	if (buffer->buffer_capacity - buffer->current_length < MAX_RESULT_LENGTH)
+	{
+		output_buffer_flush(buffer);
+	}
+
+	int written_count = snprintf(buffer->data + buffer->current_length, MAX_RESULT_LENGTH, "%f\n", result);
+	buffer->current_length += (size_t)written_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : OUTPUT BUFFER WRITE ERROR
+LIBS  : stdio.h
+NOTES : writes error message instead of result, position is offset of wrong token in line.
+**********************************************************************************************************/
+void output_buffer_write_error(struct output_buffer* buffer, int error_code, size_t error_position)
+{
+	const size_t MAX_ERROR_LENGTH = 512;
+
+	STATISTICS_COUNT_ERROR(error_code);
+
+	if (buffer->buffer_capacity - buffer->current_length < MAX_ERROR_LENGTH)
+	{
+		output_buffer_flush(buffer);
+	}
+
+	int written_count = snprintf(buffer->data + buffer->current_length, MAX_ERROR_LENGTH,
+		"Error: %s at position %zu\n", get_error_message(error_code), error_position);
+	buffer->current_length += (size_t)written_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : OUTPUT BUFFER WRITE NEW LINE
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void output_buffer_write_new_line(struct output_buffer* buffer)
+{
+	if (buffer->current_length == buffer->buffer_capacity)
+	{
+		output_buffer_flush(buffer);
+	}
+
+	buffer->data[buffer->current_length] = '\n';
+	buffer->current_length++;
+}
+
+
+/**********************************************************************************************************
+NAME  : STREAM STATE
+LIBS  : -
+NOTES : if "is_jit_enabled" is 1, formula is translated by JIT after JIT_HOT_EVALUATIONS_COUNT uses.
+        "result_cache" is NULL if results are not cached. "normalized_text" and "normalized_positions" are
+        scratch arrays of line capacity for normalized formula text, "bindings" and "bound_flags" are scratch
+        arrays for values of formula variables.
+**********************************************************************************************************/
+struct stream_state
+{
+	struct parser_context* context;
+	struct formula_cache* formula_cache;
+	struct result_cache* result_cache;
+	struct stack_double* stack;
+	struct output_buffer output_buffer;
+	int is_jit_enabled;
+
+	char* line;
+	char* normalized_text;
+	size_t* normalized_positions;
+	size_t line_capacity;
+
+	double* bindings;
+	char* bound_flags;
+	size_t bindings_capacity;
+};
+
+
+/**********************************************************************************************************
+NAME  : EVALUATE STREAM FORMULA
+LIBS  : -
+NOTES : evaluates compiled formula of cache entry with values bound to stream state, hot formula is
+        evaluated by JIT. "jit" is JIT of entry returned by "formula_cache_acquire()".
+**********************************************************************************************************/
+struct evaluation_result evaluate_stream_formula(struct stream_state* state, const struct formula_cache_entry* entry,
+	const struct jit_formula* jit)
+{
+	STATISTICS_START(evaluate_start_ticks);
+	struct evaluation_result result;
+	if (jit != NULL)
+	{
+		result = evaluate_jit_formula(jit, state->bindings);
+	}
+	else
+	{
+		if (state->stack->stack_capacity < entry->formula->max_stack_depth)
+		{
+			stack_double_free(state->stack);
+			state->stack = stack_double_initialize(entry->formula->max_stack_depth);
+		}
+
+		result = evaluate_compiled_formula(entry->formula, state->bindings, state->stack);
+	}
+	STATISTICS_END(STATISTICS_EVALUATE, evaluate_start_ticks);
+	STATISTICS_COUNT(evaluations_count);
+
+	return result;
+}
+
+
+/**********************************************************************************************************
+NAME  : CALCULATE STREAM FORMULA
+LIBS  : stdlib.h
+NOTES : binds values of line (they start at "formula_length", with where keyword if "has_where_part" is 1) to
+        formula of cache entry and evaluates it. Error of compilation of formula is returned as result. "jit" is
+        JIT of entry returned by "formula_cache_acquire()". "is_values_error" is set to 1 if error is in values
+        (its position is offset in line), otherwise position of error is offset in normalized formula text.
+**********************************************************************************************************/
+struct evaluation_result calculate_stream_formula(struct stream_state* state,
+	const struct formula_cache_entry* entry, const struct jit_formula* jit, size_t formula_length,
+	int has_where_part, int* is_values_error)
+{
+	struct evaluation_result result = { NAN, NO_ERROR, 0 };
+	*is_values_error = 0;
+	if (entry->formula == NULL)
+	{
+		result.error_code = entry->error_code;
+		result.error_position = entry->error_position;
+		return result;
+	}
+
+	size_t variables_count = entry->formula->variables_count;
+	if (variables_count + 1 > state->bindings_capacity)
+	{
+		free(state->bindings);
+		free(state->bound_flags);
+		state->bindings_capacity = (variables_count + 1) * 2;
+		state->bindings = calloc(state->bindings_capacity, sizeof(double));
+		state->bound_flags = calloc(state->bindings_capacity, sizeof(char));
+		if (state->bindings == NULL || state->bound_flags == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+	}
+
+	//formula is already compiled, only values part (starting from where keyword) is tokenized.
+	STATISTICS_START(lex_start_ticks);
+	result.error_code = tokenize_expression(state->context, state->line + formula_length);
+	STATISTICS_END(STATISTICS_LEX, lex_start_ticks);
+	result.error_position = formula_length + state->context->error_position;
+	if (result.error_code == NO_ERROR)
+	{
+		const size_t WHERE_KEYWORD_TOKENS_COUNT = 1;
+		size_t first_value_token = (has_where_part == 1) ? WHERE_KEYWORD_TOKENS_COUNT : 0;
+		STATISTICS_START(bind_start_ticks);
+		result.error_code = bind_value_tokens(state->context, first_value_token, state->line + formula_length,
+			formula_length, entry->formula, state->bindings, state->bound_flags, &result.error_position);
+		STATISTICS_END(STATISTICS_BIND, bind_start_ticks);
+	}
+
+	if (result.error_code != NO_ERROR)
+	{
+		*is_values_error = 1;
+		return result;
+	}
+
+	//variable without value is reported in formula text.
+	result.error_code = check_bound_variables(entry->formula, state->bound_flags, &result.error_position);
+	if (result.error_code != NO_ERROR)
+	{
+		return result;
+	}
+
+	if (state->result_cache == NULL ||
+		result_cache_find(state->result_cache, entry->formula_id, state->bindings, variables_count, &result) == 0)
+	{
+		result = evaluate_stream_formula(state, entry, jit);
+		if (state->result_cache != NULL)
+		{
+			result_cache_add(state->result_cache, entry->formula_id, state->bindings, variables_count, result);
+		}
+	}
+
+	return result;
+}
+
+
+/**********************************************************************************************************
+NAME  : PROCESS STREAM LINE
+LIBS  : string.h
+NOTES : line has no new line character and is not terminated by zero character. Wrong line gives error
+        message instead of result, processing of next lines continues.
+**********************************************************************************************************/
+void process_stream_line(struct stream_state* state, const char* line_start, size_t line_length)
+{
+	const char WHERE_KEYWORD = '|';
+
+	STATISTICS_POLL();
+
+	if (line_length > 0 && line_start[line_length - 1] == '\r')
+	{
+		line_length--;
+	}
+
+	//blank line gives blank line, so numbers of input and output lines match.
+	size_t first_not_space = 0;
+	while (first_not_space < line_length && isspace((unsigned char)line_start[first_not_space]) != 0)
+	{
+		first_not_space++;
+	}
+	if (first_not_space == line_length)
+	{
+		output_buffer_write_new_line(&state->output_buffer);
+		return;
+	}
+
+	if (line_length + 1 > state->line_capacity)
+	{
+		free(state->line);
+		free(state->normalized_text);
+		free(state->normalized_positions);
+		state->line_capacity = (line_length + 1) * 2;
+		state->line = calloc(state->line_capacity, sizeof(char));
+		state->normalized_text = calloc(state->line_capacity, sizeof(char));
+		state->normalized_positions = calloc(state->line_capacity, sizeof(size_t));
+		if (state->line == NULL || state->normalized_text == NULL || state->normalized_positions == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+	}
+	memcpy(state->line, line_start, line_length);
+	state->line[line_length] = '\0';
+
+	char* where_position = strchr(state->line, WHERE_KEYWORD);
+	size_t formula_length = (where_position != NULL) ? (size_t)(where_position - state->line) : line_length;
+
+	STATISTICS_START(lex_start_ticks);
+	size_t normalized_length = normalize_formula_text(state->context, state->line, formula_length,
+		state->normalized_text, state->normalized_positions);
+	STATISTICS_END(STATISTICS_LEX, lex_start_ticks);
+	struct jit_formula* jit;
+	struct formula_cache_entry* entry = formula_cache_acquire(state->formula_cache, state->context,
+		state->normalized_text, normalized_length, state->is_jit_enabled, &jit);
+	int is_values_error;
+	struct evaluation_result result = calculate_stream_formula(state, entry, jit, formula_length,
+		(where_position != NULL) ? 1 : 0, &is_values_error);
+	formula_cache_release(state->formula_cache, entry);
+
+	if (result.error_code != NO_ERROR)
+	{
+		//positions of formula errors are offsets in normalized text, which can be longer than formula
+		//("a+b" is "a + b"), positions of values errors are offsets in line.
+		size_t error_position = result.error_position;
+		if (is_values_error == 0)
+		{
+			error_position = state->normalized_positions[error_position];
+		}
+		output_buffer_write_error(&state->output_buffer, result.error_code, error_position);
+		return;
+	}
+
+	output_buffer_write_result(&state->output_buffer, result.value);
+}
+
+
+/**********************************************************************************************************
+NAME  : PROCESS STREAM DATA
+LIBS  : string.h
+NOTES : processes all complete lines of data, return count of processed characters. If "is_last_data" is
+        1, the last line is processed even without new line character.
+**********************************************************************************************************/
+size_t process_stream_data(struct stream_state* state, const char* data, size_t data_length, int is_last_data)
+{
+	size_t processed_length = 0;
+
+	while (processed_length < data_length)
+	{
+		const char* line_start = data + processed_length;
+		const char* line_end = memchr(line_start, '\n', data_length - processed_length);
+
+		if (line_end == NULL)
+		{
+			if (is_last_data == 1)
+			{
+				process_stream_line(state, line_start, data_length - processed_length);
+				processed_length = data_length;
+			}
+			break;
+		}
+
+		process_stream_line(state, line_start, (size_t)(line_end - line_start));
+		processed_length += (size_t)(line_end - line_start) + 1;
+	}
+
+	return processed_length;
+}
+
+
+/**********************************************************************************************************
+NAME  : STREAM STATE INITIALIZE
+LIBS  : stdlib.h
+NOTES : "result_cache_capacity" 0 means that results are not cached. Output is written to "output_stream", it
+        is kept in output buffer if stream is NULL. State must be passed to "stream_state_free()" after use.
+**********************************************************************************************************/
+void stream_state_initialize(struct stream_state* state, int is_jit_enabled, size_t formula_cache_capacity,
+	size_t result_cache_capacity, FILE* output_stream)
+{
+	const size_t OUTPUT_BUFFER_CAPACITY = 1 << 20;
+
+	state->context = parser_context_initialize();
+	state->formula_cache = formula_cache_initialize(formula_cache_capacity);
+	state->result_cache = (result_cache_capacity != 0) ? result_cache_initialize(result_cache_capacity) : NULL;
+	state->stack = stack_double_initialize(1);
+	state->is_jit_enabled = is_jit_enabled;
+	state->line = NULL;
+	state->normalized_text = NULL;
+	state->normalized_positions = NULL;
+	state->line_capacity = 0;
+	state->bindings = NULL;
+	state->bound_flags = NULL;
+	state->bindings_capacity = 0;
+
+	state->output_buffer.data = calloc(OUTPUT_BUFFER_CAPACITY, sizeof(char));
+	if (state->output_buffer.data == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	state->output_buffer.buffer_capacity = OUTPUT_BUFFER_CAPACITY;
+	state->output_buffer.current_length = 0;
+	state->output_buffer.output_stream = output_stream;
+}
+
+
+/**********************************************************************************************************
+NAME  : STREAM STATE FREE
+LIBS  : stdlib.h
+NOTES : output which is not flushed yet is discarded.
+**********************************************************************************************************/
+void stream_state_free(struct stream_state* state)
+{
+	free(state->output_buffer.data);
+	free(state->line);
+	free(state->normalized_text);
+	free(state->normalized_positions);
+	free(state->bindings);
+	free(state->bound_flags);
+	stack_double_free(state->stack);
+	formula_cache_free(state->formula_cache);
+	if (state->result_cache != NULL)
+	{
+		result_cache_free(state->result_cache);
+	}
+	parser_context_free(state->context);
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL STREAM MODE
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : "-" as file path means standard input. If "is_jit_enabled" is 1, hot formulas are translated by
+        JIT. Formula cache keeps not more than "formula_cache_capacity" formulas. If "result_cache_capacity"
+        is not 0, this count of the last results is cached. Return EXIT_SUCCESS or EXIT_FAILURE.
+**********************************************************************************************************/
+int call_stream_mode(const char* file_path, int is_jit_enabled, size_t formula_cache_capacity,
+	size_t result_cache_capacity)
+{
+	const size_t INPUT_CHUNK_SIZE = 1 << 20;
+
+	struct stream_state state;
+	stream_state_initialize(&state, is_jit_enabled, formula_cache_capacity, result_cache_capacity, stdout);
+
+	if (strcmp(file_path, "-") != 0)
+	{
+		struct mapped_file* mapped_file = map_file(file_path);
+		if (mapped_file == NULL)
+		{
+			fprintf(stderr, "Can not open file %s\n", file_path);
+			stream_state_free(&state);
+			return EXIT_FAILURE;
+		}
+
+		process_stream_data(&state, mapped_file->data, mapped_file->size, 1);
+		unmap_file(mapped_file);
+	}
+	else
+	{
+		//unprocessed tail of chunk (incomplete line) is moved to the beginning of buffer.
+		size_t input_capacity = INPUT_CHUNK_SIZE;
+		char* input_buffer = calloc(input_capacity, sizeof(char));
+		if (input_buffer == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+
+		size_t input_length = 0;
+		for (;;)
+		{
+			if (input_length == input_capacity)
+			{
+				input_capacity *= 2;
+				input_buffer = realloc(input_buffer, input_capacity);
+				if (input_buffer == NULL)
+				{
+					throw_error(OUT_OF_MEMORY);
+				}
+			}
+
+			size_t read_count = fread(input_buffer + input_length, sizeof(char), input_capacity - input_length, stdin);
+			input_length += read_count;
+			int is_last_data = (read_count == 0) ? 1 : 0;
+
+			size_t processed_length = process_stream_data(&state, input_buffer, input_length, is_last_data);
+			memmove(input_buffer, input_buffer + processed_length, input_length - processed_length);
+			input_length -= processed_length;
+
+			if (is_last_data == 1)
+			{
+				break;
+			}
+		}
+
+		free(input_buffer);
+	}
+
+	output_buffer_flush(&state.output_buffer);
+	fflush(stdout);
+
+	stream_state_free(&state);
+
+	return EXIT_SUCCESS;
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL CHECK STREAM MODE
+LIBS  : stdio.h, string.h
+NOTES : processes lines with known output by stream mode and prints lines whose output differs. Positions of
+        errors are checked for formulas which are changed by normalization of formula text. Return
+        EXIT_SUCCESS if output of every line is right, otherwise EXIT_FAILURE.
+**********************************************************************************************************/
+int call_check_stream_mode()
+{
+	const size_t FORMULA_CACHE_CAPACITY = 16;
+	//values errors are offsets in line, formula errors are offsets of formula tokens in line.
+	const char* LINES[] =
+	{
+		"a+b+c|a=x,b=1,c=1",
+		"a+b+c+d+e|a=1/0",
+		"a + b + c | a = 1 , b = x",
+		"a+*b | a = 1 , b = 2",
+		"  a  +  *  b | a = 1 , b = 2",
+		"1/0+a|a=1",
+		"a+b|a=1,b=2",
+		"a+b|a=1,c=2"
+	};
+	const char* OUTPUTS[] =
+	{
+		"Error: Unexpected token at position 8\n",
+		"Error: Unexpected token at position 13\n",
+		"Error: Unexpected token at position 24\n",
+		"Error: Stack underflow at position 1\n",
+		"Error: Stack underflow at position 5\n",
+		"Error: Zero division at position 1\n",
+		"3.000000\n",
+		"Error: Unexpected token at position 2\n"
+	};
+	const size_t LINES_COUNT = sizeof(LINES) / sizeof(LINES[0]);
+
+	size_t failed_count = 0;
+	struct stream_state state;
+	stream_state_initialize(&state, 0, FORMULA_CACHE_CAPACITY, 0, NULL);
+
+	for (size_t i = 0; i < LINES_COUNT; i++)
+	{
+		state.output_buffer.current_length = 0;
+		process_stream_line(&state, LINES[i], strlen(LINES[i]));
+
+		size_t output_length = state.output_buffer.current_length;
+		if (output_length != strlen(OUTPUTS[i]) || memcmp(state.output_buffer.data, OUTPUTS[i], output_length) != 0)
+		{
+			printf("%s\n    expected: %s    got: %.*s", LINES[i], OUTPUTS[i], (int)output_length,
+				state.output_buffer.data);
+			failed_count++;
+		}
+	}
+
+	printf("checked lines: %zu, failed: %zu\n", LINES_COUNT, failed_count);
+	stream_state_free(&state);
+
+	return (failed_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////STREAM SECTION END//////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////CSV FILTER SECTION//////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+CSV filter calculates one formula for every row of memory-mapped CSV file. The first line of file is header,
+its names are matched with variables of formula, columns which formula does not use are skipped without
+parsing. Rows are parsed straight into columns of BATCH_BLOCK_SIZE rows and every block is calculated by
+batch evaluation, so file is read once and nothing is copied except parsed values.
+
+Numeric field is parsed by "parse_number()" (the same literals as in formulas, with optional plus sign),
+so it is correctly rounded and does not depend on locale. Any field can be quoted, quoted field can have commas
+and escaped quotes ("") inside, but not line breaks.
+
+Row numbers start from 1 at the first line after header, empty lines are not rows.
+
+*/
+
+/**********************************************************************************************************
+NAME  : CSV FILTER
+LIBS  : -
+NOTES : "column_slots" is slot of formula variable for every column of file, -1 if column is not used.
+        "columns" are values of variables of current block, "field_errors" and "field_error_positions" are
+        error code (NO_ERROR if row is parsed) and offset of wrong field in line for every row of block.
+        If "is_results_written" is 1, result of every row is written, otherwise numbers of rows whose
+        result is true.
+**********************************************************************************************************/
+struct csv_filter
+{
+	const struct compiled_formula* formula;
+	struct batch_stack* batch_stack;
+	struct stack_double* stack;
+	double* bindings;
+
+	int* column_slots;
+	size_t columns_count;
+
+	double** columns;
+	int* field_errors;
+	size_t* field_error_positions;
+	size_t block_rows_count;
+
+	size_t rows_count;
+	size_t matched_rows_count;
+	int is_results_written;
+	struct output_buffer output_buffer;
+};
+
+
+/**********************************************************************************************************
+NAME  : PARSE CSV NUMBER
+LIBS  : -
+NOTES : parses number which starts at cursor and writes it to value, plus sign before number is allowed.
+        Return pointer after number, NULL if there is no number at cursor.
+**********************************************************************************************************/
+const char* parse_csv_number(const char* cursor, const char* data_end, double* value)
+{
+	if (cursor + 1 < data_end && *cursor == '+' && cursor[1] != '-')
+	{
+		cursor++;
+	}
+
+	size_t number_length = parse_number(cursor, data_end, value);
+
+	return (number_length != 0) ? cursor + number_length : NULL;
+}
+
+
+/**********************************************************************************************************
+NAME  : SKIP CSV FIELD
+LIBS  : -
+NOTES : return pointer on comma or line end after field. Commas inside quotes of quoted field are part of
+        field, two quotes inside it are escaped quote. Rows are lines, so quoted field ends at line end even
+        without closing quote.
+**********************************************************************************************************/
+const char* skip_csv_field(const char* cursor, const char* data_end)
+{
+	while (cursor < data_end && *cursor == ' ')
+	{
+		cursor++;
+	}
+
+	if (cursor < data_end && *cursor == '"')
+	{
+		cursor++;
+		while (cursor < data_end && *cursor != '\n')
+		{
+			if (*cursor == '"')
+			{
+				if (cursor + 1 == data_end || cursor[1] != '"')
+				{
+					cursor++;
+					break;
+				}
+				cursor++;
+			}
+			cursor++;
+		}
+	}
+
+	while (cursor < data_end && *cursor != ',' && *cursor != '\n')
+	{
+		cursor++;
+	}
+
+	return cursor;
+}
+
+
+/**********************************************************************************************************
+NAME  : PARSE CSV ROW
+LIBS  : string.h
+NOTES : parses values of used columns of line which starts at cursor into current row of block. Spaces and
+        quotes around number are allowed. If field is not a number or count of fields differs from header,
+        UNEXPECTED_TOKEN and offset of field are written for row. Return pointer on the next line.
+**********************************************************************************************************/
+const char* parse_csv_row(struct csv_filter* filter, const char* cursor, const char* data_end)
+{
+	const char* line_start = cursor;
+	size_t row = filter->block_rows_count;
+	filter->field_errors[row] = NO_ERROR;
+
+	for (size_t column = 0; column < filter->columns_count; column++)
+	{
+		if (column != 0)
+		{
+			if (cursor == data_end || *cursor != ',')
+			{
+				if (filter->field_errors[row] == NO_ERROR)
+				{
+					filter->field_errors[row] = UNEXPECTED_TOKEN;
+					filter->field_error_positions[row] = (size_t)(cursor - line_start);
+				}
+				break;
+			}
+			cursor++;
+		}
+
+		int slot = filter->column_slots[column];
+		if (slot < 0)
+		{
+			cursor = skip_csv_field(cursor, data_end);
+			continue;
+		}
+
+		const char* field_start = cursor;
+		while (cursor < data_end && *cursor == ' ')
+		{
+			cursor++;
+		}
+		int is_quoted = (cursor < data_end && *cursor == '"');
+		cursor += is_quoted;
+
+		cursor = parse_csv_number(cursor, data_end, &filter->columns[slot][row]);
+		if (cursor != NULL && is_quoted == 1)
+		{
+			cursor = (cursor < data_end && *cursor == '"') ? cursor + 1 : NULL;
+		}
+		while (cursor != NULL && cursor < data_end && *cursor == ' ')
+		{
+			cursor++;
+		}
+
+		if (cursor == NULL || (cursor < data_end && *cursor != ',' && *cursor != '\n' && *cursor != '\r'))
+		{
+			filter->field_errors[row] = UNEXPECTED_TOKEN;
+			filter->field_error_positions[row] = (size_t)(field_start - line_start);
+			cursor = skip_csv_field(field_start, data_end);
+		}
+	}
+
+	if (cursor < data_end && *cursor == '\r')
+	{
+		cursor++;
+	}
+	if (filter->field_errors[row] == NO_ERROR && cursor < data_end && *cursor != '\n')
+	{
+		filter->field_errors[row] = UNEXPECTED_TOKEN;
+		filter->field_error_positions[row] = (size_t)(cursor - line_start);
+	}
+
+	const char* line_end = memchr(cursor, '\n', (size_t)(data_end - cursor));
+
+	return (line_end != NULL) ? line_end + 1 : data_end;
+}
+
+
+/**********************************************************************************************************
+NAME  : OUTPUT BUFFER WRITE ROW NUMBER
+LIBS  : stdio.h
+NOTES : -
+**********************************************************************************************************/
+void output_buffer_write_row_number(struct output_buffer* buffer, size_t row_number)
+{
+	const size_t MAX_ROW_NUMBER_LENGTH = 32;
+
+	if (buffer->buffer_capacity - buffer->current_length < MAX_ROW_NUMBER_LENGTH)
+	{
+		output_buffer_flush(buffer);
+	}
+
+	int written_count = snprintf(buffer->data + buffer->current_length, MAX_ROW_NUMBER_LENGTH, "%zu\n",
+		row_number);
+	buffer->current_length += (size_t)written_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : FLUSH CSV BLOCK
+LIBS  : -
+NOTES : calculates parsed rows of block and writes their results or numbers of matched rows. Batch evaluation
+        does not keep positions of errors, so failed row is calculated once more by "evaluate_compiled_formula()"
+        to write the same error as stream mode does.
+**********************************************************************************************************/
+void flush_csv_block(struct csv_filter* filter)
+{
+	const struct compiled_formula* formula = filter->formula;
+	size_t block_rows_count = filter->block_rows_count;
+
+	if (block_rows_count == 0)
+	{
+		return;
+	}
+
+	int block_error_code = evaluate_batch_block(formula, (const double* const*)filter->columns, 0,
+		block_rows_count, filter->batch_stack);
+	const double* results = filter->batch_stack->blocks;
+	const int* row_errors = filter->batch_stack->row_errors;
+
+	for (size_t row = 0; row < block_rows_count; row++)
+	{
+		int is_failed = (filter->field_errors[row] != NO_ERROR || block_error_code != NO_ERROR ||
+			row_errors[row] != NO_ERROR);
+
+		if (filter->is_results_written == 0)
+		{
+			if (is_failed == 0 && results[row] == 1)
+			{
+				output_buffer_write_row_number(&filter->output_buffer, filter->rows_count + row + 1);
+				filter->matched_rows_count++;
+			}
+			continue;
+		}
+
+		if (is_failed == 0)
+		{
+			output_buffer_write_result(&filter->output_buffer, results[row]);
+		}
+		else if (filter->field_errors[row] != NO_ERROR)
+		{
+			output_buffer_write_error(&filter->output_buffer, filter->field_errors[row],
+				filter->field_error_positions[row]);
+		}
+		else
+		{
+			for (size_t slot = 0; slot < formula->variables_count; slot++)
+			{
+				filter->bindings[slot] = filter->columns[slot][row];
+			}
+			struct evaluation_result result = evaluate_compiled_formula(formula, filter->bindings, filter->stack);
+			output_buffer_write_error(&filter->output_buffer, result.error_code, result.error_position);
+		}
+	}
+
+	filter->rows_count += block_rows_count;
+	filter->block_rows_count = 0;
+}
+
+
+/**********************************************************************************************************
+NAME  : READ CSV HEADER
+LIBS  : stdio.h, stdlib.h
+NOTES : matches names of header which starts at cursor with variables of formula. Names can be quoted, the
+        first of equal names is used, cursor is moved to the first data line. Return 0 if formula has variable
+        which is not in header (its name is written to standard error).
+**********************************************************************************************************/
+int read_csv_header(struct csv_filter* filter, const char** data_cursor, const char* data_end)
+{
+	const char* UTF8_BYTE_ORDER_MARK = "\xEF\xBB\xBF";
+	const size_t BUFFER_ELEMENT = 1;
+
+	const char* cursor = *data_cursor;
+	if ((size_t)(data_end - cursor) >= strlen(UTF8_BYTE_ORDER_MARK) &&
+		memcmp(cursor, UTF8_BYTE_ORDER_MARK, strlen(UTF8_BYTE_ORDER_MARK)) == 0)
+	{
+		cursor += strlen(UTF8_BYTE_ORDER_MARK);
+	}
+
+	const char* header_end = (cursor < data_end) ? memchr(cursor, '\n', (size_t)(data_end - cursor)) : NULL;
+	header_end = (header_end != NULL) ? header_end : data_end;
+
+	filter->columns_count = 1;
+	for (const char* name_end = skip_csv_field(cursor, header_end); name_end < header_end;
+		name_end = skip_csv_field(name_end + 1, header_end))
+	{
+		filter->columns_count++;
+	}
+
+	const struct compiled_formula* formula = filter->formula;
+	filter->column_slots = calloc(filter->columns_count + BUFFER_ELEMENT, sizeof(int));
+	char* bound_flags = calloc(formula->variables_count + BUFFER_ELEMENT, sizeof(char));
+	if (filter->column_slots == NULL || bound_flags == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	for (size_t column = 0; column < filter->columns_count; column++)
+	{
+		const char* name_end = skip_csv_field(cursor, header_end);
+		const char* name_start = cursor;
+		cursor = (name_end < header_end) ? name_end + 1 : header_end;
+
+		while (name_start < name_end && (*name_start == ' ' || *name_start == '"'))
+		{
+			name_start++;
+		}
+		while (name_end > name_start && (name_end[-1] == ' ' || name_end[-1] == '"' || name_end[-1] == '\r'))
+		{
+			name_end--;
+		}
+
+		int slot = find_variable_slot(formula, name_start, (size_t)(name_end - name_start));
+		if (slot >= 0 && bound_flags[slot] == 1)
+		{
+			slot = -1;
+		}
+		filter->column_slots[column] = slot;
+		if (slot >= 0)
+		{
+			bound_flags[slot] = 1;
+		}
+	}
+
+	for (size_t slot = 0; slot < formula->variables_count; slot++)
+	{
+		if (bound_flags[slot] == 0)
+		{
+			fprintf(stderr, "Error: column \"%s\" is not found in header\n", formula->variable_names[slot]);
+			free(bound_flags);
+			return 0;
+		}
+	}
+	free(bound_flags);
+
+	*data_cursor = (header_end < data_end) ? header_end + 1 : data_end;
+
+	return 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : CSV FILTER INITIALIZE
+LIBS  : stdlib.h
+NOTES : output goes to "output_stream", it is discarded if "output_stream" is NULL. Formula is borrowed,
+        it must live longer than filter. Returned pointer must be passed to "csv_filter_free()" after use.
+**********************************************************************************************************/
+struct csv_filter* csv_filter_initialize(const struct compiled_formula* formula, int is_results_written,
+	FILE* output_stream)
+{
+	const size_t OUTPUT_BUFFER_CAPACITY = 1 << 20;
+	const size_t BUFFER_ELEMENT = 1;
+
+	struct csv_filter* filter = calloc(1, sizeof(struct csv_filter));
+	if (filter == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	filter->formula = formula;
+	filter->batch_stack = batch_stack_initialize(formula->max_stack_depth);
+	filter->stack = stack_double_initialize(formula->max_stack_depth);
+	filter->bindings = calloc(formula->variables_count + BUFFER_ELEMENT, sizeof(double));
+	filter->columns = calloc(formula->variables_count + BUFFER_ELEMENT, sizeof(double*));
+	filter->field_errors = calloc(BATCH_BLOCK_SIZE, sizeof(int));
+	filter->field_error_positions = calloc(BATCH_BLOCK_SIZE, sizeof(size_t));
+	filter->output_buffer.data = calloc(OUTPUT_BUFFER_CAPACITY, sizeof(char));
+	if (filter->bindings == NULL || filter->columns == NULL || filter->field_errors == NULL ||
+		filter->field_error_positions == NULL || filter->output_buffer.data == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	for (size_t slot = 0; slot < formula->variables_count; slot++)
+	{
+		filter->columns[slot] = calloc(BATCH_BLOCK_SIZE, sizeof(double));
+		if (filter->columns[slot] == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+	}
+
+	filter->is_results_written = is_results_written;
+	filter->output_buffer.buffer_capacity = OUTPUT_BUFFER_CAPACITY;
+	filter->output_buffer.current_length = 0;
+	filter->output_buffer.output_stream = output_stream;
+
+	return filter;
+}
+
+
+/**********************************************************************************************************
+NAME  : CSV FILTER FREE
+LIBS  : stdlib.h
+NOTES : always use this function when finish work with CSV filter.
+**********************************************************************************************************/
+void csv_filter_free(struct csv_filter* filter)
+{
+	for (size_t slot = 0; slot < filter->formula->variables_count; slot++)
+	{
+		free(filter->columns[slot]);
+	}
+	free(filter->columns);
+	free(filter->column_slots);
+	free(filter->bindings);
+	free(filter->field_errors);
+	free(filter->field_error_positions);
+	free(filter->output_buffer.data);
+	stack_double_free(filter->stack);
+	batch_stack_free(filter->batch_stack);
+	free(filter);
+}
+
+
+/**********************************************************************************************************
+NAME  : PROCESS CSV DATA
+LIBS  : -
+NOTES : filters the whole CSV file which is in memory, output is flushed at the end. Return 0 if header does
+        not contain all variables of formula.
+**********************************************************************************************************/
+int process_csv_data(struct csv_filter* filter, const char* data, size_t data_length)
+{
+	const char* data_end = data + data_length;
+	const char* cursor = data;
+	if (read_csv_header(filter, &cursor, data_end) == 0)
+	{
+		return 0;
+	}
+
+	while (cursor < data_end)
+	{
+		if (*cursor == '\n' || (*cursor == '\r' && cursor + 1 < data_end && cursor[1] == '\n'))
+		{
+			cursor += (*cursor == '\r') ? 2 : 1;
+			continue;
+		}
+
+		cursor = parse_csv_row(filter, cursor, data_end);
+		filter->block_rows_count++;
+		if (filter->block_rows_count == BATCH_BLOCK_SIZE)
+		{
+			flush_csv_block(filter);
+		}
+	}
+	flush_csv_block(filter);
+	output_buffer_flush(&filter->output_buffer);
+
+	return 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL CSV MODE
+LIBS  : stdio.h, stdlib.h
+NOTES : if "is_results_written" is 1, result (or error) of every row is written to standard output one per
+        line, otherwise numbers of rows whose result is true. "accuracy" selects vector functions of
+        batch evaluation. Return EXIT_SUCCESS or EXIT_FAILURE.
+**********************************************************************************************************/
+int call_csv_mode(const char* file_path, const char* formula_text, int is_results_written, int accuracy)
+{
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formula = compile_formula(context, formula_text);
+	if (formula == NULL)
+	{
+		fprintf(stderr, "Error: %s at position %zu\n", get_error_message(context->error_code),
+			context->error_position);
+		parser_context_free(context);
+		return EXIT_FAILURE;
+	}
+	parser_context_free(context);
+
+	struct mapped_file* mapped_file = map_file(file_path);
+	if (mapped_file == NULL)
+	{
+		fprintf(stderr, "Can not open file %s\n", file_path);
+		compiled_formula_free(formula);
+		return EXIT_FAILURE;
+	}
+
+	struct csv_filter* filter = csv_filter_initialize(formula, is_results_written, stdout);
+	filter->batch_stack->accuracy = accuracy;
+	int is_processed = process_csv_data(filter, mapped_file->data, mapped_file->size);
+	fflush(stdout);
+
+	csv_filter_free(filter);
+	unmap_file(mapped_file);
+	compiled_formula_free(formula);
+
+	return (is_processed == 1) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////CSV FILTER SECTION END//////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////FORMULA FILE SECTION////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Formula file keeps compiled formulas (ruleset) in binary form, so they are loaded without lexing, conversion
+to postfix notation and compilation. File is memory-mapped, formula of file is view: its instructions,
+positions, constants and table of variables point into mapped file, only structure of formula and array of
+pointers on variable names are allocated (from arena of file). Formula of file is read-only, it can not be
+optimized or changed, and it must not be passed to "compiled_formula_free()" (it does nothing for formula
+with arena).
+
+All numbers are stored in byte order of machine which wrote file, file of other byte order is refused.
+Pointers are not stored, every part is found by offset from the beginning of file (record), so file can
+be mapped at any address. Every part starts at offset which is multiple of 8.
+
+	header       magic "MATHPARS", version, byte order mark, count of formulas, offset of directory
+	records      one record per formula (see FORMULA FILE RECORD)
+	directory    offset, size and checksum of every record
+
+Checksum of directory is checked when file is opened, checksum of record when formula is taken for the first
+time. Record with correct checksum is checked too: opcodes, operands and depth of stack, so damaged or
+handmade file can not make evaluation read out of arrays.
+
+*/
+
+//Version is increased when layout of file changes, files of other version are refused.
+#define FORMULA_FILE_VERSION 1
+
+//Byte order mark is written as number, in other byte order it is read as 0x04030201.
+#define FORMULA_FILE_BYTE_ORDER_MARK 0x01020304
+
+/**********************************************************************************************************
+NAME  : FORMULA FILE HEADER
+LIBS  : -
+NOTES : the first bytes of file.
+**********************************************************************************************************/
+struct formula_file_header
+{
+	char magic[8];
+	unsigned int version;
+	unsigned int byte_order_mark;
+	unsigned long long formulas_count;
+	unsigned long long directory_offset;
+	unsigned long long directory_checksum;
+};
+
+
+/**********************************************************************************************************
+NAME  : FORMULA FILE ENTRY
+LIBS  : -
+NOTES : entry of directory, offset is counted from the beginning of file.
+**********************************************************************************************************/
+struct formula_file_entry
+{
+	unsigned long long record_offset;
+	unsigned long long record_size;
+	unsigned long long record_checksum;
+};
+
+
+/**********************************************************************************************************
+NAME  : FORMULA FILE RECORD
+LIBS  : -
+NOTES : the first bytes of record of formula. Record continues by parts in this order: instructions (pairs
+        of 32-bit opcode and operand), positions of instructions (64-bit), constants, table of variables
+        (32-bit, the same as "variable_table" of compiled formula), offsets of variable names (64-bit, from
+        the beginning of record), text of formula and variable names (both end with zero character).
+**********************************************************************************************************/
+struct formula_file_record
+{
+	unsigned long long instructions_count;
+	unsigned long long constants_count;
+	unsigned long long variables_count;
+	unsigned long long variable_table_capacity;
+	unsigned long long max_stack_depth;
+	unsigned long long text_length;
+};
+
+
+/**********************************************************************************************************
+NAME  : FORMULA RECORD LAYOUT
+LIBS  : -
+NOTES : offsets of parts of record from its beginning, "names_offset" is offset of the first variable name.
+**********************************************************************************************************/
+struct formula_record_layout
+{
+	size_t instructions_offset;
+	size_t positions_offset;
+	size_t constants_offset;
+	size_t variable_table_offset;
+	size_t name_offsets_offset;
+	size_t text_offset;
+	size_t names_offset;
+};
+
+
+/**********************************************************************************************************
+NAME  : FORMULA FILE
+LIBS  : -
+NOTES : "formulas" are views of records, NULL if formula was not taken yet. "expected_depths" and
+        "pending_targets" are scratch arrays for check of records.
+**********************************************************************************************************/
+struct formula_file
+{
+	struct mapped_file* mapped_file;
+	const struct formula_file_entry* entries;
+	size_t formulas_count;
+
+	struct compiled_formula** formulas;
+	struct arena* arena;
+
+	size_t* expected_depths;
+	size_t* pending_targets;
+	size_t scratch_capacity;
+};
+
+
+/**********************************************************************************************************
+NAME  : GET CHECKSUM
+LIBS  : string.h
+NOTES : FNV-1a over 64-bit words instead of bytes, size must be multiple of 8.
+**********************************************************************************************************/
+unsigned long long get_checksum(const void* data, size_t size)
+{
+	const unsigned char* bytes = data;
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < size; i += sizeof(unsigned long long))
+	{
+		unsigned long long word;
+		memcpy(&word, bytes + i, sizeof(unsigned long long));
+		hash ^= word;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+
+/**********************************************************************************************************
+NAME  : ALIGN FORMULA FILE SIZE
+LIBS  : -
+NOTES : return size rounded up to multiple of 8.
+**********************************************************************************************************/
+size_t align_formula_file_size(size_t size)
+{
+	const size_t FORMULA_FILE_ALIGNMENT = 8;
+
+	return (size + FORMULA_FILE_ALIGNMENT - 1) & ~(FORMULA_FILE_ALIGNMENT - 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : GET FORMULA RECORD LAYOUT
+LIBS  : -
+NOTES : calculates offsets of parts of record by counts of its header. Return 0 if parts do not fit
+        "record_size" bytes.
+**********************************************************************************************************/
+int get_formula_record_layout(const struct formula_file_record* record, size_t record_size,
+	struct formula_record_layout* layout)
+{
+	//counts are checked before multiplication, so offsets can not overflow.
+	if (record->instructions_count > record_size || record->constants_count > record_size ||
+		record->variables_count > record_size || record->variable_table_capacity > record_size ||
+		record->text_length > record_size)
+	{
+		return 0;
+	}
+
+	layout->instructions_offset = sizeof(struct formula_file_record);
+	layout->positions_offset = layout->instructions_offset +
+		(size_t)record->instructions_count * sizeof(struct instruction);
+	layout->constants_offset = layout->positions_offset +
+		(size_t)record->instructions_count * sizeof(unsigned long long);
+	layout->variable_table_offset = layout->constants_offset + (size_t)record->constants_count * sizeof(double);
+	layout->name_offsets_offset = layout->variable_table_offset +
+		align_formula_file_size((size_t)record->variable_table_capacity * sizeof(int));
+	layout->text_offset = layout->name_offsets_offset +
+		(size_t)record->variables_count * sizeof(unsigned long long);
+	layout->names_offset = layout->text_offset + (size_t)record->text_length + 1;
+
+	return layout->names_offset <= record_size;
+}
+
+
+/**********************************************************************************************************
+NAME  : WRITE FORMULA RECORD
+LIBS  : stdlib.h, string.h
+NOTES : writes record of formula to buffer which is grown if it is needed. Table of variables of compiled
+        formula is sized by count of tokens, it is built again by count of variables, so record is smaller.
+        Return size of record.
+**********************************************************************************************************/
+size_t write_formula_record(const struct compiled_formula* formula, const char* formula_text,
+	unsigned char** buffer, size_t* buffer_capacity)
+{
+	//table is kept at most half full, as table of compiled formula.
+	size_t table_capacity = 2;
+	while (table_capacity < 2 * formula->variables_count + 1)
+	{
+		table_capacity *= 2;
+	}
+
+	struct formula_file_record record;
+	record.instructions_count = formula->instructions_count;
+	record.constants_count = formula->constants_count;
+	record.variables_count = formula->variables_count;
+	record.variable_table_capacity = table_capacity;
+	record.max_stack_depth = formula->max_stack_depth;
+	record.text_length = strlen(formula_text);
+
+	size_t names_size = 0;
+	for (size_t i = 0; i < formula->variables_count; i++)
+	{
+		names_size += strlen(formula->variable_names[i]) + 1;
+	}
+
+	struct formula_record_layout layout;
+	get_formula_record_layout(&record, (size_t)-1, &layout);
+	size_t record_size = align_formula_file_size(layout.names_offset + names_size);
+
+	if (*buffer_capacity < record_size)
+	{
+		free(*buffer);
+		*buffer_capacity = record_size * 2;
+		*buffer = malloc(*buffer_capacity);
+		if (*buffer == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+	}
+
+	//padding bytes are zeros, so equal formulas give equal records and checksums.
+	unsigned char* data = *buffer;
+	memset(data, 0, record_size);
+	memcpy(data, &record, sizeof(record));
+	memcpy(data + layout.instructions_offset, formula->instructions,
+		formula->instructions_count * sizeof(struct instruction));
+	for (size_t i = 0; i < formula->instructions_count; i++)
+	{
+		unsigned long long position = formula->instruction_positions[i];
+		memcpy(data + layout.positions_offset + i * sizeof(position), &position, sizeof(position));
+	}
+	memcpy(data + layout.constants_offset, formula->constants, formula->constants_count * sizeof(double));
+
+	int* variable_table = (int*)(data + layout.variable_table_offset);
+	for (size_t i = 0; i < formula->variables_count; i++)
+	{
+		const char* name = formula->variable_names[i];
+		size_t position = get_string_hash(name, strlen(name)) & (table_capacity - 1);
+		while (variable_table[position] != 0)
+		{
+			position = (position + 1) & (table_capacity - 1);
+		}
+		variable_table[position] = (int)i + 1;
+	}
+	memcpy(data + layout.text_offset, formula_text, (size_t)record.text_length);
+
+	size_t name_offset = layout.names_offset;
+	for (size_t i = 0; i < formula->variables_count; i++)
+	{
+		unsigned long long offset = name_offset;
+		memcpy(data + layout.name_offsets_offset + i * sizeof(offset), &offset, sizeof(offset));
+
+		size_t name_size = strlen(formula->variable_names[i]) + 1;
+		memcpy(data + name_offset, formula->variable_names[i], name_size);
+		name_offset += name_size;
+	}
+
+	return record_size;
+}
+
+
+/**********************************************************************************************************
+NAME  : WRITE FORMULA FILE
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : writes compiled formulas and their texts to file, formula is found in file by its index in array.
+        Return 0 if file can not be written.
+**********************************************************************************************************/
+int write_formula_file(const char* file_path, const struct compiled_formula* const* formulas,
+	const char* const* formula_texts, size_t formulas_count)
+{
+	const size_t BUFFER_ELEMENT = 1;
+
+	FILE* file = fopen(file_path, "wb");
+	if (file == NULL)
+	{
+		return 0;
+	}
+
+	struct formula_file_header header;
+	memset(&header, 0, sizeof(header));
+	fwrite(&header, sizeof(header), 1, file);
+
+	struct formula_file_entry* entries = calloc(formulas_count + BUFFER_ELEMENT, sizeof(struct formula_file_entry));
+	if (entries == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	unsigned char* buffer = NULL;
+	size_t buffer_capacity = 0;
+	size_t offset = sizeof(header);
+	for (size_t i = 0; i < formulas_count; i++)
+	{
+		size_t record_size = write_formula_record(formulas[i], formula_texts[i], &buffer, &buffer_capacity);
+		fwrite(buffer, record_size, 1, file);
+
+		entries[i].record_offset = offset;
+		entries[i].record_size = record_size;
+		entries[i].record_checksum = get_checksum(buffer, record_size);
+		offset += record_size;
+	}
+	free(buffer);
+
+	size_t directory_size = formulas_count * sizeof(struct formula_file_entry);
+	fwrite(entries, sizeof(struct formula_file_entry), formulas_count, file);
+
+	memcpy(header.magic, "MATHPARS", sizeof(header.magic));
+	header.version = FORMULA_FILE_VERSION;
+	header.byte_order_mark = FORMULA_FILE_BYTE_ORDER_MARK;
+	header.formulas_count = formulas_count;
+	header.directory_offset = offset;
+	header.directory_checksum = get_checksum(entries, directory_size);
+	free(entries);
+
+	fseek(file, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, file);
+
+	int is_written = (ferror(file) == 0);
+	is_written &= (fclose(file) == 0);
+
+	return is_written;
+}
+
+
+/**********************************************************************************************************
+NAME  : OPEN FORMULA FILE
+LIBS  : stdlib.h, string.h
+NOTES : maps file and checks its header and directory, formulas are checked when they are taken. Return
+        NULL if file can not be read or it is not formula file of this version and byte order. Returned
+        pointer must be passed to "close_formula_file()" after use.
+**********************************************************************************************************/
+struct formula_file* open_formula_file(const char* file_path)
+{
+	const size_t INITIAL_ARENA_CAPACITY = 1 << 16;
+	const size_t BUFFER_ELEMENT = 1;
+
+	struct mapped_file* mapped_file = map_file(file_path);
+	if (mapped_file == NULL)
+	{
+		return NULL;
+	}
+
+	struct formula_file_header header;
+	if (mapped_file->size < sizeof(header))
+	{
+		unmap_file(mapped_file);
+		return NULL;
+	}
+	memcpy(&header, mapped_file->data, sizeof(header));
+
+	size_t entry_size = sizeof(struct formula_file_entry);
+	if (memcmp(header.magic, "MATHPARS", sizeof(header.magic)) != 0 || header.version != FORMULA_FILE_VERSION ||
+		header.byte_order_mark != FORMULA_FILE_BYTE_ORDER_MARK || header.directory_offset > mapped_file->size ||
+		header.directory_offset % sizeof(unsigned long long) != 0 ||
+		header.formulas_count > (mapped_file->size - header.directory_offset) / entry_size ||
+		get_checksum(mapped_file->data + header.directory_offset, (size_t)header.formulas_count * entry_size) !=
+		header.directory_checksum)
+	{
+		unmap_file(mapped_file);
+		return NULL;
+	}
+
+	struct formula_file* file = calloc(1, sizeof(struct formula_file));
+	if (file == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	file->mapped_file = mapped_file;
+	file->entries = (const struct formula_file_entry*)(mapped_file->data + header.directory_offset);
+	file->formulas_count = (size_t)header.formulas_count;
+	file->formulas = calloc(file->formulas_count + BUFFER_ELEMENT, sizeof(struct compiled_formula*));
+	if (file->formulas == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	file->arena = arena_initialize(INITIAL_ARENA_CAPACITY);
+
+	return file;
+}
+
+
+/**********************************************************************************************************
+NAME  : CLOSE FORMULA FILE
+LIBS  : stdlib.h
+NOTES : formulas of file can not be used after it.
+**********************************************************************************************************/
+void close_formula_file(struct formula_file* file)
+{
+	arena_free(file->arena);
+	free(file->formulas);
+	free(file->expected_depths);
+	free(file->pending_targets);
+	unmap_file(file->mapped_file);
+	free(file);
+}
+
+
+/**********************************************************************************************************
+NAME  : IS FORMULA RECORD VALID
+LIBS  : stdlib.h, string.h
+NOTES : checks that operands are in bounds of their arrays, every instruction has enough values on the
+        stack, stack never grows over "max_stack_depth", the same depth is at target of skip whether skip
+        is taken or not, skips are nested (batch evaluation keeps them as stack) and formula leaves one
+        value. Checks table and names of variables.
+**********************************************************************************************************/
+int is_formula_record_valid(struct formula_file* file, const unsigned char* record, size_t record_size,
+	const struct formula_record_layout* layout)
+{
+	struct formula_file_record header;
+	memcpy(&header, record, sizeof(header));
+	size_t instructions_count = (size_t)header.instructions_count;
+
+	if (instructions_count == 0 || header.max_stack_depth > instructions_count ||
+		record[layout->text_offset + header.text_length] != '\0')
+	{
+		return 0;
+	}
+
+	//value of table is slot + 1 or 0 for empty place, table must have empty place.
+	size_t table_capacity = (size_t)header.variable_table_capacity;
+	if (table_capacity <= header.variables_count || (table_capacity & (table_capacity - 1)) != 0)
+	{
+		return 0;
+	}
+	size_t used_places_count = 0;
+	for (size_t i = 0; i < table_capacity; i++)
+	{
+		int value;
+		memcpy(&value, record + layout->variable_table_offset + i * sizeof(int), sizeof(int));
+		if (value < 0 || (unsigned long long)value > header.variables_count)
+		{
+			return 0;
+		}
+		used_places_count += (value != 0);
+	}
+	if (used_places_count != header.variables_count)
+	{
+		return 0;
+	}
+
+	for (size_t i = 0; i < header.variables_count; i++)
+	{
+		unsigned long long name_offset;
+		memcpy(&name_offset, record + layout->name_offsets_offset + i * sizeof(name_offset), sizeof(name_offset));
+		if (name_offset < layout->names_offset || name_offset >= record_size ||
+			memchr(record + name_offset, '\0', record_size - (size_t)name_offset) == NULL)
+		{
+			return 0;
+		}
+	}
+
+	if (file->scratch_capacity < instructions_count + 1)
+	{
+		free(file->expected_depths);
+		free(file->pending_targets);
+		file->scratch_capacity = (instructions_count + 1) * 2;
+		file->expected_depths = malloc(file->scratch_capacity * sizeof(size_t));
+		file->pending_targets = malloc(file->scratch_capacity * sizeof(size_t));
+		if (file->expected_depths == NULL || file->pending_targets == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+	}
+	//0 is "no skip jumps here", depth after skip is at least 1.
+	memset(file->expected_depths, 0, (instructions_count + 1) * sizeof(size_t));
+
+	size_t depth = 0;
+	size_t pending_targets_count = 0;
+	for (size_t i = 0; i <= instructions_count; i++)
+	{
+		if (file->expected_depths[i] != 0 && file->expected_depths[i] != depth)
+		{
+			return 0;
+		}
+		while (pending_targets_count != 0 && file->pending_targets[pending_targets_count - 1] == i)
+		{
+			pending_targets_count--;
+		}
+		if (i == instructions_count)
+		{
+			break;
+		}
+
+		struct instruction instruction;
+		memcpy(&instruction, record + layout->instructions_offset + i * sizeof(instruction), sizeof(instruction));
+
+		//count of values which instruction reads from the stack.
+		size_t required_depth = 0;
+		switch (instruction.opcode)
+		{
+			case PUSH_CONSTANT:
+			case PUSH_VARIABLE:
+			{
+				unsigned long long operands_count = (instruction.opcode == PUSH_CONSTANT) ? header.constants_count :
+					header.variables_count;
+				if (instruction.operand < 0 || (unsigned long long)instruction.operand >= operands_count)
+				{
+					return 0;
+				}
+				break;
+			}
+
+			case DUPLICATE:
+				required_depth = 1;
+				break;
+
+			case CALL_OPERATION:
+			case CALL_FUNCTION:
+			{
+				int callables_count = (instruction.opcode == CALL_OPERATION) ? MATH_OPERATIONS_COUNT :
+					MATH_FUNCTIONS_COUNT;
+				if (instruction.operand < 0 || instruction.operand >= callables_count)
+				{
+					return 0;
+				}
+				required_depth = get_instruction_arguments_count(&instruction);
+				break;
+			}
+
+			case SKIP_IF_TRUE:
+			case SKIP_IF_FALSE:
+			case SKIP_IF_BELOW_TRUE:
+			{
+				required_depth = (instruction.opcode == SKIP_IF_BELOW_TRUE) ? 2 : 1;
+				size_t target = (size_t)instruction.operand;
+				if (instruction.operand < 0 || target <= i || target > instructions_count ||
+					(pending_targets_count != 0 && target > file->pending_targets[pending_targets_count - 1]) ||
+					(file->expected_depths[target] != 0 && file->expected_depths[target] != depth + 1))
+				{
+					return 0;
+				}
+				file->expected_depths[target] = depth + 1;
+				file->pending_targets[pending_targets_count] = target;
+				pending_targets_count++;
+				break;
+			}
+
+			default:
+				return 0;
+		}
+
+		if (depth < required_depth)
+		{
+			return 0;
+		}
+
+		//pushes and duplicate add value, call replaces its arguments by result, skip does not change stack.
+		int is_push = (instruction.opcode == PUSH_CONSTANT || instruction.opcode == PUSH_VARIABLE ||
+			instruction.opcode == DUPLICATE);
+		int is_call = (instruction.opcode == CALL_OPERATION || instruction.opcode == CALL_FUNCTION);
+		depth += is_push;
+		depth -= is_call * (required_depth - 1);
+		if (depth > header.max_stack_depth)
+		{
+			return 0;
+		}
+	}
+
+	return depth == 1;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET FILE FORMULA
+LIBS  : -
+NOTES : return formula with index "formula_index", NULL if index is out of file or record is damaged.
+        Formula is checked and its view is made only once, at the first call.
+**********************************************************************************************************/
+const struct compiled_formula* get_file_formula(struct formula_file* file, size_t formula_index)
+{
+	if (formula_index >= file->formulas_count)
+	{
+		return NULL;
+	}
+	if (file->formulas[formula_index] != NULL)
+	{
+		return file->formulas[formula_index];
+	}
+
+	struct formula_file_entry entry;
+	memcpy(&entry, &file->entries[formula_index], sizeof(entry));
+	const unsigned char* data = (const unsigned char*)file->mapped_file->data;
+	size_t file_size = file->mapped_file->size;
+	if (entry.record_offset > file_size || entry.record_size > file_size - entry.record_offset ||
+		entry.record_size < sizeof(struct formula_file_record) || entry.record_offset % sizeof(double) != 0 ||
+		entry.record_size % sizeof(unsigned long long) != 0)
+	{
+		return NULL;
+	}
+
+	const unsigned char* record = data + entry.record_offset;
+	size_t record_size = (size_t)entry.record_size;
+	struct formula_file_record header;
+	struct formula_record_layout layout;
+	memcpy(&header, record, sizeof(header));
+	if (get_checksum(record, record_size) != entry.record_checksum ||
+		get_formula_record_layout(&header, record_size, &layout) == 0 ||
+		is_formula_record_valid(file, record, record_size, &layout) == 0)
+	{
+		return NULL;
+	}
+
+	struct compiled_formula* formula = arena_allocate(file->arena, 1, sizeof(struct compiled_formula));
+	formula->arena = file->arena;
+	formula->instructions = (struct instruction*)(record + layout.instructions_offset);
+	formula->instructions_count = (size_t)header.instructions_count;
+	formula->constants = (double*)(record + layout.constants_offset);
+	formula->constants_count = (size_t)header.constants_count;
+	formula->variable_table = (int*)(record + layout.variable_table_offset);
+	formula->variable_table_capacity = (size_t)header.variable_table_capacity;
+	formula->variables_count = (size_t)header.variables_count;
+	formula->max_stack_depth = (size_t)header.max_stack_depth;
+
+	//positions are 64-bit in file, they are converted only where "size_t" is narrower.
+	if (sizeof(size_t) == sizeof(unsigned long long))
+	{
+		formula->instruction_positions = (size_t*)(record + layout.positions_offset);
+	}
+	else
+	{
+		formula->instruction_positions = arena_allocate(file->arena, formula->instructions_count, sizeof(size_t));
+		for (size_t i = 0; i < formula->instructions_count; i++)
+		{
+			unsigned long long position;
+			memcpy(&position, record + layout.positions_offset + i * sizeof(position), sizeof(position));
+			formula->instruction_positions[i] = (size_t)position;
+		}
+	}
+
+	formula->variable_names = arena_allocate(file->arena, formula->variables_count + 1, sizeof(char*));
+	for (size_t i = 0; i < formula->variables_count; i++)
+	{
+		unsigned long long name_offset;
+		memcpy(&name_offset, record + layout.name_offsets_offset + i * sizeof(name_offset), sizeof(name_offset));
+		formula->variable_names[i] = (char*)(record + name_offset);
+	}
+
+	file->formulas[formula_index] = formula;
+
+	return formula;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET FILE FORMULA TEXT
+LIBS  : -
+NOTES : return text which formula was compiled from, NULL if formula can not be taken.
+**********************************************************************************************************/
+const char* get_file_formula_text(struct formula_file* file, size_t formula_index)
+{
+	if (get_file_formula(file, formula_index) == NULL)
+	{
+		return NULL;
+	}
+
+	const char* record = file->mapped_file->data + file->entries[formula_index].record_offset;
+	struct formula_file_record header;
+	struct formula_record_layout layout;
+	memcpy(&header, record, sizeof(header));
+	get_formula_record_layout(&header, (size_t)file->entries[formula_index].record_size, &layout);
+
+	return record + layout.text_offset;
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL COMPILE RULES MODE
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : compiles formulas of text file (one per line, empty lines are skipped) and writes them to formula
+        file. Return EXIT_SUCCESS or EXIT_FAILURE, the first wrong formula is written to standard error.
+**********************************************************************************************************/
+int call_compile_rules_mode(const char* text_file_path, const char* formula_file_path)
+{
+	struct mapped_file* text_file = map_file(text_file_path);
+	if (text_file == NULL)
+	{
+		fprintf(stderr, "Can not open file %s\n", text_file_path);
+		return EXIT_FAILURE;
+	}
+
+	const size_t BUFFER_ELEMENT = 1;
+
+	size_t formulas_capacity = 1024;
+	size_t formulas_count = 0;
+	struct compiled_formula** formulas = calloc(formulas_capacity + BUFFER_ELEMENT, sizeof(struct compiled_formula*));
+	char** formula_texts = calloc(formulas_capacity + BUFFER_ELEMENT, sizeof(char*));
+	if (formulas == NULL || formula_texts == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	struct parser_context* context = parser_context_initialize();
+	int exit_code = EXIT_SUCCESS;
+	size_t line_number = 0;
+	const char* data_end = text_file->data + text_file->size;
+	for (const char* line_start = text_file->data; line_start < data_end && exit_code == EXIT_SUCCESS;)
+	{
+		const char* line_end = memchr(line_start, '\n', (size_t)(data_end - line_start));
+		line_end = (line_end != NULL) ? line_end : data_end;
+		size_t line_length = (size_t)(line_end - line_start);
+		line_length -= (line_length != 0 && line_start[line_length - 1] == '\r');
+		line_number++;
+
+		if (line_length != 0)
+		{
+			char* formula_text = malloc(line_length + 1);
+			if (formula_text == NULL)
+			{
+				throw_error(OUT_OF_MEMORY);
+			}
+			memcpy(formula_text, line_start, line_length);
+			formula_text[line_length] = '\0';
+
+			struct compiled_formula* formula = compile_formula(context, formula_text);
+			if (formula == NULL)
+			{
+				fprintf(stderr, "Error: %s at position %zu of line %zu\n", get_error_message(context->error_code),
+					context->error_position, line_number);
+				free(formula_text);
+				exit_code = EXIT_FAILURE;
+			}
+			else
+			{
+				if (formulas_count == formulas_capacity)
+				{
+					formulas_capacity *= 2;
+					formulas = realloc(formulas, (formulas_capacity + BUFFER_ELEMENT) * sizeof(struct compiled_formula*));
+					formula_texts = realloc(formula_texts, (formulas_capacity + BUFFER_ELEMENT) * sizeof(char*));
+					if (formulas == NULL || formula_texts == NULL)
+					{
+						throw_error(OUT_OF_MEMORY);
+					}
+				}
+				formulas[formulas_count] = formula;
+				formula_texts[formulas_count] = formula_text;
+				formulas_count++;
+			}
+		}
+
+		line_start = line_end + 1;
+	}
+	parser_context_free(context);
+	unmap_file(text_file);
+
+	if (exit_code == EXIT_SUCCESS && write_formula_file(formula_file_path,
+		(const struct compiled_formula* const*)formulas, (const char* const*)formula_texts, formulas_count) == 0)
+	{
+		fprintf(stderr, "Can not write file %s\n", formula_file_path);
+		exit_code = EXIT_FAILURE;
+	}
+
+	for (size_t i = 0; i < formulas_count; i++)
+	{
+		compiled_formula_free(formulas[i]);
+		free(formula_texts[i]);
+	}
+	free(formulas);
+	free(formula_texts);
+
+	return exit_code;
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL RULES MODE
+LIBS  : stdio.h, stdlib.h
+NOTES : calculates every formula of formula file with values ("a = 1 , b = 2") and writes results one per
+        line in the same format as stream mode. Return EXIT_FAILURE if file can not be opened or it has
+        damaged formula.
+**********************************************************************************************************/
+int call_rules_mode(const char* formula_file_path, const char* values)
+{
+	const size_t OUTPUT_BUFFER_CAPACITY = 1 << 20;
+	const size_t BUFFER_ELEMENT = 1;
+
+	struct formula_file* file = open_formula_file(formula_file_path);
+	if (file == NULL)
+	{
+		fprintf(stderr, "Can not open formula file %s\n", formula_file_path);
+		return EXIT_FAILURE;
+	}
+
+	size_t max_stack_depth = 1;
+	size_t max_variables_count = 0;
+	for (size_t i = 0; i < file->formulas_count; i++)
+	{
+		const struct compiled_formula* formula = get_file_formula(file, i);
+		if (formula == NULL)
+		{
+			fprintf(stderr, "Formula %zu of file %s is damaged\n", i + 1, formula_file_path);
+			close_formula_file(file);
+			return EXIT_FAILURE;
+		}
+		max_stack_depth = (formula->max_stack_depth > max_stack_depth) ? formula->max_stack_depth : max_stack_depth;
+		max_variables_count = (formula->variables_count > max_variables_count) ? formula->variables_count :
+			max_variables_count;
+	}
+
+	struct output_buffer output_buffer;
+	output_buffer.data = calloc(OUTPUT_BUFFER_CAPACITY, sizeof(char));
+	double* bindings = calloc(max_variables_count + BUFFER_ELEMENT, sizeof(double));
+	char* bound_flags = calloc(max_variables_count + BUFFER_ELEMENT, sizeof(char));
+	if (output_buffer.data == NULL || bindings == NULL || bound_flags == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	output_buffer.buffer_capacity = OUTPUT_BUFFER_CAPACITY;
+	output_buffer.current_length = 0;
+	output_buffer.output_stream = stdout;
+
+	struct parser_context* context = parser_context_initialize();
+	struct stack_double* stack = stack_double_initialize(max_stack_depth);
+	int values_error_code = tokenize_expression(context, values);
+	size_t values_error_position = context->error_position;
+
+	for (size_t i = 0; i < file->formulas_count; i++)
+	{
+		const struct compiled_formula* formula = get_file_formula(file, i);
+
+		size_t error_position = values_error_position;
+		int error_code = values_error_code;
+		if (error_code == NO_ERROR)
+		{
+			error_code = bind_where_values(context, 0, values, 0, formula, bindings, bound_flags, &error_position);
+		}
+		if (error_code != NO_ERROR)
+		{
+			output_buffer_write_error(&output_buffer, error_code, error_position);
+			continue;
+		}
+
+		struct evaluation_result result = evaluate_compiled_formula(formula, bindings, stack);
+		if (result.error_code != NO_ERROR)
+		{
+			output_buffer_write_error(&output_buffer, result.error_code, result.error_position);
+		}
+		else
+		{
+			output_buffer_write_result(&output_buffer, result.value);
+		}
+	}
+	output_buffer_flush(&output_buffer);
+	fflush(stdout);
+
+	stack_double_free(stack);
+	parser_context_free(context);
+	free(output_buffer.data);
+	free(bindings);
+	free(bound_flags);
+	close_formula_file(file);
+
+	return EXIT_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////FORMULA FILE SECTION END////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////UI SECTION//////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**********************************************************************************************************
+NAME  : PRINT ASSIGNMENT SPECIFICATION
+LIBS  : stdio.h
+NOTES : -
+**********************************************************************************************************/
+void print_assignment_specification()
+{
+	fputs("----------------------------------------\n", stdout);
+	fputs("Laboratory assignment #2\n", stdout);
+	fputs("Arsenii Fatykov\n", stdout);
+	fputs("FF-105\n", stdout);
+	fputs("17.3.2017\n", stdout);
+	fputs("----------------------------------------\n", stdout);
+}
+
+
+/**********************************************************************************************************
+NAME  : PRINT PROGRAM SPECIFICATION
+LIBS  : stdio.h
+NOTES : -
+**********************************************************************************************************/
+void print_program_specification()
+{
+	fputs("----------------------------------------\n", stdout);
+	fputs("Programming practicum v0\n", stdout);
+	fputs("Arsenii Fatykov\n", stdout);
+	fputs("3.3.2017\n", stdout);
+	fputs("----------------------------------------\n", stdout);
+}
+
+
+/**********************************************************************************************************
+NAME  : PRINT MATH PARSER SPECIFICATION
+LIBS  : stdio.h
+NOTES : -
+**********************************************************************************************************/
+void print_math_parser_specification()
+{
+	fputs("----------------------------------------\n", stdout);
+	fputs("Mathematical parser v0\n", stdout);
+	fputs("----------------------------------------\n", stdout);
+}
+
+
+/**********************************************************************************************************
+NAME  : PRINT MAIN MENU ITEMS
+LIBS  : stdio.h
+NOTES : -
+**********************************************************************************************************/
+void print_main_menu_items()
+{
+	fputs("----------------------------------------\n", stdout);
+	fputs("Main menu:\n", stdout);
+	fputs("1 - Mathematical parser\n", stdout);
+	fputs("0 - Exit\n\n", stdout);
+	fputs("----------------------------------------\n", stdout);
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL INPUT
+LIBS  : stdio.h, string.h
+NOTES : line has no limit of length. Returned pointer on string must be passed to "free()" after use.
+**********************************************************************************************************/
+char* call_input()
+{
+	const size_t INITIAL_CAPACITY = 256;
+
+	size_t input_capacity = INITIAL_CAPACITY;
+	size_t input_length = 0;
+	char* input_string = calloc(input_capacity, sizeof(char));
+	if (input_string == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	//line is read by parts after already read characters, buffer grows twice when it is full.
+	while (fgets(input_string + input_length, (int)(input_capacity - input_length), stdin) != NULL)
+	{
+		input_length += strlen(input_string + input_length);
+		if (input_length != 0 && input_string[input_length - 1] == '\n')
+		{
+			break;
+		}
+
+		if (input_length + 1 == input_capacity)
+		{
+			input_capacity *= 2;
+			input_string = realloc(input_string, input_capacity);
+			if (input_string == NULL)
+			{
+				throw_error(OUT_OF_MEMORY);
+			}
+		}
+	}
+	input_string[strcspn(input_string, "\n")] = 0;
+
+	return input_string;
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL MATH PARSER
+LIBS  : stdio.h
+NOTES : -
+**********************************************************************************************************/
+void call_math_parser()
+{
+	print_math_parser_specification();
+
+	fputs("Enter expression: ", stdout);
+	char* expression = call_input();
+
+	struct parser_context* context = parser_context_initialize();
+
+	struct evaluation_result result = calculate_expression(context, expression);
+	if (result.error_code == NO_ERROR)
+	{
+		printf("Result: %f\n", result.value);
+	}
+	else
+	{
+		printf("Error: %s at position %zu of \"%s\"\n", get_error_message(result.error_code),
+			result.error_position, expression);
+	}
+
+	free(expression);
+	parser_context_free(context);
+	getchar();
+}
+
+/**********************************************************************************************************
+NAME  : CALL MAIN MENU
+LIBS  : stdio.h, stdlib.h
+NOTES : -
+**********************************************************************************************************/
+void call_main_menu()
+{
+	print_program_specification();
+	print_assignment_specification();
+	
+	for (;;)
+	{
+		print_main_menu_items();
+
+		fputs("Choose item: ", stdout);
+		char* input_item = call_input();
+		fputs("\n", stdout);
+		int input_item_as_int = atoi(input_item);
+
+		switch (input_item_as_int)
+		{
+			case 1:
+				call_math_parser();
+				break;
+
+			case 0:
+				exit(EXIT_SUCCESS);
+
+			default:
+				exit(EXIT_FAILURE);
+		}
+
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////UI SECTION END//////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////BENCHMARK SECTION///////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**********************************************************************************************************
+NAME  : GET TIME SECONDS
+LIBS  : time.h
+NOTES : return monotonic enough wall clock time in seconds.
+**********************************************************************************************************/
+double get_time_seconds()
+{
+	struct timespec time_spec;
+	timespec_get(&time_spec, TIME_UTC);
+
+	return (double)time_spec.tv_sec + (double)time_spec.tv_nsec / 1e9;
+}
+
+
+/**********************************************************************************************************
+NAME  : LINEAR OPERATION LOOKUP
+LIBS  : stdlib.h, string.h
+NOTES : reference lookup which reproduces old registry behaviour: operation entries array is allocated and
+        filled for every lookup and then scanned by "strcmp()". It is used only for benchmark.
+**********************************************************************************************************/
+int linear_operation_lookup(const char* operation_alias)
+{
+	struct operation_entry* operation_entries = calloc(MATH_OPERATIONS_COUNT, sizeof(struct operation_entry));
+	if (operation_entries == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	memcpy(operation_entries, MATH_OPERATIONS, sizeof(MATH_OPERATIONS));
+
+	int operation_index = -1;
+	for (size_t i = 0; i < MATH_OPERATIONS_COUNT; i++)
+	{
+		if (strcmp(operation_alias, operation_entries[i].operation_alias) == 0)
+		{
+			operation_index = (int)i;
+			break;
+		}
+	}
+
+	free(operation_entries);
+
+	return operation_index;
+}
+
+
+/**********************************************************************************************************
+NAME  : LINEAR FUNCTION LOOKUP
+LIBS  : stdlib.h, string.h
+NOTES : reference lookup which reproduces old registry behaviour: function entries array is allocated and
+        filled for every lookup and then scanned by "strcmp()". It is used only for benchmark.
+**********************************************************************************************************/
+int linear_function_lookup(const char* function_alias)
+{
+	struct function_entry* function_entries = calloc(MATH_FUNCTIONS_COUNT, sizeof(struct function_entry));
+	if (function_entries == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	memcpy(function_entries, MATH_FUNCTIONS, sizeof(MATH_FUNCTIONS));
+
+	int function_index = -1;
+	for (size_t i = 0; i < MATH_FUNCTIONS_COUNT; i++)
+	{
+		if (strcmp(function_alias, function_entries[i].function_alias) == 0)
+		{
+			function_index = (int)i;
+			break;
+		}
+	}
+
+	free(function_entries);
+
+	return function_index;
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK REGISTRY LOOKUP
+LIBS  : stdio.h
+NOTES : classifies tokens of the arccos example like parser does (operation check, then function check)
+        and prints lookups per second for old and new registry.
+**********************************************************************************************************/
+void benchmark_registry_lookup()
+{
+	char* tokens[] =
+	{
+		"(", "(", "arccos", "(", "(", "pow", "(", "a", ",", "2", ")", "+", "pow", "(", "b", ",", "2", ")",
+		"-", "pow", "(", "c", ",", "2", ")", ")", "/", "(", "2", "*", "a", "*", "b", ")", ")", ")", "*",
+		"180", "/", "3.141592", ")", "<", "90", "OR", "MOD"
+	};
+	const size_t TOKENS_COUNT = sizeof(tokens) / sizeof(tokens[0]);
+	const size_t ROUNDS_COUNT = 200000;
+
+	//lexer knows length of every token, so it is not measured.
+	size_t tokens_lengths[sizeof(tokens) / sizeof(tokens[0])];
+	for (size_t i = 0; i < TOKENS_COUNT; i++)
+	{
+		tokens_lengths[i] = strlen(tokens[i]);
+	}
+	const size_t LOOKUPS_PER_TOKEN = 2;
+
+	volatile int checksum = 0;
+
+	double start_time = get_time_seconds();
+	for (size_t round = 0; round < ROUNDS_COUNT; round++)
+	{
+		for (size_t i = 0; i < TOKENS_COUNT; i++)
+		{
+			checksum += linear_operation_lookup(tokens[i]);
+			checksum += linear_function_lookup(tokens[i]);
+		}
+	}
+	double linear_seconds = get_time_seconds() - start_time;
+
+	start_time = get_time_seconds();
+	for (size_t round = 0; round < ROUNDS_COUNT; round++)
+	{
+		for (size_t i = 0; i < TOKENS_COUNT; i++)
+		{
+			checksum += get_operation_index(tokens[i], tokens_lengths[i]);
+			checksum += get_function_index(tokens[i], tokens_lengths[i]);
+		}
+	}
+	double switch_seconds = get_time_seconds() - start_time;
+
+	double lookups_count = (double)(ROUNDS_COUNT * TOKENS_COUNT * LOOKUPS_PER_TOKEN);
+	printf("registry lookup (rebuilt array + strcmp scan): %.0f lookups/s\n", lookups_count / linear_seconds);
+	printf("registry lookup (static table + switch)      : %.0f lookups/s\n", lookups_count / switch_seconds);
+	printf("speedup: %.1fx\n", linear_seconds / switch_seconds);
+}
+
+
+/**********************************************************************************************************
+NAME  : FILL RANDOM COLUMN
+LIBS  : stdlib.h
+NOTES : fills column with pseudo-random values from [minimum, maximum].
+**********************************************************************************************************/
+void fill_random_column(double* column, size_t rows_count, double minimum, double maximum)
+{
+	for (size_t i = 0; i < rows_count; i++)
+	{
+		column[i] = minimum + (maximum - minimum) * ((double)rand() / RAND_MAX);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK BATCH FORMULA
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : evaluates formula over random triangles row by row and by batch evaluation, checks that results and
+        errors of rows are identical and prints rows per second.
+**********************************************************************************************************/
+void benchmark_batch_formula(const char* formula_text)
+{
+	const size_t ROWS_COUNT = 1000000;
+
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formula = compile_formula(context, formula_text);
+	parser_context_free(context);
+
+	double** columns = calloc(formula->variables_count, sizeof(double*));
+	double* row_results = calloc(ROWS_COUNT, sizeof(double));
+	double* batch_results = calloc(ROWS_COUNT, sizeof(double));
+	int* row_errors = calloc(ROWS_COUNT, sizeof(int));
+	int* batch_errors = calloc(ROWS_COUNT, sizeof(int));
+	double* bindings = calloc(formula->variables_count, sizeof(double));
+	if (columns == NULL || row_results == NULL || batch_results == NULL || row_errors == NULL ||
+		batch_errors == NULL || bindings == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	for (size_t slot = 0; slot < formula->variables_count; slot++)
+	{
+		columns[slot] = calloc(ROWS_COUNT, sizeof(double));
+		if (columns[slot] == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+		fill_random_column(columns[slot], ROWS_COUNT, 1, 2);
+	}
+
+	struct stack_double* stack = stack_double_initialize(formula->max_stack_depth);
+	double start_time = get_time_seconds();
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		for (size_t slot = 0; slot < formula->variables_count; slot++)
+		{
+			bindings[slot] = columns[slot][row];
+		}
+		struct evaluation_result result = evaluate_compiled_formula(formula, bindings, stack);
+		row_results[row] = result.value;
+		row_errors[row] = result.error_code;
+	}
+	double row_seconds = get_time_seconds() - start_time;
+	stack_double_free(stack);
+
+	struct batch_stack* batch_stack = batch_stack_initialize(formula->max_stack_depth);
+	start_time = get_time_seconds();
+	evaluate_compiled_formula_batch(formula, (const double* const*)columns, ROWS_COUNT, batch_results,
+		batch_errors, batch_stack);
+	double batch_seconds = get_time_seconds() - start_time;
+	batch_stack_free(batch_stack);
+
+	size_t mismatches_count = 0;
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		if (row_errors[row] != batch_errors[row] ||
+			(row_errors[row] == NO_ERROR && memcmp(&row_results[row], &batch_results[row], sizeof(double)) != 0))
+		{
+			mismatches_count++;
+		}
+	}
+
+	printf("%s\n", formula_text);
+	printf("row by row evaluation: %.0f rows/s\n", ROWS_COUNT / row_seconds);
+	printf("batch evaluation     : %.0f rows/s\n", ROWS_COUNT / batch_seconds);
+	printf("speedup: %.1fx, mismatched rows: %zu\n", row_seconds / batch_seconds, mismatches_count);
+
+	for (size_t slot = 0; slot < formula->variables_count; slot++)
+	{
+		free(columns[slot]);
+	}
+	free(columns);
+	free(row_results);
+	free(batch_results);
+	free(row_errors);
+	free(batch_errors);
+	free(bindings);
+	compiled_formula_free(formula);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK BATCH EVALUATION
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void benchmark_batch_evaluation()
+{
+	benchmark_batch_formula("a + b > c");
+	benchmark_batch_formula(
+		"( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90");
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK PARALLEL SCALING
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : evaluates six triangle predicates from examples over the same rows with 1, 2, 4 ... threads up to
+        count of processors, checks that results do not depend on threads count and prints efficiency.
+**********************************************************************************************************/
+void benchmark_parallel_scaling()
+{
+	const char* FORMULAS_TEXTS[] =
+	{
+		"a + b > c",
+		"a + c > b",
+		"b + c > a",
+		"( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90",
+		"( ( arccos ( ( pow ( b , 2 ) + pow ( c , 2 ) - pow ( a , 2 ) ) / ( 2 * b * c ) ) ) * 180 / 3.141592 ) < 90",
+		"( ( arccos ( ( pow ( c , 2 ) + pow ( a , 2 ) - pow ( b , 2 ) ) / ( 2 * c * a ) ) ) * 180 / 3.141592 ) < 90"
+	};
+	const size_t FORMULAS_COUNT = sizeof(FORMULAS_TEXTS) / sizeof(FORMULAS_TEXTS[0]);
+	const size_t ROWS_COUNT = 2000000;
+	const char* VARIABLE_NAMES[] = { "a", "b", "c" };
+	const size_t VARIABLES_COUNT = 3;
+
+	double* variable_columns[3];
+	srand(1);
+	for (size_t i = 0; i < VARIABLES_COUNT; i++)
+	{
+		variable_columns[i] = calloc(ROWS_COUNT, sizeof(double));
+		if (variable_columns[i] == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+		fill_random_column(variable_columns[i], ROWS_COUNT, 1, 2);
+	}
+
+	struct compiled_formula** formulas = calloc(FORMULAS_COUNT, sizeof(struct compiled_formula*));
+	const double*** columns = calloc(FORMULAS_COUNT, sizeof(double**));
+	double** results = calloc(FORMULAS_COUNT, sizeof(double*));
+	double** reference_results = calloc(FORMULAS_COUNT, sizeof(double*));
+	if (formulas == NULL || columns == NULL || results == NULL || reference_results == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	struct parser_context* context = parser_context_initialize();
+	for (size_t i = 0; i < FORMULAS_COUNT; i++)
+	{
+		formulas[i] = compile_formula(context, FORMULAS_TEXTS[i]);
+		columns[i] = calloc(VARIABLES_COUNT, sizeof(double*));
+		results[i] = calloc(ROWS_COUNT, sizeof(double));
+		reference_results[i] = calloc(ROWS_COUNT, sizeof(double));
+		if (columns[i] == NULL || results[i] == NULL || reference_results[i] == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+
+		for (size_t j = 0; j < VARIABLES_COUNT; j++)
+		{
+			int slot = get_variable_slot(formulas[i], VARIABLE_NAMES[j]);
+			if (slot != -1)
+			{
+				columns[i][slot] = variable_columns[j];
+			}
+		}
+	}
+
+	parser_context_free(context);
+
+	size_t processors_count = get_processors_count();
+	double single_thread_seconds = 0;
+
+	for (size_t threads_count = 1; ; threads_count *= 2)
+	{
+		if (threads_count > processors_count)
+		{
+			threads_count = processors_count;
+		}
+
+		double start_time = get_time_seconds();
+		evaluate_formulas_parallel((const struct compiled_formula* const*)formulas, FORMULAS_COUNT,
+			(const double* const* const*)columns, ROWS_COUNT, (threads_count == 1) ? reference_results : results,
+			NULL, threads_count);
+		double seconds = get_time_seconds() - start_time;
+
+		size_t mismatches_count = 0;
+		if (threads_count == 1)
+		{
+			single_thread_seconds = seconds;
+		}
+		else
+		{
+			for (size_t i = 0; i < FORMULAS_COUNT; i++)
+			{
+				if (memcmp(results[i], reference_results[i], ROWS_COUNT * sizeof(double)) != 0)
+				{
+					mismatches_count++;
+				}
+			}
+		}
+
+		double speedup = single_thread_seconds / seconds;
+		printf("parallel evaluation, %2zu threads: %.0f rows/s, speedup %.2fx, efficiency %.0f%%, "
+			"mismatched formulas: %zu\n", threads_count, FORMULAS_COUNT * ROWS_COUNT / seconds, speedup,
+			100 * speedup / threads_count, mismatches_count);
+
+		if (threads_count == processors_count)
+		{
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < FORMULAS_COUNT; i++)
+	{
+		compiled_formula_free(formulas[i]);
+		free(columns[i]);
+		free(results[i]);
+		free(reference_results[i]);
+	}
+	free(formulas);
+	free(columns);
+	free(results);
+	free(reference_results);
+
+	for (size_t i = 0; i < VARIABLES_COUNT; i++)
+	{
+		free(variable_columns[i]);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : COMPILE FORMULA WITHOUT OPTIMIZATION
+LIBS  : -
+NOTES : reference for benchmark of optimizer.
+**********************************************************************************************************/
+struct compiled_formula* compile_formula_without_optimization(struct parser_context* context,
+	const char* formula_text)
+{
+	if (tokenize_expression(context, formula_text) != NO_ERROR)
+	{
+		return NULL;
+	}
+
+	return compile_tokens(context, formula_text, context->tokens_count, NULL);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK OPTIMIZER FORMULA
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : evaluates formula over random triangles before and after optimization, prints count of removed
+        instructions, rows per second, count of rows whose results differ in the last bits (square and cube
+        instead of "pow()") and count of mismatched rows. Terms of formulas are at most TERMS_MAGNITUDE
+        (operands are from 1 to 2) and can cancel each other, so difference is measured in ulp of the
+        greatest of terms and results: row is mismatched if difference is more than MAX_ULP_DIFFERENCE of
+        them or only one result is NAN.
+**********************************************************************************************************/
+void benchmark_optimizer_formula(const char* formula_text)
+{
+	const size_t ROWS_COUNT = 1000000;
+	const size_t MAX_VARIABLES_COUNT = 3;
+	const double MAX_ULP_DIFFERENCE = 4;
+	const double TERMS_MAGNITUDE = 8;
+
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formulas[2];
+	formulas[0] = compile_formula_without_optimization(context, formula_text);
+	formulas[1] = compile_formula_without_optimization(context, formula_text);
+	parser_context_free(context);
+
+	size_t instructions_count = formulas[1]->instructions_count;
+	int removed_instructions_count = optimize_compiled_formula(formulas[1]);
+
+	double* results[2];
+	double seconds[2];
+	double bindings[3];
+	for (size_t version = 0; version < 2; version++)
+	{
+		struct compiled_formula* formula = formulas[version];
+		struct stack_double* stack = stack_double_initialize(formula->max_stack_depth);
+		results[version] = calloc(ROWS_COUNT, sizeof(double));
+		if (results[version] == NULL || formula->variables_count > MAX_VARIABLES_COUNT)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+
+		//both versions get the same rows.
+		srand(1);
+		double start_time = get_time_seconds();
+		for (size_t row = 0; row < ROWS_COUNT; row++)
+		{
+			for (size_t slot = 0; slot < formula->variables_count; slot++)
+			{
+				bindings[slot] = 1 + (double)rand() / RAND_MAX;
+			}
+			results[version][row] = evaluate_compiled_formula(formula, bindings, stack).value;
+		}
+		seconds[version] = get_time_seconds() - start_time;
+
+		stack_double_free(stack);
+	}
+
+	size_t last_bits_count = 0;
+	size_t mismatches_count = 0;
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		double magnitude = fmax(TERMS_MAGNITUDE, fmax(fabs(results[0][row]), fabs(results[1][row])));
+		double difference = fabs(results[1][row] - results[0][row]);
+		int is_mismatched = (isnan(results[0][row]) != isnan(results[1][row])) ||
+			difference > MAX_ULP_DIFFERENCE * (nextafter(magnitude, INFINITY) - magnitude);
+		last_bits_count += (is_mismatched == 0 && difference != 0);
+		mismatches_count += is_mismatched;
+	}
+
+	printf("%s\n", formula_text);
+	printf("instructions: %zu -> %zu (removed %d)\n", instructions_count, formulas[1]->instructions_count,
+		removed_instructions_count);
+	printf("not optimized: %.0f rows/s, optimized: %.0f rows/s, speedup: %.2fx, rows different in the last bits: "
+		"%zu, mismatched rows: %zu%s\n", ROWS_COUNT / seconds[0], ROWS_COUNT / seconds[1], seconds[0] / seconds[1],
+		last_bits_count, mismatches_count, (mismatches_count == 0) ? "" : " FAILED");
+
+	for (size_t version = 0; version < 2; version++)
+	{
+		free(results[version]);
+		compiled_formula_free(formulas[version]);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK OPTIMIZER
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void benchmark_optimizer()
+{
+	benchmark_optimizer_formula(
+		"( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90");
+	benchmark_optimizer_formula("neg ( neg ( a ) ) * ( 2 * 3 - 1 ) / 4 + pow ( b , 0.5 ) - pow ( c , 2 )");
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK FORMULA GROUP TEXTS
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : evaluates formulas over random values from 1 to 2 one by one and as formula group, checks that
+        results and errors are identical and prints rows per second.
+**********************************************************************************************************/
+void benchmark_formula_group_texts(const char* group_name, const char* const* formulas_texts,
+	size_t formulas_count)
+{
+	const size_t ROWS_COUNT = 1000000;
+
+	struct parser_context* context = parser_context_initialize();
+	size_t error_formula_index;
+	struct formula_group* group = compile_formula_group(context, formulas_texts, formulas_count,
+		&error_formula_index);
+	parser_context_free(context);
+
+	double* bindings = calloc(ROWS_COUNT * group->variables_count, sizeof(double));
+	struct evaluation_result* single_results = calloc(ROWS_COUNT * formulas_count,
+		sizeof(struct evaluation_result));
+	struct evaluation_result* group_results = calloc(ROWS_COUNT * formulas_count,
+		sizeof(struct evaluation_result));
+	double** formula_bindings = calloc(formulas_count, sizeof(double*));
+	int** group_slots = calloc(formulas_count, sizeof(int*));
+	struct stack_double** stacks = calloc(formulas_count, sizeof(struct stack_double*));
+	if (bindings == NULL || single_results == NULL || group_results == NULL || formula_bindings == NULL ||
+		group_slots == NULL || stacks == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	fill_random_column(bindings, ROWS_COUNT * group->variables_count, 1, 2);
+
+	size_t instructions_count = 0;
+	for (size_t i = 0; i < formulas_count; i++)
+	{
+		instructions_count += group->formulas[i]->instructions_count;
+		formula_bindings[i] = calloc(group->formulas[i]->variables_count + 1, sizeof(double));
+		group_slots[i] = calloc(group->formulas[i]->variables_count + 1, sizeof(int));
+		if (formula_bindings[i] == NULL || group_slots[i] == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+		for (size_t slot = 0; slot < group->formulas[i]->variables_count; slot++)
+		{
+			group_slots[i][slot] = get_group_variable_slot(group, group->formulas[i]->variable_names[slot]);
+		}
+		stacks[i] = stack_double_initialize(group->formulas[i]->max_stack_depth);
+	}
+
+	double start_time = get_time_seconds();
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		const double* row_bindings = &bindings[row * group->variables_count];
+		for (size_t i = 0; i < formulas_count; i++)
+		{
+			const struct compiled_formula* formula = group->formulas[i];
+			for (size_t slot = 0; slot < formula->variables_count; slot++)
+			{
+				formula_bindings[i][slot] = row_bindings[group_slots[i][slot]];
+			}
+			single_results[row * formulas_count + i] = evaluate_compiled_formula(formula, formula_bindings[i],
+				stacks[i]);
+		}
+	}
+	double single_seconds = get_time_seconds() - start_time;
+
+	start_time = get_time_seconds();
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		evaluate_formula_group(group, &bindings[row * group->variables_count],
+			&group_results[row * formulas_count]);
+	}
+	double group_seconds = get_time_seconds() - start_time;
+
+	size_t mismatches_count = 0;
+	for (size_t i = 0; i < ROWS_COUNT * formulas_count; i++)
+	{
+		if (single_results[i].error_code != group_results[i].error_code ||
+			single_results[i].error_position != group_results[i].error_position ||
+			memcmp(&single_results[i].value, &group_results[i].value, sizeof(double)) != 0)
+		{
+			mismatches_count++;
+		}
+	}
+
+	printf("group of %zu %s\n", formulas_count, group_name);
+	printf("instructions: %zu, nodes of group: %zu\n", instructions_count, group->nodes_count);
+	printf("one by one: %.0f rows/s, group: %.0f rows/s, speedup: %.2fx, mismatched results: %zu\n",
+		ROWS_COUNT / single_seconds, ROWS_COUNT / group_seconds, single_seconds / group_seconds,
+		mismatches_count);
+
+	for (size_t i = 0; i < formulas_count; i++)
+	{
+		free(formula_bindings[i]);
+		free(group_slots[i]);
+		stack_double_free(stacks[i]);
+	}
+	free(formula_bindings);
+	free(group_slots);
+	free(stacks);
+	free(bindings);
+	free(single_results);
+	free(group_results);
+	formula_group_free(group);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK FORMULA GROUP
+LIBS  : -
+NOTES : angle predicates share only squares and products, which are cheaper than work of group per node, so
+        group is slower than evaluation one by one. Distance rules share square root of sum of squares, and
+        the rest of every rule is one comparison or one function, so group calculates much less.
+**********************************************************************************************************/
+void benchmark_formula_group()
+{
+	const char* ANGLE_PREDICATES[] =
+	{
+		"( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90",
+		"( ( arccos ( ( pow ( b , 2 ) + pow ( c , 2 ) - pow ( a , 2 ) ) / ( 2 * b * c ) ) ) * 180 / 3.141592 ) < 90",
+		"( ( arccos ( ( pow ( c , 2 ) + pow ( a , 2 ) - pow ( b , 2 ) ) / ( 2 * c * a ) ) ) * 180 / 3.141592 ) < 90"
+	};
+	const char* DISTANCE_RULES[] =
+	{
+		"sqrt ( pow ( x - 1.5 , 2 ) + pow ( y - 1.5 , 2 ) ) < 0.1",
+		"sqrt ( pow ( x - 1.5 , 2 ) + pow ( y - 1.5 , 2 ) ) < 0.2",
+		"sqrt ( pow ( x - 1.5 , 2 ) + pow ( y - 1.5 , 2 ) ) < 0.3",
+		"sqrt ( pow ( x - 1.5 , 2 ) + pow ( y - 1.5 , 2 ) ) < 0.4",
+		"ln ( sqrt ( pow ( x - 1.5 , 2 ) + pow ( y - 1.5 , 2 ) ) + 1 ) > 0.25",
+		"arccos ( ( x - 1.5 ) / ( sqrt ( pow ( x - 1.5 , 2 ) + pow ( y - 1.5 , 2 ) ) + 0.001 ) ) > 1"
+	};
+
+	benchmark_formula_group_texts("angle predicates", ANGLE_PREDICATES,
+		sizeof(ANGLE_PREDICATES) / sizeof(ANGLE_PREDICATES[0]));
+	benchmark_formula_group_texts("distance rules", DISTANCE_RULES,
+		sizeof(DISTANCE_RULES) / sizeof(DISTANCE_RULES[0]));
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK JIT FORMULA
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : evaluates formula over random triangles by stack machine and by machine code of JIT, checks that
+        results and errors are identical and prints rows per second.
+**********************************************************************************************************/
+void benchmark_jit_formula(const char* formula_text)
+{
+	const size_t ROWS_COUNT = 1000000;
+
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formula = compile_formula(context, formula_text);
+	parser_context_free(context);
+
+	printf("%s\n", formula_text);
+
+	struct jit_formula* jit = jit_compile_formula(formula, formula_text);
+	if (jit == NULL)
+	{
+		printf("JIT is not available\n");
+		compiled_formula_free(formula);
+		return;
+	}
+
+	double* bindings = calloc(ROWS_COUNT * formula->variables_count, sizeof(double));
+	struct evaluation_result* stack_results = calloc(ROWS_COUNT, sizeof(struct evaluation_result));
+	struct evaluation_result* jit_results = calloc(ROWS_COUNT, sizeof(struct evaluation_result));
+	if (bindings == NULL || stack_results == NULL || jit_results == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	fill_random_column(bindings, ROWS_COUNT * formula->variables_count, 1, 2);
+
+	struct stack_double* stack = stack_double_initialize(formula->max_stack_depth);
+	double start_time = get_time_seconds();
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		stack_results[row] = evaluate_compiled_formula(formula, &bindings[row * formula->variables_count], stack);
+	}
+	double stack_seconds = get_time_seconds() - start_time;
+	stack_double_free(stack);
+
+	start_time = get_time_seconds();
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		jit_results[row] = evaluate_jit_formula(jit, &bindings[row * formula->variables_count]);
+	}
+	double jit_seconds = get_time_seconds() - start_time;
+
+	size_t mismatches_count = 0;
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		if (stack_results[row].error_code != jit_results[row].error_code ||
+			stack_results[row].error_position != jit_results[row].error_position ||
+			memcmp(&stack_results[row].value, &jit_results[row].value, sizeof(double)) != 0)
+		{
+			mismatches_count++;
+		}
+	}
+
+	printf("stack machine: %.0f rows/s, JIT: %.0f rows/s, speedup: %.2fx, mismatched rows: %zu\n",
+		ROWS_COUNT / stack_seconds, ROWS_COUNT / jit_seconds, stack_seconds / jit_seconds, mismatches_count);
+
+	free(bindings);
+	free(stack_results);
+	free(jit_results);
+	jit_formula_free(jit);
+	compiled_formula_free(formula);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK JIT
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void benchmark_jit()
+{
+	benchmark_jit_formula("a + b > c");
+	benchmark_jit_formula(
+		"( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90");
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK ARENA
+LIBS  : stdio.h
+NOTES : calculates examples (and wrong expressions) many times by one parser context and checks that after
+        warm-up no expression takes memory from system: arena has no new blocks, buffers of tokens and
+        evaluation stack do not grow.
+**********************************************************************************************************/
+void benchmark_arena()
+{
+	const size_t REPEATS_COUNT = 200000;
+	const size_t EXPRESSIONS_COUNT = 8;
+	const char* expressions[] =
+	{
+		"a + b > c | a = 2 , b = 2 , c = 2",
+		"a + c > b | a = 2 , b = 2 , c = 2",
+		"b + c > a | a = 2 , b = 2 , c = 2",
+		"( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90 | a = 2 , b = 2 , c = 2",
+		"( ( arccos ( ( pow ( b , 2 ) + pow ( c , 2 ) - pow ( a , 2 ) ) / ( 2 * b * c ) ) ) * 180 / 3.141592 ) < 90 | a = 2 , b = 2 , c = 2",
+		"( ( arccos ( ( pow ( c , 2 ) + pow ( a , 2 ) - pow ( b , 2 ) ) / ( 2 * c * a ) ) ) * 180 / 3.141592 ) < 90 | a = 2 , b = 2 , c = 2",
+		"a / ( b - 2 ) | a = 1 , b = 2",
+		"a + ( b | a = 1 , b = 2"
+	};
+
+	struct parser_context* context = parser_context_initialize();
+
+	//warm-up gives arena, tokens and stack their steady-state sizes.
+	for (size_t i = 0; i < EXPRESSIONS_COUNT; i++)
+	{
+		calculate_expression(context, expressions[i]);
+	}
+
+	size_t system_allocations_count = context->arena->system_allocations_count;
+	size_t tokens_capacity = context->tokens_capacity;
+	struct stack_double* evaluation_stack = context->evaluation_stack;
+
+	double start_time = get_time_seconds();
+	for (size_t repeat = 0; repeat < REPEATS_COUNT; repeat++)
+	{
+		for (size_t i = 0; i < EXPRESSIONS_COUNT; i++)
+		{
+			calculate_expression(context, expressions[i]);
+		}
+	}
+	double seconds = get_time_seconds() - start_time;
+
+	size_t new_allocations_count = context->arena->system_allocations_count - system_allocations_count;
+	if (context->tokens_capacity != tokens_capacity || context->evaluation_stack != evaluation_stack)
+	{
+		new_allocations_count++;
+	}
+
+	printf("calculate expression: %.0f expressions/s, arena capacity: %zu bytes\n",
+		REPEATS_COUNT * EXPRESSIONS_COUNT / seconds, context->arena->total_capacity);
+	printf("system allocations after warm-up: %zu (%s)\n", new_allocations_count,
+		(new_allocations_count == 0) ? "ok" : "FAILED");
+
+	parser_context_free(context);
+}
+
+
+/**********************************************************************************************************
+NAME  : BUILD LONG EXPRESSION
+LIBS  : stdio.h, stdlib.h
+NOTES : builds expression of about "tokens_count" tokens. Flat expression is a sum of products of 1000
+        variables and distinct constants, deep expression is "( a + ( a + ... ) )". Returned pointer must be
+        passed to "free()" after use.
+**********************************************************************************************************/
+char* build_long_expression(size_t tokens_count, int is_deep)
+{
+	const size_t VARIABLES_COUNT = 1000;
+	const size_t MAX_TOKENS_LENGTH = 48;
+	const size_t TOKENS_PER_PART = 4;
+
+	size_t parts_count = tokens_count / TOKENS_PER_PART;
+	char* expression = calloc(parts_count * MAX_TOKENS_LENGTH + VARIABLES_COUNT * MAX_TOKENS_LENGTH, sizeof(char));
+	if (expression == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	//append cursor keeps building linear, "strcat()" would rescan expression every time.
+	char* cursor = expression;
+	if (is_deep == 1)
+	{
+		for (size_t i = 0; i < parts_count; i++)
+		{
+			cursor += sprintf(cursor, "( a + ");
+		}
+		cursor += sprintf(cursor, "1");
+		for (size_t i = 0; i < parts_count; i++)
+		{
+			cursor += sprintf(cursor, " )");
+		}
+		sprintf(cursor, " | a = 1");
+	}
+	else
+	{
+		for (size_t i = 0; i < parts_count; i++)
+		{
+			cursor += sprintf(cursor, "x%zu * %zu.5 + ", i % VARIABLES_COUNT, i);
+		}
+		cursor += sprintf(cursor, "1 |");
+		for (size_t i = 0; i < VARIABLES_COUNT; i++)
+		{
+			cursor += sprintf(cursor, "%s x%zu = %zu", (i == 0) ? "" : " ,", i, i);
+		}
+	}
+
+	return expression;
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK LONG EXPRESSIONS
+LIBS  : stdio.h, stdlib.h
+NOTES : calculates flat and deeply nested expressions of 10^4, 10^5 and 10^6 tokens. Time per token must
+        stay the same for all lengths, so parsing is linear.
+**********************************************************************************************************/
+void benchmark_long_expressions()
+{
+	const size_t MIN_TOKENS_COUNT = 10000;
+	const size_t MAX_TOKENS_COUNT = 1000000;
+
+	struct parser_context* context = parser_context_initialize();
+
+	for (int is_deep = 0; is_deep <= 1; is_deep++)
+	{
+		for (size_t tokens_count = MIN_TOKENS_COUNT; tokens_count <= MAX_TOKENS_COUNT; tokens_count *= 10)
+		{
+			char* expression = build_long_expression(tokens_count, is_deep);
+
+			double start_time = get_time_seconds();
+			struct evaluation_result result = calculate_expression(context, expression);
+			double seconds = get_time_seconds() - start_time;
+
+			printf("%s expression of %zu tokens: %.3f s, %.1f ns per token, %s\n", (is_deep == 1) ? "deep" : "flat",
+				context->tokens_count, seconds, seconds * 1e9 / context->tokens_count,
+				(result.error_code == NO_ERROR) ? "ok" : get_error_message(result.error_code));
+
+			free(expression);
+		}
+	}
+
+	parser_context_free(context);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK RESULT CACHE
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : evaluates angle predicate over random triangles with integer sides from 1 to 9 (729 distinct rows)
+        without cache and with result caches smaller and greater than count of distinct rows. Prints rows
+        per second, hits and misses and count of rows whose result or error differs from evaluation.
+**********************************************************************************************************/
+void benchmark_result_cache()
+{
+	const char* FORMULA_TEXT =
+		"( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90";
+	const size_t ROWS_COUNT = 1000000;
+	const size_t CACHE_CAPACITIES[] = { 0, 256, 1024 };
+	const int MAX_SIDE = 9;
+
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formula = compile_formula(context, FORMULA_TEXT);
+	parser_context_free(context);
+
+	struct stack_double* stack = stack_double_initialize(formula->max_stack_depth);
+	struct evaluation_result* expected_results = calloc(ROWS_COUNT, sizeof(struct evaluation_result));
+	if (expected_results == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	double bindings[3];
+	for (size_t i = 0; i < sizeof(CACHE_CAPACITIES) / sizeof(CACHE_CAPACITIES[0]); i++)
+	{
+		struct result_cache* cache = (CACHE_CAPACITIES[i] != 0) ? result_cache_initialize(CACHE_CAPACITIES[i]) : NULL;
+		size_t mismatches_count = 0;
+
+		srand(1);
+		double start_time = get_time_seconds();
+		for (size_t row = 0; row < ROWS_COUNT; row++)
+		{
+			for (size_t slot = 0; slot < formula->variables_count; slot++)
+			{
+				bindings[slot] = 1 + rand() % MAX_SIDE;
+			}
+
+			struct evaluation_result result;
+			if (cache == NULL)
+			{
+				expected_results[row] = evaluate_compiled_formula(formula, bindings, stack);
+				continue;
+			}
+			if (result_cache_find(cache, 0, bindings, formula->variables_count, &result) == 0)
+			{
+				result = evaluate_compiled_formula(formula, bindings, stack);
+				result_cache_add(cache, 0, bindings, formula->variables_count, result);
+			}
+
+			if (memcmp(&result.value, &expected_results[row].value, sizeof(double)) != 0 ||
+				result.error_code != expected_results[row].error_code ||
+				result.error_position != expected_results[row].error_position)
+			{
+				mismatches_count++;
+			}
+		}
+		double seconds = get_time_seconds() - start_time;
+
+		if (cache == NULL)
+		{
+			printf("result cache off: %.0f rows/s\n", ROWS_COUNT / seconds);
+			continue;
+		}
+
+		printf("result cache of %zu: %.0f rows/s, hits: %zu, misses: %zu, mismatched rows: %zu\n",
+			CACHE_CAPACITIES[i], ROWS_COUNT / seconds, cache->hits_count, cache->misses_count, mismatches_count);
+		result_cache_free(cache);
+	}
+
+	free(expected_results);
+	stack_double_free(stack);
+	compiled_formula_free(formula);
+}
+
+
+/**********************************************************************************************************
+NAME  : FORMULA CACHE BENCHMARK TASK
+LIBS  : -
+NOTES : work of one thread of formula cache benchmark.
+**********************************************************************************************************/
+struct formula_cache_benchmark_task
+{
+	struct formula_cache* cache;
+	const char* const* formulas_texts;
+	size_t formulas_count;
+	size_t lookups_count;
+	size_t failed_count;
+};
+
+
+/**********************************************************************************************************
+NAME  : RUN FORMULA CACHE BENCHMARK TASK
+LIBS  : string.h
+NOTES : takes formulas from shared cache by turns, every thread has its own parser context.
+**********************************************************************************************************/
+void run_formula_cache_benchmark_task(void* argument)
+{
+	struct formula_cache_benchmark_task* task = argument;
+	struct parser_context* context = parser_context_initialize();
+
+	//benchmark formulas are shorter than 127 characters, normalized text is up to twice longer.
+	char normalized_text[256];
+	size_t normalized_positions[256];
+
+	for (size_t i = 0; i < task->lookups_count; i++)
+	{
+		const char* formula_text = task->formulas_texts[i % task->formulas_count];
+		size_t normalized_length = normalize_formula_text(context, formula_text, strlen(formula_text),
+			normalized_text, normalized_positions);
+
+		struct jit_formula* jit;
+		struct formula_cache_entry* entry = formula_cache_acquire(task->cache, context, normalized_text,
+			normalized_length, 0, &jit);
+		task->failed_count += (entry->formula == NULL) ? 1 : 0;
+		formula_cache_release(task->cache, entry);
+	}
+
+	parser_context_free(context);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK FORMULA CACHE
+LIBS  : stdio.h, string.h
+NOTES : compares compilation of formula for every line with lookup in formula cache (texts differ only by
+        spaces, so they share compiled formula), then scales lookups over threads of shared cache.
+**********************************************************************************************************/
+void benchmark_formula_cache()
+{
+	const char* FORMULAS_TEXTS[] =
+	{
+		"( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90",
+		"( ( arccos ( ( pow ( a , 2 )  +  pow ( b , 2 ) - pow ( c , 2 ) ) / ( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90",
+		"a + b > c", "a  +  b > c", "a + c > b", "b + c > a"
+	};
+	const size_t FORMULAS_COUNT = sizeof(FORMULAS_TEXTS) / sizeof(FORMULAS_TEXTS[0]);
+	const size_t LOOKUPS_COUNT = 1000000;
+	const size_t CACHE_CAPACITY = 1024;
+
+	//count of threads is doubled up to 8.
+	struct formula_cache_benchmark_task tasks[8];
+	struct thread threads[8];
+
+	struct parser_context* context = parser_context_initialize();
+	double start_time = get_time_seconds();
+	for (size_t i = 0; i < LOOKUPS_COUNT; i++)
+	{
+		compiled_formula_free(compile_formula(context, FORMULAS_TEXTS[i % FORMULAS_COUNT]));
+	}
+	double compile_seconds = get_time_seconds() - start_time;
+	parser_context_free(context);
+	printf("compile every line: %.1f ns per line\n", compile_seconds * 1e9 / LOOKUPS_COUNT);
+
+	for (size_t threads_count = 1; threads_count <= sizeof(threads) / sizeof(threads[0]); threads_count *= 2)
+	{
+		struct formula_cache* cache = formula_cache_initialize(CACHE_CAPACITY);
+
+		start_time = get_time_seconds();
+		for (size_t i = 0; i < threads_count; i++)
+		{
+			struct formula_cache_benchmark_task task = { cache, FORMULAS_TEXTS, FORMULAS_COUNT, LOOKUPS_COUNT, 0 };
+			tasks[i] = task;
+			thread_start(&threads[i], &run_formula_cache_benchmark_task, &tasks[i]);
+		}
+		size_t failed_count = 0;
+		for (size_t i = 0; i < threads_count; i++)
+		{
+			thread_join(&threads[i]);
+			failed_count += tasks[i].failed_count;
+		}
+		double seconds = get_time_seconds() - start_time;
+
+		size_t compiled_count = 0;
+		for (size_t i = 0; i < FORMULA_CACHE_SHARDS_COUNT; i++)
+		{
+			compiled_count += cache->shards[i].entries_count;
+		}
+
+		printf("formula cache, %zu threads: %.1f ns per line per thread, %.0f lines/s, compiled formulas: %zu, "
+			"failed: %zu\n", threads_count, seconds * 1e9 / LOOKUPS_COUNT, threads_count * LOOKUPS_COUNT / seconds,
+			compiled_count, failed_count);
+		formula_cache_free(cache);
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : REMOVE SHORT CIRCUIT JUMPS
+LIBS  : -
+NOTES : removes skip instructions of formula, so every operand is calculated (values do not change, but
+        errors of lazy operands are reported). It is used only for benchmark.
+**********************************************************************************************************/
+void remove_short_circuit_jumps(struct compiled_formula* formula)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < formula->instructions_count; i++)
+	{
+		if (is_skip_instruction(&formula->instructions[i]) == 0)
+		{
+			formula->instructions[count] = formula->instructions[i];
+			formula->instruction_positions[count] = formula->instruction_positions[i];
+			count++;
+		}
+	}
+	formula->instructions_count = count;
+}
+
+
+/**********************************************************************************************************
+NAME  : COUNT EXECUTED INSTRUCTIONS
+LIBS  : -
+NOTES : evaluates formula like "evaluate_compiled_formula()" and return count of executed instructions
+        (taken skip is counted, skipped operand is not). It is used only for benchmark.
+**********************************************************************************************************/
+size_t count_executed_instructions(const struct compiled_formula* formula, const double* bindings,
+	struct stack_double* stack)
+{
+	size_t executed_count = 0;
+	clear_stack_double(stack);
+
+	for (size_t i = 0; i < formula->instructions_count && stack->error_code == NO_ERROR; i++)
+	{
+		const struct instruction* instruction = &formula->instructions[i];
+		executed_count++;
+
+		switch (instruction->opcode)
+		{
+			case PUSH_CONSTANT:
+				push_stack_double(stack, formula->constants[instruction->operand]);
+				break;
+
+			case PUSH_VARIABLE:
+				push_stack_double(stack, bindings[instruction->operand]);
+				break;
+
+			case DUPLICATE:
+				push_stack_double(stack, *(stack->head_element));
+				break;
+
+			case CALL_OPERATION:
+				MATH_OPERATIONS[instruction->operand].pointer_on_function(stack);
+				break;
+
+			case CALL_FUNCTION:
+				MATH_FUNCTIONS[instruction->operand].pointer_on_function(stack);
+				break;
+
+			default:
+			{
+				double tested_value = (instruction->opcode == SKIP_IF_BELOW_TRUE) ? stack->head_element[-1] :
+					stack->head_element[0];
+				if (is_skip_taken(instruction->opcode, tested_value) == 1)
+				{
+					push_stack_double(stack, NAN);
+					i = (size_t)instruction->operand - 1;
+				}
+			}
+		}
+	}
+
+	return executed_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK SHORT CIRCUIT RULE
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : evaluates rule over random rows with every operand calculated and with lazy operands, prints
+        executed instructions per row, rows per second and count of rows with different results.
+**********************************************************************************************************/
+void benchmark_short_circuit_rule(const char* formula_text)
+{
+	const size_t ROWS_COUNT = 1000000;
+
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formulas[2];
+	formulas[0] = compile_formula(context, formula_text);
+	formulas[1] = compile_formula(context, formula_text);
+	parser_context_free(context);
+	remove_short_circuit_jumps(formulas[0]);
+
+	size_t variables_count = formulas[1]->variables_count;
+	double* bindings = calloc(ROWS_COUNT * variables_count, sizeof(double));
+	double* results[2];
+	results[0] = calloc(ROWS_COUNT, sizeof(double));
+	results[1] = calloc(ROWS_COUNT, sizeof(double));
+	if (bindings == NULL || results[0] == NULL || results[1] == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	fill_random_column(bindings, ROWS_COUNT * variables_count, 0, 1);
+
+	double seconds[2];
+	size_t executed_counts[2];
+	for (size_t version = 0; version < 2; version++)
+	{
+		const struct compiled_formula* formula = formulas[version];
+		struct stack_double* stack = stack_double_initialize(formula->max_stack_depth);
+
+		double start_time = get_time_seconds();
+		for (size_t row = 0; row < ROWS_COUNT; row++)
+		{
+			const double* row_bindings = &bindings[row * variables_count];
+			results[version][row] = evaluate_compiled_formula(formula, row_bindings, stack).value;
+		}
+		seconds[version] = get_time_seconds() - start_time;
+
+		executed_counts[version] = 0;
+		for (size_t row = 0; row < ROWS_COUNT; row++)
+		{
+			const double* row_bindings = &bindings[row * variables_count];
+			executed_counts[version] += count_executed_instructions(formula, row_bindings, stack);
+		}
+
+		stack_double_free(stack);
+	}
+
+	size_t mismatches_count = 0;
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		if (memcmp(&results[0][row], &results[1][row], sizeof(double)) != 0)
+		{
+			mismatches_count++;
+		}
+	}
+
+	double eager_instructions = (double)executed_counts[0] / ROWS_COUNT;
+	double lazy_instructions = (double)executed_counts[1] / ROWS_COUNT;
+	printf("%s\n", formula_text);
+	printf("instructions per row: %.2f -> %.2f (saved %.1f%%)\n", eager_instructions, lazy_instructions,
+		100 * (1 - lazy_instructions / eager_instructions));
+	printf("all operands: %.0f rows/s, lazy operands: %.0f rows/s, speedup: %.2fx, mismatched rows: %zu\n",
+		ROWS_COUNT / seconds[0], ROWS_COUNT / seconds[1], seconds[0] / seconds[1], mismatches_count);
+
+	free(bindings);
+	free(results[0]);
+	free(results[1]);
+	compiled_formula_free(formulas[0]);
+	compiled_formula_free(formulas[1]);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK SHORT CIRCUIT
+LIBS  : -
+NOTES : rules of alerting (disjunction whose cheap first clause is often true), eligibility (conjunction
+        whose cheap first clause is often false) and tiered pricing ("if" chain) over values from 0 to 1.
+**********************************************************************************************************/
+void benchmark_short_circuit()
+{
+	benchmark_short_circuit_rule("amount > 0.5 OR ( score < 0.2 AND ln ( amount + 1 ) * arccos ( score ) > 0.3 ) "
+		"OR arccos ( risk ) * sqrt ( amount ) > 1.2 OR abs ( ln ( age + 1 ) - ln ( score + 1 ) ) > 0.6");
+	benchmark_short_circuit_rule("age >= 0.7 AND score != 0 AND arccos ( score ) < 1.2 AND "
+		"ln ( amount + 1 ) > 0.1 AND sqrt ( risk ) < 0.9");
+	benchmark_short_circuit_rule("if ( risk < 0.3 , amount * 0.9 , if ( risk < 0.7 , amount * 0.95 + "
+		"ln ( amount + 1 ) , amount + sqrt ( amount ) * arccos ( score ) ) )");
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK INCREMENTAL FORMULA
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : simulation loop which changes one variable per step (in turn), evaluates formula by stack machine
+        and by incremental evaluator, checks that results are identical and prints count of calculated
+        nodes per step and steps per second.
+**********************************************************************************************************/
+void benchmark_incremental_formula(const char* formula_text)
+{
+	const size_t STEPS_COUNT = 1000000;
+
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formula = compile_formula(context, formula_text);
+	parser_context_free(context);
+
+	size_t variables_count = formula->variables_count;
+	double* new_values = calloc(STEPS_COUNT, sizeof(double));
+	double* bindings = calloc(variables_count + 1, sizeof(double));
+	struct evaluation_result* full_results = calloc(STEPS_COUNT, sizeof(struct evaluation_result));
+	struct evaluation_result* incremental_results = calloc(STEPS_COUNT, sizeof(struct evaluation_result));
+	if (new_values == NULL || bindings == NULL || full_results == NULL || incremental_results == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	fill_random_column(new_values, STEPS_COUNT, 1, 2);
+
+	struct stack_double* stack = stack_double_initialize(formula->max_stack_depth);
+	double start_time = get_time_seconds();
+	for (size_t step = 0; step < STEPS_COUNT; step++)
+	{
+		bindings[step % variables_count] = new_values[step];
+		full_results[step] = evaluate_compiled_formula(formula, bindings, stack);
+	}
+	double full_seconds = get_time_seconds() - start_time;
+	stack_double_free(stack);
+
+	struct incremental_evaluator* evaluator = incremental_evaluator_initialize(formula);
+	size_t recomputed_nodes_count = 0;
+	start_time = get_time_seconds();
+	for (size_t step = 0; step < STEPS_COUNT; step++)
+	{
+		set_incremental_variable(evaluator, (int)(step % variables_count), new_values[step]);
+		incremental_results[step] = evaluate_incremental(evaluator);
+		recomputed_nodes_count += evaluator->recomputed_nodes_count;
+	}
+	double incremental_seconds = get_time_seconds() - start_time;
+
+	size_t mismatches_count = 0;
+	for (size_t step = 0; step < STEPS_COUNT; step++)
+	{
+		if (full_results[step].error_code != incremental_results[step].error_code ||
+			full_results[step].error_position != incremental_results[step].error_position ||
+			memcmp(&full_results[step].value, &incremental_results[step].value, sizeof(double)) != 0)
+		{
+			mismatches_count++;
+		}
+	}
+
+	printf("%s\n", formula_text);
+	printf("instructions: %zu, nodes: %zu, recomputed nodes per step: %.2f\n", formula->instructions_count,
+		evaluator->nodes_count, (double)recomputed_nodes_count / STEPS_COUNT);
+	printf("full: %.0f steps/s, incremental: %.0f steps/s, speedup: %.2fx, mismatched results: %zu\n",
+		STEPS_COUNT / full_seconds, STEPS_COUNT / incremental_seconds, full_seconds / incremental_seconds,
+		mismatches_count);
+
+	free(new_values);
+	free(bindings);
+	free(full_results);
+	free(incremental_results);
+	incremental_evaluator_free(evaluator);
+	compiled_formula_free(formula);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK INCREMENTAL EVALUATION
+LIBS  : -
+NOTES : angle predicate of triangle and formula whose subexpressions mostly depend on one variable.
+**********************************************************************************************************/
+void benchmark_incremental_evaluation()
+{
+	benchmark_incremental_formula("( ( arccos ( ( pow ( a , 2 ) + pow ( b , 2 ) - pow ( c , 2 ) ) / "
+		"( 2 * a * b ) ) ) * 180 / 3.141592 ) < 90");
+	benchmark_incremental_formula("ln ( a + 1 ) * sqrt ( a ) + sin ( a ) * cos ( a ) / ( 1 + abs ( tan ( a ) ) ) + "
+		"arccos ( b / 3 ) * ln ( b ) - sqrt ( b + 2 ) * sin ( b ) + pow ( c , 3 ) / ( 1 + c )");
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK ZONE MAP FORMULA
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : evaluates predicate by batch evaluation and by batch evaluation with zone map, checks that results
+        are identical and prints count of skipped blocks and rows per second. If "is_clustered" is 1, the first
+        variable grows from 0 to 10 like time, otherwise it is random from 0 to 10, other variables are random
+        from 1 to 2. Every way is timed several times and the best time is kept. Zone map is built once for
+        many queries, so speedup is printed without and with time of building.
+**********************************************************************************************************/
+void benchmark_zone_map_formula(const char* formula_text, int is_clustered)
+{
+	const size_t ROWS_COUNT = 4000000;
+	const size_t REPEATS_COUNT = 5;
+	const double TREND_MAXIMUM = 10;
+	const double NOISE = 0.5;
+
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formula = compile_formula(context, formula_text);
+	parser_context_free(context);
+
+	double** columns = calloc(formula->variables_count, sizeof(double*));
+	double* batch_results = calloc(ROWS_COUNT, sizeof(double));
+	double* zone_results = calloc(ROWS_COUNT, sizeof(double));
+	int* batch_errors = calloc(ROWS_COUNT, sizeof(int));
+	int* zone_errors = calloc(ROWS_COUNT, sizeof(int));
+	if (columns == NULL || batch_results == NULL || zone_results == NULL || batch_errors == NULL ||
+		zone_errors == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	for (size_t slot = 0; slot < formula->variables_count; slot++)
+	{
+		columns[slot] = calloc(ROWS_COUNT, sizeof(double));
+		if (columns[slot] == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+
+		if (slot == 0 && is_clustered == 1)
+		{
+			fill_random_column(columns[slot], ROWS_COUNT, -NOISE, NOISE);
+			for (size_t row = 0; row < ROWS_COUNT; row++)
+			{
+				columns[slot][row] += TREND_MAXIMUM * row / ROWS_COUNT;
+			}
+		}
+		else if (slot == 0)
+		{
+			fill_random_column(columns[slot], ROWS_COUNT, 0, TREND_MAXIMUM);
+		}
+		else
+		{
+			fill_random_column(columns[slot], ROWS_COUNT, 1, 2);
+		}
+	}
+
+	struct batch_stack* batch_stack = batch_stack_initialize(formula->max_stack_depth);
+	struct zone_map* zones = NULL;
+	size_t skipped_blocks_count = 0;
+	double batch_seconds = INFINITY;
+	double build_seconds = INFINITY;
+	double zone_seconds = INFINITY;
+	for (size_t repeat = 0; repeat < REPEATS_COUNT; repeat++)
+	{
+		double start_time = get_time_seconds();
+		evaluate_compiled_formula_batch(formula, (const double* const*)columns, ROWS_COUNT, batch_results,
+			batch_errors, batch_stack);
+		batch_seconds = fmin(batch_seconds, get_time_seconds() - start_time);
+
+		if (zones != NULL)
+		{
+			zone_map_free(zones);
+		}
+		start_time = get_time_seconds();
+		zones = zone_map_initialize((const double* const*)columns, formula->variables_count, ROWS_COUNT);
+		build_seconds = fmin(build_seconds, get_time_seconds() - start_time);
+
+		start_time = get_time_seconds();
+		evaluate_compiled_formula_zones(formula, (const double* const*)columns, zones, zone_results,
+			zone_errors, batch_stack, &skipped_blocks_count);
+		zone_seconds = fmin(zone_seconds, get_time_seconds() - start_time);
+	}
+	batch_stack_free(batch_stack);
+
+	size_t mismatches_count = 0;
+	for (size_t row = 0; row < ROWS_COUNT; row++)
+	{
+		if (batch_errors[row] != zone_errors[row] ||
+			memcmp(&batch_results[row], &zone_results[row], sizeof(double)) != 0)
+		{
+			mismatches_count++;
+		}
+	}
+
+	printf("%s, %s data\n", formula_text, (is_clustered == 1) ? "clustered" : "unsorted");
+	printf("blocks: %zu, skipped blocks: %zu (%.1f%%), zone map built in %.1f ms\n", zones->blocks_count,
+		skipped_blocks_count, 100.0 * skipped_blocks_count / zones->blocks_count, build_seconds * 1000);
+	printf("batch: %.0f rows/s, batch with zone map: %.0f rows/s, speedup: %.2fx (%.2fx with building), "
+		"mismatched rows: %zu\n", ROWS_COUNT / batch_seconds, ROWS_COUNT / zone_seconds,
+		batch_seconds / zone_seconds, batch_seconds / (zone_seconds + build_seconds), mismatches_count);
+
+	for (size_t slot = 0; slot < formula->variables_count; slot++)
+	{
+		free(columns[slot]);
+	}
+	free(columns);
+	free(batch_results);
+	free(zone_results);
+	free(batch_errors);
+	free(zone_errors);
+	zone_map_free(zones);
+	compiled_formula_free(formula);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK ZONE MAPS
+LIBS  : -
+NOTES : arithmetic predicate and predicate with arccosine and lazy conjunction over clustered data, and
+        arithmetic predicate over unsorted data, where zone map can not skip blocks.
+**********************************************************************************************************/
+void benchmark_zone_maps()
+{
+	benchmark_zone_map_formula("a + b > c + 5", 1);
+	benchmark_zone_map_formula("arccos ( ( a - 5 ) / 6 ) < 1 AND sqrt ( b ) * c > 0.5", 1);
+	benchmark_zone_map_formula("a + b > c + 5", 0);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK NUMBER CORPUS
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : writes literals of one kind by "printf()" format ("%.2f" for prices etc.), parses them by
+        "parse_number()" and by "strtod()", checks that values are bitwise equal and prints nanoseconds per
+        literal. Argument of format is random number from "minimum" to "maximum".
+**********************************************************************************************************/
+void benchmark_number_corpus(const char* corpus_name, const char* literal_format, double minimum, double maximum)
+{
+	const size_t LITERALS_COUNT = 200000;
+	const size_t MAX_LITERAL_LENGTH = 32;
+	const size_t REPEATS_COUNT = 5;
+
+	//literals are separated by zero characters, so "strtod()" stops at the end of literal.
+	char* corpus = calloc(LITERALS_COUNT * MAX_LITERAL_LENGTH, sizeof(char));
+	size_t* literal_offsets = calloc(LITERALS_COUNT + 1, sizeof(size_t));
+	double* parsed_values = calloc(LITERALS_COUNT, sizeof(double));
+	double* strtod_values = calloc(LITERALS_COUNT, sizeof(double));
+	if (corpus == NULL || literal_offsets == NULL || parsed_values == NULL || strtod_values == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	size_t corpus_length = 0;
+	for (size_t i = 0; i < LITERALS_COUNT; i++)
+	{
+		literal_offsets[i] = corpus_length;
+		double number = minimum + (maximum - minimum) * rand() / RAND_MAX;
+		corpus_length += (size_t)snprintf(corpus + corpus_length, MAX_LITERAL_LENGTH, literal_format, number) + 1;
+	}
+	literal_offsets[LITERALS_COUNT] = corpus_length;
+
+	double parse_seconds = 0;
+	double strtod_seconds = 0;
+	for (size_t repeat = 0; repeat < REPEATS_COUNT; repeat++)
+	{
+		double start_time = get_time_seconds();
+		for (size_t i = 0; i < LITERALS_COUNT; i++)
+		{
+			parse_number(corpus + literal_offsets[i], corpus + literal_offsets[i + 1] - 1, &parsed_values[i]);
+		}
+		double seconds = get_time_seconds() - start_time;
+		parse_seconds = (repeat == 0 || seconds < parse_seconds) ? seconds : parse_seconds;
+
+		start_time = get_time_seconds();
+		for (size_t i = 0; i < LITERALS_COUNT; i++)
+		{
+			strtod_values[i] = strtod(corpus + literal_offsets[i], NULL);
+		}
+		seconds = get_time_seconds() - start_time;
+		strtod_seconds = (repeat == 0 || seconds < strtod_seconds) ? seconds : strtod_seconds;
+	}
+
+	size_t mismatches_count = 0;
+	for (size_t i = 0; i < LITERALS_COUNT; i++)
+	{
+		if (memcmp(&parsed_values[i], &strtod_values[i], sizeof(double)) != 0)
+		{
+			mismatches_count++;
+		}
+	}
+
+	printf("%-12s (%s): parse_number %.1f ns, strtod %.1f ns per literal, speedup: %.2fx, mismatches: %zu\n",
+		corpus_name, corpus + literal_offsets[0], parse_seconds * 1e9 / LITERALS_COUNT,
+		strtod_seconds * 1e9 / LITERALS_COUNT, strtod_seconds / parse_seconds, mismatches_count);
+
+	free(corpus);
+	free(literal_offsets);
+	free(parsed_values);
+	free(strtod_values);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK NUMBER PARSING
+LIBS  : -
+NOTES : literals as they are written in formulas and data: identifiers, prices, coordinates, measurements in
+        scientific notation and doubles printed with full precision (17 digits go to big numbers).
+**********************************************************************************************************/
+void benchmark_number_parsing()
+{
+	benchmark_number_corpus("integers", "%.0f", 0, 1000000);
+	benchmark_number_corpus("prices", "%.2f", 0, 10000);
+	benchmark_number_corpus("coordinates", "%.6f", -180, 180);
+	benchmark_number_corpus("scientific", "%.3e", 1e-12, 1e-3);
+	benchmark_number_corpus("full", "%.17g", -1, 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK FORMULA FILE
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : cold start of ruleset: compilation of rules from text against loading of formula file (opening and
+        taking of every formula with checks). File is written to working directory and removed after it,
+        it is in page cache when it is loaded, so reading of disk is not timed. Results of rules of both
+        kinds are compared bitwise.
+**********************************************************************************************************/
+void benchmark_formula_file()
+{
+	const size_t RULES_COUNT = 200000;
+	const size_t MAX_RULE_LENGTH = 128;
+	const size_t VARIABLES_COUNT = 26;
+	const char* FILE_PATH = "mathpars_benchmark.bin";
+	const char* RULE_FORMATS[] =
+	{
+		"%c + %d * %c > %d AND %c < %d + %d",
+		"if ( %c > %d , sqrt ( abs ( %c - %d ) ) , %c * %d ) >= %d",
+		"pow ( %c , 2 ) + %d / ( %c + %d ) OR %c != %d - %d",
+		"( %c - %d ) * ( %c + %d ) < %c + %d * %d"
+	};
+	const size_t RULE_FORMATS_COUNT = sizeof(RULE_FORMATS) / sizeof(RULE_FORMATS[0]);
+
+	char** rule_texts = calloc(RULES_COUNT, sizeof(char*));
+	struct compiled_formula** formulas = calloc(RULES_COUNT, sizeof(struct compiled_formula*));
+	if (rule_texts == NULL || formulas == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	for (size_t i = 0; i < RULES_COUNT; i++)
+	{
+		rule_texts[i] = calloc(MAX_RULE_LENGTH, sizeof(char));
+		if (rule_texts[i] == NULL)
+		{
+			throw_error(OUT_OF_MEMORY);
+		}
+		//every format has the same places: three pairs of variable and number and the last number.
+		snprintf(rule_texts[i], MAX_RULE_LENGTH, RULE_FORMATS[i % RULE_FORMATS_COUNT],
+			'a' + rand() % VARIABLES_COUNT, rand() % 100, 'a' + rand() % VARIABLES_COUNT, rand() % 100,
+			'a' + rand() % VARIABLES_COUNT, rand() % 100, rand() % 100);
+	}
+
+	double start_time = get_time_seconds();
+	struct parser_context* context = parser_context_initialize();
+	for (size_t i = 0; i < RULES_COUNT; i++)
+	{
+		formulas[i] = compile_formula(context, rule_texts[i]);
+	}
+	parser_context_free(context);
+	double compile_seconds = get_time_seconds() - start_time;
+
+	if (write_formula_file(FILE_PATH, (const struct compiled_formula* const*)formulas,
+		(const char* const*)rule_texts, RULES_COUNT) == 0)
+	{
+		printf("formula file: can not write %s\n", FILE_PATH);
+	}
+	else
+	{
+		start_time = get_time_seconds();
+		struct formula_file* file = open_formula_file(FILE_PATH);
+		size_t damaged_count = 0;
+		for (size_t i = 0; i < RULES_COUNT; i++)
+		{
+			damaged_count += (get_file_formula(file, i) == NULL);
+		}
+		double load_seconds = get_time_seconds() - start_time;
+		size_t file_size = file->mapped_file->size;
+
+		//every rule is evaluated with the same bindings of all letters, slots of both formulas are equal.
+		double bindings[26];
+		for (size_t i = 0; i < VARIABLES_COUNT; i++)
+		{
+			bindings[i] = rand() % 100;
+		}
+		struct stack_double* stack = stack_double_initialize(MAX_RULE_LENGTH);
+		size_t mismatches_count = 0;
+		for (size_t i = 0; i < RULES_COUNT && damaged_count == 0; i++)
+		{
+			struct evaluation_result compiled_result = evaluate_compiled_formula(formulas[i], bindings, stack);
+			struct evaluation_result loaded_result = evaluate_compiled_formula(get_file_formula(file, i), bindings,
+				stack);
+			mismatches_count += (compiled_result.error_code != loaded_result.error_code ||
+				compiled_result.error_position != loaded_result.error_position ||
+				memcmp(&compiled_result.value, &loaded_result.value, sizeof(double)) != 0);
+		}
+		stack_double_free(stack);
+		close_formula_file(file);
+		remove(FILE_PATH);
+
+		printf("cold start of %zu rules: compilation %.1f ms, formula file (%.1f MB) %.1f ms, speedup: %.2fx, "
+			"damaged: %zu, mismatches: %zu\n", RULES_COUNT, compile_seconds * 1e3, file_size / 1e6,
+			load_seconds * 1e3, compile_seconds / load_seconds, damaged_count, mismatches_count);
+	}
+
+	for (size_t i = 0; i < RULES_COUNT; i++)
+	{
+		compiled_formula_free(formulas[i]);
+		free(rule_texts[i]);
+	}
+	free(rule_texts);
+	free(formulas);
+}
+
+
+/**********************************************************************************************************
+NAME  : GET RANDOM BITS
+LIBS  : stdlib.h
+NOTES : 64 random bits from "rand()", which gives at least 15 bits per call.
+**********************************************************************************************************/
+unsigned long long get_random_bits()
+{
+	unsigned long long bits = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		bits = (bits << 16) | (unsigned long long)(rand() & 0xFFFF);
+	}
+
+	return bits;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET RANDOM UNIT
+LIBS  : -
+NOTES : uniformly distributed number in [0, 1) with all 53 bits random.
+**********************************************************************************************************/
+double get_random_unit()
+{
+	return (double)(get_random_bits() >> 11) / 9007199254740992.0;
+}
+
+
+/**********************************************************************************************************
+NAME  : GET ULP DISTANCE
+LIBS  : math.h, string.h
+NOTES : count of doubles between "value" and "reference" (0 if they are equal). Two NANs are equal, NAN and
+        number are as far as possible.
+**********************************************************************************************************/
+unsigned long long get_ulp_distance(double value, double reference)
+{
+	if (isnan(value) || isnan(reference))
+	{
+		return (isnan(value) && isnan(reference)) ? 0 : ~0ULL;
+	}
+
+	const unsigned long long SIGN_BIT = 0x8000000000000000ULL;
+
+	unsigned long long ordered[2];
+	memcpy(&ordered[0], &value, sizeof(double));
+	memcpy(&ordered[1], &reference, sizeof(double));
+	for (int i = 0; i < 2; i++)
+	{
+		//negative numbers go below 2^63 in reverse order, so order of integers is order of doubles.
+		ordered[i] = ((ordered[i] & SIGN_BIT) != 0) ? SIGN_BIT - (ordered[i] & ~SIGN_BIT) : SIGN_BIT + ordered[i];
+	}
+
+	return (ordered[0] > ordered[1]) ? ordered[0] - ordered[1] : ordered[1] - ordered[0];
+}
+
+
+/**********************************************************************************************************
+NAME  : GENERATE ACCURACY ARGUMENTS
+LIBS  : math.h, stdlib.h, string.h
+NOTES : arguments of function for accuracy check, six kinds in turn: random bits (any double, NAN and
+        infinity too), uniform numbers around zero, numbers with uniform exponent over the domain, numbers
+        within 1000 ulp of hard points (multiples of pi/2, +-1 and +-0.5 for "arccos", powers of 2 and
+        border of mantissa reduction for "ln"), subnormal numbers and uniform numbers over the whole domain.
+**********************************************************************************************************/
+void generate_accuracy_arguments(int function_index, double* arguments, size_t arguments_count)
+{
+	const double PI_OVER_TWO = 1.57079632679489661923;
+	const double LN_MANTISSA_BORDER = 1.41420745849609375;
+	const unsigned long long SUBNORMAL_MASK = 0x800FFFFFFFFFFFFFULL;
+	const double HARD_ARCCOS_ARGUMENTS[] = { 1, -1, 0.5, -0.5 };
+	const long long MAX_ULP_SHIFT = 1000;
+	const int MAX_QUADRANT = 636619;
+	const int ARGUMENT_KINDS_COUNT = 6;
+
+	for (size_t i = 0; i < arguments_count; i++)
+	{
+		unsigned long long bits = get_random_bits();
+		double sign = (rand() % 2 == 0) ? 1 : -1;
+		double argument = 0;
+		switch (i % ARGUMENT_KINDS_COUNT)
+		{
+			case 0:
+				memcpy(&argument, &bits, sizeof(double));
+				break;
+
+			case 1:
+				argument = (function_index == FUNCTION_ARCCOS) ? sign * get_random_unit() :
+					(function_index == FUNCTION_LN) ? 10 * get_random_unit() : sign * 4 * PI_OVER_TWO * get_random_unit();
+				break;
+
+			case 2:
+				argument = (function_index == FUNCTION_ARCCOS) ? sign * ldexp(1 + get_random_unit(), -(rand() % 61) - 1) :
+					(function_index == FUNCTION_LN) ? ldexp(1 + get_random_unit(), rand() % 2046 - 1022) :
+					sign * ldexp(1 + get_random_unit(), rand() % 51 - 30);
+				break;
+
+			case 3:
+			{
+				if (function_index == FUNCTION_ARCCOS)
+				{
+					argument = HARD_ARCCOS_ARGUMENTS[rand() % 4];
+				}
+				else if (function_index == FUNCTION_LN)
+				{
+					argument = ldexp((rand() % 2 == 0) ? 1 : LN_MANTISSA_BORDER, rand() % 2046 - 1022);
+				}
+				else
+				{
+					argument = sign * (1 + (int)(get_random_unit() * MAX_QUADRANT)) * PI_OVER_TWO;
+				}
+
+				long long argument_bits;
+				memcpy(&argument_bits, &argument, sizeof(double));
+				argument_bits += (long long)(bits % (2 * MAX_ULP_SHIFT + 1)) - MAX_ULP_SHIFT;
+				memcpy(&argument, &argument_bits, sizeof(double));
+				break;
+			}
+
+			case 4:
+				bits &= SUBNORMAL_MASK;
+				memcpy(&argument, &bits, sizeof(double));
+				break;
+
+			default:
+				argument = (function_index == FUNCTION_ARCCOS) ? sign * 1.5 * get_random_unit() :
+					(function_index == FUNCTION_LN) ? 1e6 * get_random_unit() - 1 : sign * 1e6 * get_random_unit();
+		}
+		arguments[i] = argument;
+	}
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL CHECK ACCURACY MODE
+LIBS  : stdio.h, stdlib.h, string.h
+NOTES : every vector function in every not exact accuracy is compared with exact batch function (library)
+        over "samples_count" arguments of "generate_accuracy_arguments()". Maximal distance in ulp is
+        printed with argument which gives it, errors of rows must be the same. Return EXIT_FAILURE if
+        distance is above bound of accuracy or errors differ.
+**********************************************************************************************************/
+int call_check_accuracy_mode(size_t samples_count)
+{
+	const unsigned long long ULP_BOUNDS[BATCH_ACCURACIES_COUNT] = { 0, 1, 4 };
+
+	double* arguments = calloc(samples_count + 1, sizeof(double));
+	double* exact_results = calloc(samples_count + 1, sizeof(double));
+	double* vector_results = calloc(samples_count + 1, sizeof(double));
+	int* exact_errors = calloc(samples_count + 1, sizeof(int));
+	int* vector_errors = calloc(samples_count + 1, sizeof(int));
+	if (arguments == NULL || exact_results == NULL || vector_results == NULL || exact_errors == NULL ||
+		vector_errors == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	int is_passed = 1; //true
+	printf("%-8s %-6s %12s %8s  %s\n", "function", "mode", "max ulp", "errors", "worst argument");
+	for (int function_index = 0; function_index < MATH_FUNCTIONS_COUNT; function_index++)
+	{
+		const struct function_entry* function = &MATH_FUNCTIONS[function_index];
+		if (function->pointer_on_vector_function == NULL)
+		{
+			continue;
+		}
+
+		srand(1);
+		generate_accuracy_arguments(function_index, arguments, samples_count);
+		memcpy(exact_results, arguments, samples_count * sizeof(double));
+		for (size_t i = 0; i < samples_count; i++)
+		{
+			exact_errors[i] = NO_ERROR;
+		}
+		function->pointer_on_batch_function(exact_results, NULL, samples_count, exact_errors);
+
+		for (int accuracy = BATCH_ACCURACY_ONE_ULP; accuracy < BATCH_ACCURACIES_COUNT; accuracy++)
+		{
+			memcpy(vector_results, arguments, samples_count * sizeof(double));
+			for (size_t i = 0; i < samples_count; i++)
+			{
+				vector_errors[i] = NO_ERROR;
+			}
+			function->pointer_on_vector_function(vector_results, NULL, samples_count, vector_errors, accuracy);
+
+			unsigned long long max_distance = 0;
+			double worst_argument = 0;
+			size_t errors_mismatches_count = 0;
+			for (size_t i = 0; i < samples_count; i++)
+			{
+				unsigned long long distance = get_ulp_distance(vector_results[i], exact_results[i]);
+				if (distance > max_distance)
+				{
+					max_distance = distance;
+					worst_argument = arguments[i];
+				}
+				errors_mismatches_count += (vector_errors[i] != exact_errors[i]);
+			}
+
+			//library cotan is 1 / tan(x), vector cotan is 1 / tan too, so one ulp of tan can give two ulp of
+			//quotient.
+			unsigned long long ulp_bound = ULP_BOUNDS[accuracy] +
+				((function_index == FUNCTION_COTAN) ? 1 : 0);
+			int is_function_passed = (max_distance <= ulp_bound && errors_mismatches_count == 0);
+			is_passed = is_passed && is_function_passed;
+			printf("%-8s %-6s %12llu %8zu  %.17g%s\n", function->function_alias, get_accuracy_name(accuracy),
+				max_distance, errors_mismatches_count, worst_argument, (is_function_passed == 1) ? "" : "  FAILED");
+		}
+	}
+
+	free(arguments);
+	free(exact_results);
+	free(vector_results);
+	free(exact_errors);
+	free(vector_errors);
+
+	return (is_passed == 1) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/**********************************************************************************************************
+NAME  : BENCHMARK VECTOR FUNCTIONS
+LIBS  : stdio.h, stdlib.h
+NOTES : throughput of functions with vector versions in every accuracy, arguments are uniform over range
+        where vector versions cover all rows, so library is called only in exact mode.
+**********************************************************************************************************/
+void benchmark_vector_functions()
+{
+	const size_t ROWS_COUNT = BATCH_BLOCK_SIZE;
+	const size_t REPEATS_COUNT = 2000;
+
+	double* arguments = calloc(ROWS_COUNT, sizeof(double));
+	double* results = calloc(ROWS_COUNT, sizeof(double));
+	int* row_errors = calloc(ROWS_COUNT, sizeof(int));
+	if (arguments == NULL || results == NULL || row_errors == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+
+	srand(1);
+	for (int function_index = 0; function_index < MATH_FUNCTIONS_COUNT; function_index++)
+	{
+		const struct function_entry* function = &MATH_FUNCTIONS[function_index];
+		if (function->pointer_on_vector_function == NULL)
+		{
+			continue;
+		}
+
+		for (size_t i = 0; i < ROWS_COUNT; i++)
+		{
+			double unit = (double)rand() / RAND_MAX;
+			arguments[i] = (function_index == FUNCTION_ARCCOS) ? 1.98 * unit - 0.99 :
+				(function_index == FUNCTION_LN) ? 0.001 + 1000 * unit : 200 * unit - 100;
+			row_errors[i] = NO_ERROR;
+		}
+
+		double rows_per_second[BATCH_ACCURACIES_COUNT];
+		for (int accuracy = 0; accuracy < BATCH_ACCURACIES_COUNT; accuracy++)
+		{
+			double start_time = get_time_seconds();
+			for (size_t repeat = 0; repeat < REPEATS_COUNT; repeat++)
+			{
+				memcpy(results, arguments, ROWS_COUNT * sizeof(double));
+				function->pointer_on_vector_function(results, NULL, ROWS_COUNT, row_errors, accuracy);
+			}
+			rows_per_second[accuracy] = ROWS_COUNT * REPEATS_COUNT / (get_time_seconds() - start_time);
+		}
+
+		printf("vector %-6s: exact %.1f M rows/s, 1ulp %.1f M rows/s (%.2fx), "
+			"4ulp %.1f M rows/s (%.2fx)\n", function->function_alias,
+			rows_per_second[BATCH_ACCURACY_EXACT] / 1e6, rows_per_second[BATCH_ACCURACY_ONE_ULP] / 1e6,
+			rows_per_second[BATCH_ACCURACY_ONE_ULP] / rows_per_second[BATCH_ACCURACY_EXACT],
+			rows_per_second[BATCH_ACCURACY_FOUR_ULP] / 1e6,
+			rows_per_second[BATCH_ACCURACY_FOUR_ULP] / rows_per_second[BATCH_ACCURACY_EXACT]);
+	}
+
+	free(arguments);
+	free(results);
+	free(row_errors);
+}
+
+
+/**********************************************************************************************************
+NAME  : CALL BENCHMARKS
+LIBS  : -
+NOTES : -
+**********************************************************************************************************/
+void call_benchmarks()
+{
+	benchmark_registry_lookup();
+	benchmark_batch_evaluation();
+	benchmark_parallel_scaling();
+	benchmark_optimizer();
+	benchmark_formula_group();
+	benchmark_jit();
+	benchmark_arena();
+	benchmark_long_expressions();
+	benchmark_result_cache();
+	benchmark_formula_cache();
+	benchmark_short_circuit();
+	benchmark_incremental_evaluation();
+	benchmark_zone_maps();
+	benchmark_number_parsing();
+	benchmark_formula_file();
+	benchmark_vector_functions();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////BENCHMARK SECTION END///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+////BENCHMARK SUITE SECTION/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+
+Benchmark suite generates random but valid expressions (corpus) with controlled count of tokens, nesting
+depth, mix of operations and count of variables, and times every phase of calculation separately: lexing,
+conversion to postfix notation, compilation with optimization, binding of "where" values and evaluation.
+Calculation of the whole expression is timed too, together with system allocations it makes. Results are
+written as JSON, one case per line, so run can be saved and compared with the next one:
+
+	mathpars --bench-suite > baseline.json
+	mathpars --bench-suite baseline.json
+
+Corpus is generated from fixed seed, so the same cases are timed by every run on the same machine. Generated
+expressions never fail: arguments of "sqrt", "ln" and divisors are made positive by "abs ( ... ) + 1".
+
+The last case is CSV filter over generated in-memory CSV file, it is measured by throughput in GB/s.
+
+*/
+
+//Mix of operations of generated expressions, flags can be combined.
+#define CORPUS_ARITHMETIC 1
+#define CORPUS_LOGICAL    2
+#define CORPUS_FUNCTIONS  4
+
+//Phase time (throughput) which grows (falls) more than this part of baseline is reported as regression.
+#define REGRESSION_THRESHOLD 0.15
+
+/**********************************************************************************************************
+NAME  : CORPUS SETTINGS
+LIBS  : -
+NOTES : "tokens_count" is approximate count of formula tokens, "max_depth" is maximal nesting of brackets and
+        functions, "operations_mix" is combination of CORPUS flags. If "variables_count" is 0, formula has only
+        constants and no "where" part.
+**********************************************************************************************************/
+struct corpus_settings
+{
+	const char* name;
+	size_t tokens_count;
+	size_t max_depth;
+	int operations_mix;
+	size_t variables_count;
+};
+
+
+/**********************************************************************************************************
+NAME  : CORPUS WRITER
+LIBS  : -
+NOTES : append cursor of generated expression and count of formula tokens written so far.
+**********************************************************************************************************/
+struct corpus_writer
+{
+	char* cursor;
+	size_t tokens_count;
+	const struct corpus_settings* settings;
+};
+
+
+/**********************************************************************************************************
+NAME  : SUITE RESULT
+LIBS  : -
+NOTES : time of phases per token or per evaluation. Lexing is timed per token of the whole expression, other
+        phases of parsing per token of formula. "allocations_per_eval" is count of system allocations made by
+        one steady-state calculation of expression.
+**********************************************************************************************************/
+struct suite_result
+{
+	size_t tokens_count;
+	size_t iterations_count;
+
+	double lex_ns_per_token;
+	double postfix_ns_per_token;
+	double compile_ns_per_token;
+	double bind_ns_per_eval;
+	double evaluate_ns_per_eval;
+	double calculate_ns_per_eval;
+	double allocations_per_eval;
+};
+
+
+/**********************************************************************************************************
+NAME  : WRITE CORPUS TOKENS
+LIBS  : stdio.h
+NOTES : appends "text" which contains "tokens_count" tokens.
+**********************************************************************************************************/
+void write_corpus_tokens(struct corpus_writer* writer, const char* text, size_t tokens_count)
+{
+	writer->cursor += sprintf(writer->cursor, "%s", text);
+	writer->tokens_count += tokens_count;
+}
+
+
+/**********************************************************************************************************
+NAME  : WRITE CORPUS LEAF
+LIBS  : stdio.h, stdlib.h
+NOTES : appends variable or constant, variables are more frequent, so formula is not folded to constant.
+**********************************************************************************************************/
+void write_corpus_leaf(struct corpus_writer* writer)
+{
+	if (writer->settings->variables_count != 0 && rand() % 4 != 0)
+	{
+		writer->cursor += sprintf(writer->cursor, "x%d", rand() % (int)writer->settings->variables_count);
+	}
+	else
+	{
+		writer->cursor += sprintf(writer->cursor, "%d.%d", rand() % 100, rand() % 100);
+	}
+	writer->tokens_count++;
+}
+
+
+/**********************************************************************************************************
+NAME  : WRITE CORPUS TERM
+LIBS  : stdlib.h
+NOTES : appends random valid subexpression of about "tokens_budget" tokens, "depth" is its nesting.
+**********************************************************************************************************/
+void write_corpus_term(struct corpus_writer* writer, size_t tokens_budget, size_t depth)
+{
+	//the cheapest node is "( x + y )" or "neg ( x )", it has 3 tokens besides its arguments, "abs ( x ) + 1"
+	//which makes argument positive has 4 more tokens.
+	const size_t NODE_TOKENS_COUNT = 3;
+	const size_t POSITIVE_TOKENS_COUNT = 4;
+	const char* ARITHMETIC_OPERATIONS[] = { " + ", " - ", " * ", " / " };
+	const char* LOGICAL_OPERATIONS[] = { " > ", " < ", " = ", " OR " };
+	const char* FUNCTIONS[] = { "sin", "cos", "abs", "neg", "sqrt", "ln", "pow" };
+
+	int mix = writer->settings->operations_mix;
+	if (tokens_budget <= NODE_TOKENS_COUNT || depth >= writer->settings->max_depth)
+	{
+		write_corpus_leaf(writer);
+		return;
+	}
+
+	int is_function = ((mix & CORPUS_FUNCTIONS) != 0) &&
+		((mix & (CORPUS_ARITHMETIC | CORPUS_LOGICAL)) == 0 || rand() % 3 == 0);
+	if (is_function == 1)
+	{
+		const char* function = FUNCTIONS[rand() % (sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0]))];
+		size_t argument_budget = tokens_budget - NODE_TOKENS_COUNT;
+		int is_positive_argument = (strcmp(function, "sqrt") == 0 || strcmp(function, "ln") == 0);
+		if (is_positive_argument == 1)
+		{
+			argument_budget = (argument_budget > POSITIVE_TOKENS_COUNT) ? argument_budget - POSITIVE_TOKENS_COUNT : 1;
+		}
+
+		write_corpus_tokens(writer, function, 1);
+		write_corpus_tokens(writer, " ( ", 1);
+		if (is_positive_argument == 1)
+		{
+			write_corpus_tokens(writer, "abs ( ", 2);
+			write_corpus_term(writer, argument_budget, depth + 2);
+			write_corpus_tokens(writer, " ) + 1", 3);
+		}
+		else if (strcmp(function, "pow") == 0)
+		{
+			write_corpus_term(writer, argument_budget, depth + 1);
+			write_corpus_tokens(writer, " , 2", 2);
 		}
-		current_char++;
+		else
+		{
+			write_corpus_term(writer, argument_budget, depth + 1);
+		}
+		write_corpus_tokens(writer, " )", 1);
+		return;
+	}
+
+	const char* operation;
+	if ((mix & CORPUS_LOGICAL) != 0 && ((mix & CORPUS_ARITHMETIC) == 0 || rand() % 2 == 0))
+	{
+		operation = LOGICAL_OPERATIONS[rand() % (sizeof(LOGICAL_OPERATIONS) / sizeof(LOGICAL_OPERATIONS[0]))];
+	}
+	else
+	{
+		operation = ARITHMETIC_OPERATIONS[rand() % (sizeof(ARITHMETIC_OPERATIONS) /
+			sizeof(ARITHMETIC_OPERATIONS[0]))];
+	}
+
+	size_t arguments_budget = tokens_budget - NODE_TOKENS_COUNT;
+	size_t left_budget = 1 + (size_t)rand() % arguments_budget;
+	size_t right_budget = arguments_budget - left_budget + 1;
+
+	write_corpus_tokens(writer, "( ", 1);
+	write_corpus_term(writer, left_budget, depth + 1);
+	write_corpus_tokens(writer, operation, 1);
+	if (strcmp(operation, " / ") == 0)
+	{
+		write_corpus_tokens(writer, "( abs ( ", 3);
+		//divisor has brackets around positive argument.
+		right_budget = (right_budget > POSITIVE_TOKENS_COUNT + 2) ? right_budget - POSITIVE_TOKENS_COUNT - 2 : 1;
+		write_corpus_term(writer, right_budget, depth + 3);
+		write_corpus_tokens(writer, " ) + 1 )", 4);
+	}
+	else
+	{
+		write_corpus_term(writer, right_budget, depth + 1);
+	}
+	write_corpus_tokens(writer, " )", 1);
+}
+
+
+/**********************************************************************************************************
+NAME  : GENERATE EXPRESSION
+LIBS  : stdio.h, stdlib.h
+NOTES : generates random valid expression by settings, random generator must be seeded by caller. Formula is
+        sum of terms, every term is random tree. "where" part binds every variable. Returned pointer must be
+        passed to "free()" after use.
+**********************************************************************************************************/
+char* generate_expression(const struct corpus_settings* settings)
+{
+	//"abs ( x ) + 1" of divisor adds 7 tokens, its text with spaces is the longest per token.
+	const size_t MAX_TOKEN_LENGTH = 16;
+	const size_t MAX_TERMS_TOKENS_COUNT = 1024;
+	const size_t MAX_VALUE_LENGTH = 32;
+
+	size_t capacity = (settings->tokens_count * 3 + MAX_TERMS_TOKENS_COUNT) * MAX_TOKEN_LENGTH +
+		settings->variables_count * MAX_VALUE_LENGTH + 1;
+	char* expression = calloc(capacity, sizeof(char));
+	if (expression == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
 	}
-	struct dictionary* dictionary = dictionary_initialize(dictionary_capacity);
 
-	const size_t MAX_CHARACTER = 256;
-	char* previous_token = calloc(MAX_CHARACTER, sizeof(char));
-	char* token = strtok(values, TOKEN_DELIMITER);
-	while (token != NULL)
+	struct corpus_writer writer = { expression, 0, settings };
+	while (writer.tokens_count < settings->tokens_count)
 	{
-		if (token[0] == EQUALS_SIGN)
+		if (writer.tokens_count != 0)
 		{
-			token = strtok(NULL, TOKEN_DELIMITER);
-			dictionary_add(dictionary, previous_token, token);
+			write_corpus_tokens(&writer, " + ", 1);
 		}
-		else
+
+		size_t tokens_budget = settings->tokens_count - writer.tokens_count;
+		if (tokens_budget > MAX_TERMS_TOKENS_COUNT && settings->max_depth < MAX_TERMS_TOKENS_COUNT)
 		{
-			previous_token = strcpy(previous_token, token);
-			token = strtok(NULL, TOKEN_DELIMITER);
+			tokens_budget = MAX_TERMS_TOKENS_COUNT;
 		}
+		write_corpus_term(&writer, tokens_budget, 0);
 	}
 
-	return dictionary;
+	for (size_t i = 0; i < settings->variables_count; i++)
+	{
+		writer.cursor += sprintf(writer.cursor, "%s x%zu = %d.%d", (i == 0) ? " |" : " ,", i, rand() % 100,
+			rand() % 100);
+	}
+
+	return expression;
 }
 
 
 /**********************************************************************************************************
-NAME  : TURN FORMULA INTO EXPRESSION
-LIBS  : string.h
-NOTES : -
+NAME  : GET SYSTEM ALLOCATIONS COUNT
+LIBS  : -
+NOTES : return count of system allocations made by parser context so far: blocks of arena, growth of token
+        arrays and evaluation stack. These are the only allocations of "calculate_expression()".
+**********************************************************************************************************/
+size_t get_system_allocations_count(const struct parser_context* context, size_t tokens_capacity,
+	const struct stack_double* evaluation_stack)
+{
+	return context->arena->system_allocations_count + (context->tokens_capacity != tokens_capacity) +
+		(context->evaluation_stack != evaluation_stack);
+}
+
+
+/**********************************************************************************************************
+NAME  : TIME SUITE PHASES
+LIBS  : -
+NOTES : times phases of calculation of tokenized expression, every phase is repeated "iterations_count"
+        times.
 **********************************************************************************************************/
-char* turn_formula_into_expression(char* formula, struct dictionary* value_dictionary)
+void time_suite_phases(struct parser_context* context, const char* expression, size_t formula_tokens_count,
+	size_t iterations_count, struct suite_result* result)
 {
-	const char* TOKEN_DELIMITER = " ";
+	const size_t WHERE_KEYWORD_TOKENS_COUNT = 1;
 
-	const size_t MAX_CHARACTERS = 256;
-	char* result_expression = calloc(MAX_CHARACTERS, sizeof(char));
+	volatile double checksum = 0;
 
-	char* token = strtok(formula, TOKEN_DELIMITER);
-	while (token != NULL)
+	double start_time = get_time_seconds();
+	for (size_t i = 0; i < iterations_count; i++)
 	{
-		char* value = dictionary_find(value_dictionary, token);
+		tokenize_expression(context, expression);
+	}
+	result->lex_ns_per_token = (get_time_seconds() - start_time) * 1e9 / (iterations_count * context->tokens_count);
 
-		if (value != NULL)
-		{
-			strcat(result_expression, value);
-		}
-		else
-		{
-			strcat(result_expression, token);
-		}
-		strcat(result_expression, TOKEN_DELIMITER);
+	start_time = get_time_seconds();
+	for (size_t i = 0; i < iterations_count; i++)
+	{
+		convert_tokens_to_postfix(context, formula_tokens_count);
+	}
+	result->postfix_ns_per_token = (get_time_seconds() - start_time) * 1e9 /
+		(iterations_count * formula_tokens_count);
+
+	struct compiled_formula* formula = NULL;
+	start_time = get_time_seconds();
+	for (size_t i = 0; i < iterations_count; i++)
+	{
+		arena_reset(context->arena);
+		formula = compile_postfix_tokens(context, expression, context->arena);
+		optimize_compiled_formula(formula);
+	}
+	result->compile_ns_per_token = (get_time_seconds() - start_time) * 1e9 /
+		(iterations_count * formula_tokens_count);
+
+	double* bindings = arena_allocate(context->arena, formula->variables_count + 1, sizeof(double));
+	char* bound_flags = arena_allocate(context->arena, formula->variables_count + 1, sizeof(char));
+	size_t error_position = 0;
+
+	start_time = get_time_seconds();
+	for (size_t i = 0; i < iterations_count; i++)
+	{
+		bind_where_values(context, formula_tokens_count + WHERE_KEYWORD_TOKENS_COUNT, expression, 0, formula,
+			bindings, bound_flags, &error_position);
+	}
+	result->bind_ns_per_eval = (get_time_seconds() - start_time) * 1e9 / iterations_count;
 
-		token = strtok(NULL, TOKEN_DELIMITER);
+	start_time = get_time_seconds();
+	for (size_t i = 0; i < iterations_count; i++)
+	{
+		checksum += evaluate_compiled_formula(formula, bindings, context->evaluation_stack).value;
 	}
+	result->evaluate_ns_per_eval = (get_time_seconds() - start_time) * 1e9 / iterations_count;
+
+	size_t tokens_capacity = context->tokens_capacity;
+	const struct stack_double* evaluation_stack = context->evaluation_stack;
+	size_t allocations_count = get_system_allocations_count(context, tokens_capacity, evaluation_stack);
 
-	return result_expression;
+	start_time = get_time_seconds();
+	for (size_t i = 0; i < iterations_count; i++)
+	{
+		checksum += calculate_expression(context, expression).value;
+	}
+	result->calculate_ns_per_eval = (get_time_seconds() - start_time) * 1e9 / iterations_count;
+	result->allocations_per_eval = (double)(get_system_allocations_count(context, tokens_capacity,
+		evaluation_stack) - allocations_count) / iterations_count;
 }
 
 
 /**********************************************************************************************************
-NAME  : CALCULATE EXPRESSION
-LIBS  : stdio.h, stype.h, stdlib.h
-NOTES : -
+NAME  : RUN SUITE CASE
+LIBS  : stdio.h, math.h
+NOTES : times phases of calculation of expression. Every phase is repeated over the same count of tokens, so
+        short and long expressions are timed for about the same time. Phases are timed several times and the
+        best time is kept, so noise of other processes does not look like regression. Return 0 if expression
+        failed.
 **********************************************************************************************************/
-double calculate_expression(char* expression)
+int run_suite_case(const char* expression, struct suite_result* result)
 {
-	char* converted_expression = convert_infix_to_postfix(expression);
+	const size_t TOKENS_PER_PHASE = 1000000;
+	const size_t REPEATS_COUNT = 5;
 
-	const size_t STACK_CAPACITY = 64;
-	struct stack_double* stack = stack_double_initialize(STACK_CAPACITY);
+	struct parser_context* context = parser_context_initialize();
 
-	const char DELIMITER[2] = " ";
-	char* token;
+	//warm-up calculation grows arena and token arrays to steady state.
+	struct evaluation_result warm_up_result = calculate_expression(context, expression);
+	if (warm_up_result.error_code != NO_ERROR)
+	{
+		fprintf(stderr, "Error: %s at position %zu\n", get_error_message(warm_up_result.error_code),
+			warm_up_result.error_position);
+		parser_context_free(context);
+		return 0;
+	}
 
-	token = strtok(converted_expression, DELIMITER);
+	tokenize_expression(context, expression);
+	size_t formula_tokens_count = 0;
+	while (formula_tokens_count < context->tokens_count &&
+		context->tokens[formula_tokens_count].kind != TOKEN_WHERE_KEYWORD)
+	{
+		formula_tokens_count++;
+	}
 
-	while (token != NULL)
+	size_t iterations_count = TOKENS_PER_PHASE / formula_tokens_count + 1;
+	for (size_t i = 0; i < REPEATS_COUNT; i++)
 	{
-		if (is_number(token))
-		{
-			double pushing_value = 0;
-			pushing_value = atof(token);
-			push_stack_double(stack, pushing_value);
-		}
-		else if (is_operation(token) == 1)
-		{
-			calculate_stack_operation(token, stack);
-		}
-		else if (is_function(token) == 1)
+		struct suite_result repeat_result;
+		time_suite_phases(context, expression, formula_tokens_count, iterations_count, &repeat_result);
+		if (i == 0)
 		{
-			calculate_stack_function(token, stack);
-		}
-		else
-		{
-			throw_error(UNEXPECTED_TOKEN);
+			*result = repeat_result;
+			continue;
 		}
 
-		token = strtok(NULL, DELIMITER);
+		result->lex_ns_per_token = fmin(result->lex_ns_per_token, repeat_result.lex_ns_per_token);
+		result->postfix_ns_per_token = fmin(result->postfix_ns_per_token, repeat_result.postfix_ns_per_token);
+		result->compile_ns_per_token = fmin(result->compile_ns_per_token, repeat_result.compile_ns_per_token);
+		result->bind_ns_per_eval = fmin(result->bind_ns_per_eval, repeat_result.bind_ns_per_eval);
+		result->evaluate_ns_per_eval = fmin(result->evaluate_ns_per_eval, repeat_result.evaluate_ns_per_eval);
+		result->calculate_ns_per_eval = fmin(result->calculate_ns_per_eval, repeat_result.calculate_ns_per_eval);
+		result->allocations_per_eval = fmax(result->allocations_per_eval, repeat_result.allocations_per_eval);
 	}
+	result->tokens_count = formula_tokens_count;
+	result->iterations_count = iterations_count * REPEATS_COUNT;
 
-	double result = *(stack->head_element);
-	
-	stack_double_free(stack);
+	parser_context_free(context);
 
-	return result;
+	return 1;
 }
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////
-////STACK MACHINE SECTION END///////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-
-
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
-////UI SECTION//////////////////////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /**********************************************************************************************************
-NAME  : PRINT ASSIGNMENT SPECIFICATION
-LIBS  : stdio.h
-NOTES : -
+NAME  : GENERATE CSV
+LIBS  : stdio.h, stdlib.h
+NOTES : writes CSV file with "rows_count" rows of random numbers and column of text which formula does not
+        use. Returned pointer must be passed to "free()" after use.
 **********************************************************************************************************/
-void print_assignment_specification()
+char* generate_csv(size_t rows_count, size_t* data_length)
 {
-	fputs("----------------------------------------\n", stdout);
-	fputs("Laboratory assignment #2\n", stdout);
-	fputs("Arsenii Fatykov\n", stdout);
-	fputs("FF-105\n", stdout);
-	fputs("17.3.2017\n", stdout);
-	fputs("----------------------------------------\n", stdout);
-}
+	const char* HEADER = "id,a,b,c,note\n";
+	const size_t MAX_ROW_LENGTH = 128;
 
+	char* data = calloc(strlen(HEADER) + rows_count * MAX_ROW_LENGTH + 1, sizeof(char));
+	if (data == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
 
-/**********************************************************************************************************
-NAME  : PRINT PROGRAM SPECIFICATION
-LIBS  : stdio.h
-NOTES : -
-**********************************************************************************************************/
-void print_program_specification()
-{
-	fputs("----------------------------------------\n", stdout);
-	fputs("Programming practicum v0\n", stdout);
-	fputs("Arsenii Fatykov\n", stdout);
-	fputs("3.3.2017\n", stdout);
-	fputs("----------------------------------------\n", stdout);
+	char* cursor = data + sprintf(data, "%s", HEADER);
+	for (size_t row = 0; row < rows_count; row++)
+	{
+		cursor += sprintf(cursor, "%zu,%.6f,%.3f,%d,item%d\n", row + 1, (double)rand() / RAND_MAX * 100,
+			(double)rand() / RAND_MAX - 0.5, rand() % 1000, rand() % 100);
+	}
+	*data_length = (size_t)(cursor - data);
+
+	return data;
 }
 
 
 /**********************************************************************************************************
-NAME  : PRINT MATH PARSER SPECIFICATION
-LIBS  : stdio.h
-NOTES : -
+NAME  : RUN CSV SUITE CASE
+LIBS  : -
+NOTES : return the best throughput of CSV filter in GB/s, output is discarded.
 **********************************************************************************************************/
-void print_math_parser_specification()
+double run_csv_suite_case(const char* formula_text, const char* data, size_t data_length)
 {
-	fputs("----------------------------------------\n", stdout);
-	fputs("Mathematical parser v0\n", stdout);
-	fputs("----------------------------------------\n", stdout);
+	const size_t REPEATS_COUNT = 5;
+	const double BYTES_PER_GIGABYTE = 1e9;
+
+	struct parser_context* context = parser_context_initialize();
+	struct compiled_formula* formula = compile_formula(context, formula_text);
+	parser_context_free(context);
+
+	double best_seconds = 0;
+	for (size_t i = 0; i < REPEATS_COUNT; i++)
+	{
+		struct csv_filter* filter = csv_filter_initialize(formula, 0, NULL);
+		double start_time = get_time_seconds();
+		process_csv_data(filter, data, data_length);
+		double seconds = get_time_seconds() - start_time;
+		csv_filter_free(filter);
+
+		best_seconds = (i == 0 || seconds < best_seconds) ? seconds : best_seconds;
+	}
+	compiled_formula_free(formula);
+
+	return data_length / BYTES_PER_GIGABYTE / best_seconds;
 }
 
 
 /**********************************************************************************************************
-NAME  : PRINT MAIN MENU ITEMS
-LIBS  : stdio.h
-NOTES : -
+NAME  : FIND BASELINE METRIC
+LIBS  : stdlib.h, string.h
+NOTES : finds metric of case in JSON written by "call_benchmark_suite()". Return 0 if it is not found.
 **********************************************************************************************************/
-void print_main_menu_items()
+int find_baseline_metric(const char* baseline, const char* case_name, const char* metric_name, double* value)
 {
-	fputs("----------------------------------------\n", stdout);
-	fputs("Main menu:\n", stdout);
-	fputs("1 - Mathematical parser\n", stdout);
-	fputs("0 - Exit\n\n", stdout);
-	fputs("----------------------------------------\n", stdout);
+	char case_key[128];
+	char metric_key[128];
+	snprintf(case_key, sizeof(case_key), "\"name\": \"%s\"", case_name);
+	snprintf(metric_key, sizeof(metric_key), "\"%s\": ", metric_name);
+
+	const char* case_text = strstr(baseline, case_key);
+	if (case_text == NULL)
+	{
+		return 0;
+	}
+
+	//every case is written on its own line.
+	const char* case_end = strchr(case_text, '\n');
+	const char* metric_text = strstr(case_text, metric_key);
+	if (metric_text == NULL || (case_end != NULL && metric_text > case_end))
+	{
+		return 0;
+	}
+
+	*value = strtod(metric_text + strlen(metric_key), NULL);
+
+	return 1;
 }
 
 
 /**********************************************************************************************************
-NAME  : CALL INPUT
-LIBS  : stdio.h, string.h
-NOTES : returned pointer on string must be passed to "free()" after use.
+NAME  : READ BASELINE
+LIBS  : stdlib.h, string.h
+NOTES : return text of baseline file, NULL if file can not be read. Returned pointer must be passed to
+        "free()" after use.
 **********************************************************************************************************/
-char* call_input()
+char* read_baseline(const char* file_path)
 {
-	const size_t MAX_CHARACTERS = 256;
-	const size_t BYTE_FOR_NEW_LINE_CHARACTER = 1;
-
-	char* input_string = calloc(MAX_CHARACTERS + BYTE_FOR_NEW_LINE_CHARACTER, sizeof(char));
+	struct mapped_file* mapped_file = map_file(file_path);
+	if (mapped_file == NULL)
+	{
+		return NULL;
+	}
 
-	fgets(input_string, MAX_CHARACTERS + BYTE_FOR_NEW_LINE_CHARACTER, stdin);
-	input_string[strcspn(input_string, "\n")] = 0;
+	char* baseline = calloc(mapped_file->size + 1, sizeof(char));
+	if (baseline == NULL)
+	{
+		throw_error(OUT_OF_MEMORY);
+	}
+	memcpy(baseline, mapped_file->data, mapped_file->size);
+	unmap_file(mapped_file);
 
-	return input_string;
+	return baseline;
 }
 
 
 /**********************************************************************************************************
-NAME  : CALL MATH PARSER
-LIBS  : stdio.h
-NOTES : -
+NAME  : CALL BENCHMARK SUITE
+LIBS  : stdio.h, stdlib.h
+NOTES : writes results of every case as JSON to standard output. If "baseline_path" is not NULL, results are
+        compared with saved ones and every regression is written to standard error (time which grows or
+        throughput which falls). Return EXIT_FAILURE if case failed or regressed.
 **********************************************************************************************************/
-void call_math_parser()
+int call_benchmark_suite(const char* baseline_path)
 {
-	print_math_parser_specification();
+	const unsigned int CORPUS_SEED = 1;
+	const size_t CSV_ROWS_COUNT = 1000000;
+	const char* CSV_FORMULA = "a + b * 10 > 50 AND c < 500";
+	const struct corpus_settings CASES[] =
+	{
+		{ "small",     16,     4,    CORPUS_ARITHMETIC,                                      3 },
+		{ "medium",    256,    8,    CORPUS_ARITHMETIC | CORPUS_FUNCTIONS,                   16 },
+		{ "large",     65536,  16,   CORPUS_ARITHMETIC | CORPUS_LOGICAL | CORPUS_FUNCTIONS,  256 },
+		{ "logical",   256,    8,    CORPUS_ARITHMETIC | CORPUS_LOGICAL,                     16 },
+		{ "functions", 256,    64,   CORPUS_FUNCTIONS,                                       16 },
+		{ "constants", 256,    8,    CORPUS_ARITHMETIC | CORPUS_FUNCTIONS,                   0 },
+		{ "deep",      4096,   2048, CORPUS_FUNCTIONS,                                       1 }
+	};
+	const char* METRICS_NAMES[] = { "lex_ns_per_token", "postfix_ns_per_token", "compile_ns_per_token",
+		"bind_ns_per_eval", "evaluate_ns_per_eval", "calculate_ns_per_eval", "allocations_per_eval" };
+	const size_t CASES_COUNT = sizeof(CASES) / sizeof(CASES[0]);
+	const size_t METRICS_COUNT = sizeof(METRICS_NAMES) / sizeof(METRICS_NAMES[0]);
+
+	char* baseline = NULL;
+	if (baseline_path != NULL)
+	{
+		baseline = read_baseline(baseline_path);
+		if (baseline == NULL)
+		{
+			fprintf(stderr, "Error: can not read baseline \"%s\"\n", baseline_path);
+			return EXIT_FAILURE;
+		}
+	}
 
-	fputs("Enter expression: ", stdout);
-	char* expression = call_input();
+	int exit_code = EXIT_SUCCESS;
 
-	if (is_there_where_keyword(expression) == 1)
+	printf("{\n\"cases\": [\n");
+	for (size_t i = 0; i < CASES_COUNT; i++)
 	{
-		char* formula = get_formula_from_expression(expression);
-		char* values = get_values_from_expression(expression);
+		srand(CORPUS_SEED);
+		char* expression = generate_expression(&CASES[i]);
+
+		struct suite_result result = { 0 };
+		if (run_suite_case(expression, &result) == 0)
+		{
+			fprintf(stderr, "case \"%s\" failed\n", CASES[i].name);
+			exit_code = EXIT_FAILURE;
+		}
+		free(expression);
+
+		double metrics[] = { result.lex_ns_per_token, result.postfix_ns_per_token, result.compile_ns_per_token,
+			result.bind_ns_per_eval, result.evaluate_ns_per_eval, result.calculate_ns_per_eval,
+			result.allocations_per_eval };
+
+		printf("{ \"name\": \"%s\", \"tokens\": %zu, \"iterations\": %zu", CASES[i].name, result.tokens_count,
+			result.iterations_count);
+		for (size_t j = 0; j < METRICS_COUNT; j++)
+		{
+			printf(", \"%s\": %.3f", METRICS_NAMES[j], metrics[j]);
+		}
+		printf(" },\n");
 
-		struct dictionary* value_dictionary = get_value_dictionary(values);
-		expression = turn_formula_into_expression(formula, value_dictionary);
+		double baseline_value;
+		for (size_t j = 0; baseline != NULL && j < METRICS_COUNT; j++)
+		{
+			if (find_baseline_metric(baseline, CASES[i].name, METRICS_NAMES[j], &baseline_value) == 0)
+			{
+				continue;
+			}
 
-		free(formula);
-		free(values);
-		dictionary_free(value_dictionary);
+			//allocations are counted exactly, any growth is regression.
+			int is_allocations = (j == METRICS_COUNT - 1);
+			double limit = is_allocations ? baseline_value : baseline_value * (1 + REGRESSION_THRESHOLD);
+			if (metrics[j] > limit)
+			{
+				fprintf(stderr, "regression: %s %s %.3f -> %.3f (%+.1f%%)\n", CASES[i].name, METRICS_NAMES[j],
+					baseline_value, metrics[j], (baseline_value != 0) ? (metrics[j] / baseline_value - 1) * 100 : 0);
+				exit_code = EXIT_FAILURE;
+			}
+		}
 	}
 
-	double result = calculate_expression(expression);
-	free(expression);
-	printf("Result: %f\n", result);
-	getchar();
+	//CSV filter is measured by throughput, so greater value is better.
+	srand(CORPUS_SEED);
+	size_t csv_length;
+	char* csv = generate_csv(CSV_ROWS_COUNT, &csv_length);
+	double csv_gb_per_s = run_csv_suite_case(CSV_FORMULA, csv, csv_length);
+	free(csv);
+
+	printf("{ \"name\": \"csv\", \"bytes\": %zu, \"rows\": %zu, \"gb_per_s\": %.3f }\n", csv_length,
+		CSV_ROWS_COUNT, csv_gb_per_s);
+
+	double baseline_value;
+	if (baseline != NULL && find_baseline_metric(baseline, "csv", "gb_per_s", &baseline_value) == 1 &&
+		csv_gb_per_s < baseline_value * (1 - REGRESSION_THRESHOLD))
+	{
+		fprintf(stderr, "regression: csv gb_per_s %.3f -> %.3f (%+.1f%%)\n", baseline_value, csv_gb_per_s,
+			(csv_gb_per_s / baseline_value - 1) * 100);
+		exit_code = EXIT_FAILURE;
+	}
+	printf("]\n}\n");
+
+	free(baseline);
+
+	return exit_code;
 }
 
+
 /**********************************************************************************************************
-NAME  : CALL MAIN MENU
+NAME  : CALL CORPUS MODE
 LIBS  : stdio.h, stdlib.h
-NOTES : -
+NOTES : writes "expressions_count" generated expressions to standard output, one per line, so corpus can be
+        passed to stream mode.
 **********************************************************************************************************/
-void call_main_menu()
+int call_corpus_mode(size_t expressions_count, const struct corpus_settings* settings)
 {
-	print_program_specification();
-	print_assignment_specification();
-	
-	for (;;)
+	srand(1);
+	for (size_t i = 0; i < expressions_count; i++)
 	{
-		print_main_menu_items();
+		char* expression = generate_expression(settings);
+		puts(expression);
+		free(expression);
+	}
 
-		fputs("Choose item: ", stdout);
-		char* input_item = call_input();
-		fputs("\n", stdout);
-		int input_item_as_int = atoi(input_item);
+	return EXIT_SUCCESS;
+}
 
-		switch (input_item_as_int)
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////BENCHMARK SUITE SECTION END/////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+int main(int argc, char* argv[])
+{
+	STATISTICS_INITIALIZE();
+
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+	{
+		call_benchmarks();
+		return 0;
+	}
+
+	if (argc > 2 && strcmp(argv[1], "--stream") == 0)
+	{
+		const size_t DEFAULT_FORMULA_CACHE_CAPACITY = 65536;
+
+		int is_jit_enabled = 0;
+		size_t formula_cache_capacity = DEFAULT_FORMULA_CACHE_CAPACITY;
+		size_t result_cache_capacity = 0;
+		for (int i = 3; i < argc; i++)
 		{
-			case 1:
-				call_math_parser();
-				break;
+			if (strcmp(argv[i], "--jit") == 0)
+			{
+				is_jit_enabled = 1;
+			}
+			else if (strcmp(argv[i], "--result-cache") == 0 && i + 1 < argc)
+			{
+				result_cache_capacity = strtoul(argv[++i], NULL, 10);
+			}
+			else if (strcmp(argv[i], "--formula-cache") == 0 && i + 1 < argc)
+			{
+				formula_cache_capacity = strtoul(argv[++i], NULL, 10);
+			}
+		}
+		return call_stream_mode(argv[2], is_jit_enabled, formula_cache_capacity, result_cache_capacity);
+	}
 
-			case 0:
-				exit(EXIT_SUCCESS);
+	if (argc > 1 && strcmp(argv[1], "--check-stream") == 0)
+	{
+		return call_check_stream_mode();
+	}
 
-			default:
-				exit(EXIT_FAILURE);
+	if (argc > 3 && strcmp(argv[1], "--csv") == 0)
+	{
+		int is_results_written = 0; //false
+		int accuracy = BATCH_ACCURACY_EXACT;
+		for (int i = 4; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--results") == 0)
+			{
+				is_results_written = 1;
+			}
+			else if (strcmp(argv[i], "--accuracy") == 0 && i + 1 < argc)
+			{
+				accuracy = get_accuracy_by_name(argv[++i]);
+				if (accuracy == -1)
+				{
+					fprintf(stderr, "Unknown accuracy %s (exact, 1ulp, 4ulp)\n", argv[i]);
+					return EXIT_FAILURE;
+				}
+			}
 		}
+		return call_csv_mode(argv[2], argv[3], is_results_written, accuracy);
+	}
 
+	if (argc > 3 && strcmp(argv[1], "--compile-rules") == 0)
+	{
+		return call_compile_rules_mode(argv[2], argv[3]);
 	}
-}
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////
-////UI SECTION END//////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////
+	if (argc > 3 && strcmp(argv[1], "--rules") == 0)
+	{
+		return call_rules_mode(argv[2], argv[3]);
+	}
 
+	if (argc > 1 && strcmp(argv[1], "--check-accuracy") == 0)
+	{
+		const size_t DEFAULT_SAMPLES_COUNT = 1000000;
+
+		return call_check_accuracy_mode((argc > 2) ? strtoul(argv[2], NULL, 10) : DEFAULT_SAMPLES_COUNT);
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--bench-suite") == 0)
+	{
+		return call_benchmark_suite((argc > 2) ? argv[2] : NULL);
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--corpus") == 0)
+	{
+		const size_t DEFAULT_MAX_DEPTH = 8;
+		const size_t DEFAULT_VARIABLES_COUNT = 3;
+		const int MIN_ARGUMENTS_COUNT = 4;
+		const int MAX_ARGUMENTS_COUNT = 6;
+
+		//expressions count, tokens count, depth and variables count.
+		size_t numbers[4] = { 0, 0, DEFAULT_MAX_DEPTH, DEFAULT_VARIABLES_COUNT };
+		int is_usage_wrong = (argc < MIN_ARGUMENTS_COUNT || argc > MAX_ARGUMENTS_COUNT);
+		for (int i = 2; is_usage_wrong == 0 && i < argc; i++)
+		{
+			char* number_end;
+			numbers[i - 2] = strtoul(argv[i], &number_end, 10);
+			is_usage_wrong = (number_end == argv[i] || *number_end != '\0' || argv[i][0] == '-');
+		}
+		if (is_usage_wrong == 1)
+		{
+			fprintf(stderr, "Usage: %s --corpus count tokens [depth [variables]]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		struct corpus_settings settings = { "corpus", numbers[1], numbers[2],
+			CORPUS_ARITHMETIC | CORPUS_LOGICAL | CORPUS_FUNCTIONS, numbers[3] };
+		return call_corpus_mode(numbers[0], &settings);
+	}
 
-int main()
-{
 	call_main_menu();
 
 	return 0;